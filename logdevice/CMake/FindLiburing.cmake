@@ -0,0 +1,61 @@
+# Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# - Try to find liburing with the features io_uring sockets use
+# Once done this will define
+#
+#  LIBURING_FOUND - system has a recent enough liburing
+#  LIBURING_INCLUDE_DIR - the liburing include directory
+#  LIBURING_LIBRARY - Link this to use liburing, empty if not found
+#
+# Provided buffer rings (io_uring_setup_buf_ring()) need liburing 2.4 and
+# zero-copy sends (IORING_OP_SEND_ZC) need 2.3. With an older liburing,
+# io_uring sockets are left disabled rather than failing the build.
+
+find_path(LIBURING_INCLUDE_DIR NAMES liburing.h)
+find_library(LIBURING_LIBRARY NAMES uring)
+
+include(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(
+    Liburing DEFAULT_MSG
+    LIBURING_LIBRARY LIBURING_INCLUDE_DIR)
+
+if (LIBURING_FOUND)
+  ENABLE_LANGUAGE(C)
+  include(CMakePushCheckState)
+  include(CheckCSourceCompiles)
+  cmake_push_check_state(RESET)
+  set(CMAKE_REQUIRED_INCLUDES ${LIBURING_INCLUDE_DIR})
+  set(CMAKE_REQUIRED_LIBRARIES ${LIBURING_LIBRARY})
+  CHECK_C_SOURCE_COMPILES("#include <liburing.h>
+int main() {
+  struct io_uring ring;
+  int ret;
+  struct io_uring_buf_ring* br =
+      io_uring_setup_buf_ring(&ring, 8, 0, 0, &ret);
+  struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+  io_uring_prep_send_zc_fixed(sqe, 0, 0, 0, 0, 0, 0);
+  return br != 0 && IORING_OP_SEND_ZC && IORING_CQE_F_NOTIF;
+}" LIBURING_HAS_BUF_RING_AND_SEND_ZC)
+  cmake_pop_check_state()
+
+  if (NOT LIBURING_HAS_BUF_RING_AND_SEND_ZC)
+    message(STATUS "liburing at ${LIBURING_LIBRARY} lacks provided buffer "
+                   "rings or zero-copy sends (needs 2.4+), io_uring sockets "
+                   "will be unavailable")
+    set(LIBURING_FOUND FALSE)
+  else()
+    message(STATUS "Found liburing: ${LIBURING_LIBRARY}")
+  endif()
+else()
+  message(STATUS "liburing not found, io_uring sockets will be unavailable")
+endif()
+
+if (NOT LIBURING_FOUND)
+  set(LIBURING_LIBRARY "")
+endif (NOT LIBURING_FOUND)
+
+mark_as_advanced(LIBURING_INCLUDE_DIR LIBURING_LIBRARY)
@@ -64,6 +64,7 @@ find_package(LZ4 REQUIRED)
 find_package(Sqlite REQUIRED)
 find_package(Snappy REQUIRED)
 find_package(LibIberty REQUIRED)
+find_package(Liburing)
 include_directories(${LOGDEVICE_STAGING_DIR}/usr/local/include)
 include_directories(${JEMALLOC_INCLUDE_DIR})
 include_directories(${LIBSODIUM_INCLUDE_DIR})
@@ -87,6 +88,10 @@ include_directories(${ROCKSDB_INCLUDE_DIRS})
 include_directories(${LIBLZMA_INCLUDE_DIRS})
 include_directories(${LIBGFLAGS_INCLUDE_DIR})
 include_directories(${FBTHRIFT_INCLUDE_DIR})
+if(LIBURING_FOUND)
+  include_directories(${LIBURING_INCLUDE_DIR})
+  add_definitions(-DLOGDEVICE_HAVE_LIBURING=1)
+endif()
 
 # Figure out where to install the Python library
 # Some packages (e.g. OpenCV) also install to dist-packages (Debian)
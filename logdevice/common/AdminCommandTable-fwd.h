@@ -93,7 +93,13 @@ typedef AdminCommandTable<std::string, /* State */
                           size_t,      /* Send buf-sz */
                           uint32_t,    /* Peer Config Version */
                           bool,        /* Is ssl */
-                          int          /* FD of the underlying socket */
+                          int,         /* FD of the underlying socket */
+                          bool,        /* Compression */
+                          float,       /* Compression ratio out */
+                          float,       /* Compression ratio in */
+                          float,       /* Compression CPU (ms) */
+                          uint64_t,    /* Socket writes */
+                          float        /* Avg write size (B) */
                           >
     InfoSocketsTable;
 
@@ -393,6 +399,24 @@ typedef AdminCommandTable<int,                       /* Stats NodeID */
                           >
     InfoAppendOutliersTable;
 
+typedef AdminCommandTable<std::chrono::milliseconds, /* Time */
+                          uint64_t,                  /* Trace ID */
+                          logid_t,                   /* Log ID */
+                          admin_command_table::LSN,  /* LSN */
+                          uint32_t,                  /* Waves */
+                          std::string,               /* Shard */
+                          int64_t,                   /* Client queue us */
+                          int64_t,                   /* Sequencer us */
+                          int64_t,                   /* Store fanout us */
+                          int64_t,                   /* Network us */
+                          int64_t,                   /* Storage queue us */
+                          int64_t,                   /* Storage write us */
+                          int64_t,                   /* WAL sync us */
+                          int64_t,                   /* Total us */
+                          int64_t                    /* Release us */
+                          >
+    InfoAppendLatencyBreakdownTable;
+
 struct InfoStorageTasksTableFieldOffsets {
   static constexpr int SHARD_ID = 0;
   static constexpr int PRIORITY = 1;
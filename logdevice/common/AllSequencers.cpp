@@ -416,20 +416,20 @@ void AllSequencers::notifyWorkerActivationCompletion(logid_t logid, Status st) {
   };
 
   // Post an ActivationCompletionRequest to all workers
+  std::vector<std::unique_ptr<Request>> rqs;
   for (worker_id_t worker_idx{0}; worker_idx.val_ <
        worker->processor_->getWorkerCount(WorkerType::GENERAL);
        ++worker_idx.val_) {
-    std::unique_ptr<Request> rq = std::make_unique<ActivationCompletionRequest>(
-        completion_callback, worker_idx, WorkerType::GENERAL, st, logid);
-
-    int rv = worker->processor_->postWithRetrying(rq);
-    if (rv != 0 && err != E::SHUTDOWN) {
-      ld_error("Got unexpected err %s for Processor::postWithRetrying() "
-               "with log %lu",
-               error_name(err),
-               logid.val_);
-      ld_check(false);
-    }
+    rqs.push_back(std::make_unique<ActivationCompletionRequest>(
+        completion_callback, worker_idx, WorkerType::GENERAL, st, logid));
+  }
+  int rv = worker->processor_->postImportantRequests(folly::range(rqs));
+  if (rv != 0 && err != E::SHUTDOWN) {
+    ld_error("Got unexpected err %s for Processor::postImportantRequests() "
+             "with log %lu",
+             error_name(err),
+             logid.val_);
+    ld_check(false);
   }
 
   // Notify SequencerBackgroundActivator.
@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include <boost/circular_buffer.hpp>
+
+#include "logdevice/common/ShardID.h"
+#include "logdevice/include/types.h"
+
+namespace facebook { namespace logdevice {
+
+/**
+ * @file Where the time of an append sampled for latency tracing went, as seen
+ *       by its sequencer. Clients sample appends according to
+ *       Settings::append_latency_breakdown_sample_rate.
+ *
+ *       The stages follow each other, so
+ *
+ *         total = sequencer + store_fanout + network + storage_queue +
+ *                 storage_write + wal_sync
+ *
+ *       except that the three storage stages are zero if the storage node did
+ *       not report them (e.g. it runs an older version), in which case
+ *       network includes them. client_queue is measured by the client before
+ *       the APPEND was sent, and release happens after the reply was sent;
+ *       neither is part of total. Time spent between the client and the
+ *       sequencer is the client's latency minus client_queue and total; the
+ *       client traces its side with the same trace_id.
+ */
+
+struct AppendLatencyBreakdown {
+  // When the Appender was reaped, by system clock.
+  std::chrono::milliseconds time;
+  uint64_t trace_id;
+  logid_t log_id;
+  lsn_t lsn;
+  uint32_t waves;
+  // Storage shard whose STORED made the record fully replicated. The
+  // network and storage stages are those of its copy.
+  ShardID shard;
+
+  // AppendRequest created -> APPEND sent, measured on the client.
+  int64_t client_queue_us;
+  // Appender created for the APPEND -> LSN assigned, e.g. waiting for the
+  // sequencer to activate or for room in its sliding window.
+  int64_t sequencer_us;
+  // LSN assigned -> STORE to `shard` passed to TCP. Includes earlier waves.
+  int64_t store_fanout_us;
+  // STORE sent -> STORED received, minus the storage stages below.
+  int64_t network_us;
+  // STORE received -> a storage thread starts writing the batch of writes
+  // that includes it to the local log store.
+  int64_t storage_queue_us;
+  // Writing that batch.
+  int64_t storage_write_us;
+  // Written -> synced, if the STORE asked for a sync.
+  int64_t wal_sync_us;
+  // Appender created -> fully replicated, when the reply is sent.
+  int64_t total_us;
+  // Fully replicated -> reaped, i.e. until the record could be released to
+  // readers.
+  int64_t release_us;
+};
+
+/**
+ * The most recent breakdowns collected on a Worker. Only touched on its
+ * thread.
+ */
+class RecentAppendLatencyBreakdowns {
+ public:
+  static constexpr size_t kCapacity = 1000;
+
+  RecentAppendLatencyBreakdowns() : entries_(kCapacity) {}
+
+  void add(const AppendLatencyBreakdown& entry) {
+    entries_.push_back(entry);
+  }
+
+  const boost::circular_buffer<AppendLatencyBreakdown>& entries() const {
+    return entries_;
+  }
+
+ private:
+  boost::circular_buffer<AppendLatencyBreakdown> entries_;
+};
+
+}} // namespace facebook::logdevice
@@ -10,6 +10,7 @@
 
 #include <memory>
 
+#include <folly/Random.h>
 #include <folly/stats/BucketedTimeSeries.h>
 #include <folly/synchronization/Baton.h>
 
@@ -98,7 +99,9 @@ AppendRequest::AppendRequest(AppendRequest&& other) noexcept
       buffered_writer_blob_flag_(std::move(other.buffered_writer_blob_flag_)),
       bypass_write_token_check_(std::move(other.bypass_write_token_check_)),
       append_redirected_to_dead_node_(
-          std::move(other.append_redirected_to_dead_node_)) {
+          std::move(other.append_redirected_to_dead_node_)),
+      latency_trace_id_(other.latency_trace_id_),
+      latency_trace_queue_us_(other.latency_trace_queue_us_) {
   if (!AppendRequest::clientThreadId) {
     AppendRequest::clientThreadId =
         std::max<unsigned>(1, ++AppendRequest::nextThreadId);
@@ -153,6 +156,15 @@ AppendRequest::~AppendRequest() {
                       latency_usec,
                       previous_lsn_,
                       sequencer_node_);
+  if (latency_trace_id_ != 0) {
+    tracer_.traceAppendLatency(latency_trace_id_,
+                               record_.logid,
+                               record_.attrs.lsn,
+                               client_status,
+                               latency_trace_queue_us_,
+                               latency_usec,
+                               sequencer_node_);
+  }
 
   if (is_active_) {
     // Call back only when the request is active. If not, it has been cancelled
@@ -180,6 +192,13 @@ Request::Execution AppendRequest::execute() {
   // milliseconds pass
   setupTimer();
 
+  // Decide if this append goes into the latency breakdown. This is the only
+  // cost of tracing for appends that are not sampled.
+  double sample_rate = getSettings().append_latency_breakdown_sample_rate;
+  if (sample_rate > 0 && folly::Random::randDouble01() < sample_rate) {
+    latency_trace_id_ = std::max<uint64_t>(1, folly::Random::rand64());
+  }
+
   // kick off the state machine
   if (bypass_write_token_check_) {
     // No need to fetch log config in this case
@@ -341,6 +360,12 @@ void AppendRequest::sendAppendMessage() {
   const NodeID dest = sequencer_node_;
 
   auto msg = createAppendMessage();
+  if (latency_trace_id_ != 0) {
+    // Resends after redirects and preemptions count as client queueing.
+    latency_trace_queue_us_ = usec_since(creation_time_);
+    msg->setLatencyTrace(AppendLatencyTrace{
+        latency_trace_id_, static_cast<uint32_t>(latency_trace_queue_us_)});
+  }
 
   // make sure that on_socket_close_ is not active in case we're resending this
   // message
@@ -739,6 +764,9 @@ APPEND_flags_t AppendRequest::getAppendFlags() {
   if (previous_lsn_ != LSN_INVALID) {
     append_flags |= APPEND_Header::LSN_BEFORE_REDIRECT;
   }
+  if (latency_trace_id_ != 0) {
+    append_flags |= APPEND_Header::LATENCY_TRACE;
+  }
   return append_flags;
 }
 
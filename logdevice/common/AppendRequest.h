@@ -381,6 +381,14 @@ class AppendRequest : public AppendRequestBase,
   // Control whether e2e tracing is on
   bool is_traced_ = false;
 
+  // Nonzero if this append was sampled for the latency breakdown. Sent to
+  // the sequencer in APPEND messages, see AppendLatencyTrace.
+  uint64_t latency_trace_id_ = 0;
+
+  // Time from creation of this request to sending the last APPEND, or -1 if
+  // no APPEND was sent. Only maintained if latency_trace_id_ is nonzero.
+  int64_t latency_trace_queue_us_ = -1;
+
   // This thread-local is set on *client* threads. Processor::postRequest()
   // executing on a client thread will pass this request object to Worker
   // whose index is a function of clientThreadId and the log id. This
@@ -13,6 +13,7 @@
 #include <cstdlib>
 
 #include "logdevice/common/Address.h"
+#include "logdevice/common/AppendLatencyBreakdown.h"
 #include "logdevice/common/AppendRequest.h"
 #include "logdevice/common/AppenderTracer.h"
 #include "logdevice/common/Checksum.h"
@@ -30,10 +31,12 @@
 #include "logdevice/common/Sequencer.h"
 #include "logdevice/common/TailRecord.h"
 #include "logdevice/common/TraceLogger.h"
+#include "logdevice/common/Tracepoints.h"
 #include "logdevice/common/Worker.h"
 #include "logdevice/common/WorkerTimeoutStats.h"
 #include "logdevice/common/debug.h"
 #include "logdevice/common/protocol/APPENDED_Message.h"
+#include "logdevice/common/protocol/APPEND_Message.h"
 #include "logdevice/common/protocol/DELETE_Message.h"
 #include "logdevice/common/protocol/RELEASE_Message.h"
 #include "logdevice/common/protocol/STORED_Message.h"
@@ -335,6 +338,7 @@ void Appender::forgetThePreviousWave(const copyset_size_t cfg_synced) {
   recipients_.replace(nullptr, 0, this);
   synced_replies_remaining_ = cfg_synced;
   held_store_replies_.clear();
+  hedge_recipients_.clear();
 }
 
 int Appender::trySendingWavesOfStores(
@@ -564,6 +568,8 @@ int Appender::sendWave() {
   ld_check(recipients_.getReplication() <= COPYSET_SIZE_MAX);
 
   cancelStoreTimer();
+  cancelHedgeTimer();
+  hedge_elapsed_ = std::chrono::microseconds::zero();
 
   int rv = trySendingWavesOfStores(cfg_synced, cfg_extras, append_ctx);
 
@@ -589,6 +595,10 @@ int Appender::sendWave() {
     activateStoreTimer(timeout_.value());
   }
 
+  if (rv == 0 && replies_expected_ >= recipients_.getReplication()) {
+    scheduleHedge();
+  }
+
   return rv;
 }
 
@@ -606,6 +616,7 @@ int Appender::start(std::shared_ptr<EpochSequencer> epoch_sequencer,
 
   initStoreTimer();
   initRetryTimer();
+  initHedgeTimer();
 
   const std::shared_ptr<const Configuration> cfg(getClusterConfig());
 
@@ -683,6 +694,10 @@ int Appender::start(std::shared_ptr<EpochSequencer> epoch_sequencer,
   ld_check(tail_record_ != nullptr);
 
   STAT_INCR(getStats(), appender_start);
+  tracepoints::appenderStart(log_id_, lsn, payload_.size());
+  if (latency_trace_) {
+    latency_trace_->started = std::chrono::steady_clock::now();
+  }
 
   // Test only setting to disallow appender from retiring. We skip sending the
   // copies to the storage nodes and hence stay in the started stage until
@@ -812,6 +827,14 @@ void Appender::retire(RetireReason reason) {
     }
   }
 
+  tracepoints::appenderRetired(
+      log_id_,
+      store_hdr_.rid.lsn(),
+      st,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          creation_time_.time_since_epoch())
+          .count());
+
   Appender::Reaper reaper;
   retireAppender(st, store_hdr_.rid.lsn(), reaper);
 }
@@ -1204,6 +1227,226 @@ void Appender::onTimeout() {
   sendWave();
 }
 
+std::chrono::microseconds Appender::getHedgeDelay(ShardID shard) const {
+  const auto& bounds = getSettings().store_hedging_delay;
+  auto estimate = copyset_manager_->getNodeSetState()->getStoreLatencyEstimate(
+      shard);
+  if (!estimate.hasValue()) {
+    return bounds.hi;
+  }
+  return std::max(bounds.lo, std::min(bounds.hi, estimate->tail));
+}
+
+bool Appender::storeLatencyEstimatesEnabled() const {
+  const Settings& settings = getSettings();
+  return settings.latency_aware_copyset_selection || settings.store_hedging;
+}
+
+void Appender::scheduleHedge() {
+  const Settings& settings = getSettings();
+  if (!settings.store_hedging || hedged_ ||
+      (store_hdr_.flags & STORE_Header::CHAIN) || !timeout_.has_value()) {
+    // Chain-sent waves are not hedged: a slow node in the middle of the
+    // chain would look like all downstream nodes being slow.
+    return;
+  }
+
+  folly::Optional<std::chrono::microseconds> next;
+  for (const Recipient& r : recipients_.getRecipients()) {
+    if (r.outcomeKnown()) {
+      continue;
+    }
+    auto delay = getHedgeDelay(r.getShardID());
+    if (delay > hedge_elapsed_ && (!next.hasValue() || delay < next.value())) {
+      next = delay;
+    }
+  }
+
+  if (!next.hasValue() || next.value() >= timeout_.value()) {
+    // The store timeout fires first and will take care of the slow nodes.
+    return;
+  }
+
+  activateHedgeTimer(next.value() - hedge_elapsed_);
+  hedge_elapsed_ = next.value();
+}
+
+void Appender::onHedgeTimeout() {
+  ld_check(started());
+  if (recipients_.isFullyReplicated() || wave_failed_with_error_ || hedged_ ||
+      preempted_) {
+    return;
+  }
+
+  // The copyset selector completes the copies already stored with nodes
+  // other than the late ones and those that failed.
+  StoreChainLink copyset[COPYSET_SIZE_MAX];
+  copyset_size_t nstored = 0;
+  copyset_custsz_t<4> excluded;
+  size_t nlate = 0;
+  size_t noutstanding = 0;
+  for (const Recipient& r : recipients_.getRecipients()) {
+    if (r.stored()) {
+      copyset[nstored++] = StoreChainLink{r.getShardID(), ClientID::INVALID};
+    } else if (r.failed()) {
+      excluded.push_back(r.getShardID());
+    } else {
+      ++noutstanding;
+      if (getHedgeDelay(r.getShardID()) <= hedge_elapsed_) {
+        excluded.push_back(r.getShardID());
+        ++nlate;
+      }
+    }
+  }
+
+  if (nlate == 0) {
+    // Outstanding STOREs are to nodes that are slower on average; give them
+    // until their own hedge delay.
+    scheduleHedge();
+    return;
+  }
+  if (noutstanding > getSettings().store_hedging_max_outstanding) {
+    // Too many STOREs are in flight for a hedge to help much. Leave it to
+    // the store timeout.
+    STAT_INCR(getStats(), appender_store_hedge_skipped);
+    return;
+  }
+
+  const copyset_size_t replication = recipients_.getReplication();
+  ld_check(nstored + replication <= COPYSET_SIZE_MAX);
+  copyset_size_t full_size = 0;
+  auto result = copyset_manager_->getCopySetSelector()->augmentExcluding(
+      copyset, nstored, &full_size, excluded.data(), excluded.size());
+  if (result != CopySetSelector::Result::SUCCESS) {
+    STAT_INCR(getStats(), appender_store_hedge_skipped);
+    return;
+  }
+
+  // The selector may have picked nodes that are still outstanding in time;
+  // only the others are new.
+  StoreChainLink replacements[COPYSET_SIZE_MAX];
+  copyset_size_t nreplacements = 0;
+  for (copyset_size_t i = nstored; i < full_size; ++i) {
+    if (!recipients_.find(copyset[i].destination)) {
+      replacements[nreplacements++] = copyset[i];
+    }
+  }
+  if (nreplacements == 0) {
+    scheduleHedge();
+    return;
+  }
+  if (!recipients_.add(replacements, nreplacements, this)) {
+    // The wave is as large as it gets without moving its Recipients.
+    STAT_INCR(getStats(), appender_store_hedge_skipped);
+    return;
+  }
+
+  ld_debug("Appender %s is hedging wave #%u: %zu STOREs late, %hhu stored, "
+           "%hhu replacements",
+           store_hdr_.rid.toString().c_str(),
+           store_hdr_.wave,
+           nlate,
+           nstored,
+           nreplacements);
+  STAT_INCR(getStats(), appender_store_hedged);
+  hedged_ = true;
+
+  // Hedge copies carry the copyset of the whole wave, replacements included.
+  // Copies already sent are amended once the record is fully replicated, see
+  // amendCopysetsAfterHedge().
+  const copyset_size_t wave_size = recipients_.size();
+  for (copyset_size_t i = 0; i < wave_size; ++i) {
+    copyset[i] = StoreChainLink{
+        recipients_.getRecipients()[i].getShardID(), ClientID::INVALID};
+  }
+  store_hdr_.copyset_size = wave_size;
+
+  STORE_flags_t store_flags = isDraining() ? STORE_Header::DRAINING : 0;
+  if (!attrs_.optional_keys.empty()) {
+    store_flags |= STORE_Header::CUSTOM_KEY;
+  }
+  if (store_hdr_.nsync > 0) {
+    // As many copies as before may be unsynced.
+    store_flags |= STORE_Header::SYNC;
+  }
+
+  for (copyset_size_t i = 0; i < wave_size; ++i) {
+    const ShardID shard = copyset[i].destination;
+    if (std::find_if(replacements,
+                     replacements + nreplacements,
+                     [&](const StoreChainLink& l) {
+                       return l.destination == shard;
+                     }) == replacements + nreplacements) {
+      continue;
+    }
+    hedge_recipients_.push_back(shard);
+    int rv = sendSTORE(copyset, copyset_off_t(i), folly::none, store_flags);
+    if (rv < 0) {
+      // Out of buffer space or some system resource. The STOREs already
+      // outstanding and the store timeout take it from here.
+      ld_check(err == E::SYSLIMIT || err == E::NOBUFS);
+      break;
+    }
+    if (rv > 0) {
+      ++replies_expected_;
+      ++outstanding_;
+    }
+  }
+}
+
+void Appender::amendCopysetsAfterHedge() {
+  ld_check(recipients_.isFullyReplicated());
+  copyset_custsz_t<4> stored;
+  recipients_.getReleaseSet(stored);
+  auto is_hedge = [&](ShardID shard) {
+    return std::find(hedge_recipients_.begin(),
+                     hedge_recipients_.end(),
+                     shard) != hedge_recipients_.end();
+  };
+  if (std::none_of(stored.begin(), stored.end(), is_hedge)) {
+    // Hedge copies get a DELETE; the copyset of the other copies is right.
+    return;
+  }
+
+  const copyset_size_t wave_size = recipients_.size();
+  StoreChainLink copyset[COPYSET_SIZE_MAX];
+  for (copyset_size_t i = 0; i < wave_size; ++i) {
+    copyset[i] = StoreChainLink{
+        recipients_.getRecipients()[i].getShardID(), ClientID::INVALID};
+  }
+  ld_check(store_hdr_.copyset_size == wave_size);
+
+  for (copyset_size_t i = 0; i < wave_size; ++i) {
+    const ShardID shard = copyset[i].destination;
+    if (is_hedge(shard) ||
+        std::find(stored.begin(), stored.end(), shard) == stored.end()) {
+      continue;
+    }
+    // Not in appender context: replies come after this Appender is unlinked
+    // and are dropped by STORED_Message.
+    auto amend = std::make_unique<STORE_Message>(store_hdr_,
+                                                 copyset,
+                                                 copyset_off_t(i),
+                                                 STORE_Header::AMEND,
+                                                 extra_,
+                                                 attrs_.optional_keys,
+                                                 PayloadHolder(),
+                                                 false);
+    int rv = sender_->sendMessage(std::move(amend), shard.asNodeID());
+    if (rv != 0) {
+      RATELIMIT_INFO(std::chrono::seconds(10),
+                     10,
+                     "Failed to send a copyset amend for record %s (wave %u) "
+                     "to %s: %s. Recipient set: %s",
+                     store_hdr_.rid.toString().c_str(),
+                     store_hdr_.wave,
+                     shard.toString().c_str(),
+                     error_description(err),
+                     recipients_.dumpRecipientSet().c_str());
+    }
+  }
+}
+
 void Appender::onChainForwardingFailure(unsigned int index) {
   folly::fbvector<Recipient>& recipients = recipients_.getRecipients();
 
@@ -1244,6 +1487,8 @@ void Appender::onCopySent(Status st, ShardID to, const STORE_Header& mhdr) {
   ld_check(replies_expected_ > 0);
 
   if (st == Status::OK) {
+    tracepoints::appenderStoreSent(
+        log_id_, mhdr.rid.lsn(), mhdr.wave, to.node(), payload_.size());
     if (mhdr.flags & STORE_Header::CHAIN) {
       for (auto& r : recipients_.getRecipients()) {
         r.setState(Recipient::State::OUTSTANDING);
@@ -1252,6 +1497,9 @@ void Appender::onCopySent(Status st, ShardID to, const STORE_Header& mhdr) {
       Recipient* r = recipients_.find(to);
       ld_check(r);
       r->setState(Recipient::State::OUTSTANDING);
+      if (latency_trace_ || storeLatencyEstimatesEnabled()) {
+        r->setStoreSentTime(std::chrono::steady_clock::now());
+      }
     }
     ld_spew("STORE message for %s (wave %u) was passed to TCP for delivery to "
             "%s",
@@ -1339,6 +1587,9 @@ int Appender::onReply(const STORED_Header& header,
     worker->getWorkerTimeoutStats().onReply(from, store_hdr_);
   }
 
+  tracepoints::appenderStored(
+      log_id_, header.rid.lsn(), header.wave, from.node(), header.status);
+
   // decrement outstanding responses
   --outstanding_;
   if (header.status == E::OK) {
@@ -1469,6 +1720,21 @@ int Appender::onReply(const STORED_Header& header,
       }
     }
 
+    // Feed the round trip time to the latency estimates used by
+    // latency-aware copyset selection and STORE hedging. With chain-sending
+    // the reply time includes forwarding hops, so it says little about this
+    // shard alone.
+    if (!(store_hdr_.flags & STORE_Header::CHAIN) &&
+        recipient->getStoreSentTime() !=
+            std::chrono::steady_clock::time_point::min() &&
+        storeLatencyEstimatesEnabled()) {
+      copyset_manager_->getNodeSetState()->recordStoreLatency(
+          from,
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() -
+              recipient->getStoreSentTime()));
+    }
+
     onRecipientSucceeded(recipient);
     // `this` may no longer exist here.
     return 0;
@@ -1764,6 +2030,11 @@ void Appender::onRecipientSucceeded(Recipient* recipient) {
   }
 
   ld_check(!reply_sent_);
+  if (latency_trace_) {
+    latency_trace_->replicated = std::chrono::steady_clock::now();
+    latency_trace_->replicated_by = recipient->getShardID();
+    latency_trace_->store_sent = recipient->getStoreSentTime();
+  }
   // record the latency of this append
   HISTOGRAM_ADD(getStats(), append_latency, usec_since(creation_time_));
   int64_t latency_usec = usec_since(creation_time_);
@@ -1799,9 +2070,15 @@ void Appender::onRecipientSucceeded(Recipient* recipient) {
                                  : "invalid");
   }
   sendReply(compose_lsn(store_hdr_.rid.epoch, store_hdr_.rid.esn), E::OK);
+  if (std::find(hedge_recipients_.begin(),
+                hedge_recipients_.end(),
+                recipient->getShardID()) != hedge_recipients_.end()) {
+    STAT_INCR(getStats(), appender_store_hedge_won);
+  }
 
   cancelStoreTimer();
   cancelRetryTimer();
+  cancelHedgeTimer();
 
   if (release_type_ != static_cast<ReleaseTypeRaw>(ReleaseType::INVALID)) {
     // Build the set of recipients to which we should send a RELEASE message
@@ -1853,6 +2130,7 @@ bool Appender::onRecipientFailed(Recipient* recipient,
   // If we won't be able to make progress for this wave.
   cancelStoreTimer();
   cancelRetryTimer();
+  cancelHedgeTimer();
   store_timeout_set_ = false;
 
   // If we have enough nodes, and wave is not too high (threshold 2 is
@@ -1959,9 +2237,13 @@ bool Appender::isDone(uint8_t flag) {
 void Appender::onComplete(bool linked) {
   cancelStoreTimer();
   cancelRetryTimer();
+  cancelHedgeTimer();
 
   if (recipients_.isFullyReplicated()) {
     deleteExtras();
+    if (!hedge_recipients_.empty()) {
+      amendCopysetsAfterHedge();
+    }
   }
 
   // Prevent replies from remaining extras to come back by removing ourselves
@@ -1982,6 +2264,9 @@ void Appender::onComplete(bool linked) {
 
 void Appender::onReaped() {
   ld_check(!isDone(REAPED));
+  if (latency_trace_) {
+    onLatencyTraceDone();
+  }
   auto release_type = static_cast<ReleaseType>(release_type_.load());
   lsn_t lsn = getLSN();
   epoch_t last_released_epoch;
@@ -2117,6 +2402,18 @@ void Appender::activateStoreTimer(std::chrono::milliseconds delay) {
   store_timer_.activate(delay);
 }
 
+void Appender::initHedgeTimer() {
+  hedge_timer_.assign(std::bind(&Appender::onHedgeTimeout, this));
+}
+
+void Appender::activateHedgeTimer(std::chrono::microseconds delay) {
+  hedge_timer_.activate(delay);
+}
+
+void Appender::cancelHedgeTimer() {
+  hedge_timer_.cancel();
+}
+
 void Appender::cancelRetryTimer() {
   retry_timer_.cancel();
 }
@@ -2227,7 +2524,9 @@ StatsHolder* Appender::getStats() {
 
 int Appender::registerOnSocketClosed(NodeID nid, SocketCallback& cb) {
   Sender& sender = Worker::onThisThread()->sender();
-  int rv = sender.registerOnSocketClosed(Address(nid), cb);
+  // STOREs of this log may go over their own connection to nid, see
+  // Sender::selectStripe().
+  int rv = sender.registerOnSocketClosed(Address(nid), cb, log_id_);
   return rv;
 }
 
@@ -2276,6 +2575,73 @@ void Appender::setLogOffset(OffsetMap offset_map) {
   }
 }
 
+void Appender::setLatencyTrace(const AppendLatencyTrace& trace) {
+  ld_check(!started());
+  latency_trace_ = std::make_unique<LatencyTrace>();
+  latency_trace_->trace_id = trace.trace_id;
+  latency_trace_->client_queue_us = trace.client_queue_us;
+  passthru_flags_ |= STORE_Header::LATENCY_TRACE;
+}
+
+void Appender::onStorageLatencyTrace(ShardID from,
+                                     const STORED_LatencyTrace& trace) {
+  // Keep the timings of the copy that completed replication; replies from
+  // extras may still come.
+  if (latency_trace_ &&
+      latency_trace_->replicated == std::chrono::steady_clock::time_point()) {
+    latency_trace_->storage_from = from;
+    latency_trace_->storage = trace;
+  }
+}
+
+void Appender::onLatencyTraceDone() {
+  using namespace std::chrono;
+  const LatencyTrace& t = *latency_trace_;
+  if (t.replicated == steady_clock::time_point()) {
+    // Not fully replicated. Only successful appends get a breakdown.
+    return;
+  }
+  auto us = [](steady_clock::duration d) {
+    return duration_cast<microseconds>(d).count();
+  };
+
+  AppendLatencyBreakdown b;
+  b.time = duration_cast<milliseconds>(system_clock::now().time_since_epoch());
+  b.trace_id = t.trace_id;
+  b.log_id = log_id_;
+  b.lsn = store_hdr_.rid.lsn();
+  b.waves = store_hdr_.wave;
+  b.shard = t.replicated_by;
+  b.client_queue_us = t.client_queue_us;
+  b.sequencer_us = us(t.started - creation_time_);
+  // store_sent isn't set for chain-sent copies, count them from the start
+  auto store_sent = std::max(t.store_sent, t.started);
+  b.store_fanout_us = us(store_sent - t.started);
+  b.storage_queue_us = 0;
+  b.storage_write_us = 0;
+  b.wal_sync_us = 0;
+  if (t.storage_from == t.replicated_by) {
+    b.storage_queue_us = t.storage.queue_us;
+    b.storage_write_us = t.storage.write_us;
+    b.wal_sync_us = t.storage.sync_us;
+  }
+  b.network_us = std::max<int64_t>(0,
+                                   us(t.replicated - store_sent) -
+                                       b.storage_queue_us -
+                                       b.storage_write_us - b.wal_sync_us);
+  b.total_us = us(t.replicated - creation_time_);
+  b.release_us = us(steady_clock::now() - t.replicated);
+  onLatencyBreakdown(b);
+}
+
+void Appender::onLatencyBreakdown(const AppendLatencyBreakdown& breakdown) {
+  // Appenders may be reaped on another Worker; that's where this goes.
+  if (Worker* w = Worker::onThisThread(false)) {
+    w->appendLatencyBreakdowns().add(breakdown);
+  }
+  tracer_.traceLatencyBreakdown(breakdown);
+}
+
 bool Appender::isDraining() const {
   return epoch_sequencer_->getState() == EpochSequencer::State::DRAINING;
 }
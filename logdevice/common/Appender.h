@@ -86,6 +86,8 @@ class Worker;
 enum class ReleaseType : uint8_t;
 struct Address;
 struct APPENDED_Header;
+struct AppendLatencyBreakdown;
+struct AppendLatencyTrace;
 struct Settings;
 
 /**
@@ -638,6 +640,15 @@ class Appender : public IntrusiveUnorderedMapHook {
     can_resume_write_stream_ = can_resume_write_stream;
   }
 
+  // Traces the stages of this append for the latency breakdown, see
+  // AppendLatencyBreakdown. Sets the LATENCY_TRACE flag on passthru_flags_ so
+  // that storage nodes report their part.
+  void setLatencyTrace(const AppendLatencyTrace& trace);
+
+  // Called with the timings from a STORED reply to a traced STORE, right
+  // before onReply() for the same reply.
+  void onStorageLatencyTrace(ShardID from, const STORED_LatencyTrace& trace);
+
  protected:
   // protected: members are for use by test subclasses. This class is not
   // intended to be subclassed other than for testing.
@@ -700,6 +711,9 @@ class Appender : public IntrusiveUnorderedMapHook {
   virtual void cancelRetryTimer();
   virtual void activateRetryTimer();
   virtual bool retryTimerIsActive();
+  virtual void initHedgeTimer();
+  virtual void activateHedgeTimer(std::chrono::microseconds delay);
+  virtual void cancelHedgeTimer();
   virtual bool isNodeAlive(NodeID node);
 
  private:
@@ -711,6 +725,27 @@ class Appender : public IntrusiveUnorderedMapHook {
 
   // AppenderTracer for tracing append operations
   AppenderTracer tracer_;
+
+  // Timestamps of an append sampled for the latency breakdown.
+  struct LatencyTrace {
+    uint64_t trace_id;
+    uint32_t client_queue_us;
+    std::chrono::steady_clock::time_point started;
+    // When the recipient that completed replication was sent its STORE, and
+    // when its STORED came.
+    std::chrono::steady_clock::time_point store_sent;
+    std::chrono::steady_clock::time_point replicated;
+    ShardID replicated_by;
+    // Timings in the last STORED that had them.
+    ShardID storage_from;
+    STORED_LatencyTrace storage{0, 0, 0};
+  };
+
+  // Only allocated if the append is traced.
+  std::unique_ptr<LatencyTrace> latency_trace_;
+
+  // Called when a traced Appender is reaped to collect its breakdown.
+  void onLatencyTraceDone();
   // Worker on whose thread this Appender was created. May be null in tests so
   // Appender should access this through virtual methods of this class so that
   // tests can override them.
@@ -842,6 +877,22 @@ class Appender : public IntrusiveUnorderedMapHook {
   // Note: in tests, this is left uninitialized.
   Timer retry_timer_;
 
+  // timer for hedging STOREs of the current wave, see onHedgeTimeout()
+  // Note: in tests, this is left uninitialized.
+  Timer hedge_timer_;
+
+  // True once onHedgeTimeout() sent a hedge STORE; at most one hedge is sent
+  // per Appender.
+  bool hedged_{false};
+
+  // Recipients added to the current wave by onHedgeTimeout(). Cleared with
+  // every new wave.
+  copyset_custsz_t<4> hedge_recipients_;
+
+  // Time since the current wave was sent at which hedge_timer_ fires (or
+  // last fired). Reset with every new wave.
+  std::chrono::microseconds hedge_elapsed_{0};
+
   // Used to diferentiate if we failed due to an error or a timeout. If we
   // failed with an error we don't want onTimeout to graylist a first node that
   // did not respond.
@@ -1013,6 +1064,50 @@ class Appender : public IntrusiveUnorderedMapHook {
    */
   void onTimeout();
 
+  /**
+   * Called by hedge_timer_ if some STOREs of the current wave have not been
+   * acknowledged within the estimated tail latency of their recipients (see
+   * getHedgeDelay()). If few enough STOREs are outstanding, adds replacement
+   * nodes other than the late ones, picked by
+   * CopySetSelector::augmentExcluding(), to the current wave and sends them
+   * a STORE instead of waiting for the store timeout. STOREDs from the late
+   * nodes and from the replacements all count toward replication. At most
+   * one hedge is sent per Appender.
+   */
+  void onHedgeTimeout();
+
+  /**
+   * Called when the record is fully replicated after a hedge. Copies stored
+   * by recipients that were in the wave before onHedgeTimeout() carry a
+   * copyset without the hedge recipients. If some hedge recipient stored a
+   * copy, sends the others an amend with the full copyset, so that every
+   * copy lists all nodes that have one (e.g. for rebuilding). Replies are
+   * not waited for.
+   */
+  void amendCopysetsAfterHedge();
+
+  /**
+   * Activates hedge_timer_ for the earliest hedge delay among outstanding
+   * recipients of the current wave that is not yet covered by
+   * hedge_elapsed_, if hedging is enabled and that delay is shorter than the
+   * store timeout.
+   */
+  void scheduleHedge();
+
+  /**
+   * @return delay after which an outstanding STORE to @param shard is
+   *         considered late: the tail STORE latency estimate of the shard
+   *         clamped to --store-hedging-delay.
+   */
+  std::chrono::microseconds getHedgeDelay(ShardID shard) const;
+
+  /**
+   * @return true if sequencers keep per-shard STORE latency estimates in
+   *         NodeSetState, i.e. if latency-aware copyset selection or STORE
+   *         hedging, which read them, is enabled.
+   */
+  bool storeLatencyEstimatesEnabled() const;
+
   /**
    * Mark a storage shard as not available in the NodeSetState so that it will
    * not be selected for sending STORE messages for certain amount of time.
@@ -1039,7 +1134,7 @@ class Appender : public IntrusiveUnorderedMapHook {
 
   // try sending waves of STOREs without resetting csm_state_
   // until a complete wave is sent, or copyset selector is unable to select
-  // a copyset
+  // a copyset.
   int trySendingWavesOfStores(const copyset_size_t cfg_synced,
                               const copyset_size_t cfg_extras,
                               const CopySetManager::AppendContext& append_ctx);
@@ -1087,6 +1182,9 @@ class Appender : public IntrusiveUnorderedMapHook {
   virtual int registerOnSocketClosed(NodeID nid, SocketCallback& cb);
   virtual void replyToAppendRequest(APPENDED_Header& replyhdr);
   virtual void schedulePeriodicReleases();
+  // Publishes the latency breakdown of a traced append, see
+  // onLatencyTraceDone().
+  virtual void onLatencyBreakdown(const AppendLatencyBreakdown& breakdown);
 
   // Request that is used to send an E::OK reply back to a client on the worker
   // it received the append message on. Used in onReaped().
@@ -424,6 +424,9 @@ std::unique_ptr<Appender> AppenderPrep::constructAppender() {
         write_stream_rqid_,
         (bool)(header_.flags & APPEND_Header::WRITE_STREAM_RESUME));
   }
+  if (latency_trace_.has_value()) {
+    appender->setLatencyTrace(latency_trace_.value());
+  }
   return appender;
 }
 
@@ -68,6 +68,11 @@ class AppenderPrep : public std::enable_shared_from_this<AppenderPrep> {
     return *this;
   }
 
+  AppenderPrep& setLatencyTrace(const AppendLatencyTrace& trace) {
+    latency_trace_ = trace;
+    return *this;
+  }
+
   void execute();
 
   // Called directly in tests
@@ -167,6 +172,9 @@ class AppenderPrep : public std::enable_shared_from_this<AppenderPrep> {
   write_stream_request_id_t write_stream_rqid_ =
       WRITE_STREAM_REQUEST_ID_INVALID;
 
+  // Latency trace context, if the append was sampled for tracing.
+  folly::Optional<AppendLatencyTrace> latency_trace_;
+
   PayloadHolder payload_;
   // TODO factor away
   APPEND_Header header_;
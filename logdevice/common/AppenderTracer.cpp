@@ -9,6 +9,7 @@
 
 #include <memory>
 
+#include "logdevice/common/AppendLatencyBreakdown.h"
 #include "logdevice/common/ClientID.h"
 #include "logdevice/common/Recipient.h"
 #include "logdevice/common/RecipientSet.h"
@@ -88,4 +89,27 @@ void AppenderTracer::traceAppend(
   publish(APPENDER_TRACER, sample_builder);
 }
 
+void AppenderTracer::traceLatencyBreakdown(const AppendLatencyBreakdown& b) {
+  auto sample_builder = [&]() -> std::unique_ptr<TraceSample> {
+    auto sample = std::make_unique<TraceSample>();
+    sample->addNormalValue("trace_id", std::to_string(b.trace_id));
+    sample->addIntValue("log_id", b.log_id.val());
+    sample->addIntValue("lsn", b.lsn);
+    sample->addIntValue("waves", b.waves);
+    sample->addNormalValue("shard", b.shard.toString());
+    sample->addIntValue("client_queue_us", b.client_queue_us);
+    sample->addIntValue("sequencer_us", b.sequencer_us);
+    sample->addIntValue("store_fanout_us", b.store_fanout_us);
+    sample->addIntValue("network_us", b.network_us);
+    sample->addIntValue("storage_queue_us", b.storage_queue_us);
+    sample->addIntValue("storage_write_us", b.storage_write_us);
+    sample->addIntValue("wal_sync_us", b.wal_sync_us);
+    sample->addIntValue("total_us", b.total_us);
+    sample->addIntValue("release_us", b.release_us);
+    return sample;
+  };
+
+  publish(APPENDER_LATENCY_TRACER, sample_builder, /* force */ true);
+}
+
 }} // namespace facebook::logdevice
@@ -16,9 +16,11 @@ namespace facebook { namespace logdevice {
 
 class TraceLogger;
 class RecipientSet;
+struct AppendLatencyBreakdown;
 struct ClientID;
 
 constexpr auto APPENDER_TRACER = "appender";
+constexpr auto APPENDER_LATENCY_TRACER = "appender_latency";
 
 class AppenderTracer : SampledTracer {
  public:
@@ -38,6 +40,10 @@ class AppenderTracer : SampledTracer {
                    uint32_t waves,
                    std::string client_status,
                    std::string internal_status);
+
+  // Publishes the breakdown of a traced append. These are sampled by the
+  // client, so they are always published.
+  void traceLatencyBreakdown(const AppendLatencyBreakdown& breakdown);
 };
 
 }} // namespace facebook::logdevice
@@ -45,4 +45,27 @@ void ClientAppendTracer::traceAppend(const logid_t log_id,
   publish(CLIENT_APPEND_TRACER, sample_builder);
 }
 
+void ClientAppendTracer::traceAppendLatency(uint64_t trace_id,
+                                            logid_t log_id,
+                                            lsn_t lsn,
+                                            Status client_request_status,
+                                            int64_t client_queue_usec,
+                                            int64_t latency_usec,
+                                            NodeID sequencer) {
+  auto sample_builder = [=]() -> std::unique_ptr<TraceSample> {
+    auto sample = std::make_unique<TraceSample>();
+    sample->addNormalValue("trace_id", std::to_string(trace_id));
+    sample->addNormalValue("log_id", std::to_string(log_id.val()));
+    sample->addNormalValue("lsn", lsn_to_string(lsn));
+    sample->addNormalValue(
+        "client_status_code", std::string(error_name(client_request_status)));
+    sample->addIntValue("client_queue_us", client_queue_usec);
+    sample->addIntValue("latency_us", latency_usec);
+    sample->addNormalValue("sequencer_node", sequencer.toString());
+    return sample;
+  };
+  // Sampling was already decided when the append was created.
+  publish(CLIENT_APPEND_LATENCY_TRACER, sample_builder, /* force */ true);
+}
+
 }} // namespace facebook::logdevice
@@ -19,6 +19,7 @@ namespace facebook { namespace logdevice {
 class TraceLogger;
 
 constexpr auto CLIENT_APPEND_TRACER = "client_append_tracer";
+constexpr auto CLIENT_APPEND_LATENCY_TRACER = "client_append_latency";
 
 class ClientAppendTracer : SampledTracer {
  public:
@@ -33,6 +34,19 @@ class ClientAppendTracer : SampledTracer {
                    int64_t latency_usec,
                    lsn_t previous_lsn,
                    NodeID sequencer);
+
+  // Client side of the latency breakdown of an append sampled according to
+  // Settings::append_latency_breakdown_sample_rate. Always published; join
+  // with the sequencer's "appender_latency" samples on trace_id. Time spent
+  // on the network is latency_usec - client_queue_usec - the sequencer's
+  // total_us.
+  void traceAppendLatency(uint64_t trace_id,
+                          logid_t log_id,
+                          lsn_t lsn,
+                          Status client_request_status,
+                          int64_t client_queue_usec,
+                          int64_t latency_usec,
+                          NodeID sequencer);
 };
 
 }} // namespace facebook::logdevice
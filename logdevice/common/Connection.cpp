@@ -10,6 +10,7 @@
 
 #include <algorithm>
 #include <errno.h>
+#include <fcntl.h>
 #include <functional>
 #include <memory>
 
@@ -33,13 +34,16 @@
 #include "logdevice/common/FlowGroup.h"
 #include "logdevice/common/ProtocolHandler.h"
 #include "logdevice/common/ResourceBudget.h"
+#include "logdevice/common/SSLFetcher.h"
 #include "logdevice/common/SocketCallback.h"
 #include "logdevice/common/SocketDependencies.h"
 #include "logdevice/common/debug.h"
 #include "logdevice/common/libevent/compat.h"
+#include "logdevice/common/network/IOBufArena.h"
 #include "logdevice/common/network/MessageReader.h"
 #include "logdevice/common/network/SocketAdapter.h"
 #include "logdevice/common/network/SocketConnectCallback.h"
+#include "logdevice/common/protocol/COMPRESSED_Message.h"
 #include "logdevice/common/protocol/Compatibility.h"
 #include "logdevice/common/protocol/Message.h"
 #include "logdevice/common/protocol/MessageTypeNames.h"
@@ -121,8 +125,7 @@ Connection::Connection(std::unique_ptr<SocketDependencies>& deps,
       end_stream_rewind_event_(deps_->getEvBase()),
       buffered_output_flush_event_(deps_->getEvBase()),
       legacy_connection_(deps_->attachedToLegacyEventBase()),
-      retry_receipt_of_message_(deps_->getEvBase()),
-      sched_write_chain_(deps_->getEvBase()) {
+      retry_receipt_of_message_(deps_->getEvBase()) {
   conntype_ = conntype;
 
   if (!peer_sockaddr.valid()) {
@@ -297,6 +300,7 @@ Connection::Connection(int fd,
   // Set the read callback.
   read_cb_.reset(new MessageReader(*proto_handler_, proto_));
   proto_handler_->sock()->setReadCB(read_cb_.get());
+  enableZeroCopy();
 }
 
 void Connection::onBufferedOutputWrite(struct evbuffer* buffer,
@@ -674,6 +678,7 @@ int Connection::connect() {
         transitionToConnected();
         read_cb_.reset(new MessageReader(*proto_handler_, proto_));
         proto_handler_->sock()->setReadCB(read_cb_.get());
+        enableZeroCopy();
       }
     };
 
@@ -1391,8 +1396,14 @@ void Connection::close(Status reason) {
                                   /* message_type */ folly::none);
     }
     sock_write_cb_.clear();
+    // Zero-copy writes still pinned were accounted as drained above.
+    zerocopy_bytes_pinned_ = 0;
+    if (zerocopy_owner_) {
+      *zerocopy_owner_ = nullptr;
+      zerocopy_owner_.reset();
+    }
     sendChain_.reset();
-    sched_write_chain_.cancelTimeout();
+    sched_write_chain_.cancelLoopCallback();
     // Invoke closeNow to close the socket.
     proto_handler_->sock()->closeNow();
   }
@@ -1522,14 +1533,20 @@ bool Connection::isChecksummingEnabled(MessageType msgtype) {
   return msg_checksum_set.find((char)msgtype) == msg_checksum_set.end();
 }
 
-std::unique_ptr<folly::IOBuf> Connection::serializeMessage(const Message& msg) {
+std::unique_ptr<folly::IOBuf>
+Connection::serializeMessage(const Message& msg, size_t size_hint) {
   const bool compute_checksum =
       ProtocolHeader::needChecksumInHeader(msg.type_, proto_) &&
       isChecksummingEnabled(msg.type_);
 
   const size_t protohdr_bytes = ProtocolHeader::bytesNeeded(msg.type_, proto_);
-  auto io_buf = folly::IOBuf::create(IOBUF_ALLOCATION_UNIT);
-  ld_check(protohdr_bytes <= IOBUF_ALLOCATION_UNIT);
+  // With an exact hint the whole message fits in one buffer. Otherwise
+  // ProtocolWriter appends more buffers as needed.
+  const size_t capacity =
+      std::max(protohdr_bytes, size_hint ? size_hint : IOBUF_ALLOCATION_UNIT);
+  IOBufArena* arena = deps_->getSerializationArena();
+  auto io_buf =
+      arena ? arena->allocate(capacity) : folly::IOBuf::create(capacity);
   io_buf->advance(protohdr_bytes);
 
   ProtocolWriter writer(msg.type_, io_buf.get(), proto_);
@@ -1552,6 +1569,22 @@ std::unique_ptr<folly::IOBuf> Connection::serializeMessage(const Message& msg) {
   protohdr.cksum = compute_checksum ? writer.computeChecksum() : 0;
   protohdr.cksum += shouldTamperChecksum(); // For Tests only
   protohdr.type = msg.type_;
+
+  if (compressor_ && shouldCompress(msg, bodylen)) {
+    // The checksum of the original body travels in the COMPRESSED header and
+    // is verified once the recipient decompressed it.
+    ld_check_eq(protohdr_bytes,
+                ProtocolHeader::bytesNeeded(MessageType::COMPRESSED, proto_));
+    io_buf = compressMessageBody(protohdr, protohdr_bytes, *io_buf);
+    if (!io_buf) {
+      err = E::INTERNAL;
+      close(err);
+      return nullptr;
+    }
+    protohdr.cksum = 0;
+    protohdr.type = MessageType::COMPRESSED;
+  }
+
   io_buf->prepend(protohdr_bytes);
   protohdr.len = io_buf->computeChainDataLength();
 
@@ -1560,7 +1593,7 @@ std::unique_ptr<folly::IOBuf> Connection::serializeMessage(const Message& msg) {
 }
 
 Connection::SendStatus
-Connection::sendBuffer(std::unique_ptr<folly::IOBuf>&& io_buf) {
+Connection::sendBuffer(std::unique_ptr<folly::IOBuf>&& io_buf, bool urgent) {
   if (legacy_connection_) {
     struct evbuffer* outbuf =
         buffered_output_ ? buffered_output_ : deps_->getOutput(bev_);
@@ -1581,15 +1614,20 @@ Connection::sendBuffer(std::unique_ptr<folly::IOBuf>&& io_buf) {
         return Connection::SendStatus::ERROR;
       }
     }
+    if (urgent && buffered_output_) {
+      flushBufferedOutput();
+    }
   } else if (proto_handler_->good()) { // Sending data over new connection.
+    // Urgent messages are batched too: writing them right away would complete
+    // the messages ahead of them (onSent()) from within sendMessage(). The
+    // batch is written before the event loop waits for more events anyway.
     if (sendChain_) {
-      ld_check(sched_write_chain_.isScheduled());
+      ld_check(sched_write_chain_.isLoopCallbackScheduled());
       sendChain_->prependChain(std::move(io_buf));
     } else {
       sendChain_ = std::move(io_buf);
-      ld_check(!sched_write_chain_.isScheduled());
-      sched_write_chain_.attachCallback([this]() { scheduleWriteChain(); });
-      sched_write_chain_.scheduleTimeout(0);
+      ld_check(!sched_write_chain_.isLoopCallbackScheduled());
+      deps_->getEvBase()->getEventBase()->runInLoop(&sched_write_chain_);
       sched_start_time_ = SteadyTimestamp::now();
     }
   }
@@ -1609,31 +1647,97 @@ void Connection::scheduleWriteChain() {
            to_msec(now - sched_start_time_).count());
 
   // Get bytes that are added to sendq but not yet added in the asyncSocket.
-  auto bytes_in_sendq = getBufferedBytesSize() - sock_write_cb_.bytes_buffered;
-  sock_write_cb_.write_chains.emplace_back(
-      SocketWriteCallback::WriteUnit{bytes_in_sendq, now});
-  // These bytes are now buffered in socket and will be removed from sendq.
-  sock_write_cb_.bytes_buffered += bytes_in_sendq;
-  proto_handler_->sock()->writeChain(&sock_write_cb_, std::move(sendChain_));
+  auto bytes_in_sendq = getBufferedBytesSize() - sock_write_cb_.bytes_buffered -
+      zerocopy_bytes_pinned_;
+
+  const size_t zerocopy_threshold =
+      zerocopy_owner_ ? getSettings().zerocopy_send_threshold : 0;
+  if (zerocopy_threshold == 0) {
+    writeChainToSocket(std::move(sendChain_), bytes_in_sendq, now, false);
+  } else {
+    // Large buffers (typically payloads of RECORDs and STOREs, which are
+    // cloned into the chain rather than copied) are written on their own
+    // without copying them into the socket buffer. Runs of smaller buffers in
+    // between are written as usual. AsyncSocket keeps the writes in order.
+    std::unique_ptr<folly::IOBuf> small;
+    size_t small_len = 0;
+    size_t total_len = 0;
+    std::unique_ptr<folly::IOBuf> buf = std::move(sendChain_);
+    while (buf) {
+      std::unique_ptr<folly::IOBuf> next = buf->pop();
+      const size_t len = buf->length();
+      total_len += len;
+      if (len >= zerocopy_threshold) {
+        if (small) {
+          writeChainToSocket(std::move(small), small_len, now, false);
+          small_len = 0;
+        }
+        writeChainToSocket(std::move(buf), len, now, true);
+      } else if (len > 0) {
+        small_len += len;
+        if (small) {
+          small->prependChain(std::move(buf));
+        } else {
+          small = std::move(buf);
+        }
+      }
+      buf = std::move(next);
+    }
+    if (small) {
+      writeChainToSocket(std::move(small), small_len, now, false);
+    }
+    ld_check_eq(total_len, bytes_in_sendq);
+  }
   // All the bytes will be now removed from sendq now that we have written into
   // the asyncsocket.
   onBytesAdmittedToSend(bytes_in_sendq);
 }
 
+void Connection::writeChainToSocket(std::unique_ptr<folly::IOBuf> chain,
+                                    size_t len,
+                                    SteadyTimestamp now,
+                                    bool zerocopy) {
+  // The socket holds on to a zero-copy chain until the kernel is done with
+  // it; the marker appended to the chain tells us when that is.
+  folly::WriteFlags flags = folly::WriteFlags::NONE;
+  std::shared_ptr<ZeroCopyWrite> zerocopy_write;
+  if (zerocopy) {
+    ld_check(zerocopy_owner_);
+    zerocopy_write = std::make_shared<ZeroCopyWrite>(len, zerocopy_owner_);
+    chain->prependChain(folly::IOBuf::takeOwnership(
+        new std::shared_ptr<ZeroCopyWrite>(zerocopy_write),
+        0,
+        &Connection::releaseZeroCopyWrite));
+    flags = folly::WriteFlags::WRITE_MSG_ZEROCOPY;
+    STAT_INCR(deps_->getStats(), sock_zerocopy_writes);
+    STAT_ADD(deps_->getStats(), sock_zerocopy_bytes, len);
+  }
+
+  ++num_socket_writes_;
+  num_bytes_in_socket_writes_ += len;
+  sock_write_cb_.write_chains.emplace_back(
+      SocketWriteCallback::WriteUnit{len, now, std::move(zerocopy_write)});
+  // These bytes are now buffered in socket and will be removed from sendq.
+  sock_write_cb_.bytes_buffered += len;
+  proto_handler_->sock()->writeChain(&sock_write_cb_, std::move(chain), flags);
+}
+
 int Connection::serializeMessage(std::unique_ptr<Envelope>&& envelope) {
   // We should only write to the output buffer once connected.
   ld_check(connected_);
 
   const auto& msg = envelope->message();
 
-  std::unique_ptr<folly::IOBuf> serialized_buf = serializeMessage(msg);
+  std::unique_ptr<folly::IOBuf> serialized_buf =
+      serializeMessage(msg, envelope->copiedBytes());
 
   if (serialized_buf == nullptr) {
     return -1;
   }
 
   const auto msglen = serialized_buf->computeChainDataLength();
-  Connection::SendStatus status = sendBuffer(std::move(serialized_buf));
+  Connection::SendStatus status = sendBuffer(
+      std::move(serialized_buf), envelope->priority() == Priority::MAX);
   if (status == Connection::SendStatus::ERROR) {
     RATELIMIT_CRITICAL(std::chrono::seconds(1),
                        2,
@@ -1939,6 +2043,8 @@ void Connection::bytesSentCallback(struct evbuffer* buffer,
   ld_check(buffer == self->deps_->getOutput(self->bev_));
   STAT_INCR(self->deps_->getStats(), sock_write_events);
   if (info->n_deleted > 0) {
+    ++self->num_socket_writes_;
+    self->num_bytes_in_socket_writes_ += info->n_deleted;
     self->onBytesAdmittedToSend(info->n_deleted);
   }
 }
@@ -2037,17 +2143,25 @@ void Connection::drainSendQueue() {
   auto g = folly::makeGuard(deps_->setupContextGuard());
   ld_check(!legacy_connection_);
   auto& cb = sock_write_cb_;
+  size_t total_bytes_written = 0;
   size_t total_bytes_drained = 0;
   for (size_t& i = cb.num_success; i > 0; --i) {
-    total_bytes_drained += cb.write_chains.front().length;
-    STAT_ADD(deps_->getStats(),
-             sock_write_sched_size,
-             cb.write_chains.front().length);
+    auto& unit = cb.write_chains.front();
+    total_bytes_written += unit.length;
+    STAT_ADD(deps_->getStats(), sock_write_sched_size, unit.length);
+    if (unit.zerocopy && !unit.zerocopy->released) {
+      // The kernel may still be reading from the memory of this write. Keep
+      // it accounted for until the socket releases it.
+      unit.zerocopy->written = true;
+      zerocopy_bytes_pinned_ += unit.length;
+    } else {
+      total_bytes_drained += unit.length;
+    }
     cb.write_chains.pop_front();
   }
 
-  ld_check(cb.bytes_buffered >= total_bytes_drained);
-  cb.bytes_buffered -= total_bytes_drained;
+  ld_check(cb.bytes_buffered >= total_bytes_written);
+  cb.bytes_buffered -= total_bytes_written;
   onBytesPassedToTCP(total_bytes_drained);
 
   // flushOutputAndClose sets close_reason_ and waits for all buffers to drain.
@@ -2059,6 +2173,161 @@ void Connection::drainSendQueue() {
   }
 }
 
+void Connection::enableZeroCopy() {
+  ld_check(!legacy_connection_);
+  if (getSettings().zerocopy_send_threshold == 0 || isSSL()) {
+    return;
+  }
+  if (!proto_handler_->sock()->setZeroCopy(true)) {
+    RATELIMIT_INFO(std::chrono::seconds(10),
+                   1,
+                   "Could not enable MSG_ZEROCOPY on socket %s, large writes "
+                   "will be copied",
+                   conn_description_.c_str());
+    return;
+  }
+  zerocopy_owner_ = std::make_shared<Connection*>(this);
+}
+
+void Connection::releaseZeroCopyWrite(void* buf, void* /* userData */) {
+  std::unique_ptr<std::shared_ptr<ZeroCopyWrite>> holder(
+      static_cast<std::shared_ptr<ZeroCopyWrite>*>(buf));
+  ZeroCopyWrite& write = **holder;
+  write.released = true;
+  // Otherwise drainSendQueue() will account for the write once it processes
+  // its writeSuccess().
+  if (write.written && *write.owner) {
+    (*write.owner)->onZeroCopyWriteDone(write.length);
+  }
+}
+
+void Connection::onZeroCopyWriteDone(size_t nbytes) {
+  auto g = folly::makeGuard(deps_->setupContextGuard());
+  ld_check(zerocopy_bytes_pinned_ >= nbytes);
+  zerocopy_bytes_pinned_ -= nbytes;
+  onBytesPassedToTCP(nbytes);
+}
+
+int Connection::enableCompression() {
+  ld_check(!compressor_ && !decompressor_);
+  compressor_ =
+      StreamCompressor::create(getSettings().connection_compression_level);
+  decompressor_ = StreamDecompressor::create();
+  if (!compressor_ || !decompressor_) {
+    ld_error("Failed to set up compression of connection %s: %s",
+             conn_description_.c_str(),
+             error_description(err));
+    compressor_.reset();
+    decompressor_.reset();
+    return -1;
+  }
+  STAT_INCR(deps_->getStats(), sock_compression_negotiated);
+  return 0;
+}
+
+bool Connection::shouldCompress(const Message& msg, size_t bodylen) {
+  if (isHandshakeMessage(msg.type_) || msg.hasBufferedWriterPayload() ||
+      bodylen < getSettings().connection_compression_min_size) {
+    return false;
+  }
+  auto config = deps_->getServerConfig();
+  return config &&
+      config->getTrafficShapingConfig().compressed_traffic_classes.count(
+          msg.tc_);
+}
+
+std::unique_ptr<folly::IOBuf>
+Connection::compressMessageBody(const ProtocolHeader& protohdr,
+                                size_t protohdr_bytes,
+                                const folly::IOBuf& body) {
+  const StreamCompressionStats before = compressor_->getStats();
+  auto compressed = compressor_->compress(body);
+  if (!compressed) {
+    RATELIMIT_CRITICAL(std::chrono::seconds(1),
+                       2,
+                       "INTERNAL ERROR: Failed to compress a message of type "
+                       "%s for %s",
+                       messageTypeNames()[protohdr.type].c_str(),
+                       conn_description_.c_str());
+    return nullptr;
+  }
+  const StreamCompressionStats& after = compressor_->getStats();
+  STAT_INCR(deps_->getStats(), sock_compressed_messages_sent);
+  STAT_ADD(deps_->getStats(),
+           sock_compressed_raw_bytes_sent,
+           after.raw_bytes - before.raw_bytes);
+  STAT_ADD(deps_->getStats(),
+           sock_compressed_bytes_sent,
+           after.compressed_bytes - before.compressed_bytes);
+  STAT_ADD(deps_->getStats(),
+           sock_compression_usec,
+           (after.time - before.time).count());
+
+  COMPRESSED_Header hdr{protohdr.type,
+                        protohdr.cksum,
+                        static_cast<uint32_t>(after.raw_bytes -
+                                              before.raw_bytes)};
+  auto io_buf =
+      folly::IOBuf::create(protohdr_bytes + sizeof(COMPRESSED_Header));
+  io_buf->advance(protohdr_bytes);
+  memcpy(io_buf->writableTail(), &hdr, sizeof(hdr));
+  io_buf->append(sizeof(hdr));
+  io_buf->prependChain(std::move(compressed));
+  return io_buf;
+}
+
+int Connection::readCompressedHeader(const folly::IOBuf& body,
+                                     COMPRESSED_Header* out) {
+  if (!decompressor_) {
+    ld_error("PROTOCOL ERROR: got a COMPRESSED message from %s, which did "
+             "not negotiate compression",
+             conn_description_.c_str());
+    err = E::PROTO;
+    return -1;
+  }
+  folly::io::Cursor cursor(&body);
+  if (!cursor.tryPull(out, sizeof(*out)) || isHandshakeMessage(out->type) ||
+      out->type == MessageType::COMPRESSED ||
+      out->uncompressed_len > Message::MAX_LEN) {
+    ld_error("PROTOCOL ERROR: got an invalid COMPRESSED message from %s",
+             conn_description_.c_str());
+    err = E::BADMSG;
+    return -1;
+  }
+  return 0;
+}
+
+std::unique_ptr<folly::IOBuf>
+Connection::decompressMessageBody(const COMPRESSED_Header& hdr,
+                                  const folly::IOBuf& body) {
+  ld_check(decompressor_);
+  folly::io::Cursor cursor(&body);
+  cursor.skip(sizeof(hdr));
+
+  const StreamCompressionStats before = decompressor_->getStats();
+  auto decompressed = decompressor_->decompress(cursor, hdr.uncompressed_len);
+  if (!decompressed) {
+    ld_error("PROTOCOL ERROR: failed to decompress a message of type %s "
+             "received from %s",
+             messageTypeNames()[hdr.type].c_str(),
+             conn_description_.c_str());
+    err = E::BADMSG;
+    return nullptr;
+  }
+  const StreamCompressionStats& after = decompressor_->getStats();
+  STAT_INCR(deps_->getStats(), sock_compressed_messages_received);
+  STAT_ADD(deps_->getStats(),
+           sock_compressed_raw_bytes_received,
+           after.raw_bytes - before.raw_bytes);
+  STAT_ADD(deps_->getStats(),
+           sock_compressed_bytes_received,
+           after.compressed_bytes - before.compressed_bytes);
+  STAT_ADD(deps_->getStats(),
+           sock_decompression_usec,
+           (after.time - before.time).count());
+  return decompressed;
+}
+
 void Connection::deferredEventQueueEventCallback(void* instance, short) {
   auto self = reinterpret_cast<Connection*>(instance);
   self->processDeferredEventQueue();
@@ -2330,6 +2599,10 @@ bool Connection::processHandshakeMessage(const Message* msg) {
   ld_assert(proto_ <= getSettings().max_protocol);
   ld_spew("%s negotiated protocol %d", conn_description_.c_str(), proto_);
 
+  if (deps_->compressionNegotiated(msg, proto_) && enableCompression() != 0) {
+    return false;
+  }
+
   // Now that we know what protocol we are speaking with the other end,
   // we can serialize pending messages. Messages that are not compatible
   // with the protocol will not be sent.
@@ -2343,10 +2616,23 @@ int Connection::dispatchMessageBody(ProtocolHeader header,
   auto g = folly::makeGuard(deps_->setupContextGuard());
   recv_message_ph_ = header;
   ProtocolHeader& ph = recv_message_ph_;
+
+  // A COMPRESSED message is processed as the message it wraps. Only its
+  // header is looked at until we know the message will be processed now:
+  // decompressing advances the stream, so it must happen exactly once.
+  folly::Optional<COMPRESSED_Header> compressed;
+  if (ph.type == MessageType::COMPRESSED) {
+    compressed.emplace();
+    if (readCompressedHeader(*inbuf, compressed.get_pointer()) != 0) {
+      return -1;
+    }
+  }
+  const MessageType type = compressed ? compressed->type : ph.type;
+
   // Tell the Worker that we're processing a message, so it can time it.
   // The time will include message's deserialization, checksumming,
   // onReceived, destructor and Socket's processing overhead.
-  RunContext run_context(ph.type);
+  RunContext run_context(type);
   deps_->onStartedRunning(run_context);
   SCOPE_EXIT {
     deps_->onStoppedRunning(run_context);
@@ -2354,11 +2640,12 @@ int Connection::dispatchMessageBody(ProtocolHeader header,
 
   size_t protocol_bytes_already_read =
       ProtocolHeader::bytesNeeded(ph.type, proto_);
-  size_t payload_size = ph.len - protocol_bytes_already_read;
+  size_t payload_size = compressed ? compressed->uncompressed_len
+                                   : ph.len - protocol_bytes_already_read;
 
   // Request reservation to add this message into the system.
   auto resource_token = deps_->getResourceToken(payload_size);
-  if (!resource_token && !shouldBeInlined(ph.type)) {
+  if (!resource_token && !shouldBeInlined(type)) {
     RATELIMIT_ERROR(std::chrono::seconds(1),
                     1,
                     "INTERNAL ERROR: message of type %s received from peer "
@@ -2377,6 +2664,8 @@ int Connection::dispatchMessageBody(ProtocolHeader header,
             if (proto_handler_->dispatchMessageBody(hdr, std::move(payload)) ==
                 0) {
               proto_handler_->sock()->setReadCB(read_cb_.get());
+              // Messages received along with this one.
+              read_cb_->dispatchBufferedMessages();
             }
           });
       retry_receipt_of_message_.scheduleTimeout(0);
@@ -2385,10 +2674,22 @@ int Connection::dispatchMessageBody(ProtocolHeader header,
     return -1;
   }
 
+  const message_len_t wire_len = ph.len;
+  if (compressed) {
+    inbuf = decompressMessageBody(*compressed, *inbuf);
+    if (!inbuf) {
+      return -1;
+    }
+    ph.type = compressed->type;
+    ph.cksum = compressed->cksum;
+    ph.len = ProtocolHeader::bytesNeeded(ph.type, proto_) +
+        compressed->uncompressed_len;
+  }
+
   ProtocolReader reader(ph.type, std::move(inbuf), proto_);
 
   ++num_messages_received_;
-  num_bytes_received_ += ph.len;
+  num_bytes_received_ += wire_len;
   expectProtocolHeader();
 
   // 1. compute and verify checksum in header.
@@ -2466,11 +2767,20 @@ int Connection::dispatchMessageBody(ProtocolHeader header,
     handshaken_ = true;
     first_attempt_ = false;
     handshake_timeout_event_.cancelTimeout();
+    // The TLS handshake is long done by now.
+    if (isSSL() && getSettings().ssl_ktls) {
+      if (isKernelTlsEnabled()) {
+        STAT_INCR(deps_->getStats(), ssl_ktls_connections);
+      } else {
+        STAT_INCR(deps_->getStats(), ssl_ktls_fallbacks);
+      }
+    }
   }
 
   MESSAGE_TYPE_STAT_INCR(deps_->getStats(), ph.type, message_received);
   TRAFFIC_CLASS_STAT_INCR(deps_->getStats(), msg->tc_, messages_received);
-  TRAFFIC_CLASS_STAT_ADD(deps_->getStats(), msg->tc_, bytes_received, ph.len);
+  TRAFFIC_CLASS_STAT_ADD(
+      deps_->getStats(), msg->tc_, bytes_received, wire_len);
 
   ld_spew("Received message %s of size %u bytes from %s",
           messageTypeNames()[ph.type].c_str(),
@@ -2479,8 +2789,19 @@ int Connection::dispatchMessageBody(ProtocolHeader header,
 
   // 4. Dispatch message to state machines for processing.
 
+  // The time spent is only needed for --client-connection-rebalancing.
+  const bool track_cpu_time = getSettings().client_connection_rebalancing;
+  std::chrono::steady_clock::time_point dispatch_start;
+  if (track_cpu_time) {
+    dispatch_start = std::chrono::steady_clock::now();
+  }
   Message::Disposition disp = deps_->onReceived(
       msg.get(), peer_name_, principal_, std::move(resource_token));
+  if (track_cpu_time) {
+    last_message_received_time_ = std::chrono::steady_clock::now();
+    cpu_time_ += std::chrono::duration_cast<std::chrono::microseconds>(
+        last_message_received_time_ - dispatch_start);
+  }
 
   // 5. Dispose off message according to state machine's request.
   switch (disp) {
@@ -2672,13 +2993,99 @@ size_t Connection::getBufferedBytesSize() const {
   // This covers the bytes in sendq or in sendChain_ for asyncSocket based
   // implementation.
   size_t buffered_bytes = next_pos_ - drain_pos_;
-  // This covers the bytes buffered in asyncsocket.
+  // This covers the bytes buffered in asyncsocket, and the bytes of zero-copy
+  // writes the kernel has not released yet.
   if (!legacy_connection_) {
-    buffered_bytes += sock_write_cb_.bytes_buffered;
+    buffered_bytes += sock_write_cb_.bytes_buffered + zerocopy_bytes_pinned_;
   }
   return buffered_bytes;
 }
 
+bool Connection::canMigrate() const {
+  // SSL and compression keep stream state that can't be handed over. Unix
+  // socket connections may be using the shared memory transport.
+  if (isClosed() || !handshaken_ || !peerIsClient() || isSSL() ||
+      compressor_ != nullptr || peer_sockaddr_.isUnixAddress()) {
+    return false;
+  }
+  // Other adapters (e.g. io_uring) may shut the socket down on close or have
+  // a receive in flight, either of which would break the duplicated fd.
+  if (!legacy_connection_ && !proto_handler_->sock()->canDetachFd()) {
+    return false;
+  }
+
+  // Nothing may be partially read, or waiting to be processed or sent.
+  if (!pendingq_.empty() || !serializeq_.empty() || !sendq_.empty() ||
+      getBufferedBytesSize() > 0 || msg_pending_processing_ ||
+      !expecting_header_ || !deferred_event_queue_.empty()) {
+    return false;
+  }
+  if (legacy_connection_) {
+    if (LD_EV(evbuffer_get_length)(deps_->getInput(bev_)) > 0 ||
+        (buffered_output_ &&
+         LD_EV(evbuffer_get_length)(buffered_output_) > 0)) {
+      return false;
+    }
+  } else if (read_cb_ == nullptr || read_cb_->hasBufferedData()) {
+    return false;
+  }
+
+  // Anybody else watching for the connection to close or holding on to it
+  // (e.g. read streams) expects it to stay where it is.
+  return impl_->on_close_.size() <= 1 && conn_closed_.use_count() == 1 &&
+      socket_ref_holder_.use_count() <= 1;
+}
+
+int Connection::detachForMigration(ConnectionMigrationState* out) {
+  ld_check(canMigrate());
+  ld_check(out);
+
+  // Our copy of the socket gets closed with this Connection, the duplicate
+  // keeps the TCP connection open.
+  int fd = fcntl(fd_, F_DUPFD_CLOEXEC, 0);
+  if (fd < 0) {
+    ld_error("Failed to duplicate fd %d of %s to move it to another worker: "
+             "errno=%d (%s)",
+             fd_,
+             conn_description_.c_str(),
+             errno,
+             strerror(errno));
+    err = E::SYSLIMIT;
+    return -1;
+  }
+
+  out->fd = fd;
+  out->client_addr = peer_sockaddr_;
+  out->conn_token = std::move(conn_incoming_token_);
+  out->conn_external_token = std::move(conn_external_token_);
+  out->type = type_;
+  out->conntype = conntype_;
+  out->proto = proto_;
+  out->peer_config_version = peer_config_version_;
+  out->principal = principal_;
+  out->csid = csid_;
+  out->peer_location = peer_location_;
+
+  close(E::SHUTDOWN);
+  return 0;
+}
+
+void Connection::restoreFromMigration(ConnectionMigrationState& state) {
+  ld_check(!handshaken_);
+  ld_check(peer_name_.isClientAddress());
+
+  conn_external_token_ = std::move(state.conn_external_token);
+  proto_ = state.proto;
+  peer_config_version_ = state.peer_config_version;
+  principal_ = std::move(state.principal);
+  csid_ = std::move(state.csid);
+  peer_location_ = std::move(state.peer_location);
+
+  handshaken_ = true;
+  first_attempt_ = false;
+  handshake_timeout_event_.cancelTimeout();
+}
+
 void Connection::handshakeTimeoutCallback(void* arg, short) {
   reinterpret_cast<Connection*>(arg)->onHandshakeTimeout();
 }
@@ -2745,6 +3152,13 @@ void Connection::getDebugInfo(InfoSocketsTable& table) const {
   auto total_busy_time = health_stats_.busy_time_.count();
   auto total_rwnd_limited_time = health_stats_.rwnd_limited_time_.count();
   auto total_sndbuf_limited_time = health_stats_.sndbuf_limited_time_.count();
+  const StreamCompressionStats compression_out =
+      compressor_ ? compressor_->getStats() : StreamCompressionStats();
+  const StreamCompressionStats compression_in =
+      decompressor_ ? decompressor_->getStats() : StreamCompressionStats();
+  auto ratio = [](const StreamCompressionStats& s) {
+    return s.compressed_bytes == 0 ? 0 : 1.0 * s.raw_bytes / s.compressed_bytes;
+  };
   table.next()
       .set<0>(state)
       .set<1>(deps_->describeConnection(peer_name_))
@@ -2765,7 +3179,15 @@ void Connection::getDebugInfo(InfoSocketsTable& table) const {
       .set<12>(this->getTcpSendBufSize())
       .set<13>(getPeerConfigVersion().val())
       .set<14>(isSSL())
-      .set<15>(fd_);
+      .set<15>(fd_)
+      .set<16>(compressor_ != nullptr)
+      .set<17>(ratio(compression_out))
+      .set<18>(ratio(compression_in))
+      .set<19>((compression_out.time + compression_in.time).count() / 1000.0)
+      .set<20>(num_socket_writes_)
+      .set<21>(num_socket_writes_ == 0
+                   ? 0
+                   : 1.0 * num_bytes_in_socket_writes_ / num_socket_writes_);
 }
 
 bool Connection::peerIsClient() const {
@@ -2789,6 +3211,15 @@ folly::ssl::X509UniquePtr Connection::getPeerCert() const {
   return nullptr;
 }
 
+bool Connection::isKernelTlsEnabled() const {
+  ld_check(isSSL());
+
+  if (legacy_connection_) {
+    return logdevice::isKernelTlsEnabled(bufferevent_openssl_get_ssl(bev_));
+  }
+  return proto_handler_->sock()->isKernelTlsEnabled();
+}
+
 SocketDrainStatusType
 Connection::getSlowSocketReason(unsigned* net_ltd_pct,
                                 unsigned* rwnd_ltd_pct,
@@ -10,12 +10,14 @@
 #include <chrono>
 #include <deque>
 #include <memory>
+#include <utility>
 
 #include <folly/Memory.h>
 #include <folly/Optional.h>
 #include <folly/futures/Future.h>
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/EventBase.h>
 #include <folly/io/async/SSLContext.h>
 
 #include "event2/buffer.h"
@@ -39,12 +41,15 @@
 #include "logdevice/common/configuration/Configuration.h"
 #include "logdevice/common/libevent/LibEventCompatibility.h"
 #include "logdevice/common/network/SocketWriteCallback.h"
+#include "logdevice/common/network/StreamCompression.h"
 #include "logdevice/common/settings/Settings.h"
 
 namespace facebook { namespace logdevice {
 
 class BWAvailableCallback;
+struct COMPRESSED_Header;
 class FlowGroup;
+class MessageReader;
 class ProtocolHandler;
 class ResourceBudget;
 class SocketAdapter;
@@ -83,6 +88,25 @@ struct Settings;
 // is that this will work only if Sockets cannot be shared among threads, but
 // that is currently not needed.
 
+/**
+ * What a client connection takes along when it's moved to another worker,
+ * see Connection::detachForMigration().
+ */
+struct ConnectionMigrationState {
+  // Duplicate of the connection's socket, owned by this struct's holder.
+  int fd{-1};
+  Sockaddr client_addr;
+  ResourceBudget::Token conn_token;
+  ResourceBudget::Token conn_external_token;
+  SocketType type{SocketType::DATA};
+  ConnectionType conntype{ConnectionType::PLAIN};
+  uint16_t proto{0};
+  config_version_t peer_config_version{0};
+  std::shared_ptr<PrincipalIdentity> principal;
+  std::string csid;
+  std::string peer_location;
+};
+
 // Defined later in this file.
 class SocketDependencies;
 /**
@@ -213,6 +237,48 @@ class Connection : public TrafficShappingSocket {
     return peer_sockaddr_;
   }
 
+  /**
+   * Returns the time this worker spent processing messages received on this
+   * connection since the previous call. Used to balance client connections
+   * across workers.
+   */
+  std::chrono::microseconds takeCpuTime() {
+    return std::exchange(cpu_time_, std::chrono::microseconds::zero());
+  }
+
+  std::chrono::steady_clock::time_point getLastMessageReceivedTime() const {
+    return last_message_received_time_;
+  }
+
+  /**
+   * Can this connection be moved to another worker with
+   * detachForMigration()? Only handshaken plain TCP connections from clients
+   * qualify, whose socket adapter can hand over its fd (see
+   * SocketAdapter::canDetachFd()), with no message partially read or waiting
+   * to be sent, no compression state, and nobody but the Sender watching for
+   * them to close or holding on to them.
+   */
+  bool canMigrate() const;
+
+  /**
+   * Moves the socket and handshake state of a connection for which
+   * canMigrate() is true into `out`, then closes this Connection with
+   * E::SHUTDOWN without closing the TCP connection: `out->fd` is a duplicate
+   * of the socket. The new worker resumes the connection with
+   * restoreFromMigration().
+   *
+   * @return 0 on success, -1 if the socket could not be duplicated, with err
+   *         set to SYSLIMIT. The connection is left untouched then.
+   */
+  int detachForMigration(ConnectionMigrationState* out);
+
+  /**
+   * Called on a Connection just constructed from the fd of a
+   * ConnectionMigrationState to pick up where the old worker's connection
+   * left off, without a new handshake.
+   */
+  void restoreFromMigration(ConnectionMigrationState& state);
+
   /**
    * For Testing only!
    */
@@ -562,6 +628,12 @@ class Connection : public TrafficShappingSocket {
    */
   folly::ssl::X509UniquePtr getPeerCert() const;
 
+  /**
+   * @return should only be called if the socket is SSL enabled. Returns true
+   *         if record encryption was offloaded to kernel TLS (--ssl-ktls).
+   */
+  bool isKernelTlsEnabled() const;
+
   void setPeerShuttingDown() {
     peer_shuttingdown_ = true;
   }
@@ -654,16 +726,43 @@ class Connection : public TrafficShappingSocket {
   };
   /**
    * Writes a serialized buffer into the socket.
+   *
+   * @param urgent  the buffer holds a Priority::MAX message, don't hold it
+   *                back to batch it with later writes (see
+   *                buffered_output_)
    * @returns SendStatus based on the status of the write.
    */
-  SendStatus sendBuffer(std::unique_ptr<folly::IOBuf>&& buffer_chain);
+  SendStatus sendBuffer(std::unique_ptr<folly::IOBuf>&& buffer_chain,
+                        bool urgent = false);
   /**
-   * For asyncsocket based connections, to batch data better we schedule a zero
-   * timeout event in sendBuffer. It allows to batch all the data going to same
-   * destination. The batch is written into asyncsocket in this method.
+   * For asyncsocket based connections, to batch data better sendBuffer only
+   * appends to sendChain_ and schedules this method to run at the end of the
+   * current event loop iteration. It allows to batch all the data going to
+   * the same destination into one write. The batch is written into
+   * asyncsocket in this method.
    */
   void scheduleWriteChain();
 
+  /**
+   * Writes `chain`, of `len` bytes, into the asyncsocket as one write unit.
+   * If `zerocopy` is true, it is sent with MSG_ZEROCOPY.
+   */
+  void writeChainToSocket(std::unique_ptr<folly::IOBuf> chain,
+                          size_t len,
+                          SteadyTimestamp now,
+                          bool zerocopy);
+
+  class WriteChainCallback : public folly::EventBase::LoopCallback {
+   public:
+    explicit WriteChainCallback(Connection* conn) : conn_(conn) {}
+    void runLoopCallback() noexcept override {
+      conn_->scheduleWriteChain();
+    }
+
+   private:
+    Connection* const conn_;
+  };
+
   void onSent(std::unique_ptr<Envelope>,
               Status,
               Message::CompletionMethod = Message::CompletionMethod::IMMEDIATE);
@@ -706,6 +805,69 @@ class Connection : public TrafficShappingSocket {
    */
   void drainSendQueue();
 
+  /**
+   * Enables MSG_ZEROCOPY on the socket of a newly established plaintext
+   * connection if --zerocopy-send-threshold is set.
+   */
+  void enableZeroCopy();
+
+  /**
+   * Called once a write sent with MSG_ZEROCOPY was both written into the
+   * socket and released by the kernel. Only then are its bytes drained from
+   * the Sender's accounting.
+   */
+  void onZeroCopyWriteDone(size_t nbytes);
+
+  // Free function of the marker IOBuf appended to zero-copy write chains.
+  static void releaseZeroCopyWrite(void* buf, void* userData);
+
+  /**
+   * Sets up the zstd streams of a connection that negotiated compression
+   * during the handshake.
+   *
+   * @return 0 on success, -1 otherwise with err set to E::NOMEM or
+   *         E::INVALID_PARAM.
+   */
+  int enableCompression();
+
+  /**
+   * @return true if `msg', whose serialized body is `bodylen' bytes long,
+   *         should be sent COMPRESSED on this connection.
+   */
+  bool shouldCompress(const Message& msg, size_t bodylen);
+
+  /**
+   * Compresses a serialized message body into the body of a COMPRESSED
+   * message, leaving room for the ProtocolHeader in front of it.
+   *
+   * @param protohdr  header of the message being compressed, with its type
+   *                  and checksum set
+   * @return the body of the COMPRESSED message, or nullptr on failure.
+   */
+  std::unique_ptr<folly::IOBuf>
+  compressMessageBody(const ProtocolHeader& protohdr,
+                      size_t protohdr_bytes,
+                      const folly::IOBuf& body);
+
+  /**
+   * Reads and validates the header of a COMPRESSED message received from the
+   * peer.
+   *
+   * @return 0 on success, -1 if the message is malformed or compression was
+   *         not negotiated, with err set to E::BADMSG or E::PROTO.
+   */
+  int readCompressedHeader(const folly::IOBuf& body, COMPRESSED_Header* out);
+
+  /**
+   * Decompresses the body of a COMPRESSED message received from the peer.
+   *
+   * @return the body of the wrapped message, or nullptr with err set to
+   *         E::BADMSG if it could not be decompressed.
+   */
+  std::unique_ptr<folly::IOBuf>
+  decompressMessageBody(const COMPRESSED_Header& hdr,
+                        const folly::IOBuf& body);
+
   SocketDependencies* getDeps() const {
     return deps_.get();
   }
@@ -762,10 +924,14 @@ class Connection : public TrafficShappingSocket {
    * - checksumming is disabled
    * - Message Type is ACK/HELLO
    *
+   * @param size_hint  bytes to reserve for the header and the copied part of
+   *                   the body (see Envelope::copiedBytes()), or 0 if unknown
+   *
    * @return serialized buffer if no errors, returns a nullptr otherwise. err
    *         contains the actual reason.
    */
-  std::unique_ptr<folly::IOBuf> serializeMessage(const Message& msg);
+  std::unique_ptr<folly::IOBuf> serializeMessage(const Message& msg,
+                                                 size_t size_hint = 0);
 
   /**
    * Allow the async message error simulator to optionally take ownership of
@@ -1316,7 +1482,7 @@ class Connection : public TrafficShappingSocket {
 
   // Read callback installed in AsyncSocket to read data and pass it to higher
   // layers.
-  std::unique_ptr<folly::AsyncSocket::ReadCallback> read_cb_;
+  std::unique_ptr<MessageReader> read_cb_;
 
   // If receive of a message hit ENOBUFS then we will retry the same message
   // again till it succeeds. This will all stop reading more messages from the
@@ -1331,13 +1497,43 @@ class Connection : public TrafficShappingSocket {
   // not invoke computeChainDataLength on it frequently.
   std::unique_ptr<folly::IOBuf> sendChain_;
 
-  // Timer used to schedule event as soon as data is added to sendChain_.The
-  // callback of this timer add data into the asyncsocket.
-  EvTimer sched_write_chain_;
+  // Scheduled as soon as data is added to sendChain_, adds it into the
+  // asyncsocket at the end of the event loop iteration.
+  WriteChainCallback sched_write_chain_{this};
+
+  // Number of writes into the socket and the number of bytes they carried,
+  // reported by getDebugInfo(). For asyncsocket based connections a write is
+  // a batch handed to the asyncsocket, which normally writes it with one
+  // writev(). For bufferevents it's a drain of the output buffer.
+  uint64_t num_socket_writes_{0};
+  uint64_t num_bytes_in_socket_writes_{0};
 
   // Used to note down delays in writing into the asyncsocket.
   SteadyTimestamp sched_start_time_;
 
+  // Non-null if writes of at least zerocopy_send_threshold bytes are sent
+  // with MSG_ZEROCOPY. Points to this Connection until it is closed, so that
+  // writes released by the socket afterwards are ignored.
+  std::shared_ptr<Connection*> zerocopy_owner_;
+
+  // Bytes of zero-copy writes that were written into the socket but that the
+  // kernel may still be reading from. Counted by getBufferedBytesSize().
+  size_t zerocopy_bytes_pinned_{0};
+
+  // Both non-null if compression of the message stream was negotiated in
+  // the handshake. See COMPRESSED_Message.h.
+  std::unique_ptr<StreamCompressor> compressor_;
+  std::unique_ptr<StreamDecompressor> decompressor_;
+
+  // Time spent processing received messages, see takeCpuTime(). Only kept
+  // with --client-connection-rebalancing.
+  std::chrono::microseconds cpu_time_{0};
+
+  // When the last message was received, for migration decisions. Only kept
+  // with --client-connection-rebalancing.
+  std::chrono::steady_clock::time_point last_message_received_time_{
+      std::chrono::steady_clock::now()};
+
   /**
    * For Testing only!
    */
@@ -1351,6 +1547,7 @@ class Connection : public TrafficShappingSocket {
   friend class ClientSocketTest;
   friend class ServerSocketTest;
   friend class ClientConnectionTest;
+  friend class ClientConnectionMigrationTest;
 };
 
 }} // namespace facebook::logdevice
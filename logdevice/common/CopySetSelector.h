@@ -7,8 +7,10 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <memory>
 
+#include "logdevice/common/CopySet.h"
 #include "logdevice/common/Random.h"
 #include "logdevice/common/ShardID.h"
 #include "logdevice/common/types_internal.h"
@@ -20,8 +22,6 @@ namespace facebook { namespace logdevice {
  *        replicas of records.
  */
 
-struct StoreChainLink;
-
 class CopySetSelector {
  public:
   // see the @return doc block of the select() function
@@ -196,6 +196,39 @@ class CopySetSelector {
                          RNG& rng = DefaultRNG::get(),
                          bool retry = true) const = 0;
 
+  /**
+   * Variant of augment() that doesn't pick any of the `nexcluded` shards in
+   * `excluded` for the new copies, e.g. because STOREs to them are late.
+   * `excluded` must not intersect the existing copyset.
+   *
+   * The default implementation calls augment() and fails if it picked an
+   * excluded shard.
+   */
+  virtual Result augmentExcluding(StoreChainLink inout_copyset[],
+                                  copyset_size_t existing_copyset_size,
+                                  copyset_size_t* out_full_size,
+                                  const ShardID excluded[],
+                                  size_t nexcluded,
+                                  RNG& rng = DefaultRNG::get()) const {
+    Result result = augment(inout_copyset,
+                            existing_copyset_size,
+                            out_full_size,
+                            /* fill_client_id = */ false,
+                            /* chain_out = */ nullptr,
+                            rng);
+    if (result != Result::SUCCESS) {
+      return result;
+    }
+    for (copyset_size_t i = 0; i < *out_full_size; ++i) {
+      if (std::find(excluded,
+                    excluded + nexcluded,
+                    inout_copyset[i].destination) != excluded + nexcluded) {
+        return Result::FAILED;
+      }
+    }
+    return result;
+  }
+
   /**
    * This CopySetSelector selects copysets of size
    * getReplicationFactor() + `extras`.
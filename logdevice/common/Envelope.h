@@ -48,7 +48,8 @@ class Envelope : public BWAvailableCallback {
         msg_(std::move(msg)),
         drain_pos_(~0),
         birth_time_(std::chrono::steady_clock::now()),
-        cost_(msg_->size()) {}
+        cost_(msg_->size(Compatibility::MAX_PROTOCOL_SUPPORTED,
+                         &copied_bytes_)) {}
 
   // Used to track an Envelope on various queued in the Connection as
   // an Envelope is transmitted.
@@ -67,6 +68,11 @@ class Envelope : public BWAvailableCallback {
   size_t cost() const {
     return cost_;
   }
+  // Number of bytes serialization will copy into the output buffer, i.e.
+  // cost() minus payloads written without copying.
+  size_t copiedBytes() const {
+    return copied_bytes_;
+  }
 
   const Message& message() const {
     return *msg_;
@@ -121,6 +127,9 @@ class Envelope : public BWAvailableCallback {
   // When this envelope was created.
   const std::chrono::steady_clock::time_point birth_time_;
 
+  // See copiedBytes(). Set while computing cost_, so declared before it.
+  size_t copied_bytes_{0};
+
   // Size in bytes charged against buffer limits while queued.
   // May be different from final serialized size (e.g. if
   // cancelled or protocol version changes).
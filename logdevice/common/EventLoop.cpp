@@ -7,6 +7,8 @@
  */
 #include "logdevice/common/EventLoop.h"
 
+#include <algorithm>
+#include <chrono>
 #include <errno.h>
 #include <unistd.h>
 
@@ -129,6 +131,15 @@ void EventLoop::addWithPriority(folly::Function<void()> func, int8_t priority) {
       priority_queues_enabled_ ? priority : folly::Executor::HI_PRI);
 }
 
+void EventLoop::addBatch(EventLoopTaskQueue::TaskBatch batch) {
+  if (!priority_queues_enabled_) {
+    for (auto& task : batch) {
+      task.second = folly::Executor::HI_PRI;
+    }
+  }
+  task_queue_->addBatch(std::move(batch));
+}
+
 Status EventLoop::init(
     EvBase::EvBaseType base_type,
     size_t request_pump_capacity,
@@ -149,6 +160,42 @@ Status EventLoop::init(
   return Status::OK;
 }
 
+constexpr std::chrono::milliseconds EventLoop::kTimingWheelTick;
+
+void EventLoop::scheduleOnTimingWheel(TimingWheel::Entry& entry,
+                                      std::chrono::microseconds delay) {
+  ld_check(EventLoop::onThisThread() == this);
+  const auto now = TimingWheel::Clock::now();
+  if (!timing_wheel_) {
+    timing_wheel_ = std::make_unique<TimingWheel>(kTimingWheelTick, now);
+    timing_wheel_timer_ = std::make_unique<EvTimer>(base_.get());
+    timing_wheel_timer_->attachCallback([this] { onTimingWheelTimer(); });
+  }
+  timing_wheel_->schedule(entry, delay, now);
+  armTimingWheelTimer(timing_wheel_->expiryTime(entry), now);
+}
+
+void EventLoop::armTimingWheelTimer(TimingWheel::Clock::time_point deadline,
+                                    TimingWheel::Clock::time_point now) {
+  if (timing_wheel_timer_->isScheduled() &&
+      timing_wheel_deadline_ <= deadline) {
+    return;
+  }
+  auto delay = std::chrono::ceil<std::chrono::milliseconds>(deadline - now);
+  timing_wheel_timer_->scheduleTimeout(
+      std::max(delay, std::chrono::milliseconds(0)));
+  timing_wheel_deadline_ = deadline;
+}
+
+void EventLoop::onTimingWheelTimer() {
+  // Callbacks may schedule entries, which rearms the timer as needed.
+  timing_wheel_->advance(TimingWheel::Clock::now());
+  if (!timing_wheel_->empty()) {
+    armTimingWheelTimer(
+        timing_wheel_->nextWakeUp(), TimingWheel::Clock::now());
+  }
+}
+
 void EventLoop::run() {
   EventLoop::thisThreadLoop_ = this; // save in a thread-local
   // this runs until we get destroyed or shutdown is called on
@@ -22,6 +22,7 @@
 #include "logdevice/common/Semaphore.h"
 #include "logdevice/common/ThreadID.h"
 #include "logdevice/common/TimeoutMap.h"
+#include "logdevice/common/TimingWheel.h"
 #include "logdevice/common/libevent/LibEventCompatibility.h"
 
 namespace facebook { namespace logdevice {
@@ -93,6 +94,12 @@ class EventLoop : public folly::Executor {
    */
   void addWithPriority(folly::Function<void()>, int8_t priority) override;
 
+  /**
+   * Enqueue all functions of the batch, waking up the EventLoop thread once.
+   * See EventLoopTaskQueue::addBatch().
+   */
+  void addBatch(EventLoopTaskQueue::TaskBatch batch);
+
   /**
    * Get the thread handle of this EventLoop.
    *
@@ -140,6 +147,20 @@ class EventLoop : public folly::Executor {
     return commonTimeouts().get(std::chrono::milliseconds(0));
   }
 
+  /**
+   * Schedules `entry` to fire after `delay` on this loop's timing wheel. The
+   * wheel is created on first use and is driven by a single libevent timer,
+   * which is only rearmed when the wheel's next deadline moves earlier, so
+   * the cost of a timer doesn't depend on how many others are pending.
+   * Must only be called from this loop's thread.
+   */
+  void scheduleOnTimingWheel(TimingWheel::Entry& entry,
+                             std::chrono::microseconds delay);
+
+  // Tick of the timing wheel. Libevent timers have millisecond granularity
+  // anyway.
+  static constexpr std::chrono::milliseconds kTimingWheelTick{1};
+
   static const int PRIORITY_LOW = 2;    // lowest priority
   static const int PRIORITY_NORMAL = 1; // default libevent priority
   static const int PRIORITY_HIGH = 0;   // elevated priority (numerically lower)
@@ -205,6 +226,19 @@ class EventLoop : public folly::Executor {
   // TimeoutMap to cache common timeouts.
   TimeoutMap common_timeouts_{kMaxFastTimeouts};
 
+  // See scheduleOnTimingWheel(). timing_wheel_timer_ is pending whenever the
+  // wheel is not empty, and goes off at timing_wheel_deadline_.
+  std::unique_ptr<TimingWheel> timing_wheel_;
+  std::unique_ptr<EvTimer> timing_wheel_timer_;
+  TimingWheel::Clock::time_point timing_wheel_deadline_;
+
+  // Makes sure timing_wheel_timer_ goes off no later than `deadline`.
+  void armTimingWheelTimer(TimingWheel::Clock::time_point deadline,
+                           TimingWheel::Clock::time_point now);
+
+  // Fires the due entries of the timing wheel and rearms the timer.
+  void onTimingWheelTimer();
+
   // True indicates eventloop honors the priority with used in
   // EventLoop::addWithPriority. If false EventLoop will override the priority
   // of the task and make all work added as single priority.
@@ -95,6 +95,27 @@ int EventLoopTaskQueue::addWithPriority(Func func, int8_t priority) {
   return 0;
 }
 
+int EventLoopTaskQueue::addBatch(TaskBatch batch) {
+  if (UNLIKELY(sem_.isShutdown())) {
+    err = E::SHUTDOWN;
+    return -1;
+  }
+  if (batch.empty()) {
+    return 0;
+  }
+  auto context = folly::RequestContext::saveContext();
+  for (auto& [func, priority] : batch) {
+    ld_check(func);
+    Task t(std::move(func), context);
+    queues_[translatePriority(priority)].enqueue(std::move(t));
+  }
+  // All tasks are in the queues before the semaphore goes up, same as in
+  // addWithPriority(). A single post() of the whole count makes the fd
+  // readable once.
+  sem_.post(batch.size());
+  return 0;
+}
+
 void EventLoopTaskQueue::haveTasksEventHandler() {
   ld_check(sem_waiter_);
   try {
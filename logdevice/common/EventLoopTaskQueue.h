@@ -9,6 +9,8 @@
 
 #include <memory>
 #include <numeric>
+#include <utility>
+#include <vector>
 
 #include <folly/Executor.h>
 #include <folly/Function.h>
@@ -50,6 +52,9 @@ class EventLoopTaskQueue {
  public:
   constexpr static size_t kNumberOfPriorities = 3;
 
+  // Functions to add together, each with its priority.
+  using TaskBatch = std::vector<std::pair<Func, int8_t>>;
+
   /**
    * Registers the event.
    *
@@ -88,6 +93,18 @@ class EventLoopTaskQueue {
     return addWithPriority(std::move(func), folly::Executor::LO_PRI);
   }
 
+  /**
+   * Like calling addWithPriority() for each function of `batch`, in order,
+   * but the eventloop thread is signaled once for the whole batch rather than
+   * once per function.
+   *
+   * Can be invoked from any thread.
+   *
+   * @return 0 on success, -1 with err set to SHUTDOWN if the queue is shut
+   *         down, in which case none of the functions were added.
+   */
+  virtual int addBatch(TaskBatch batch);
+
   /*
    * Checks if the queue is filled up to the soft capacity limit.
    */
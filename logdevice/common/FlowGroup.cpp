@@ -146,11 +146,97 @@ bool FlowGroup::applyUpdate(FlowGroupsUpdate::GroupEntry& update,
   return need_to_run;
 }
 
+bool FlowGroup::applySharedBudgetPolicy(
+    const FlowGroupPolicy& policy,
+    std::shared_ptr<SharedFlowBudget> budget) {
+  const bool was_enabled = enabled_;
+  // The budget is the same for the lifetime of the process. Don't touch the
+  // pointer once set, the worker reads it without holding the meter lock.
+  if (shared_budget_ != budget) {
+    shared_budget_ = std::move(budget);
+  }
+  enabled_ = policy.enabled();
+
+  if (!enabled_) {
+    // Same as applyUpdate(): start clean if re-enabled and release anything
+    // blocked by the old policy.
+    for (auto& e : meter_.entries) {
+      e.reset(0);
+    }
+    return was_enabled;
+  }
+
+  for (size_t i = 0; i < meter_.entries.size(); ++i) {
+    // Borrowed credit must always be able to make the meter drainable, even
+    // if the burst configured for the process is smaller than the number of
+    // workers.
+    meter_.entries[i].setCapacity(
+        std::max<int64_t>(policy.entries[i].capacity, 1));
+  }
+  // The new policy may allow borrowing what the old one didn't.
+  return !priorityq_.empty();
+}
+
+std::chrono::microseconds FlowGroup::sharedBudgetWaitTime() {
+  auto res = std::chrono::microseconds::max();
+  if (!shared_budget_ || !enabled_ || priorityq_.empty()) {
+    return res;
+  }
+  for (Priority p = Priority::MAX; p < PRIORITYQ_PRIORITY;
+       p = priorityBelow(p)) {
+    if (!priorityq_.empty(p)) {
+      // Enough to pay off the debt and release one callback.
+      const int64_t needed = meter_.entries[asInt(p)].debt() + 1;
+      res = std::min(
+          res, shared_budget_->timeUntilAvailable(scope_, p, needed));
+    }
+  }
+  return res;
+}
+
+bool FlowGroup::borrowSharedBudget(Priority p) {
+  if (!shared_budget_ || !enabled_) {
+    return false;
+  }
+  auto& meter = meter_.entries[asInt(p)];
+  // Fill the meter to its maximum burst so that we come back for more no
+  // more often than the TrafficShaper would have refilled it.
+  const int64_t wanted =
+      std::max<int64_t>(meter.capacity() - meter.level(), meter.debt() + 1);
+  int64_t transferred;
+  const int64_t borrowed =
+      shared_budget_->borrow(scope_, p, wanted, transferred);
+  if (borrowed == 0) {
+    return false;
+  }
+  size_t budget = FlowMeter::Entry::UNRESTRICTED_BUDGET;
+  const size_t overflow = meter.fill(borrowed, budget);
+  if (overflow > 0) {
+    // Credit from the pool was taken last, return it first.
+    shared_budget_->giveBack(
+        scope_, p, overflow, std::min<int64_t>(overflow, transferred));
+  }
+  deps_->statsAdd(&PerShapingPriorityStats::bwborrowed, scope_, p, borrowed);
+  deps_->statsAdd(
+      &PerShapingPriorityStats::bwtransferred, scope_, p, transferred);
+  return meter.canDrain();
+}
+
 size_t FlowGroup::returnCredits(Priority p, size_t amount) {
   if (!enabled()) {
     return amount;
   }
-  return meter_.entries[asInt(p)].returnCredits(amount);
+  auto& meter = meter_.entries[asInt(p)];
+  const size_t overflow = meter.returnCredits(amount);
+  if (shared_budget_ && overflow > 0) {
+    // No FlowGroupsUpdate will redistribute the overflow, hand it back to
+    // the other workers right away.
+    shared_budget_->giveBack(
+        scope_,
+        p,
+        std::min<size_t>(meter.consumeReturnedCreditOverflow(), INT64_MAX));
+  }
+  return overflow;
 }
 
 bool FlowGroup::run(std::mutex& flow_meters_mutex,
@@ -170,8 +256,17 @@ bool FlowGroup::run(std::mutex& flow_meters_mutex,
   for (Priority p = Priority::MAX; p < PRIORITYQ_PRIORITY;
        p = priorityBelow(p)) {
     auto& meter_entry = meter_.entries[asInt(p)];
-    while (!priorityq_.empty(p) && (!enabled_ || meter_entry.canDrain()) &&
-           !run_limits_exceeded()) {
+    auto can_drain = [&] {
+      if (!enabled_ || meter_entry.canDrain()) {
+        return true;
+      }
+      if (!shared_budget_) {
+        return false;
+      }
+      std::lock_guard<std::mutex> lock(flow_meters_mutex);
+      return borrowSharedBudget(p);
+    };
+    while (!priorityq_.empty(p) && can_drain() && !run_limits_exceeded()) {
       issueCallback(priorityq_.front(p), flow_meters_mutex);
     }
 
@@ -189,7 +284,8 @@ bool FlowGroup::drain(size_t cost, Priority p) {
   bool res = false;
   if (!wouldCutInLine(p)) {
     auto& meter = meter_.entries[asInt(p)];
-    if (!enabled_ || meter.drain(cost)) {
+    if (!enabled_ || meter.drain(cost) ||
+        (borrowSharedBudget(p) && meter.drain(cost))) {
       deps_->statsAdd(&PerShapingPriorityStats::bwconsumed, scope_, p, cost);
       res = true;
     }
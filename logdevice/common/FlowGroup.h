@@ -7,6 +7,8 @@
  */
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <thread>
 
 #include <folly/ScopeGuard.h>
@@ -16,6 +18,7 @@
 #include "logdevice/common/FlowGroupDependencies.h"
 #include "logdevice/common/FlowMeter.h"
 #include "logdevice/common/PriorityQueue.h"
+#include "logdevice/common/SharedFlowBudget.h"
 #include "logdevice/common/Timestamp.h"
 #include "logdevice/common/configuration/FlowGroupPolicy.h"
 #include "logdevice/common/configuration/NodeLocation.h"
@@ -67,6 +70,11 @@ namespace facebook { namespace logdevice {
  *           from other priority buckets)
  *        c) returned credit from the clients (this happens when the client
  *           requests more than it actually needed)
+ *
+ *        Alternatively, a FlowGroup can be attached to a SharedFlowBudget.
+ *        It then receives only policy changes from the TrafficShaper and
+ *        borrows credit from the shared budget whenever one of its meters
+ *        runs dry. See SharedFlowBudget.
  */
 
 class FlowGroupsUpdate {
@@ -161,15 +169,16 @@ class FlowGroup {
     return scope_;
   }
 
-  bool canDrainMeter(Priority p) const {
-    return !enabled() || meter_.entries[asInt(p)].canDrain();
+  bool canDrainMeter(Priority p) {
+    return !enabled() || meter_.entries[asInt(p)].canDrain() ||
+        borrowSharedBudget(p);
   }
 
   /**
    * Return true if sufficient bandwidth exists to transmit at least one
    * message at the given priority level.
    */
-  bool canDrain(Priority p) const {
+  bool canDrain(Priority p) {
     bool res = !wouldCutInLine(p) && canDrainMeter(p);
     if (assert_can_drain_ && reordering_allowed_at_priority_ == p) {
       ld_check(res);
@@ -281,6 +290,10 @@ class FlowGroup {
       ld_check(!assert_can_drain_);
       reordering_allowed_at_priority_ = Priority::INVALID;
     }
+
+    if (shared_budget_ && enabled_ && on_shared_budget_wait_) {
+      on_shared_budget_wait_();
+    }
   }
 
   /** Remove a callback from the PriorityQueue for this FlowGroup. */
@@ -309,6 +322,34 @@ class FlowGroup {
   bool applyUpdate(FlowGroupsUpdate::GroupEntry& update,
                    StatsHolder* stats = nullptr);
 
+  /**
+   * Apply a policy change to a FlowGroup that borrows its bandwidth from
+   * `budget` instead of receiving allotments via applyUpdate(). Only the
+   * enabled state and the maximum burst (already scaled to one worker) of
+   * the policy are used here, the bandwidth limits are enforced by `budget`.
+   *
+   * @return  true iff queued callbacks may now be released.
+   */
+  bool applySharedBudgetPolicy(const FlowGroupPolicy& policy,
+                               std::shared_ptr<SharedFlowBudget> budget);
+
+  /**
+   * Set the function to call when a callback is queued on a FlowGroup that
+   * borrows from a SharedFlowBudget. Nothing else will run the FlowGroup
+   * once the budget refills, so the owner must arrange for that.
+   */
+  void setSharedBudgetWaitCallback(std::function<void()> cb) {
+    on_shared_budget_wait_ = std::move(cb);
+  }
+
+  /**
+   * @return  How long until the shared budget will have enough credit to
+   *          release a queued callback, std::chrono::microseconds::max() if
+   *          nothing is queued or the FlowGroup doesn't borrow from a
+   *          SharedFlowBudget.
+   */
+  std::chrono::microseconds sharedBudgetWaitTime();
+
   /**
    * Release queued messages for which bandwidth is now available.
    *
@@ -346,6 +387,14 @@ class FlowGroup {
     return reordering_allowed_at_priority_ != p && !priorityq_.empty(p);
   }
 
+  /**
+   * Refill the meter of priority p from shared_budget_, if the FlowGroup
+   * has one.
+   *
+   * @return  true iff the meter can now be drained.
+   */
+  bool borrowSharedBudget(Priority p);
+
   /**
    * Transfer the specified amount of credit from the 'source' to 'sink'
    * FlowMeter.
@@ -391,6 +440,11 @@ class FlowGroup {
 
   FlowMeter meter_;
 
+  // If set, the meters are refilled from this budget on demand rather than
+  // by applyUpdate().
+  std::shared_ptr<SharedFlowBudget> shared_budget_;
+  std::function<void()> on_shared_budget_wait_;
+
   // The scope of connections being managed by this FlowGroup.
   NodeLocationScope scope_ = NodeLocationScope::ROOT;
 
@@ -53,6 +53,10 @@ class FlowMeter {
       return level_;
     }
 
+    int64_t capacity() const {
+      return bucket_capacity_;
+    }
+
     void setCapacity(int64_t capacity) {
       ld_check(capacity >= 0);
       bucket_capacity_ = capacity;
@@ -58,11 +58,14 @@ NodeAvailabilityChecker::checkNode(NodeSetState* nodeset_state,
 
   NodeID dest_nid(shard.node(), 0);
   ClientID our_name_at_peer;
+  // Check the connection the STOREs for this log will actually go over.
+  const logid_t log_id =
+      nodeset_state ? nodeset_state->getLogID() : LOGID_INVALID;
 
   NodeStatus result;
 
   int rv = checkConnection(
-      dest_nid, &our_name_at_peer, allow_unencrypted_connections);
+      dest_nid, &our_name_at_peer, allow_unencrypted_connections, log_id);
   if (rv != 0) {
     switch (err) {
       case E::NOTFOUND:
@@ -70,7 +73,7 @@ NodeAvailabilityChecker::checkNode(NodeSetState* nodeset_state,
         // We never tried/managed to connect to this node and connecting attempt
         // is not in progress. Let's try to connect and report as unavailable if
         // it fails immediately.
-        rv = connect(dest_nid, allow_unencrypted_connections);
+        rv = connect(dest_nid, allow_unencrypted_connections, log_id);
         if (rv != 0) {
           result = NodeStatus::NOT_AVAILABLE;
         } else {
@@ -87,7 +90,7 @@ NodeAvailabilityChecker::checkNode(NodeSetState* nodeset_state,
         // We don't have a working connection to the node yet. Skip this
         // destination for now, but make sure a reconnection attempt is in
         // progress.
-        connect(dest_nid, allow_unencrypted_connections);
+        connect(dest_nid, allow_unencrypted_connections, log_id);
         // fall-through
         FOLLY_FALLTHROUGH;
       case E::DISABLED:
@@ -129,9 +132,10 @@ NodeAvailabilityChecker::checkNode(NodeSetState* nodeset_state,
 
 int NodeAvailabilityChecker::checkConnection(NodeID nid,
                                              ClientID* our_name_at_peer,
-                                             bool allow_unencrypted) const {
+                                             bool allow_unencrypted,
+                                             logid_t log_id) const {
   return Worker::onThisThread()->sender().checkConnection(
-      nid, our_name_at_peer, allow_unencrypted);
+      nid, our_name_at_peer, allow_unencrypted, log_id);
 }
 
 // `nodeset_state` is nullptr in tests.
@@ -174,8 +178,11 @@ NodeAvailabilityChecker::getNodesConfiguration() const {
   return Worker::onThisThread()->getNodesConfiguration();
 }
 
-int NodeAvailabilityChecker::connect(NodeID nid, bool allow_unencrypted) const {
-  return Worker::onThisThread()->sender().connect(nid, allow_unencrypted);
+int NodeAvailabilityChecker::connect(NodeID nid,
+                                     bool allow_unencrypted,
+                                     logid_t log_id) const {
+  return Worker::onThisThread()->sender().connect(
+      nid, allow_unencrypted, log_id);
 }
 
 const NodeAvailabilityChecker* NodeAvailabilityChecker::instance() {
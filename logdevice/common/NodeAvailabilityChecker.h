@@ -62,9 +62,12 @@ class NodeAvailabilityChecker {
 
  protected:
   // Proxy for Sender::checkConnection(). override in tests
+  // @param log_id  log the record is for, STOREs of a log may be sent on their
+  //                own connection to nid (see Sender::selectStripe())
   virtual int checkConnection(NodeID nid,
                               ClientID* our_name_at_peer,
-                              bool allow_unencrypted) const;
+                              bool allow_unencrypted,
+                              logid_t log_id) const;
 
   // Proxy for NodeSetState::checkNotAvailableUntil(). override in tests.
   // @param now is provided for test override.
@@ -93,7 +96,7 @@ class NodeAvailabilityChecker {
   getNodesConfiguration() const;
 
   // Proxy for Sender::connect(). override in tests
-  virtual int connect(NodeID nid, bool allow_unencrypted) const;
+  virtual int connect(NodeID nid, bool allow_unencrypted, logid_t log_id) const;
 };
 
 }} // namespace facebook::logdevice
@@ -29,6 +29,7 @@ NodeSetState::NodeSetState(const StorageSet& shards,
   // after so the map is thread-safe after construction
   for (const ShardID shard : shards) {
     shard_states_[shard] = ShardState();
+    shard_latencies_[shard];
   }
   graylisting_enabled_.store(grayListingEnabledInSettings());
 }
@@ -390,6 +391,61 @@ void NodeSetState::resetGrayList(GrayListResetReason r) {
   }
 }
 
+void NodeSetState::recordStoreLatency(ShardID shard,
+                                      std::chrono::microseconds latency) {
+  // Weight of a new sample in the moving average.
+  static constexpr double kEwmaAlpha = 0.1;
+  // Quantile tracked by the tail estimate.
+  static constexpr double kTailQuantile = 0.99;
+  // Step of the tail estimate, as a fraction of the moving average so that
+  // it works for any latency scale.
+  static constexpr double kTailStep = 0.25;
+
+  auto it = shard_latencies_.find(shard);
+  if (it == shard_latencies_.end()) {
+    ld_check(false);
+    return;
+  }
+  ShardLatency& state = it->second;
+  const double sample = std::max<int64_t>(latency.count(), 1);
+
+  const uint64_t prev_ewma = state.ewma_us.load(std::memory_order_relaxed);
+  const uint64_t prev_tail = state.tail_us.load(std::memory_order_relaxed);
+  if (prev_ewma == 0 || prev_tail == 0) {
+    state.ewma_us.store(sample, std::memory_order_relaxed);
+    state.tail_us.store(sample, std::memory_order_relaxed);
+    return;
+  }
+
+  const double ewma = prev_ewma + (sample - prev_ewma) * kEwmaAlpha;
+  state.ewma_us.store(std::max<uint64_t>(ewma, 1), std::memory_order_relaxed);
+
+  // Stochastic gradient descent on the quantile loss: steps of fixed size,
+  // up by q and down by (1 - q), regardless of how far the sample is. The
+  // estimate settles where P(sample > estimate) = 1 - q.
+  const double step = ewma * kTailStep;
+  const double tail = sample > prev_tail
+      ? prev_tail + step * kTailQuantile
+      : prev_tail - step * (1 - kTailQuantile);
+  state.tail_us.store(std::max<double>(tail, 1), std::memory_order_relaxed);
+}
+
+folly::Optional<NodeSetState::StoreLatencyEstimate>
+NodeSetState::getStoreLatencyEstimate(ShardID shard) const {
+  auto it = shard_latencies_.find(shard);
+  if (it == shard_latencies_.end()) {
+    ld_check(false);
+    return folly::none;
+  }
+  const uint64_t ewma = it->second.ewma_us.load(std::memory_order_relaxed);
+  const uint64_t tail = it->second.tail_us.load(std::memory_order_relaxed);
+  if (ewma == 0 || tail == 0) {
+    return folly::none;
+  }
+  return StoreLatencyEstimate{
+      std::chrono::microseconds(ewma), std::chrono::microseconds(tail)};
+}
+
 const Settings* FOLLY_NULLABLE NodeSetState::getSettings() const {
   if (!Worker::onThisThread(false)) {
     return nullptr;
@@ -212,10 +212,45 @@ class NodeSetState : public std::enable_shared_from_this<NodeSetState> {
     return all_shards_cnt_;
   }
 
+  logid_t getLogID() const {
+    return log_id_;
+  }
+
   bool containsShard(ShardID shard) const {
     return shard_states_.count(shard);
   }
 
+  /**
+   * Latency estimates of STORE->STORED round trips to a shard, as observed by
+   * Appenders of this log. Used by WeightedCopySetSelector to bias copyset
+   * selection away from shards that are slow but not (yet) graylisted.
+   */
+  struct StoreLatencyEstimate {
+    // exponentially weighted moving average of the round trip time
+    std::chrono::microseconds ewma;
+    // running estimate of the p99 of the round trip time, updated by
+    // fixed-size steps (stochastic gradient descent on the quantile loss)
+    std::chrono::microseconds tail;
+  };
+
+  /**
+   * Feed a new STORE->STORED round trip time sample for the given shard.
+   * Thread-safe; concurrent updates may occasionally lose a sample, which is
+   * fine for an estimate.
+   *
+   * @param  shard    Shard that must belong to the storage set.
+   * @param  latency  Time between passing the STORE to TCP and receiving a
+   *                  successful STORED reply.
+   */
+  void recordStoreLatency(ShardID shard, std::chrono::microseconds latency);
+
+  /**
+   * @return  the current latency estimate for the shard, or folly::none if
+   *          no sample has been recorded for it yet.
+   */
+  folly::Optional<StoreLatencyEstimate>
+  getStoreLatencyEstimate(ShardID shard) const;
+
   std::shared_ptr<NodeSetState> getSharedPtr() {
     return shared_from_this();
   }
@@ -329,6 +364,14 @@ class NodeSetState : public std::enable_shared_from_this<NodeSetState> {
   std::unordered_map<ShardID, shard_state_atomic_t, ShardID::Hash>
       shard_states_;
 
+  // Latency estimates, in microseconds. 0 means no sample yet. Same key set
+  // as shard_states_, fixed after construction.
+  struct ShardLatency {
+    std::atomic<uint64_t> ewma_us{0};
+    std::atomic<uint64_t> tail_us{0};
+  };
+  std::unordered_map<ShardID, ShardLatency, ShardID::Hash> shard_latencies_;
+
   // No. of different types of nodes that are available/not-available.
   // This is an array of NotAvailableReason::Count elments of type
   // std::atomic<nodeset_ssize_t>
@@ -0,0 +1,209 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/NumaTopology.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#include <boost/filesystem.hpp>
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <sched.h>
+#include <sys/sysmacros.h>
+
+#include "logdevice/common/checks.h"
+#include "logdevice/common/debug.h"
+
+namespace fs = boost::filesystem;
+
+namespace facebook { namespace logdevice {
+
+namespace {
+
+// Reads a small sysfs file, without the trailing newline.
+bool read_sysfs_file(const fs::path& path, std::string* out) {
+  if (!folly::readFile(path.c_str(), *out)) {
+    return false;
+  }
+  *out = folly::trimWhitespace(*out).str();
+  return true;
+}
+
+} // namespace
+
+int parse_cpu_list(const std::string& list, std::vector<int>* out) {
+  ld_check(out);
+  out->clear();
+  std::vector<folly::StringPiece> ranges;
+  folly::split(',', folly::trimWhitespace(list), ranges);
+  for (folly::StringPiece range : ranges) {
+    if (range.empty()) {
+      // An empty list is a node without CPUs.
+      continue;
+    }
+    folly::StringPiece first, last;
+    if (!folly::split('-', range, first, last)) {
+      first = last = range;
+    }
+    auto lo = folly::tryTo<int>(first);
+    auto hi = folly::tryTo<int>(last);
+    if (!lo.hasValue() || !hi.hasValue() || *lo < 0 || *lo > *hi) {
+      return -1;
+    }
+    for (int cpu = *lo; cpu <= *hi; ++cpu) {
+      out->push_back(cpu);
+    }
+  }
+  return 0;
+}
+
+NumaTopology::NumaTopology(const std::string& sysfs_root)
+    : sysfs_root_(sysfs_root) {
+  const fs::path node_dir = fs::path(sysfs_root_) / "devices/system/node";
+  boost::system::error_code ec;
+  std::vector<std::pair<int, std::vector<int>>> nodes;
+  for (fs::directory_iterator it(node_dir, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    const std::string name = it->path().filename().string();
+    if (name.compare(0, 4, "node") != 0) {
+      continue;
+    }
+    auto id = folly::tryTo<int>(folly::StringPiece(name).subpiece(4));
+    std::string cpulist;
+    std::vector<int> cpus;
+    if (!id.hasValue() || !read_sysfs_file(it->path() / "cpulist", &cpulist) ||
+        parse_cpu_list(cpulist, &cpus) != 0) {
+      ld_warning("Ignoring NUMA node %s: can't read its cpu list",
+                 it->path().c_str());
+      continue;
+    }
+    if (cpus.empty()) {
+      // Memory-only node, no thread can be bound to it.
+      continue;
+    }
+    std::sort(cpus.begin(), cpus.end());
+    nodes.emplace_back(*id, std::move(cpus));
+  }
+
+  if (nodes.empty()) {
+    // No NUMA support in the kernel, or sysfs isn't mounted. Act as if all
+    // CPUs belong to one node.
+    std::vector<int> cpus(std::max(1u, std::thread::hardware_concurrency()));
+    for (int i = 0; i < cpus.size(); ++i) {
+      cpus[i] = i;
+    }
+    nodes.emplace_back(0, std::move(cpus));
+  }
+
+  std::sort(nodes.begin(), nodes.end());
+  for (auto& node : nodes) {
+    node_ids_.push_back(node.first);
+    nodes_.push_back(std::move(node.second));
+  }
+}
+
+const NumaTopology& NumaTopology::get() {
+  static const NumaTopology topology("/sys");
+  return topology;
+}
+
+const std::vector<int>& NumaTopology::cpusOfNode(int node) const {
+  ld_check(node >= 0 && node < nodes_.size());
+  return nodes_[node];
+}
+
+int NumaTopology::nodeOfCpu(int cpu) const {
+  for (int node = 0; node < nodes_.size(); ++node) {
+    const auto& cpus = nodes_[node];
+    if (std::binary_search(cpus.begin(), cpus.end(), cpu)) {
+      return node;
+    }
+  }
+  return -1;
+}
+
+int NumaTopology::nodeOfDevice(dev_t dev) const {
+  if (!isMultiNode()) {
+    return nodes_.empty() ? -1 : 0;
+  }
+  const fs::path dev_link = fs::path(sysfs_root_) / "dev/block" /
+      folly::to<std::string>(major(dev), ":", minor(dev));
+  boost::system::error_code ec;
+  const fs::path dev_dir = fs::canonical(dev_link, ec);
+  if (ec) {
+    return -1;
+  }
+  // Partitions don't have a device link, the disk they're on does.
+  std::string value;
+  if (!read_sysfs_file(dev_dir / "device/numa_node", &value) &&
+      !read_sysfs_file(dev_dir.parent_path() / "device/numa_node", &value)) {
+    return -1;
+  }
+  auto id = folly::tryTo<int>(value);
+  if (!id.hasValue()) {
+    return -1;
+  }
+  // -1 if the firmware doesn't say which node the device is attached to.
+  auto it = std::find(node_ids_.begin(), node_ids_.end(), *id);
+  return it == node_ids_.end() ? -1 : it - node_ids_.begin();
+}
+
+int NumaTopology::nodeForWorker(int idx, int nworkers) const {
+  ld_check(idx >= 0 && idx < nworkers);
+  if (!isMultiNode()) {
+    return -1;
+  }
+  size_t total_cpus = 0;
+  for (const auto& cpus : nodes_) {
+    total_cpus += cpus.size();
+  }
+  // Position of the start of the worker's slice in the list of all CPUs.
+  const size_t pos = idx * total_cpus / nworkers;
+  size_t end = 0;
+  for (int node = 0; node < nodes_.size(); ++node) {
+    end += nodes_[node].size();
+    if (pos < end) {
+      return node;
+    }
+  }
+  return nodes_.size() - 1;
+}
+
+int NumaTopology::bindThisThread(int node) const {
+  if (!isMultiNode() || node < 0) {
+    return 0;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpusOfNode(node)) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  // pid 0 is the calling thread.
+  if (::sched_setaffinity(0, sizeof(set), &set) != 0) {
+    ld_error("Failed to bind thread to NUMA node %d: %s",
+             node_ids_[node],
+             strerror(errno));
+    return -1;
+  }
+  return 0;
+}
+
+int NumaTopology::currentNode() const {
+  if (!isMultiNode()) {
+    return 0;
+  }
+  const int cpu = ::sched_getcpu();
+  return cpu < 0 ? -1 : nodeOfCpu(cpu);
+}
+
+}} // namespace facebook::logdevice
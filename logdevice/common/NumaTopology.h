@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace facebook { namespace logdevice {
+
+/**
+ * @file NUMA nodes of the host and the CPUs that belong to each of them, as
+ * reported by sysfs. Used to keep the threads serving a shard, and the memory
+ * they allocate, on the node closest to the shard's disk.
+ *
+ * On hosts with a single node, or where sysfs doesn't expose the topology,
+ * everything looks like one node and binding threads is a no-op.
+ */
+
+class NumaTopology {
+ public:
+  /**
+   * Reads the topology from `sysfs_root` (normally "/sys").
+   */
+  explicit NumaTopology(const std::string& sysfs_root);
+
+  /**
+   * The topology of this host, read once.
+   */
+  static const NumaTopology& get();
+
+  size_t numNodes() const {
+    return nodes_.size();
+  }
+
+  bool isMultiNode() const {
+    return nodes_.size() > 1;
+  }
+
+  /**
+   * CPUs of the node with index `node` in [0, numNodes()).
+   */
+  const std::vector<int>& cpusOfNode(int node) const;
+
+  /**
+   * @return  the node index whose CPUs include `cpu`, or -1.
+   */
+  int nodeOfCpu(int cpu) const;
+
+  /**
+   * @return  the node index of the block device `dev` (e.g. st_dev of a file
+   *          on it), or -1 if sysfs doesn't tell. For partitions, the node
+   *          of the whole disk.
+   */
+  int nodeOfDevice(dev_t dev) const;
+
+  /**
+   * Spreads `nworkers` workers over the nodes in proportion to how many CPUs
+   * each node has.
+   *
+   * @return  the node index of worker `idx`, or -1 on single node hosts.
+   */
+  int nodeForWorker(int idx, int nworkers) const;
+
+  /**
+   * Restricts the calling thread to the CPUs of `node`. Does nothing on
+   * single node hosts or if `node` is -1.
+   *
+   * @return  0 on success, -1 if sched_setaffinity() failed.
+   */
+  int bindThisThread(int node) const;
+
+  /**
+   * @return  the node the calling thread currently runs on, or -1.
+   */
+  int currentNode() const;
+
+ private:
+  std::string sysfs_root_;
+  // Kernel node ids, e.g. {0, 1}. Node indexes used by this class are
+  // positions in this vector.
+  std::vector<int> node_ids_;
+  std::vector<std::vector<int>> nodes_;
+};
+
+/**
+ * Parses a sysfs cpu list such as "0-3,8,10-11".
+ *
+ * @return  0 on success, -1 if `list` is malformed.
+ */
+int parse_cpu_list(const std::string& list, std::vector<int>* out);
+
+}} // namespace facebook::logdevice
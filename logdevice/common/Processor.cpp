@@ -8,6 +8,7 @@
 #include "logdevice/common/Processor.h"
 
 #include <algorithm>
+#include <map>
 #include <memory>
 #include <numeric>
 #include <vector>
@@ -41,6 +42,7 @@
 #include "logdevice/common/UpdateableSecurityInfo.h"
 #include "logdevice/common/WheelTimer.h"
 #include "logdevice/common/Worker.h"
+#include "logdevice/common/WorkStealingExecutor.h"
 #include "logdevice/common/WorkerLoadBalancing.h"
 #include "logdevice/common/configuration/UpdateableConfig.h"
 #include "logdevice/common/configuration/nodes/NodesConfigurationManager.h"
@@ -112,7 +114,8 @@ class ProcessorImpl {
                     settings->ssl_key_path,
                     settings->ssl_ca_path,
                     settings->ssl_cert_refresh_interval,
-                    processor->stats_) {
+                    processor->stats_,
+                    settings->ssl_ktls) {
     dbg::externalLoggerLogLevel = settings->external_loglevel;
   }
 
@@ -131,6 +134,10 @@ class ProcessorImpl {
   ClientIdxAllocator client_idx_allocator_;
   ResourceBudget incoming_message_budget_;
 
+  // for lazy init of the CPU executor
+  folly::once_flag cpu_executor_init_flag_;
+  std::unique_ptr<WorkStealingExecutor> cpu_executor_;
+
   // for lazy init of background queue and threads
   folly::once_flag background_init_flag_;
   std::vector<std::unique_ptr<BackgroundThread>> background_threads_;
@@ -452,6 +459,115 @@ int Processor::postRequest(std::unique_ptr<Request>& rq) {
       rq, rq->getWorkerTypeAffinity(), getTargetThreadForRequest(rq));
 }
 
+int Processor::postBatchImpl(
+    folly::Range<std::unique_ptr<Request>*> rqs,
+    const std::vector<std::pair<WorkerType, int>>& targets,
+    bool force) {
+  ld_check_eq(rqs.size(), targets.size());
+  int rv = 0;
+
+  // Indices in `rqs` of the requests for each worker, in order.
+  std::map<std::pair<WorkerType, int>, std::vector<size_t>> per_worker;
+  for (size_t i = 0; i < rqs.size(); ++i) {
+    const auto& [worker_type, target_thread] = targets[i];
+    if (!rqs[i] || target_thread < 0 ||
+        target_thread >= getWorkerCount(worker_type)) {
+      err = E::INVALID_PARAM;
+      rv = -1;
+      continue;
+    }
+    per_worker[targets[i]].push_back(i);
+  }
+
+  std::vector<std::unique_ptr<Request>> batch;
+  std::vector<RequestType> types;
+  for (const auto& [target, indices] : per_worker) {
+    const WorkerType worker_type = target.first;
+    const worker_id_t worker_idx(target.second);
+    batch.clear();
+    types.clear();
+    for (size_t i : indices) {
+      types.push_back(rqs[i]->type_);
+      batch.push_back(std::move(rqs[i]));
+    }
+
+    Worker& w = getWorker(worker_idx, worker_type);
+    const int batch_rv =
+        force ? w.forcePostBatch(batch) : w.tryPostBatch(batch);
+    for (RequestType type : types) {
+      Request::bumpStatsWhenPosted(
+          stats_, type, worker_type, worker_idx, batch_rv == 0);
+    }
+    if (batch_rv != 0) {
+      // Nothing was posted, give the requests back to the caller.
+      ld_check_eq(batch.size(), indices.size());
+      for (size_t k = 0; k < indices.size(); ++k) {
+        rqs[indices[k]] = std::move(batch[k]);
+      }
+      rv = -1;
+    }
+  }
+  return rv;
+}
+
+std::vector<std::pair<WorkerType, int>> Processor::getTargetsForRequests(
+    folly::Range<std::unique_ptr<Request>*> rqs) {
+  std::vector<std::pair<WorkerType, int>> targets;
+  targets.reserve(rqs.size());
+  for (const auto& rq : rqs) {
+    if (rq) {
+      targets.emplace_back(
+          rq->getWorkerTypeAffinity(), getTargetThreadForRequest(rq));
+    } else {
+      // Rejected by postBatchImpl().
+      targets.emplace_back(WorkerType::GENERAL, -1);
+    }
+  }
+  return targets;
+}
+
+int Processor::postRequests(folly::Range<std::unique_ptr<Request>*> rqs) {
+  if (shutting_down_.load()) {
+    err = E::SHUTDOWN;
+    return -1;
+  }
+  return postBatchImpl(rqs, getTargetsForRequests(rqs), /* force */ false);
+}
+
+int Processor::postImportantRequests(
+    folly::Range<std::unique_ptr<Request>*> rqs) {
+  if (shutting_down_.load() && !allow_post_during_shutdown_) {
+    err = E::SHUTDOWN;
+    return -1;
+  }
+  return postBatchImpl(rqs, getTargetsForRequests(rqs), /* force */ true);
+}
+
+int Processor::applyToWorkersAndPost(
+    folly::Function<std::unique_ptr<Request>(Worker&)> func,
+    Processor::Order order) {
+  std::vector<std::unique_ptr<Request>> rqs;
+  std::vector<std::pair<WorkerType, int>> targets;
+  applyToWorkers(
+      [&](Worker& w) {
+        std::unique_ptr<Request> rq = func(w);
+        if (rq) {
+          rqs.push_back(std::move(rq));
+          targets.emplace_back(w.worker_type_, w.idx_.val());
+        }
+      },
+      order);
+
+  if (rqs.empty()) {
+    return 0;
+  }
+  if (shutting_down_.load() && !allow_post_during_shutdown_) {
+    err = E::SHUTDOWN;
+    return -1;
+  }
+  return postBatchImpl(folly::range(rqs), targets, /* force */ true);
+}
+
 int Processor::blockingRequestImpl(std::unique_ptr<Request>& rq, bool force) {
   Semaphore sem;
   rq->setClientBlockedSemaphore(&sem);
@@ -593,6 +709,12 @@ void Processor::shutdown() {
   for (auto& background_thread : impl_->background_threads_) {
     background_thread->join();
   }
+
+  // Workers are gone, results of tasks still queued will fail to be posted
+  // back with E::SHUTDOWN.
+  if (impl_->cpu_executor_) {
+    impl_->cpu_executor_->shutdown();
+  }
 }
 
 void Processor::noteWorkerQuiescent(worker_id_t worker_id, WorkerType type) {
@@ -644,6 +766,13 @@ void Processor::reportLoad(worker_id_t idx,
   impl_->worker_load_balancing_.reportLoad(idx, load);
 }
 
+worker_id_t Processor::selectRebalancingTarget(worker_id_t from,
+                                               double min_imbalance,
+                                               int64_t* excess) {
+  return impl_->worker_load_balancing_.selectRebalancingTarget(
+      from, min_imbalance, excess);
+}
+
 int Processor::postImportant(std::unique_ptr<Request>& rq) {
   return postImportant(
       rq, rq->getWorkerTypeAffinity(), getTargetThreadForRequest(rq));
@@ -749,6 +878,18 @@ bool Processor::enqueueToBackground(folly::Function<void()> fn) {
   return validateFn(fn) && impl_->background_queue_.write(std::move(fn));
 }
 
+WorkStealingExecutor& Processor::getCpuExecutor() {
+  folly::call_once(impl_->cpu_executor_init_flag_, [this] {
+    const int configured = settings()->num_cpu_executor_threads;
+    const int num_threads =
+        configured <= 0 ? settings()->num_workers : configured;
+    ld_info("Starting the CPU executor with %d threads", num_threads);
+    impl_->cpu_executor_ =
+        std::make_unique<WorkStealingExecutor>(num_threads, stats_);
+  });
+  return *impl_->cpu_executor_;
+}
+
 bool Processor::enqueueToBackgroundIfNotFull(folly::Function<void()> fn) {
   folly::call_once(
       impl_->background_init_flag_, initBackgroundQueueAndThreads, this);
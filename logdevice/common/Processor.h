@@ -12,10 +12,13 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <folly/ConcurrentBitSet.h>
 #include <folly/Function.h>
 #include <folly/Memory.h>
+#include <folly/Range.h>
 #include <folly/memory/EnableSharedFromThis.h>
 
 #include "logdevice/common/ResourceBudget.h"
@@ -65,6 +68,7 @@ class UpdateableConfig;
 class UpdateableSecurityInfo;
 class Worker;
 class WheelTimer;
+class WorkStealingExecutor;
 class Configuration;
 enum class SequencerOptions : uint8_t;
 using workers_t = std::vector<std::unique_ptr<Worker>>;
@@ -156,6 +160,21 @@ class Processor : public folly::enable_shared_from_this<Processor> {
    */
   int getTargetThreadForRequest(const std::unique_ptr<Request>& rq);
 
+  /**
+   * getTargetThreadForRequest() and worker type of each of `rqs`.
+   */
+  std::vector<std::pair<WorkerType, int>>
+  getTargetsForRequests(folly::Range<std::unique_ptr<Request>*> rqs);
+
+  /**
+   * Common implementation of postRequests(), postImportantRequests() and
+   * applyToWorkersAndPost(). Posts rqs[i] to the worker targets[i], with one
+   * batch per worker.
+   */
+  int postBatchImpl(folly::Range<std::unique_ptr<Request>*> rqs,
+                    const std::vector<std::pair<WorkerType, int>>& targets,
+                    bool force);
+
   // BufferedWriter for batching by sequencers.  Initialized only on servers.
   std::unique_ptr<SequencerBatching> sequencer_batching_;
   // Used to detect that we are in a test environment without a
@@ -217,6 +236,18 @@ class Processor : public folly::enable_shared_from_this<Processor> {
   void applyToWorkers(folly::Function<void(Worker&)> func,
                       Order order = Order::FORWARD);
 
+  /**
+   * Like applyToWorkers(), but `func` may return a Request to execute on the
+   * Worker it was called with (or nullptr). Once `func` was called for all
+   * Workers, the requests are posted with postImportantRequests() semantics.
+   *
+   * @return 0 if all requests were posted, -1 otherwise with err set as by
+   *         postImportant(). Requests that couldn't be posted are destroyed.
+   */
+  int applyToWorkersAndPost(
+      folly::Function<std::unique_ptr<Request>(Worker&)> func,
+      Order order = Order::FORWARD);
+
   void applyToWorkerPool(folly::Function<void(Worker&)>&& func,
                          Order order = Order::FORWARD,
                          WorkerType worker_type = WorkerType::GENERAL) {
@@ -334,6 +365,27 @@ class Processor : public folly::enable_shared_from_this<Processor> {
   int postImportant(std::unique_ptr<Request>& rq,
                     WorkerType worker_type,
                     int target_thread);
+
+  /**
+   * Posts each of `rqs` to the Worker that postRequest() would pick for it.
+   * Requests going to the same Worker are handed to it as one batch, which
+   * wakes up its thread once rather than once per request (see
+   * Worker::forcePostBatch()). Requests for the same Worker execute in the
+   * order they have in `rqs`.
+   *
+   * @param rqs  requests to execute. Requests that were posted are set to
+   *             nullptr, ownership of the others remains with the caller.
+   *
+   * @return 0 if all requests were posted, -1 otherwise with err set as by
+   *         postRequest() for one of the failed requests.
+   */
+  int postRequests(folly::Range<std::unique_ptr<Request>*> rqs);
+
+  /**
+   * Like postRequests(), but with the semantics of postImportant().
+   */
+  int postImportantRequests(folly::Range<std::unique_ptr<Request>*> rqs);
+
   // Older alias for postImportant()
   int postWithRetrying(std::unique_ptr<Request>& rq) {
     return postImportant(rq);
@@ -616,6 +668,14 @@ class Processor : public folly::enable_shared_from_this<Processor> {
                           int64_t load,
                           WorkerType worker_type);
 
+  /**
+   * Proxy for WorkerLoadBalancing::selectRebalancingTarget(), used by
+   * GENERAL workers to pick a worker to move client connections to.
+   */
+  worker_id_t selectRebalancingTarget(worker_id_t from,
+                                      double min_imbalance,
+                                      int64_t* excess);
+
   SequencerBatching& sequencerBatching();
 
   const std::string& getName() {
@@ -667,6 +727,11 @@ class Processor : public folly::enable_shared_from_this<Processor> {
 
   bool enqueueToBackgroundIfNotFull(folly::Function<void()> fn);
 
+  // Work stealing executor for CPU-heavy work that doesn't touch Worker
+  // state, shared by all workers. Started on first use. Workers should use
+  // Worker::offloadToCpuExecutor() to get results back.
+  WorkStealingExecutor& getCpuExecutor();
+
   // For debugging.  I can't think of a good way to distinguish different client
   // instances.  Even the Processor's "this" pointer won't do: although there's
   // a 1:1 correspondence between Client and Processor, two different Processors
@@ -7,6 +7,7 @@
  */
 #pragma once
 
+#include <chrono>
 #include <limits>
 #include <memory>
 #include <utility>
@@ -173,6 +174,18 @@ class Recipient {
     return shard_;
   }
 
+  /**
+   * Remember the time at which the STORE for this recipient was passed to
+   * TCP, so that the STORE->STORED round trip can be measured.
+   */
+  void setStoreSentTime(std::chrono::steady_clock::time_point t) {
+    store_sent_time_ = t;
+  }
+
+  std::chrono::steady_clock::time_point getStoreSentTime() const {
+    return store_sent_time_;
+  }
+
   void swap(Recipient& other) {
     if (this == &other) {
       return;
@@ -186,6 +199,7 @@ class Recipient {
     this->on_socket_closed_.swap(other.on_socket_closed_);
     this->on_bw_avail_.swap(other.on_bw_avail_);
     std::swap(this->state_, other.state_);
+    std::swap(this->store_sent_time_, other.store_sent_time_);
 
     // the two Recipient::SocketCloseCallback objects have the same
     // .appender_ pointers. No need to swap those.
@@ -211,6 +225,11 @@ class Recipient {
   // one-byte field indicating the state of the recipient.
   State state_ = State::REQUEST_PENDING;
 
+  // when the STORE was passed to TCP for delivery to this recipient,
+  // time_point::min() if not sent yet
+  std::chrono::steady_clock::time_point store_sent_time_ =
+      std::chrono::steady_clock::time_point::min();
+
   // this functor is called when a Connection through which we sent a
   // STORE messages to this recipient closes before a reply is
   // received. The effect is to decrement Appender's count of copies
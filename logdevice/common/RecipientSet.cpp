@@ -24,6 +24,20 @@ void RecipientSet::replace(const StoreChainLink copyset[],
   }
 }
 
+bool RecipientSet::add(const StoreChainLink copyset[],
+                       int size,
+                       Appender* appender) {
+  if (recipients_.size() + size > recipients_.capacity() ||
+      recipients_.size() + size > COPYSET_SIZE_MAX) {
+    return false;
+  }
+  for (int i = 0; i < size; i++) {
+    ld_check(!find(copyset[i].destination));
+    recipients_.emplace_back(copyset[i].destination, appender);
+  }
+  return true;
+}
+
 int RecipientSet::indexOf(ShardID shard) {
   int i = 0;
   for (Recipient& r : recipients_) {
@@ -49,7 +49,8 @@ class RecipientSet {
 
   void reset(copyset_size_t replication, copyset_size_t extra) {
     replication_ = replication;
-    recipients_.reserve(replication_ + extra);
+    // leave room for one hedge recipient, see add()
+    recipients_.reserve(replication_ + extra + 1);
   }
 
   copyset_size_t getReplication() const {
@@ -94,6 +95,16 @@ class RecipientSet {
    */
   void replace(const StoreChainLink copyset[], int size, Appender* appender);
 
+  /**
+   * Add recipients to the set, e.g. for a hedge STORE. Existing Recipients
+   * have registered their socket callbacks, so this fails instead of moving
+   * them to a larger buffer.
+   *
+   * @return true on success, false if there is not enough spare capacity,
+   *         in which case the set is not changed
+   */
+  bool add(const StoreChainLink copyset[], int size, Appender* appender);
+
   /**
    * @return a pointer to Recipient with the specified nid in the set,
    *          or nullptr if nid is not in the set.
@@ -44,6 +44,20 @@ std::shared_ptr<folly::SSLContext> SSLFetcher::getSSLContext(bool loadCert) {
       // Disabling sessions caching
       SSL_CTX_set_session_cache_mode(context_->getSSLCtx(), SSL_SESS_CACHE_OFF);
 
+      // Have OpenSSL hand sessions to kernel TLS once the handshake is done.
+      // If the kernel lacks the tls module or the negotiated cipher, it keeps
+      // encrypting in userspace.
+      if (ktls_) {
+#ifdef SSL_OP_ENABLE_KTLS
+        context_->setOptions(SSL_OP_ENABLE_KTLS);
+#else
+        RATELIMIT_WARNING(std::chrono::seconds(60),
+                          1,
+                          "--ssl-ktls is set but OpenSSL was built without "
+                          "kernel TLS support, encrypting in userspace");
+#endif
+      }
+
       // keep track of context creation parameters
       updateState(loadCert, SSL_CTX_get0_certificate(context_->getSSLCtx()));
     } catch (const std::exception& ex) {
@@ -78,4 +92,15 @@ void SSLFetcher::updateState(bool loadCert, X509* cert) {
   state_.last_loaded_ = std::chrono::steady_clock::now();
 }
 
+bool isKernelTlsEnabled(const SSL* ssl) {
+  if (!ssl) {
+    return false;
+  }
+#ifdef BIO_get_ktls_send
+  return BIO_get_ktls_send(SSL_get_wbio(ssl));
+#else
+  return false;
+#endif
+}
+
 }} // namespace facebook::logdevice
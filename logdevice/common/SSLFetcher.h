@@ -32,11 +32,13 @@ class SSLFetcher {
              const std::string& key_path,
              const std::string& ca_path,
              std::chrono::seconds refresh_interval,
-             StatsHolder* stats = nullptr)
+             StatsHolder* stats = nullptr,
+             bool ktls = false)
       : cert_path_(cert_path),
         key_path_(key_path),
         ca_path_(ca_path),
         refresh_interval_(refresh_interval),
+        ktls_(ktls),
         stats_(stats) {}
 
   /**
@@ -55,6 +57,8 @@ class SSLFetcher {
   const std::string key_path_;
   const std::string ca_path_;
   const std::chrono::seconds refresh_interval_;
+  // Enable kernel TLS offload on the created contexts.
+  const bool ktls_;
 
   struct ContextState {
     std::chrono::time_point<std::chrono::steady_clock> last_loaded_;
@@ -76,4 +80,10 @@ class SSLFetcher {
   void updateState(bool loadCert, X509* cert);
 };
 
+/**
+ * @return true if record encryption for the given established session was
+ *         handed to kernel TLS (see --ssl-ktls).
+ */
+bool isKernelTlsEnabled(const SSL* ssl);
+
 }} // namespace facebook::logdevice
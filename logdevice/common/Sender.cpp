@@ -7,6 +7,9 @@
  */
 #include "logdevice/common/Sender.h"
 
+#include <unistd.h>
+
+#include <algorithm>
 #include <chrono>
 #include <stdexcept>
 #include <unordered_map>
@@ -16,6 +19,7 @@
 #include <folly/Random.h>
 #include <folly/ScopeGuard.h>
 #include <folly/container/F14Map.h>
+#include <folly/hash/Hash.h>
 #include <folly/json.h>
 #include <folly/small_vector.h>
 
@@ -42,6 +46,7 @@
 #include "logdevice/common/protocol/Message.h"
 #include "logdevice/common/protocol/MessageDispatch.h"
 #include "logdevice/common/protocol/MessageTracer.h"
+#include "logdevice/common/request_util.h"
 #include "logdevice/common/settings/Settings.h"
 #include "logdevice/common/stats/ServerHistograms.h"
 #include "logdevice/common/stats/Stats.h"
@@ -63,6 +68,41 @@ class DisconnectedClientCallback : public SocketCallback {
   void operator()(Status st, const Address& name) override;
 };
 
+// Closes a server Connection that Sender no longer tracks. Done from a
+// separate event loop iteration because we may be running in a callback of
+// that Connection.
+void closeLater(std::unique_ptr<Connection> conn, Status reason) {
+  STAT_INCR(Worker::stats(), server_connection_close_backlog);
+  Worker::onThisThread()->add([s = std::move(conn), reason] {
+    if (s->good()) {
+      s->close(reason);
+    }
+    STAT_DECR(Worker::stats(), server_connection_close_backlog);
+  });
+}
+
+// For how long messages to the old ClientID of a client connection moved to
+// another worker are forwarded there. Replies to requests received before the
+// move normally go out well within that.
+constexpr std::chrono::seconds kMigratedClientForwardingTime{60};
+
+// Load is moved gradually, at most this many connections at a time.
+constexpr size_t kMaxClientConnectionsMigratedAtOnce = 8;
+
+// Closes the socket of a ConnectionMigrationState that no worker took over,
+// e.g. if the request carrying it was dropped during shutdown.
+std::shared_ptr<ConnectionMigrationState>
+makeSharedMigrationState(ConnectionMigrationState state) {
+  return std::shared_ptr<ConnectionMigrationState>(
+      new ConnectionMigrationState(std::move(state)),
+      [](ConnectionMigrationState* s) {
+        if (s->fd >= 0) {
+          ::close(s->fd);
+        }
+        delete s;
+      });
+}
+
 } // namespace
 
 namespace admin_command_table {
@@ -90,6 +130,44 @@ class SenderImpl {
   // attempts is controlled by a ConnectionThrottle.
   folly::F14NodeMap<node_index_t, std::unique_ptr<Connection>> server_conns_;
 
+  // Additional DATA Connections to LogDevice servers, if
+  // Settings::connections_per_node is greater than 1. They carry messages
+  // that can be striped by log, leaving server_conns_ to everything else.
+  // Each vector has connections_per_node - 1 slots, null until first used.
+  folly::F14NodeMap<node_index_t, std::vector<std::unique_ptr<Connection>>>
+      server_stripes_;
+
+  // Calls fn on each additional Connection to the node at index idx.
+  template <typename Fn>
+  void forEachStripe(node_index_t idx, Fn fn) {
+    auto it = server_stripes_.find(idx);
+    if (it != server_stripes_.end()) {
+      for (auto& conn : it->second) {
+        if (conn) {
+          fn(*conn);
+        }
+      }
+    }
+  }
+
+  // Index of the additional Connection, out of n, that carries all messages
+  // striped by log_id.
+  static size_t stripeIndex(logid_t log_id, size_t n) {
+    return folly::hash::twang_mix64(log_id.val_) % n;
+  }
+
+  // Calls fn on each additional Connection to any node.
+  template <typename Fn>
+  void forAllStripes(Fn fn) const {
+    for (const auto& entry : server_stripes_) {
+      for (const auto& conn : entry.second) {
+        if (conn) {
+          fn(*conn);
+        }
+      }
+    }
+  }
+
   // a map of all Connections wrapping connections that were accepted from
   // clients, keyed by 32-bit client ids. This map is empty on clients.
   folly::F14NodeMap<ClientID, std::unique_ptr<Connection>, ClientID::Hash>
@@ -97,6 +175,16 @@ class SenderImpl {
 
   ClientIdxAllocator* client_id_allocator_;
 
+  // Client connections moved to other workers by migrateClientConnections(),
+  // keyed by the ClientID they had here.
+  struct MigratedClient {
+    worker_id_t worker;
+    ClientID client_name; // on `worker`
+    steady_clock::time_point forward_until;
+  };
+  folly::F14FastMap<ClientID, MigratedClient, ClientID::Hash>
+      migrated_clients_;
+
   Timer detect_slow_socket_timer_;
 };
 
@@ -161,6 +249,8 @@ Sender::Sender(std::shared_ptr<const Settings> settings,
       connection_factory_(std::move(connection_factory)),
       impl_(new SenderImpl(client_id_allocator)),
       is_gossip_sender_(is_gossip_sender),
+      connections_per_node_(is_gossip_sender ? 1
+                                             : settings->connections_per_node),
       nodes_(std::move(nodes)),
       my_node_index_(my_index),
       my_location_(std::move(my_location)) {
@@ -191,11 +281,26 @@ int Sender::addClient(int fd,
                       ResourceBudget::Token conn_token,
                       SocketType type,
                       ConnectionType conntype) {
+  auto w = Worker::onThisThread();
+  ClientID client_name(
+      impl_->client_id_allocator_->issueClientIdx(w->worker_type_, w->idx_));
+
+  Connection* conn = addClientConnection(
+      fd, client_name, client_addr, std::move(conn_token), type, conntype);
+  return conn ? 0 : -1;
+}
+
+Connection* Sender::addClientConnection(int fd,
+                                        ClientID client_name,
+                                        const Sockaddr& client_addr,
+                                        ResourceBudget::Token conn_token,
+                                        SocketType type,
+                                        ConnectionType conntype) {
   if (shutting_down_) {
     ld_check(false); // listeners are shut down before Senders.
     ld_error("Sender is shut down");
     err = E::SHUTDOWN;
-    return -1;
+    return nullptr;
   }
 
   eraseDisconnectedClients();
@@ -209,10 +314,6 @@ int Sender::addClient(int fd,
     Worker::unpackRunContext(prev_context);
   }
 
-  auto w = Worker::onThisThread();
-  ClientID client_name(
-      impl_->client_id_allocator_->issueClientIdx(w->worker_type_, w->idx_));
-
   try {
     // Until we have better information (e.g. in a future update to the
     // HELLO message), assume clients are within our region unless they
@@ -243,7 +344,7 @@ int Sender::addClient(int fd,
                   client_addr.toString().c_str());
       ld_check(0);
       err = E::EXISTS;
-      return -1;
+      return nullptr;
     }
 
     auto* cb = new DisconnectedClientCallback();
@@ -255,13 +356,191 @@ int Sender::addClient(int fd,
       ld_check(false);
       delete cb;
     }
+    return res.first->second.get();
   } catch (const ConstructorFailed&) {
     ld_error("Failed to construct a client Connection: error %d (%s)",
              static_cast<int>(err),
              error_description(err));
+    return nullptr;
+  }
+}
+
+int Sender::addMigratedClient(ClientID client_name,
+                              ConnectionMigrationState& state) {
+  const int fd = std::exchange(state.fd, -1);
+  Connection* conn = addClientConnection(fd,
+                                         client_name,
+                                         state.client_addr,
+                                         std::move(state.conn_token),
+                                         state.type,
+                                         state.conntype);
+  if (!conn) {
+    RATELIMIT_ERROR(std::chrono::seconds(10),
+                    2,
+                    "Failed to take over client connection %s from %s: %s",
+                    client_name.toString().c_str(),
+                    state.client_addr.toString().c_str(),
+                    error_description(err));
+    ::close(fd);
+    impl_->client_id_allocator_->releaseClientIdx(client_name);
+    return -1;
+  }
+
+  conn->restoreFromMigration(state);
+  STAT_INCR(Worker::stats(), client_connections_migrated_in);
+  return 0;
+}
+
+size_t Sender::migrateClientConnections(worker_id_t target,
+                                        std::chrono::microseconds budget) {
+  ld_check(onMyWorker());
+  Worker* w = Worker::onThisThread();
+  ld_check(w->worker_type_ == WorkerType::GENERAL);
+  ld_check(target != w->idx_);
+
+  const auto now = steady_clock::now();
+  for (auto it = impl_->migrated_clients_.begin();
+       it != impl_->migrated_clients_.end();) {
+    if (it->second.forward_until <= now) {
+      it = impl_->migrated_clients_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  if (shutting_down_) {
+    return 0;
+  }
+
+  struct Candidate {
+    ClientID client_name;
+    std::chrono::microseconds cpu_time;
+  };
+  std::vector<Candidate> candidates;
+  const auto min_idle = Worker::settings().client_connection_migration_min_idle;
+  for (auto& entry : impl_->client_conns_) {
+    Connection& conn = *entry.second;
+    // Taken from every connection, so that the next round only looks at what
+    // was used since this one.
+    const auto cpu_time = conn.takeCpuTime();
+    if (cpu_time.count() > 0 && cpu_time <= budget &&
+        now - conn.getLastMessageReceivedTime() >= min_idle &&
+        conn.canMigrate()) {
+      candidates.push_back(Candidate{entry.first, cpu_time});
+    }
+  }
+  std::sort(candidates.begin(),
+            candidates.end(),
+            [](const Candidate& a, const Candidate& b) {
+              return a.cpu_time > b.cpu_time;
+            });
+
+  size_t moved = 0;
+  for (const Candidate& candidate : candidates) {
+    if (moved >= kMaxClientConnectionsMigratedAtOnce) {
+      break;
+    }
+    if (candidate.cpu_time > budget) {
+      continue;
+    }
+    auto pos = impl_->client_conns_.find(candidate.client_name);
+    ld_check(pos != impl_->client_conns_.end());
+    Connection& conn = *pos->second;
+
+    // Issued here rather than on the target worker so that replies to the
+    // old ClientID can be forwarded right away.
+    const ClientID new_name = impl_->client_id_allocator_->issueClientIdx(
+        WorkerType::GENERAL, target);
+    ConnectionMigrationState state;
+    if (conn.detachForMigration(&state) != 0) {
+      // Out of fds, no point trying the others.
+      impl_->client_id_allocator_->releaseClientIdx(new_name);
+      break;
+    }
+
+    auto shared_state = makeSharedMigrationState(std::move(state));
+    std::unique_ptr<Request> rq =
+        FuncRequest::make(target,
+                          WorkerType::GENERAL,
+                          RequestType::MIGRATE_CLIENT_CONNECTION,
+                          [new_name, shared_state] {
+                            Worker::onThisThread()->sender().addMigratedClient(
+                                new_name, *shared_state);
+                          });
+    // Important so that it can't be overtaken by messages forwarded to the
+    // connection afterwards.
+    if (w->processor_->postImportant(rq) != 0) {
+      // The connection is closed already, the client will reconnect.
+      RATELIMIT_ERROR(std::chrono::seconds(10),
+                      2,
+                      "Failed to move client connection %s to worker %s: %s",
+                      candidate.client_name.toString().c_str(),
+                      Worker::getName(WorkerType::GENERAL, target).c_str(),
+                      error_description(err));
+      impl_->client_id_allocator_->releaseClientIdx(new_name);
+      continue;
+    }
+
+    ld_debug("Moved client connection %s to worker %s as %s, cpu time %ldus",
+             candidate.client_name.toString().c_str(),
+             Worker::getName(WorkerType::GENERAL, target).c_str(),
+             new_name.toString().c_str(),
+             candidate.cpu_time.count());
+    impl_->migrated_clients_[candidate.client_name] =
+        SenderImpl::MigratedClient{
+            target, new_name, now + kMigratedClientForwardingTime};
+    budget -= candidate.cpu_time;
+    ++moved;
+    STAT_INCR(Worker::stats(), client_connections_migrated_out);
+  }
+  return moved;
+}
+
+void Sender::resetClientConnectionsCpuTime() {
+  ld_check(onMyWorker());
+  for (auto& entry : impl_->client_conns_) {
+    entry.second->takeCpuTime();
+  }
+}
+
+int Sender::forwardToMigratedClient(std::unique_ptr<Message>& msg,
+                                    ClientID cid,
+                                    BWAvailableCallback* on_bw_avail,
+                                    SocketCallback* onclose) {
+  auto it = impl_->migrated_clients_.find(cid);
+  if (it == impl_->migrated_clients_.end()) {
+    err = E::NOTFOUND;
+    return -1;
+  }
+  if (it->second.forward_until <= steady_clock::now()) {
+    impl_->migrated_clients_.erase(it);
+    err = E::NOTFOUND;
+    return -1;
+  }
+  if (on_bw_avail || onclose) {
+    // These would have to be called on this Worker. Callers handle the
+    // client going away anyway.
+    err = E::UNREACHABLE;
     return -1;
   }
 
+  const ClientID new_name = it->second.client_name;
+  // FuncRequest needs a copyable function.
+  auto shared_msg = std::make_shared<std::unique_ptr<Message>>(std::move(msg));
+  std::unique_ptr<Request> rq =
+      FuncRequest::make(it->second.worker,
+                        WorkerType::GENERAL,
+                        RequestType::FORWARD_TO_MIGRATED_CLIENT,
+                        [new_name, shared_msg] {
+                          Worker::onThisThread()->sender().sendMessage(
+                              std::move(*shared_msg), new_name);
+                        });
+  if (Worker::onThisThread()->processor_->postImportant(rq) != 0) {
+    // err set by postImportant()
+    msg = std::move(*shared_msg);
+    return -1;
+  }
+  STAT_INCR(Worker::stats(), client_messages_forwarded);
   return 0;
 }
 
@@ -449,6 +728,14 @@ int Sender::sendMessageImpl(std::unique_ptr<Message>&& msg,
                             const Address& addr,
                             BWAvailableCallback* on_bw_avail,
                             SocketCallback* onclose) {
+  if (addr.isClientAddress() && !impl_->migrated_clients_.empty()) {
+    int rv =
+        forwardToMigratedClient(msg, addr.asClientID(), on_bw_avail, onclose);
+    if (rv == 0 || err != E::NOTFOUND) {
+      return rv;
+    }
+  }
+
   Connection* conn = getConnection(addr, *msg);
   if (!conn) {
     // err set by getConnection()
@@ -639,6 +926,8 @@ void Sender::resetServerSocketConnectThrottle(NodeID node_id) {
   if (conn != nullptr) {
     conn->resetConnectThrottle();
   }
+  impl_->forEachStripe(
+      node_id.index(), [](Connection& c) { c.resetConnectThrottle(); });
 }
 
 void Sender::setPeerShuttingDown(NodeID node_id) {
@@ -648,9 +937,13 @@ void Sender::setPeerShuttingDown(NodeID node_id) {
   if (conn != nullptr) {
     conn->setPeerShuttingDown();
   }
+  impl_->forEachStripe(
+      node_id.index(), [](Connection& c) { c.setPeerShuttingDown(); });
 }
 
-int Sender::registerOnSocketClosed(const Address& addr, SocketCallback& cb) {
+int Sender::registerOnSocketClosed(const Address& addr,
+                                   SocketCallback& cb,
+                                   logid_t striping_log_id) {
   Connection* conn;
 
   if (addr.isClientAddress()) {
@@ -670,6 +963,13 @@ int Sender::registerOnSocketClosed(const Address& addr, SocketCallback& cb) {
       err = E::NOTFOUND;
       return -1;
     }
+    // Messages striped by log go over an additional Connection; it is that
+    // Connection closing that loses them.
+    Connection* stripe =
+        findStripe(addr.asNodeID().index(), striping_log_id);
+    if (stripe) {
+      conn = stripe;
+    }
   }
 
   return conn->pushOnCloseCallback(cb);
@@ -683,6 +983,12 @@ void Sender::flushOutputAndClose(Status reason) {
       ++open_socket_count;
     }
   }
+  impl_->forAllStripes([&](Connection& conn) {
+    if (!conn.isClosed()) {
+      conn.flushOutputAndClose(reason);
+      ++open_socket_count;
+    }
+  });
 
   for (auto& it : impl_->client_conns_) {
     if (it.second && !it.second->isClosed()) {
@@ -729,6 +1035,11 @@ int Sender::closeServerSocket(NodeID peer, Status reason) {
   if (!c->isClosed()) {
     c->close(reason);
   }
+  impl_->forEachStripe(peer.index(), [&](Connection& conn) {
+    if (!conn.isClosed()) {
+      conn.close(reason);
+    }
+  });
 
   return 0;
 }
@@ -742,6 +1053,12 @@ std::pair<uint32_t, uint32_t> Sender::closeAllSockets() {
       entry.second->close(E::SHUTDOWN);
     }
   }
+  impl_->forAllStripes([&](Connection& conn) {
+    if (!conn.isClosed()) {
+      sockets_closed.first++;
+      conn.close(E::SHUTDOWN);
+    }
+  });
 
   for (auto& entry : impl_->client_conns_) {
     if (!entry.second->isClosed()) {
@@ -771,6 +1088,7 @@ void Sender::shutdownSockets(folly::Executor* executor) {
   executor->add([&] {
     shutting_down_ = true;
     closeAllSockets();
+    impl_->server_stripes_.clear();
     impl_->server_conns_.clear();
     impl_->client_conns_.clear();
     sem.post();
@@ -801,6 +1119,22 @@ bool Sender::isClosed() const {
       }
     }
   }
+  for (const auto& entry : impl_->server_stripes_) {
+    for (const auto& conn : entry.second) {
+      if (conn && !conn->isClosed()) {
+        if (!go_over_all_sockets) {
+          return false;
+        }
+
+        ++num_open_server_sockets;
+        size_t pending_bytes = conn->getBytesPending();
+        if (server_with_max_pending_bytes < pending_bytes) {
+          max_pending_work_server = conn.get();
+          server_with_max_pending_bytes = pending_bytes;
+        }
+      }
+    }
+  }
 
   int num_open_client_sockets = 0;
   ClientID max_pending_work_clientID;
@@ -862,7 +1196,8 @@ bool Sender::isClosed(const Address& addr) const {
 
 int Sender::checkConnection(NodeID nid,
                             ClientID* our_name_at_peer,
-                            bool allow_unencrypted) {
+                            bool allow_unencrypted,
+                            logid_t striping_log_id) {
   if (!nid.isNodeID()) {
     ld_check(false);
     err = E::INVALID_PARAM;
@@ -881,6 +1216,19 @@ int Sender::checkConnection(NodeID nid,
     return -1;
   }
 
+  if (connections_per_node_ > 1 && striping_log_id != LOGID_INVALID) {
+    // Messages of this log are sent on an additional Connection, check that
+    // one instead. selectStripe() replaces it if it was closed or does not
+    // match the main Connection's type anymore.
+    Connection* stripe = findStripe(nid.index(), striping_log_id);
+    if (!stripe || stripe->isClosed() ||
+        stripe->getConnType() != c->getConnType()) {
+      err = E::NOTFOUND;
+      return -1;
+    }
+    c = stripe;
+  }
+
   // check if the Connection to destination has reached its buffer limit
   if (c->sizeLimitsExceeded()) {
     err = E::NOBUFS;
@@ -911,7 +1259,9 @@ int Sender::checkConnection(ClientID cid, bool check_peer_is_node) {
   return 0;
 }
 
-int Sender::connect(NodeID nid, bool allow_unencrypted) {
+int Sender::connect(NodeID nid,
+                    bool allow_unencrypted,
+                    logid_t striping_log_id) {
   if (shutting_down_) {
     err = E::SHUTDOWN;
     return -1;
@@ -922,6 +1272,10 @@ int Sender::connect(NodeID nid, bool allow_unencrypted) {
   if (!c) {
     return -1;
   }
+  c = selectStripe(*c, striping_log_id);
+  if (!c) {
+    return -1;
+  }
 
   return c->connect();
 }
@@ -992,13 +1346,7 @@ Connection* Sender::initServerConnection(NodeID nid,
       // We have a plaintext connection, but now we need an encrypted one.
       // Scheduling this Connection to be closed and moving it out of
       // server_conns_ to initialize an SSL connection in its place.
-      STAT_INCR(Worker::stats(), server_connection_close_backlog);
-      Worker::onThisThread()->add([s = std::move(it->second)] {
-        if (s->good()) {
-          s->close(E::SSLREQUIRED);
-        }
-        STAT_DECR(Worker::stats(), server_connection_close_backlog);
-      });
+      closeLater(std::move(it->second), E::SSLREQUIRED);
       ld_check(!it->second);
       impl_->server_conns_.erase(it);
       it = impl_->server_conns_.end();
@@ -1084,6 +1432,67 @@ Connection* Sender::initServerConnection(NodeID nid,
   return it->second.get();
 }
 
+Connection* FOLLY_NULLABLE Sender::selectStripe(Connection& main_conn,
+                                                logid_t log_id) {
+  if (connections_per_node_ <= 1 || log_id == LOGID_INVALID) {
+    return &main_conn;
+  }
+  ld_check(!is_gossip_sender_);
+
+  const NodeID nid = main_conn.peer_name_.asNodeID();
+  auto& stripes = impl_->server_stripes_[nid.index()];
+  if (stripes.empty()) {
+    stripes.resize(connections_per_node_ - 1);
+  }
+  // All messages of a log go through the same Connection, so they are
+  // delivered in the order they were sent.
+  auto& conn = stripes[SenderImpl::stripeIndex(log_id, stripes.size())];
+
+  // Replace the stripe if it was closed, and follow the main Connection when
+  // it is replaced by an SSL one, like initServerConnection() does.
+  if (conn && conn->isClosed()) {
+    closeLater(std::move(conn), E::PEER_CLOSED);
+  } else if (conn && conn->getConnType() != main_conn.getConnType()) {
+    closeLater(std::move(conn), E::SSLREQUIRED);
+  }
+
+  if (!conn) {
+    try {
+      conn = connection_factory_->createConnection(
+          nid,
+          SocketType::DATA,
+          main_conn.getConnType(),
+          main_conn.getPeerType(),
+          main_conn.flow_group_,
+          std::make_unique<SocketDependencies>(
+              Worker::onThisThread()->processor_, this));
+    } catch (ConstructorFailed& exp) {
+      ld_error("Could not create additional Connection to node %s: %s",
+               toString(nid).c_str(),
+               exp.what());
+      if (err != E::NOTINCONFIG && err != E::NOSSLCONFIG) {
+        err = E::INTERNAL;
+      }
+      return nullptr;
+    }
+    STAT_INCR(Worker::stats(), connection_stripes_created);
+  }
+  return conn.get();
+}
+
+Connection* FOLLY_NULLABLE Sender::findStripe(node_index_t idx,
+                                              logid_t log_id) const {
+  if (connections_per_node_ <= 1 || log_id == LOGID_INVALID) {
+    return nullptr;
+  }
+  auto it = impl_->server_stripes_.find(idx);
+  if (it == impl_->server_stripes_.end() || it->second.empty()) {
+    return nullptr;
+  }
+  const auto& stripes = it->second;
+  return stripes[SenderImpl::stripeIndex(log_id, stripes.size())].get();
+}
+
 Sockaddr Sender::getSockaddr(const Address& addr) {
   if (addr.isClientAddress()) {
     auto pos = impl_->client_conns_.find(addr.id_.client_);
@@ -1154,6 +1563,11 @@ Connection* FOLLY_NULLABLE Sender::getConnection(const NodeID& nid,
     // err set by initServerConnection()
     return nullptr;
   }
+  conn = selectStripe(*conn, msg.getStripingLogID());
+  if (!conn) {
+    // err set by selectStripe()
+    return nullptr;
+  }
 
   int rv = conn->connect();
 
@@ -1524,6 +1938,12 @@ void Sender::noteConfigurationChanged(
     }
 
     s->close(E::NOTINCONFIG);
+    impl_->forEachStripe(i, [](Connection& conn) {
+      if (!conn.isClosed()) {
+        conn.close(E::NOTINCONFIG);
+      }
+    });
+    impl_->server_stripes_.erase(i);
     it = impl_->server_conns_.erase(it);
   }
 }
@@ -1596,6 +2016,8 @@ std::string Sender::dumpQueuedMessages(Address addr) const {
     for (const auto& entry : impl_->server_conns_) {
       entry.second->dumpQueuedMessages(&counts);
     }
+    impl_->forAllStripes(
+        [&](const Connection& conn) { conn.dumpQueuedMessages(&counts); });
 
     for (const auto& entry : impl_->client_conns_) {
       entry.second->dumpQueuedMessages(&counts);
@@ -1613,6 +2035,7 @@ void Sender::forEachConnection(
   for (const auto& entry : impl_->server_conns_) {
     cb(*entry.second);
   }
+  impl_->forAllStripes(cb);
   for (const auto& entry : impl_->client_conns_) {
     cb(*entry.second);
   }
@@ -1670,6 +2093,7 @@ void Sender::closeSlowSockets() {
           entry.first);
     }
   }
+  impl_->forAllStripes(close_if_slow);
   for (auto& entry : impl_->client_conns_) {
     Connection* conn = entry.second.get();
     if (conn) {
@@ -7,6 +7,7 @@
  */
 #pragma once
 
+#include <chrono>
 #include <forward_list>
 #include <functional>
 #include <limits>
@@ -33,6 +34,7 @@
 #include "logdevice/common/configuration/TrafficClass.h"
 #include "logdevice/common/configuration/TrafficShapingConfig.h"
 #include "logdevice/common/protocol/Message.h"
+#include "logdevice/common/types_internal.h"
 #include "logdevice/include/Err.h"
 
 // Think twice before adding new includes here!  This file is included in many
@@ -52,6 +54,7 @@ class NodesConfiguration;
 class BWAvailableCallback;
 class ClientIdxAllocator;
 class Connection;
+struct ConnectionMigrationState;
 class FlowGroup;
 class FlowGroupsUpdate;
 class SenderImpl;
@@ -415,8 +418,15 @@ class Sender : public SenderBase {
    *                     the incoming Connection was already closed.
    * INVALID_PARAM  if cb is already on
    * some callback list (debug build asserts)
+   *
+   * If striping_log_id is valid and addr is a server address, cb is pushed
+   * onto the Connection that messages striped by that log are sent on (see
+   * selectStripe()), or onto the main Connection to that node if no such
+   * Connection exists yet.
    */
-  int registerOnSocketClosed(const Address& addr, SocketCallback& cb);
+  int registerOnSocketClosed(const Address& addr,
+                             SocketCallback& cb,
+                             logid_t striping_log_id = LOGID_INVALID);
 
   /**
    * Tells all open Connections to flush output and close, asynchronously.
@@ -521,10 +531,17 @@ class Sender : public SenderBase {
    * Connection to destination is valid but reaches its buffer limit DISABLED
    * connection is currently marked down after an unsuccessful connection
    * attempt INVALID_PARAM  nid is invalid (debug build asserts)
+   *
+   * If striping_log_id is valid, the checks are made on the Connection that
+   * messages striped by that log are sent on (see selectStripe()), and
+   * our_name_at_peer names that Connection. NOTFOUND is reported if it has
+   * not been created yet or was closed; connect() with the same log id
+   * (re)creates it.
    */
   int checkConnection(NodeID nid,
                       ClientID* our_name_at_peer,
-                      bool allow_unencrypted);
+                      bool allow_unencrypted,
+                      logid_t striping_log_id = LOGID_INVALID);
 
   /**
    * Check if a working connection to a give client exists. If peer_is_client is
@@ -548,8 +565,13 @@ class Sender : public SenderBase {
    *         NOSSLCONFIG   Connection to nid must use SSL but SSL is not
    *                       configured for nid
    *         see Connection::connect() for the rest of possible error codes
+   *
+   * If striping_log_id is valid, also connects the Connection that messages
+   * striped by that log are sent on, creating it if needed.
    */
-  int connect(NodeID nid, bool allow_unencrypted);
+  int connect(NodeID nid,
+              bool allow_unencrypted,
+              logid_t striping_log_id = LOGID_INVALID);
 
   /**
    * @param addr  peer name of a client or server Connection expected to be
@@ -700,6 +722,28 @@ class Sender : public SenderBase {
                 SocketType type,
                 ConnectionType conntype);
 
+  /**
+   * Moves idle client connections of this Worker to GENERAL worker `target`,
+   * busiest first, until the CPU time they used since the previous call adds
+   * up to `budget`. Only connections for which Connection::canMigrate() is
+   * true and that have been idle for at least
+   * --client-connection-migration-min-idle are considered. The connections
+   * get new ClientIDs on `target`; messages sent to their old ClientIDs on
+   * this Worker are forwarded for a while.
+   *
+   * @return  number of connections moved
+   */
+  size_t migrateClientConnections(worker_id_t target,
+                                  std::chrono::microseconds budget);
+
+  /**
+   * Discards the CPU time client connections used since the previous call to
+   * this or migrateClientConnections(). Called instead of the latter when
+   * there's no worker to move connections to, so that the next round only
+   * looks at recent usage.
+   */
+  void resetClientConnectionsCpuTime();
+
   /**
    * Called by a Connection managed by this Sender when bytes are added to one
    * of Connection's queues. These calls should be matched by
@@ -872,6 +916,10 @@ class Sender : public SenderBase {
 
   bool is_gossip_sender_;
 
+  // Number of DATA connections kept to every node, see
+  // Settings::connections_per_node. Always 1 for gossip.
+  const size_t connections_per_node_;
+
   std::shared_ptr<const configuration::nodes::NodesConfiguration> nodes_;
 
   // ids of disconnected Connections to be erased from .client_sockets_
@@ -946,6 +994,27 @@ class Sender : public SenderBase {
                                    SocketType sock_type,
                                    bool allow_unencrypted);
 
+  /**
+   * Picks the connection to the peer of `main_conn' (a Connection in
+   * server_conns_) that messages striped by log_id should be sent on. Those
+   * with a valid striping log id (see Message::getStripingLogID()) go to one
+   * of the additional connections to that node, always the same for a given
+   * log, which is created if needed. All other messages use main_conn.
+   *
+   * @return the Connection to use; on failure returns nullptr and sets err
+   *         to INTERNAL, NOTINCONFIG or NOSSLCONFIG
+   */
+  Connection* FOLLY_NULLABLE selectStripe(Connection& main_conn,
+                                          logid_t log_id);
+
+  /**
+   * @return the existing Connection to node idx that selectStripe() would
+   *         pick for log_id, or nullptr if there is none or messages of
+   *         log_id are not striped.
+   */
+  Connection* FOLLY_NULLABLE findStripe(node_index_t idx,
+                                        logid_t log_id) const;
+
   /**
    * This method gets the Connection associated with a given ClientID. The
    * connection must already exist for this method to succeed.
@@ -1005,6 +1074,39 @@ class Sender : public SenderBase {
    */
   void eraseDisconnectedClients();
 
+  /**
+   * Creates a client Connection named `client_name` for `fd` and inserts it
+   * into the client map. Common part of addClient() and addMigratedClient().
+   *
+   * @return  the new Connection, or nullptr with err set as for addClient()
+   */
+  Connection* addClientConnection(int fd,
+                                  ClientID client_name,
+                                  const Sockaddr& client_addr,
+                                  ResourceBudget::Token conn_token,
+                                  SocketType type,
+                                  ConnectionType conntype);
+
+  /**
+   * Takes over a client connection that another Worker moved here with
+   * migrateClientConnections(), under the ClientID that Worker issued for
+   * it. Takes ownership of `state.fd` whether or not it succeeds.
+   */
+  int addMigratedClient(ClientID client_name, ConnectionMigrationState& state);
+
+  /**
+   * If `cid` is the ClientID a connection had before it was moved to another
+   * Worker, sends `msg` to it there. Messages that need a callback on this
+   * Worker can't be forwarded and fail with UNREACHABLE.
+   *
+   * @return  0 if `msg` was forwarded, -1 with err set if it couldn't be,
+   *          or -1 with err set to NOTFOUND if `cid` wasn't moved
+   */
+  int forwardToMigratedClient(std::unique_ptr<Message>& msg,
+                              ClientID cid,
+                              BWAvailableCallback* on_bw_avail,
+                              SocketCallback* onclose);
+
   /**
    * Initializes my_node_id_ and my_location_ from the current config and
    * settings.
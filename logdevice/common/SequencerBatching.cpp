@@ -77,6 +77,14 @@ SequencerBatching::SequencerBatching(Processor* processor)
                        processor_->stats_) {
   buffered_writer_.prependChecksums();
   buffered_writer_.setCallbackInternal(this);
+  // Hot logs listed in settings are batched and sequenced on whichever worker
+  // received the APPEND rather than on a single worker picked by hashing the
+  // log ID. EpochSequencer's sliding window is shared by all workers and
+  // releases records in LSN order regardless of which worker stored them.
+  buffered_writer_.setPerWorkerLogPredicate([](logid_t log_id) {
+    return Worker::settings().sequencer_batching_per_worker_logs.count(
+        log_id) > 0;
+  });
 }
 
 SequencerBatching::~SequencerBatching() {
@@ -18,6 +18,8 @@
 #include "logdevice/common/EventHandler.h"
 #include "logdevice/common/EventLoop.h"
 #include "logdevice/common/FlowGroup.h"
+#include "logdevice/common/SharedFlowBudget.h"
+#include "logdevice/common/Timer.h"
 #include "logdevice/common/Worker.h"
 #include "logdevice/common/configuration/ShapingConfig.h"
 #include "logdevice/common/libevent/compat.h"
@@ -50,6 +52,7 @@ class ShapingContainer {
     auto scope = NodeLocationScope::NODE;
     for (auto& fg : flow_groups_) {
       fg.configure(scfg.configured(scope));
+      fg.setSharedBudgetWaitCallback([this] { scheduleSharedBudgetRun(); });
       scope = NodeLocation::nextGreaterScope(scope);
     }
   }
@@ -86,6 +89,59 @@ class ShapingContainer {
     return run;
   }
 
+  /**
+   * Apply a policy update to all FlowGroups and have them borrow their
+   * bandwidth from `budget` from now on.
+   *
+   * @return true if an update makes a FlowGroup runnable.
+   */
+  bool
+  applySharedBudgetPolicies(FlowGroupsUpdate& update,
+                            const std::shared_ptr<SharedFlowBudget>& budget) {
+    std::unique_lock<std::mutex> lock(flow_meters_mutex_);
+    bool run = false;
+
+    for (size_t i = 0; i < flow_groups_.size(); ++i) {
+      NodeLocationScope s = static_cast<NodeLocationScope>(i);
+      auto entry_it = update.group_entries.find(s);
+      if (entry_it == update.group_entries.end()) {
+        continue;
+      }
+      if (flow_groups_[i].applySharedBudgetPolicy(
+              entry_it->second.policy, budget)) {
+        run = true;
+      }
+    }
+
+    return run;
+  }
+
+  /**
+   * Arrange for the FlowGroups to run once the shared budgets they borrow
+   * from have refilled enough to release a queued callback. No-op if no
+   * FlowGroup borrows from a SharedFlowBudget or has callbacks queued.
+   */
+  void scheduleSharedBudgetRun() {
+    auto delay = std::chrono::microseconds::max();
+    for (auto& fg : flow_groups_) {
+      delay = std::min(delay, fg.sharedBudgetWaitTime());
+    }
+    if (delay == std::chrono::microseconds::max()) {
+      return;
+    }
+    delay = std::max(delay, kMinSharedBudgetRunDelay);
+    auto run_time = SteadyTimestamp::now() + delay;
+    if (!shared_budget_timer_) {
+      shared_budget_timer_ = std::make_unique<Timer>(
+          [this] { runFlowGroups(RunType::REPLENISH); });
+    } else if (shared_budget_timer_->isActive() &&
+               shared_budget_run_time_ <= run_time) {
+      return;
+    }
+    shared_budget_run_time_ = run_time;
+    shared_budget_timer_->activate(delay);
+  }
+
   void updateFlowGroupRunRequestedTime(SteadyTimestamp enqueue_time) {
     flow_groups_run_requested_time_ = enqueue_time;
   }
@@ -129,6 +185,11 @@ class ShapingContainer {
       }
     }
 
+    if (!exceeded_deadline) {
+      // Callbacks still waiting for shared budget to refill.
+      scheduleSharedBudgetRun();
+    }
+
     deps_->histogram_add_fg_runtime(
         std::chrono::duration_cast<std::chrono::microseconds>(
             SteadyTimestamp::now() - run_start_time)
@@ -177,6 +238,14 @@ class ShapingContainer {
 
   SteadyTimestamp flow_groups_run_requested_time_;
 
+  // Don't wake up more often than this to see if shared budgets refilled.
+  static constexpr std::chrono::microseconds kMinSharedBudgetRunDelay{10};
+
+  // Runs the FlowGroups when the shared budget they wait for has refilled.
+  // Created on first use, on the Worker thread.
+  std::unique_ptr<Timer> shared_budget_timer_;
+  SteadyTimestamp shared_budget_run_time_;
+
   std::shared_ptr<FlowGroupDependencies> deps_;
 };
 
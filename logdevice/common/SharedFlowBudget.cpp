@@ -0,0 +1,223 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/SharedFlowBudget.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <folly/ConstexprMath.h>
+
+#include "logdevice/common/checks.h"
+
+namespace facebook { namespace logdevice {
+
+namespace {
+
+constexpr long double kNanosPerSec = 1e9;
+
+int64_t toNanos(SteadyTimestamp ts) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             ts.time_since_epoch())
+      .count();
+}
+
+} // namespace
+
+void AtomicTokenBucket::configure(int64_t rate, int64_t capacity) {
+  ld_check(rate >= 0);
+  ld_check(capacity >= 0);
+  rate_.store(rate, std::memory_order_relaxed);
+  capacity_.store(capacity, std::memory_order_relaxed);
+  // Don't hold on to more than the new maximum burst.
+  int64_t cur = level_.load(std::memory_order_relaxed);
+  while (cur > capacity &&
+         !level_.compare_exchange_weak(
+             cur, capacity, std::memory_order_relaxed)) {
+  }
+}
+
+void AtomicTokenBucket::refill(SteadyTimestamp now) {
+  const int64_t now_ns = toNanos(now);
+  int64_t until = refilled_until_ns_.load(std::memory_order_acquire);
+  while (now_ns > until) {
+    const int64_t rate = rate_.load(std::memory_order_relaxed);
+    const int64_t capacity = capacity_.load(std::memory_order_relaxed);
+    int64_t credit = 0;
+    int64_t new_until = now_ns;
+    if (until == 0) {
+      // First use, start with a full bucket.
+      credit = capacity;
+    } else if (rate > 0 && level_.load(std::memory_order_relaxed) < capacity) {
+      const long double accrued =
+          static_cast<long double>(now_ns - until) * rate / kNanosPerSec;
+      if (accrued >= capacity) {
+        // Enough time passed to fill the bucket, the remainder is lost.
+        credit = capacity;
+      } else {
+        credit = static_cast<int64_t>(accrued);
+        if (credit == 0) {
+          // Wait until at least one byte accrued.
+          return;
+        }
+        // Keep the time the fractional byte has been accruing for.
+        new_until = until +
+            static_cast<int64_t>(std::floor(credit * kNanosPerSec / rate));
+      }
+    }
+    // Whoever advances the refill time deposits the credit that accrued.
+    if (refilled_until_ns_.compare_exchange_weak(
+            until, new_until, std::memory_order_acq_rel)) {
+      deposit(credit);
+      return;
+    }
+  }
+}
+
+int64_t AtomicTokenBucket::deposit(int64_t amount) {
+  if (amount <= 0) {
+    return 0;
+  }
+  const int64_t capacity = capacity_.load(std::memory_order_relaxed);
+  int64_t cur = level_.load(std::memory_order_relaxed);
+  int64_t next;
+  do {
+    if (cur >= capacity) {
+      return amount;
+    }
+    next = std::min(
+        folly::constexpr_add_overflow_clamped(cur, amount), capacity);
+  } while (!level_.compare_exchange_weak(cur, next, std::memory_order_relaxed));
+  return amount - (next - cur);
+}
+
+int64_t AtomicTokenBucket::borrow(int64_t amount, SteadyTimestamp now) {
+  if (amount <= 0) {
+    return 0;
+  }
+  refill(now);
+  int64_t cur = level_.load(std::memory_order_relaxed);
+  int64_t taken;
+  do {
+    if (cur <= 0) {
+      return 0;
+    }
+    taken = std::min(cur, amount);
+  } while (!level_.compare_exchange_weak(
+      cur, cur - taken, std::memory_order_relaxed));
+  return taken;
+}
+
+int64_t AtomicTokenBucket::giveBack(int64_t amount) {
+  return deposit(amount);
+}
+
+std::chrono::microseconds
+AtomicTokenBucket::timeUntilAvailable(int64_t amount, SteadyTimestamp now) {
+  refill(now);
+  const int64_t rate = rate_.load(std::memory_order_relaxed);
+  const int64_t capacity = capacity_.load(std::memory_order_relaxed);
+  // The bucket never holds more than its capacity, borrow() then hands out
+  // whatever it has.
+  amount = std::min(amount, capacity);
+  const int64_t deficit = amount - level_.load(std::memory_order_relaxed);
+  if (amount > 0 && deficit <= 0) {
+    return std::chrono::microseconds::zero();
+  }
+  if (rate <= 0 || amount <= 0) {
+    return std::chrono::microseconds::max();
+  }
+  // Credit accrued since the last refill that isn't deposited yet is
+  // ignored, at worst we are a microsecond early.
+  return std::chrono::microseconds(
+      static_cast<int64_t>(std::ceil(deficit * 1e6L / rate)));
+}
+
+void SharedFlowBudget::configure(NodeLocationScope scope,
+                                 const FlowGroupPolicy& policy) {
+  auto& sb = scopes_[static_cast<size_t>(scope)];
+  for (size_t i = 0; i < sb.buckets.size(); ++i) {
+    const auto& entry = policy.entries[i];
+    sb.buckets[i].configure(entry.guaranteed_bw, entry.capacity);
+    if (i < sb.pool_limits.size()) {
+      // INT64_MAX means no-cap.
+      const bool unlimited = entry.max_bw == INT64_MAX;
+      if (!unlimited) {
+        sb.pool_limits[i].configure(
+            std::max<int64_t>(entry.max_bw - entry.guaranteed_bw, 0),
+            entry.capacity);
+      }
+      sb.pool_unlimited[i].store(unlimited, std::memory_order_relaxed);
+    }
+  }
+}
+
+int64_t SharedFlowBudget::borrow(NodeLocationScope scope,
+                                 Priority p,
+                                 int64_t amount,
+                                 int64_t& transferred,
+                                 SteadyTimestamp now) {
+  ld_check(p < Priority::NUM_PRIORITIES);
+  auto& sb = scopes_[static_cast<size_t>(scope)];
+  const int64_t guaranteed = sb.buckets[asInt(p)].borrow(amount, now);
+  transferred = 0;
+  if (guaranteed == amount) {
+    return guaranteed;
+  }
+
+  // Top up from the shared pool, within the priority's maximum bandwidth.
+  int64_t want = amount - guaranteed;
+  const bool unlimited =
+      sb.pool_unlimited[asInt(p)].load(std::memory_order_relaxed);
+  if (!unlimited) {
+    want = sb.pool_limits[asInt(p)].borrow(want, now);
+  }
+  if (want > 0) {
+    transferred = sb.pool().borrow(want, now);
+    if (!unlimited && transferred < want) {
+      sb.pool_limits[asInt(p)].giveBack(want - transferred);
+    }
+  }
+  return guaranteed + transferred;
+}
+
+void SharedFlowBudget::giveBack(NodeLocationScope scope,
+                                Priority p,
+                                int64_t amount,
+                                int64_t from_pool) {
+  ld_check(p < Priority::NUM_PRIORITIES);
+  ld_check(from_pool >= 0);
+  ld_check(from_pool <= amount);
+  auto& sb = scopes_[static_cast<size_t>(scope)];
+  // The priority's bucket can't hold more than it handed out, the excess was
+  // borrowed from the pool.
+  from_pool += sb.buckets[asInt(p)].giveBack(amount - from_pool);
+  if (from_pool > 0) {
+    sb.pool().giveBack(from_pool);
+    if (!sb.pool_unlimited[asInt(p)].load(std::memory_order_relaxed)) {
+      sb.pool_limits[asInt(p)].giveBack(from_pool);
+    }
+  }
+}
+
+std::chrono::microseconds
+SharedFlowBudget::timeUntilAvailable(NodeLocationScope scope,
+                                     Priority p,
+                                     int64_t amount,
+                                     SteadyTimestamp now) {
+  ld_check(p < Priority::NUM_PRIORITIES);
+  auto& sb = scopes_[static_cast<size_t>(scope)];
+  auto from_pool = sb.pool().timeUntilAvailable(amount, now);
+  if (!sb.pool_unlimited[asInt(p)].load(std::memory_order_relaxed)) {
+    from_pool = std::max(
+        from_pool, sb.pool_limits[asInt(p)].timeUntilAvailable(amount, now));
+  }
+  return std::min(
+      sb.buckets[asInt(p)].timeUntilAvailable(amount, now), from_pool);
+}
+
+}} // namespace facebook::logdevice
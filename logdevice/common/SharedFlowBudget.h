@@ -0,0 +1,179 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+#include "logdevice/common/Priority.h"
+#include "logdevice/common/Timestamp.h"
+#include "logdevice/common/configuration/FlowGroupPolicy.h"
+#include "logdevice/common/configuration/NodeLocation.h"
+
+namespace facebook { namespace logdevice {
+
+/**
+ * @file  A token bucket that can be shared by any number of threads without
+ *        locking.
+ *
+ *        The bucket is full when first used and refilled lazily after
+ *        that: whoever next takes credit from it first deposits the credit
+ *        accrued at the configured rate since the last deposit, up to the
+ *        configured capacity. Only whole bytes of credit are deposited and
+ *        the refill time only advances by the time they took to accrue, so
+ *        frequent small borrowers do not lose the fractional remainder.
+ */
+class AtomicTokenBucket {
+ public:
+  /**
+   * @param rate      Refill rate in bytes per second.
+   * @param capacity  Maximum credit the bucket can hold (maximum burst).
+   */
+  void configure(int64_t rate, int64_t capacity);
+
+  /**
+   * Take up to `amount` bytes of credit.
+   *
+   * @return  The credit taken, 0 if the bucket was empty.
+   */
+  int64_t borrow(int64_t amount, SteadyTimestamp now = SteadyTimestamp::now());
+
+  /**
+   * Put back credit that was borrowed but not used. Credit that doesn't fit
+   * within the capacity is discarded.
+   *
+   * @return  The credit discarded.
+   */
+  int64_t giveBack(int64_t amount);
+
+  /**
+   * @return  How long it will take for the bucket to hold `amount` bytes of
+   *          credit, or std::chrono::microseconds::max() if it never will
+   *          with the current configuration.
+   */
+  std::chrono::microseconds
+  timeUntilAvailable(int64_t amount,
+                     SteadyTimestamp now = SteadyTimestamp::now());
+
+  int64_t level() const {
+    return level_.load(std::memory_order_relaxed);
+  }
+  int64_t rate() const {
+    return rate_.load(std::memory_order_relaxed);
+  }
+  int64_t capacity() const {
+    return capacity_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  void refill(SteadyTimestamp now);
+  // Returns the part of amount that didn't fit.
+  int64_t deposit(int64_t amount);
+
+  std::atomic<int64_t> level_{0};
+  // steady_clock time, in nanoseconds, up to which accrued credit has been
+  // deposited.
+  std::atomic<int64_t> refilled_until_ns_{0};
+  std::atomic<int64_t> rate_{0};
+  std::atomic<int64_t> capacity_{0};
+};
+
+/**
+ * Process wide bandwidth budgets for the FlowGroups of all workers.
+ *
+ * When enabled (see the flow-groups-shared-budgets setting), the
+ * FlowGroups of a worker don't wait for the TrafficShaper to hand them
+ * their per-quantum allotment. Instead, whenever a FlowGroup runs out
+ * of credit at some priority, it borrows enough credit to refill its
+ * meter from two parent buckets shared by the FlowGroups of that scope
+ * on all workers:
+ *
+ *   1) the bucket of that priority, refilled at the priority's
+ *      guaranteed bandwidth and holding at most its maximum burst,
+ *   2) the scope's shared pool (the priority queue bucket of the
+ *      FlowGroupPolicy). Credit taken from the pool at each priority
+ *      is additionally limited by a bucket refilled at that
+ *      priority's max_bw less its guaranteed_bw.
+ *
+ * Policies are expressed exactly as in the configuration (process
+ * wide, per second), so no normalization by the number of workers or
+ * the update interval is needed and shaping precision no longer
+ * depends on how promptly workers process TrafficShaper requests.
+ *
+ * These scope buckets are the node-wide level of the hierarchy, the
+ * FlowGroups' meters being the per-worker one. There is no parent
+ * bucket above the scopes: the shaping configuration has no limit on
+ * the total bandwidth of a node across scopes.
+ */
+class SharedFlowBudget {
+ public:
+  /**
+   * Apply the (process wide, per second) policy of a scope. Safe to call
+   * while workers borrow.
+   */
+  void configure(NodeLocationScope scope, const FlowGroupPolicy& policy);
+
+  /**
+   * Take up to `amount` bytes of credit for traffic of priority p in the
+   * given scope, first from the priority's bucket then from the scope's
+   * shared pool.
+   *
+   * @param transferred  Set to the part of the result taken from the
+   *                     shared pool.
+   * @return  The credit taken.
+   */
+  int64_t borrow(NodeLocationScope scope,
+                 Priority p,
+                 int64_t amount,
+                 int64_t& transferred,
+                 SteadyTimestamp now = SteadyTimestamp::now());
+
+  /**
+   * Return unused credit of priority p, e.g. credit that clients returned
+   * to a FlowGroup that couldn't hold it.
+   *
+   * @param from_pool  The part of amount that was taken from the scope's
+   *                   shared pool, it goes back there. The rest goes back
+   *                   to the priority's bucket, and whatever that bucket
+   *                   has no room for is put in the shared pool too.
+   */
+  void giveBack(NodeLocationScope scope,
+                Priority p,
+                int64_t amount,
+                int64_t from_pool = 0);
+
+  /**
+   * @return  How long until borrow() can provide `amount` bytes of credit
+   *          at priority p, std::chrono::microseconds::max() if never with
+   *          the current policy.
+   */
+  std::chrono::microseconds
+  timeUntilAvailable(NodeLocationScope scope,
+                     Priority p,
+                     int64_t amount,
+                     SteadyTimestamp now = SteadyTimestamp::now());
+
+ private:
+  struct ScopeBudget {
+    // Per-priority buckets followed by the shared pool.
+    std::array<AtomicTokenBucket, asInt(Priority::NUM_PRIORITIES) + 1> buckets;
+    // Limits on the credit each priority can take from the shared pool.
+    std::array<AtomicTokenBucket, asInt(Priority::NUM_PRIORITIES)> pool_limits;
+    std::array<std::atomic<bool>, asInt(Priority::NUM_PRIORITIES)>
+        pool_unlimited{};
+
+    AtomicTokenBucket& pool() {
+      return buckets.back();
+    }
+  };
+
+  std::array<ScopeBudget, NodeLocation::NUM_ALL_SCOPES> scopes_;
+};
+
+}} // namespace facebook::logdevice
@@ -676,6 +676,12 @@ SocketDependencies::createHelloMessage(NodeID destNodeID) {
     hdr.flags |= HELLO_Header::CLIENT_LOCATION;
   }
 
+  // Ask the server to compress the message stream. Ignored by servers that
+  // don't support it or don't allow it.
+  if (getSettings().connection_compression) {
+    hdr.flags |= HELLO_Header::COMPRESSION_ZSTD;
+  }
+
   const std::string& csid = getCSID();
   ld_check(csid.size() < MAX_CSID_SIZE);
   if (!csid.empty()) {
@@ -713,6 +719,22 @@ void SocketDependencies::processACKMessage(const Message* msg,
   *destProto = ack->getHeader().proto;
 }
 
+bool SocketDependencies::compressionNegotiated(const Message* msg,
+                                               uint16_t proto) {
+  switch (msg->type_) {
+    case MessageType::HELLO:
+      return static_cast<const HELLO_Message*>(msg)->acceptsCompression(
+          proto, getSettings());
+    case MessageType::ACK:
+      return proto >= Compatibility::CONNECTION_COMPRESSION_SUPPORT &&
+          (static_cast<const ACK_Message*>(msg)->getHeader().options &
+           ACK_Header::COMPRESSION_ZSTD);
+    default:
+      ld_check(false);
+      return false;
+  }
+}
+
 std::unique_ptr<Message>
 SocketDependencies::deserialize(const ProtocolHeader& ph,
                                 ProtocolReader& reader) {
@@ -753,6 +775,10 @@ folly::Executor* SocketDependencies::getExecutor() const {
   return worker_->getExecutor();
 }
 
+IOBufArena* SocketDependencies::getSerializationArena() {
+  return worker_ ? &worker_->serializationArena() : nullptr;
+}
+
 int SocketDependencies::getTCPInfo(TCPInfo* info, int fd) {
   LinuxNetUtils util;
   return util.getTCPInfo(info, fd);
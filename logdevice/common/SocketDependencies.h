@@ -26,6 +26,7 @@ class NodesConfiguration;
 class Processor;
 class Sender;
 class Configuration;
+class IOBufArena;
 class ServerConfig;
 class StatsHolder;
 struct Settings;
@@ -140,6 +141,9 @@ class SocketDependencies {
   virtual void processACKMessage(const Message* msg,
                                  ClientID* our_name_at_peer,
                                  uint16_t* destProto);
+  // Whether the handshake message `msg' (HELLO on the passive side, ACK on
+  // the active side) establishes a compressed message stream.
+  virtual bool compressionNegotiated(const Message* msg, uint16_t proto);
   virtual std::unique_ptr<Message> deserialize(const ProtocolHeader& ph,
                                                ProtocolReader& reader);
   virtual std::string describeConnection(const Address& addr);
@@ -153,6 +157,9 @@ class SocketDependencies {
    */
   virtual folly::Func setupContextGuard();
   virtual folly::Executor* getExecutor() const;
+  // Arena that outgoing messages are serialized into, or nullptr to allocate
+  // each buffer from the heap.
+  virtual IOBufArena* getSerializationArena();
   virtual int getTCPInfo(TCPInfo* info, int fd);
   virtual ~SocketDependencies() {}
 
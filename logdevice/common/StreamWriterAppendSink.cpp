@@ -15,12 +15,14 @@ StreamWriterAppendSink::StreamWriterAppendSink(
     std::shared_ptr<Processor> processor,
     std::unique_ptr<ClientBridge> bridge,
     std::chrono::milliseconds append_retry_timeout,
-    chrono_expbackoff_t<std::chrono::milliseconds> expbackoff_settings)
+    chrono_expbackoff_t<std::chrono::milliseconds> expbackoff_settings,
+    size_t max_inflight_window)
     : processor_(std::move(processor)),
       bridge_(std::move(bridge)),
       append_retry_timeout_(append_retry_timeout),
       holder_(this),
-      expbackoff_settings_(expbackoff_settings) {}
+      expbackoff_settings_(expbackoff_settings),
+      max_inflight_window_(max_inflight_window) {}
 
 StreamWriterAppendSink::~StreamWriterAppendSink() {
   if (!processor_) {
@@ -262,15 +264,16 @@ void StreamWriterAppendSink::onCallback(Stream& stream,
       // If we send only 1 pending message per prefix ACK, that will resemble
       // ONE_AT_A_TIME mode. We chose 2 so that the client can systematically
       // improve the input throughput by having many inflight, as a proper write
-      // stream connection is established with a sequencer.
-      // TODO: Try out more than 2 triggers for each sequencer prefix ACK.
+      // stream connection is established with a sequencer. With a fixed
+      // inflight window, the prefix ACK slides the window and we refill it.
       if (req_seq_num == next_seq_num(stream.max_prefix_acked_seq_num_)) {
         auto num_called_back = stream.triggerPrefixCallbacks();
-        postNextReadyRequestsIfExists(stream, 2 * num_called_back);
+        postNextReadyRequestsIfExists(
+            stream, numRequestsToPost(stream, 2 * num_called_back));
       }
     } else {
       rewindStreamUntil(stream, req_seq_num);
-      postNextReadyRequestsIfExists(stream, 2);
+      postNextReadyRequestsIfExists(stream, numRequestsToPost(stream, 2));
     }
   } else {
     // Rewinding a stream until req_seq_num discards any previous successful
@@ -327,6 +330,10 @@ void StreamWriterAppendSink::postNextReadyRequestsIfExists(
     Stream& stream,
     size_t suggested_count) {
   for (size_t i = 0; i < suggested_count; i++) {
+    if (max_inflight_window_ > 0 &&
+        inflightWindowSize(stream) >= max_inflight_window_) {
+      break;
+    }
     auto next_ready_seq_num = next_seq_num(stream.max_inflight_window_seq_num_);
     auto it = stream.pending_stream_requests_.find(next_ready_seq_num);
     if (it != stream.pending_stream_requests_.end()) {
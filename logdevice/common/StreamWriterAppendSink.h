@@ -245,12 +245,17 @@ class StreamWriterAppendSink : public BufferedWriterAppendSink {
    * client (for instance tracing, write tokens. Refer 'ClientBridge.h').
    * 'append_retry_timeout' is used to determine when an inflight APPEND request
    * has failed so it they can retried.
+   * 'max_inflight_window' caps the number of sequence numbers per stream that
+   * are in the inflight window. Appends beyond the window wait until the
+   * prefix of the window is acked, after which the window is refilled. 0 means
+   * no limit: appends are posted as soon as all earlier ones are in flight.
    */
   StreamWriterAppendSink(
       std::shared_ptr<Processor> processor,
       std::unique_ptr<ClientBridge> bridge,
       std::chrono::milliseconds append_retry_timeout,
-      chrono_expbackoff_t<std::chrono::milliseconds> expbackoff_settings);
+      chrono_expbackoff_t<std::chrono::milliseconds> expbackoff_settings,
+      size_t max_inflight_window = 0);
   virtual ~StreamWriterAppendSink() override;
 
   bool checkAppend(logid_t logid,
@@ -273,7 +278,8 @@ class StreamWriterAppendSink : public BufferedWriterAppendSink {
 
   // Posts suggested_count number of  stream requests that are ready but not
   // inflight, that corresponds to the requests after sequence number
-  // stream.max_inflight_window_seq_num_.
+  // stream.max_inflight_window_seq_num_. Never grows the inflight window
+  // beyond max_inflight_window_, if set.
   void postNextReadyRequestsIfExists(Stream& stream, size_t suggested_count);
 
  protected:
@@ -341,6 +347,27 @@ class StreamWriterAppendSink : public BufferedWriterAppendSink {
   // failed stream append requests.
   chrono_expbackoff_t<std::chrono::milliseconds> expbackoff_settings_;
 
+  // Maximum number of sequence numbers in the inflight window of a stream, or
+  // 0 if the window is not fixed. See constructor.
+  const size_t max_inflight_window_;
+
+  // Number of sequence numbers currently in the inflight window of stream,
+  // i.e. (max_prefix_acked_seq_num_, max_inflight_window_seq_num_].
+  static size_t inflightWindowSize(const Stream& stream) {
+    return stream.max_inflight_window_seq_num_.val_ -
+        stream.max_prefix_acked_seq_num_.val_;
+  }
+
+  // Number of requests to post after some requests were acked or rewound:
+  // enough to fill the window if it is fixed, otherwise legacy_count.
+  size_t numRequestsToPost(const Stream& stream, size_t legacy_count) const {
+    if (max_inflight_window_ == 0) {
+      return legacy_count;
+    }
+    size_t window = inflightWindowSize(stream);
+    return window < max_inflight_window_ ? max_inflight_window_ - window : 0;
+  }
+
   // Checks if the earliest pending request, (also the first one in the inflight
   // window), which corresponds to sequence number
   // (stream.max_prefix_acked_seq_num_ + 1) in the stream is in flight. If not,
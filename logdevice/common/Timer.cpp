@@ -11,6 +11,7 @@
 #include "logdevice/common/LibeventTimer.h"
 #include "logdevice/common/Processor.h"
 #include "logdevice/common/RunContext.h"
+#include "logdevice/common/TimingWheel.h"
 #include "logdevice/common/WheelTimer.h"
 #include "logdevice/common/Worker.h"
 #include "logdevice/common/stats/Stats.h"
@@ -131,6 +132,67 @@ WheelTimerDispatchImpl::makeWheelTimerInternalExecutor(Worker* worker) {
   };
 }
 
+class TimingWheelTimerImpl : public TimerInterface {
+ public:
+  TimingWheelTimerImpl() : entry_([this] { onFire(); }) {}
+
+  void activate(std::chrono::microseconds delay,
+                TimeoutMap* /* timeout_map */ = nullptr) override {
+    ld_check(callback_);
+    auto ev_loop = EventLoop::onThisThread();
+    ld_check(ev_loop);
+    worker_ = Worker::onThisThread(false /* enforce_worker */);
+    workerRunContext_ = worker_ ? worker_->currentlyRunning_ : RunContext();
+    ev_loop->scheduleOnTimingWheel(entry_, delay);
+  }
+
+  void cancel() override {
+    entry_.cancel();
+  }
+
+  bool isActive() const override {
+    return entry_.isScheduled();
+  }
+
+  void setCallback(std::function<void()> callback) override {
+    callback_ = std::move(callback);
+  }
+
+  void assign(std::function<void()> callback) override {
+    setCallback(std::move(callback));
+  }
+
+  bool isAssigned() const override {
+    return !!callback_;
+  }
+
+ private:
+  TimingWheelTimerImpl(const TimingWheelTimerImpl&) = delete;
+  TimingWheelTimerImpl(TimingWheelTimerImpl&&) = delete;
+  TimingWheelTimerImpl& operator=(const TimingWheelTimerImpl&) = delete;
+  TimingWheelTimerImpl& operator=(TimingWheelTimerImpl&&) = delete;
+
+  void onFire() {
+    // The callback may destroy this timer.
+    Worker* worker = worker_;
+    RunContext run_context = workerRunContext_;
+    if (worker) {
+      WorkerContextScopeGuard g(worker);
+      worker->onStartedRunning(run_context);
+      callback_();
+      worker->onStoppedRunning(run_context);
+    } else {
+      callback_();
+    }
+  }
+
+  std::function<void()> callback_;
+  TimingWheel::Entry entry_;
+  // Worker and run context that activated the timer.
+  Worker* worker_{nullptr};
+  RunContext workerRunContext_;
+};
+
 } // namespace
 
 // Sometimes the worker is unavailable i.e. in tests and we cannot assign.
@@ -198,7 +260,10 @@ TimerInterface& Timer::getTimerImpl() const {
     // This is called from tests and ldbench workers. Caller cannot assume
     // Worker interface to be available in those cases.
     auto worker = Worker::onThisThread(false /* enforce_worker */);
-    if (worker && worker->updateable_settings_->enable_hh_wheel_backed_timers) {
+    if (worker && worker->updateable_settings_->worker_timing_wheel) {
+      impl_ = std::make_unique<TimingWheelTimerImpl>();
+    } else if (worker &&
+               worker->updateable_settings_->enable_hh_wheel_backed_timers) {
       impl_ = std::make_unique<WheelTimerDispatchImpl>();
     } else {
       impl_ = std::make_unique<LibEventTimerImpl>();
@@ -0,0 +1,160 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/TimingWheel.h"
+
+#include <algorithm>
+
+#include "logdevice/common/checks.h"
+
+namespace facebook { namespace logdevice {
+
+constexpr size_t TimingWheel::kSlotBits;
+constexpr size_t TimingWheel::kSlots;
+constexpr size_t TimingWheel::kLevels;
+
+namespace {
+constexpr uint64_t kSlotMask = TimingWheel::kSlots - 1;
+// Number of ticks the wheel can hold.
+constexpr uint64_t kMaxTicks = uint64_t(1)
+    << (TimingWheel::kSlotBits * TimingWheel::kLevels);
+} // namespace
+
+void TimingWheel::Entry::cancel() {
+  if (hook_.is_linked()) {
+    hook_.unlink();
+    ld_check(wheel_);
+    --wheel_->size_;
+    wheel_ = nullptr;
+  }
+}
+
+TimingWheel::TimingWheel(std::chrono::microseconds tick,
+                         Clock::time_point now)
+    : start_(now), tick_(tick) {
+  ld_check(tick.count() > 0);
+}
+
+TimingWheel::~TimingWheel() {
+  for (auto& wheel : wheels_) {
+    for (auto& bucket : wheel) {
+      while (!bucket.empty()) {
+        Entry& entry = bucket.front();
+        bucket.pop_front();
+        entry.wheel_ = nullptr;
+      }
+    }
+  }
+}
+
+void TimingWheel::schedule(Entry& entry,
+                           std::chrono::microseconds delay,
+                           Clock::time_point now) {
+  ld_check(entry.callback_);
+  entry.cancel();
+
+  const int64_t since_start =
+      std::chrono::duration_cast<std::chrono::microseconds>(now + delay -
+                                                            start_)
+          .count();
+  // Round up, so that the entry doesn't fire before `delay` has passed.
+  uint64_t tick = since_start <= 0
+      ? 0
+      : (since_start + tick_.count() - 1) / tick_.count();
+  tick = std::max(tick, current_tick_ + 1);
+  tick = std::min(tick, current_tick_ + kMaxTicks - 1);
+
+  entry.expiry_tick_ = tick;
+  entry.wheel_ = this;
+  insert(entry);
+  ++size_;
+}
+
+void TimingWheel::insert(Entry& entry) {
+  ld_check_ge(entry.expiry_tick_, current_tick_);
+  const uint64_t ticks_left = entry.expiry_tick_ - current_tick_;
+  for (size_t level = 0; level < kLevels; ++level) {
+    const size_t shift = kSlotBits * level;
+    if (ticks_left < (uint64_t(1) << (shift + kSlotBits))) {
+      wheels_[level][(entry.expiry_tick_ >> shift) & kSlotMask].push_back(
+          entry);
+      return;
+    }
+  }
+  ld_check(false);
+}
+
+void TimingWheel::cascade(size_t level) {
+  Bucket& bucket =
+      wheels_[level][(current_tick_ >> (kSlotBits * level)) & kSlotMask];
+  while (!bucket.empty()) {
+    Entry& entry = bucket.front();
+    bucket.pop_front();
+    insert(entry);
+  }
+}
+
+size_t TimingWheel::advance(Clock::time_point now) {
+  const int64_t since_start =
+      std::chrono::duration_cast<std::chrono::microseconds>(now - start_)
+          .count();
+  if (since_start < 0) {
+    return 0;
+  }
+  const uint64_t target = since_start / tick_.count();
+  if (size_ == 0) {
+    current_tick_ = std::max(current_tick_, target);
+    return 0;
+  }
+
+  size_t fired = 0;
+  while (current_tick_ < target && size_ > 0) {
+    ++current_tick_;
+    // Redistribute the higher levels whose bucket for the new tick just came
+    // up, highest first, since they may move entries to the buckets of lower
+    // levels that are about to be redistributed too.
+    for (size_t level = kLevels - 1; level > 0; --level) {
+      const uint64_t mask = (uint64_t(1) << (kSlotBits * level)) - 1;
+      if ((current_tick_ & mask) == 0) {
+        cascade(level);
+      }
+    }
+
+    Bucket& bucket = wheels_[0][current_tick_ & kSlotMask];
+    while (!bucket.empty()) {
+      Entry& entry = bucket.front();
+      ld_check_eq(entry.expiry_tick_, current_tick_);
+      bucket.pop_front();
+      --size_;
+      entry.wheel_ = nullptr;
+      ++fired;
+      // May destroy or reschedule the entry.
+      entry.callback_();
+    }
+  }
+  current_tick_ = std::max(current_tick_, target);
+  return fired;
+}
+
+TimingWheel::Clock::time_point TimingWheel::nextWakeUp() const {
+  // Ticks until level 0 wraps around and level 1 must be redistributed.
+  const uint64_t until_cascade = kSlots - (current_tick_ & kSlotMask);
+  for (uint64_t i = 1; i < until_cascade; ++i) {
+    if (!wheels_[0][(current_tick_ + i) & kSlotMask].empty()) {
+      return tickTime(current_tick_ + i);
+    }
+  }
+  return tickTime(current_tick_ + until_cascade);
+}
+
+TimingWheel::Clock::time_point
+TimingWheel::expiryTime(const Entry& entry) const {
+  ld_check(entry.wheel_ == this);
+  return tickTime(entry.expiry_tick_);
+}
+
+}} // namespace facebook::logdevice
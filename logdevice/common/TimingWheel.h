@@ -0,0 +1,158 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include <folly/Function.h>
+#include <folly/IntrusiveList.h>
+
+namespace facebook { namespace logdevice {
+
+/**
+ * @file Hierarchical timing wheel: timers are kept in buckets by expiration
+ * tick instead of a heap, so that scheduling, cancelling and firing a timer
+ * are all O(1) regardless of how many timers there are.
+ *
+ * There are kLevels wheels of kSlots buckets. Level 0 holds timers expiring
+ * in the next kSlots ticks, one bucket per tick. Level k holds timers further
+ * away, one bucket per kSlots^k ticks. Whenever the level 0 wheel wraps
+ * around, the next bucket of level 1 is redistributed into level 0, and so
+ * on up the levels. Delays longer than the highest level can hold
+ * (kSlots^kLevels ticks) are cut down to that.
+ *
+ * Timers never fire early, and fire at most one tick late plus however late
+ * advance() gets called.
+ *
+ * Not thread safe. Used by EventLoop to back Timer when
+ * --worker-timing-wheel is set, see EventLoop::scheduleOnTimingWheel().
+ */
+
+class TimingWheel {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr size_t kSlotBits = 8;
+  static constexpr size_t kSlots = 1 << kSlotBits;
+  static constexpr size_t kLevels = 4;
+
+  /**
+   * A timer on the wheel. The owner keeps it alive while it's scheduled;
+   * destroying a scheduled entry cancels it. The callback may destroy or
+   * reschedule the entry, but must not replace the callback itself.
+   */
+  class Entry {
+   public:
+    Entry() = default;
+    explicit Entry(folly::Function<void()> callback)
+        : callback_(std::move(callback)) {}
+
+    Entry(const Entry&) = delete;
+    Entry& operator=(const Entry&) = delete;
+
+    ~Entry() {
+      cancel();
+    }
+
+    void setCallback(folly::Function<void()> callback) {
+      callback_ = std::move(callback);
+    }
+
+    bool hasCallback() const {
+      return static_cast<bool>(callback_);
+    }
+
+    bool isScheduled() const {
+      return hook_.is_linked();
+    }
+
+    void cancel();
+
+   private:
+    friend class TimingWheel;
+
+    folly::IntrusiveListHook hook_;
+    TimingWheel* wheel_{nullptr};
+    uint64_t expiry_tick_{0};
+    folly::Function<void()> callback_;
+  };
+
+  /**
+   * @param tick  granularity of the wheel
+   * @param now   time of tick 0
+   */
+  explicit TimingWheel(std::chrono::microseconds tick,
+                       Clock::time_point now = Clock::now());
+
+  ~TimingWheel();
+
+  /**
+   * Schedules `entry` to fire once `delay` has passed since `now`,
+   * rescheduling it if it's already scheduled. The entry must have a
+   * callback.
+   */
+  void schedule(Entry& entry,
+                std::chrono::microseconds delay,
+                Clock::time_point now = Clock::now());
+
+  /**
+   * Fires all entries that are due at `now`, in order of expiration tick.
+   * Callbacks may schedule and cancel entries, including their own.
+   *
+   * @return number of entries fired
+   */
+  size_t advance(Clock::time_point now = Clock::now());
+
+  /**
+   * Earliest time at which advance() may have something to do: the
+   * expiration of the next non-empty level 0 bucket, or the next time a
+   * higher level bucket must be redistributed. Only meaningful if !empty().
+   */
+  Clock::time_point nextWakeUp() const;
+
+  /**
+   * Time at which `entry`, which must be scheduled on this wheel, is due.
+   */
+  Clock::time_point expiryTime(const Entry& entry) const;
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+ private:
+  using Bucket = folly::IntrusiveList<Entry, &Entry::hook_>;
+
+  Clock::time_point tickTime(uint64_t tick) const {
+    return start_ + tick_ * tick;
+  }
+
+  // Puts `entry` in the bucket for its expiry_tick_ relative to
+  // current_tick_.
+  void insert(Entry& entry);
+
+  // Moves the entries of the bucket of `level` that current_tick_ points to
+  // into lower levels.
+  void cascade(size_t level);
+
+  const Clock::time_point start_;
+  const std::chrono::microseconds tick_;
+
+  // All entries expiring at or before this tick have been fired.
+  uint64_t current_tick_{0};
+  size_t size_{0};
+
+  std::array<std::array<Bucket, kSlots>, kLevels> wheels_;
+};
+
+}} // namespace facebook::logdevice
@@ -0,0 +1,16 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/Tracepoints.h"
+
+namespace facebook { namespace logdevice { namespace tracepoints {
+
+FOLLY_SDT_DEFINE_SEMAPHORE(logdevice, write_storage_task_enqueue)
+FOLLY_SDT_DEFINE_SEMAPHORE(logdevice, write_storage_task_execute)
+FOLLY_SDT_DEFINE_SEMAPHORE(logdevice, write_storage_task_sync)
+
+}}} // namespace facebook::logdevice::tracepoints
@@ -0,0 +1,191 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <folly/CPortability.h>
+#include <folly/tracing/StaticTracepoint.h>
+
+#include "logdevice/common/NodeID.h"
+#include "logdevice/include/Err.h"
+#include "logdevice/include/types.h"
+
+/**
+ * @file Static (USDT) tracepoints at the boundaries of the append and read
+ *       paths, for attaching perf, bpftrace etc. in production:
+ *
+ *         bpftrace -e 'usdt:/path/to/logdeviced:logdevice:appender_retired
+ *                      { @us = hist((nsecs - arg3) / 1000); }'
+ *
+ *       A tracepoint is a single nop plus an ELF note describing where its
+ *       arguments are, so it's free when nothing is attached, except for
+ *       computing the arguments. Only pass values that are at hand. Where
+ *       getting the arguments costs something (e.g. virtual calls), the
+ *       tracepoint has a semaphore that tracers bump while attached, and
+ *       callers check its *Enabled() function first.
+ *
+ *       All tracepoints are in provider "logdevice" and go through the
+ *       functions below, so that the arguments of a tracepoint have the same
+ *       order and types at every call site. Most start with log id and LSN.
+ *       If you change a signature, update TracepointsTest and any scripts
+ *       using it: argument positions are the only "schema" tracing tools see.
+ */
+
+namespace facebook { namespace logdevice { namespace tracepoints {
+
+// Append path, in order.
+
+// Sequencer received an APPEND message.
+FOLLY_ALWAYS_INLINE void appendReceived(logid_t log_id, size_t payload_size) {
+  uint64_t log = log_id.val_;
+  FOLLY_SDT(logdevice, append_received, log, payload_size);
+}
+
+// Appender got an LSN and starts sending STOREs.
+FOLLY_ALWAYS_INLINE void
+appenderStart(logid_t log_id, lsn_t lsn, size_t payload_size) {
+  uint64_t log = log_id.val_;
+  FOLLY_SDT(logdevice, appender_start, log, lsn, payload_size);
+}
+
+// A STORE of wave `wave` was written into the socket to `node`.
+FOLLY_ALWAYS_INLINE void appenderStoreSent(logid_t log_id,
+                                           lsn_t lsn,
+                                           uint32_t wave,
+                                           node_index_t node,
+                                           size_t payload_size) {
+  uint64_t log = log_id.val_;
+  uint32_t node_idx = static_cast<uint32_t>(node);
+  FOLLY_SDT(
+      logdevice, appender_store_sent, log, lsn, wave, node_idx, payload_size);
+}
+
+// A STORED reply came from `node`.
+FOLLY_ALWAYS_INLINE void appenderStored(logid_t log_id,
+                                        lsn_t lsn,
+                                        uint32_t wave,
+                                        node_index_t node,
+                                        Status status) {
+  uint64_t log = log_id.val_;
+  uint32_t node_idx = static_cast<uint32_t>(node);
+  uint32_t st = static_cast<uint32_t>(status);
+  FOLLY_SDT(logdevice, appender_stored, log, lsn, wave, node_idx, st);
+}
+
+// Appender retired. `created_ns` is when it was created, by steady_clock,
+// i.e. CLOCK_MONOTONIC like bpftrace's nsecs.
+FOLLY_ALWAYS_INLINE void appenderRetired(logid_t log_id,
+                                         lsn_t lsn,
+                                         Status status,
+                                         int64_t created_ns) {
+  uint64_t log = log_id.val_;
+  uint32_t st = static_cast<uint32_t>(status);
+  FOLLY_SDT(logdevice, appender_retired, log, lsn, st, created_ns);
+}
+
+// Storage tasks. `log_id` and `lsn` are invalid for writes that aren't of
+// a record. The write storage task tracepoints have semaphores, their
+// arguments come from virtual calls on the task.
+
+FOLLY_SDT_DECLARE_SEMAPHORE(logdevice, write_storage_task_enqueue);
+FOLLY_SDT_DECLARE_SEMAPHORE(logdevice, write_storage_task_execute);
+FOLLY_SDT_DECLARE_SEMAPHORE(logdevice, write_storage_task_sync);
+
+FOLLY_ALWAYS_INLINE bool writeStorageTaskEnqueueEnabled() {
+  return FOLLY_SDT_IS_ENABLED(logdevice, write_storage_task_enqueue);
+}
+
+FOLLY_ALWAYS_INLINE void
+writeStorageTaskEnqueue(logid_t log_id, lsn_t lsn, size_t payload_size) {
+  uint64_t log = log_id.val_;
+  FOLLY_SDT_WITH_SEMAPHORE(
+      logdevice, write_storage_task_enqueue, log, lsn, payload_size);
+}
+
+FOLLY_ALWAYS_INLINE bool writeStorageTaskExecuteEnabled() {
+  return FOLLY_SDT_IS_ENABLED(logdevice, write_storage_task_execute);
+}
+
+// The write is about to be written to the local log store as part of a batch
+// of `batch_size` writes.
+FOLLY_ALWAYS_INLINE void writeStorageTaskExecute(logid_t log_id,
+                                                 lsn_t lsn,
+                                                 size_t payload_size,
+                                                 size_t batch_size) {
+  uint64_t log = log_id.val_;
+  FOLLY_SDT_WITH_SEMAPHORE(logdevice,
+                           write_storage_task_execute,
+                           log,
+                           lsn,
+                           payload_size,
+                           batch_size);
+}
+
+FOLLY_ALWAYS_INLINE bool writeStorageTaskSyncEnabled() {
+  return FOLLY_SDT_IS_ENABLED(logdevice, write_storage_task_sync);
+}
+
+// The write was synced, in a sync that took `sync_latency_us`.
+FOLLY_ALWAYS_INLINE void writeStorageTaskSync(logid_t log_id,
+                                              lsn_t lsn,
+                                              size_t payload_size,
+                                              int64_t sync_latency_us) {
+  uint64_t log = log_id.val_;
+  FOLLY_SDT_WITH_SEMAPHORE(logdevice,
+                           write_storage_task_sync,
+                           log,
+                           lsn,
+                           payload_size,
+                           sync_latency_us);
+}
+
+// Read path, in order.
+
+// A read of [from_lsn, until_lsn], up to `max_bytes`, was queued for a
+// storage thread.
+FOLLY_ALWAYS_INLINE void readStorageTaskEnqueue(logid_t log_id,
+                                                lsn_t from_lsn,
+                                                lsn_t until_lsn,
+                                                size_t max_bytes) {
+  uint64_t log = log_id.val_;
+  FOLLY_SDT(logdevice,
+            read_storage_task_enqueue,
+            log,
+            from_lsn,
+            until_lsn,
+            max_bytes);
+}
+
+// A storage thread read `nrecords` records, `bytes` in total, starting at
+// `from_lsn`.
+FOLLY_ALWAYS_INLINE void readStorageTaskExecute(logid_t log_id,
+                                                lsn_t from_lsn,
+                                                size_t nrecords,
+                                                size_t bytes) {
+  uint64_t log = log_id.val_;
+  FOLLY_SDT(
+      logdevice, read_storage_task_execute, log, from_lsn, nrecords, bytes);
+}
+
+// A RECORD message was written into the socket to the reader.
+FOLLY_ALWAYS_INLINE void
+recordSent(logid_t log_id, lsn_t lsn, size_t payload_size) {
+  uint64_t log = log_id.val_;
+  FOLLY_SDT(logdevice, record_sent, log, lsn, payload_size);
+}
+
+// ClientReadStream delivered a record to the application.
+FOLLY_ALWAYS_INLINE void
+clientReadStreamDeliver(logid_t log_id, lsn_t lsn, size_t payload_size) {
+  uint64_t log = log_id.val_;
+  FOLLY_SDT(logdevice, client_read_stream_deliver, log, lsn, payload_size);
+}
+
+}}} // namespace facebook::logdevice::tracepoints
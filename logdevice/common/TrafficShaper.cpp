@@ -57,6 +57,12 @@ TrafficShaper::TrafficShaper(Processor* processor, StatsHolder* stats)
   nw_shaping_deps_ = std::make_unique<NwShapingFlowGroupDeps>(stats, nullptr);
   read_shaping_deps_ = std::make_unique<ReadShapingFlowGroupDeps>(stats);
 
+  shared_budgets_ = processor_->settings()->flow_groups_shared_budgets;
+  if (shared_budgets_) {
+    nw_budget_ = std::make_shared<SharedFlowBudget>();
+    read_io_budget_ = std::make_shared<SharedFlowBudget>();
+  }
+
   if (processor_->getAllWorkersCount() != 0) {
     mainLoopThread_ = std::thread(&TrafficShaper::mainLoop, this);
 
@@ -232,26 +238,53 @@ bool TrafficShaper::dispatchUpdateCommon(
   return future_updates_required;
 }
 
+bool TrafficShaper::configureSharedBudget(
+    const configuration::ShapingConfig& shaping_config,
+    int nworkers,
+    FlowGroupsUpdate& update,
+    SharedFlowBudget& budget) {
+  for (auto& policy_it : shaping_config.flowGroupPolicies) {
+    auto scope = policy_it.first;
+    auto entry_it = update.group_entries.find(scope);
+    if (entry_it == update.group_entries.end()) {
+      RATELIMIT_ERROR(std::chrono::seconds(1),
+                      2,
+                      "Didn't find scope:%d in group_entries",
+                      static_cast<int>(scope));
+      continue;
+    }
+    budget.configure(scope, policy_it.second);
+    // Workers only use the maximum burst, split evenly between them.
+    entry_it->second.policy =
+        policy_it.second.normalize(nworkers, std::chrono::seconds(1));
+  }
+  return false;
+}
+
 bool TrafficShaper::dispatchUpdateNw() {
   auto config = processor_->config_->updateableServerConfig()->get();
   const configuration::ShapingConfig& shaping_config =
       config->getTrafficShapingConfig();
-  bool future_updates_required =
-      dispatchUpdateCommon(shaping_config,
-                           processor_->getAllWorkersCount(),
-                           *nw_update_,
-                           nw_shaping_deps_.get());
-
-  processor_->applyToWorkers(
-      [&](Worker& w) {
-        if (w.sender().getNwShapingContainer()->applyFlowGroupsUpdate(
-                *nw_update_, stats_)) {
-          std::unique_ptr<Request> run_req =
-              std::make_unique<RunFlowGroupsRequest>(
-                  w.sender().getNwShapingContainer(),
-                  RequestType::TRAFFIC_SHAPER_RUN_FLOW_GROUPS);
-          processor_->postImportant(run_req, w.worker_type_, w.idx_.val());
+  bool future_updates_required = shared_budgets_
+      ? configureSharedBudget(shaping_config,
+                              processor_->getAllWorkersCount(),
+                              *nw_update_,
+                              *nw_budget_)
+      : dispatchUpdateCommon(shaping_config,
+                             processor_->getAllWorkersCount(),
+                             *nw_update_,
+                             nw_shaping_deps_.get());
+
+  processor_->applyToWorkersAndPost(
+      [&](Worker& w) -> std::unique_ptr<Request> {
+        auto container = w.sender().getNwShapingContainer();
+        if (shared_budgets_
+                ? container->applySharedBudgetPolicies(*nw_update_, nw_budget_)
+                : container->applyFlowGroupsUpdate(*nw_update_, stats_)) {
+          return std::make_unique<RunFlowGroupsRequest>(
+              container, RequestType::TRAFFIC_SHAPER_RUN_FLOW_GROUPS);
         }
+        return nullptr;
       },
       Processor::Order::RANDOM);
 
@@ -262,22 +295,28 @@ bool TrafficShaper::dispatchUpdateReadIO() {
   auto config = processor_->config_->updateableServerConfig()->get();
   const configuration::ShapingConfig& shaping_config =
       config->getReadIOShapingConfig();
-  bool future_updates_required =
-      dispatchUpdateCommon(shaping_config,
-                           processor_->getWorkerCount(WorkerType::GENERAL),
-                           *read_io_update_,
-                           read_shaping_deps_.get());
-
-  processor_->applyToWorkers(
-      [&](Worker& w) {
-        if (w.readShapingContainer().applyFlowGroupsUpdate(
-                *read_io_update_, nullptr /*stats*/)) {
-          std::unique_ptr<Request> run_req =
-              std::make_unique<RunFlowGroupsRequest>(
-                  &w.readShapingContainer(),
-                  RequestType::READIO_SHAPER_RUN_FLOW_GROUPS);
-          processor_->postImportant(run_req, w.worker_type_, w.idx_.val());
+  bool future_updates_required = shared_budgets_
+      ? configureSharedBudget(shaping_config,
+                              processor_->getWorkerCount(WorkerType::GENERAL),
+                              *read_io_update_,
+                              *read_io_budget_)
+      : dispatchUpdateCommon(shaping_config,
+                             processor_->getWorkerCount(WorkerType::GENERAL),
+                             *read_io_update_,
+                             read_shaping_deps_.get());
+
+  processor_->applyToWorkersAndPost(
+      [&](Worker& w) -> std::unique_ptr<Request> {
+        auto& container = w.readShapingContainer();
+        if (shared_budgets_
+                ? container.applySharedBudgetPolicies(
+                      *read_io_update_, read_io_budget_)
+                : container.applyFlowGroupsUpdate(
+                      *read_io_update_, nullptr /*stats*/)) {
+          return std::make_unique<RunFlowGroupsRequest>(
+              &container, RequestType::READIO_SHAPER_RUN_FLOW_GROUPS);
         }
+        return nullptr;
       },
       Processor::Order::RANDOM);
 
@@ -14,6 +14,7 @@
 #include <thread>
 
 #include "logdevice/common/FlowGroup.h"
+#include "logdevice/common/SharedFlowBudget.h"
 #include "logdevice/common/configuration/Configuration.h"
 #include "logdevice/include/ConfigSubscriptionHandle.h"
 
@@ -26,6 +27,10 @@ class StatsHolder;
  * @file A background thread that monitors external events
  *       affecting traffic shaping policy, and periodically adds
  *       bandwidth credit to each Sender's FlowGroups.
+ *
+ *       With flow-groups-shared-budgets, FlowGroups borrow credit from
+ *       SharedFlowBudgets instead, and the thread only wakes up to apply
+ *       configuration changes.
  */
 
 class TrafficShaper {
@@ -66,6 +71,11 @@ class TrafficShaper {
   std::unique_ptr<FlowGroupsUpdate> nw_update_;
   std::unique_ptr<FlowGroupsUpdate> read_io_update_;
 
+  // Set from the flow-groups-shared-budgets setting at construction.
+  bool shared_budgets_{false};
+  std::shared_ptr<SharedFlowBudget> nw_budget_;
+  std::shared_ptr<SharedFlowBudget> read_io_budget_;
+
   // comes last to ensure unsubscription before rest of destruction
   ConfigSubscriptionHandle config_update_sub_;
 
@@ -103,6 +113,19 @@ class TrafficShaper {
                             FlowGroupsUpdate& update,
                             FlowGroupDependencies* deps);
 
+  /**
+   * Shared budgets counterpart of dispatchUpdateCommon(): configure `budget`
+   * with the policies of `shaping_config` and prepare an update carrying
+   * the per-worker maximum burst of each FlowGroup.
+   *
+   * @return false  The budgets refill by themselves, updates are only needed
+   *                on configuration changes.
+   */
+  bool configureSharedBudget(const configuration::ShapingConfig& shaping_config,
+                             int nworkers,
+                             FlowGroupsUpdate& update,
+                             SharedFlowBudget& budget);
+
   void setIntervalImpl(const decltype(updateInterval_)& interval);
   std::unique_ptr<FlowGroupDependencies> nw_shaping_deps_;
   std::unique_ptr<FlowGroupDependencies> read_shaping_deps_;
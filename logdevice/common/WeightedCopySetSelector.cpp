@@ -718,8 +718,43 @@ WeightedCopySetSelector::select(copyset_size_t extras,
   // (7/12 vs 5/6 to be exact).
   // The purpose of NodeAvailabilityCache is to mitigate this bias.
 
+  // Latency-aware mode: keep drawing valid copysets until we have
+  // `latency_candidates` of them, then return the one with the lowest
+  // estimated latency. A fraction of selections skips this to keep the load
+  // spread according to weights and to let slow shards' estimates recover.
+  size_t latency_candidates = 1;
+  if (nodeset_state_) {
+    const Settings* settings = nodeset_state_->getSettings();
+    if (settings && settings->latency_aware_copyset_selection &&
+        folly::Random::randDouble01(rng) >=
+            settings->latency_aware_copyset_random_fraction) {
+      latency_candidates = settings->latency_aware_copyset_candidates;
+    }
+  }
+  copyset_chain_t candidate(replication_);
+  copyset_chain_t best_candidate(replication_);
+  bool best_candidate_chain = false;
+  std::chrono::microseconds best_candidate_latency =
+      std::chrono::microseconds::max();
+  size_t num_candidates = 0;
+
   Result ret;
   size_t attempts = 0;
+
+  auto return_best_candidate = [&] {
+    ld_check(num_candidates > 0);
+    std::copy(best_candidate.begin(), best_candidate.end(), copyset_out);
+    if (chain_out) {
+      *chain_out = best_candidate_chain;
+    }
+    *copyset_size_out = replication_;
+    if (latency_candidates > 1) {
+      STAT_INCR(stats_, copyset_latency_aware);
+    }
+    // TODO #8329263: support extras
+    return extras ? Result::PARTIAL : Result::SUCCESS;
+  };
+
   SCOPE_EXIT {
     if (!retry) {
       // not updating stats twice
@@ -738,6 +773,11 @@ WeightedCopySetSelector::select(copyset_size_t extras,
 
   // retry if allowed, else log errors
   auto retry_or_complain_on_too_many_unavailable = [&] {
+    if (num_candidates > 0) {
+      // Some shards became unavailable while we were collecting latency-aware
+      // candidates. The ones we already have are still good.
+      return return_best_candidate();
+    }
     if (retry) {
       nodeset_state_->resetGrayList(
           NodeSetState::GrayListResetReason::CANT_PICK_COPYSET);
@@ -791,6 +831,9 @@ WeightedCopySetSelector::select(copyset_size_t extras,
 
   while (true) {
     if (attempts >= MAX_BLACKLISTING_ITERATIONS) {
+      if (num_candidates > 0) {
+        return ret = return_best_candidate();
+      }
       RATELIMIT_ERROR(
           std::chrono::seconds(10),
           2,
@@ -934,18 +977,43 @@ WeightedCopySetSelector::select(copyset_size_t extras,
     }
 
     // Check if all selected nodes are available. If not, blacklist and retry.
+    bool candidate_chain = chain_out ? *chain_out : false;
     if (checkAvailabilityAndBlacklist(copyset_chain.data(),
                                       replication_,
                                       hierarchy,
                                       cache,
                                       &biased,
-                                      copyset_out,
-                                      chain_out)) {
-      *copyset_size_out = replication_;
-      // TODO #8329263: support extras
-      return ret = extras ? Result::PARTIAL : Result::SUCCESS;
+                                      candidate.data(),
+                                      chain_out ? &candidate_chain : nullptr)) {
+      std::chrono::microseconds latency =
+          latency_candidates > 1 ? estimateLatency(candidate.data())
+                                 : std::chrono::microseconds(0);
+      if (num_candidates == 0 || latency < best_candidate_latency) {
+        best_candidate.swap(candidate);
+        best_candidate_chain = candidate_chain;
+        best_candidate_latency = latency;
+      }
+      if (++num_candidates >= latency_candidates) {
+        return ret = return_best_candidate();
+      }
+    }
+  }
+}
+
+std::chrono::microseconds
+WeightedCopySetSelector::estimateLatency(const StoreChainLink copyset[]) const {
+  // An append is only as fast as its slowest copy, so use the maximum of
+  // per-shard tail latencies. Shards without an estimate count as fast, so
+  // that new or recovered shards get explored.
+  std::chrono::microseconds res(0);
+  for (copyset_size_t i = 0; i < replication_; ++i) {
+    auto estimate =
+        nodeset_state_->getStoreLatencyEstimate(copyset[i].destination);
+    if (estimate.has_value()) {
+      res = std::max(res, estimate->tail);
     }
   }
+  return res;
 }
 
 // See comment in .h for explanation.
@@ -1098,10 +1166,43 @@ CopySetSelector::Result
 WeightedCopySetSelector::augment(StoreChainLink inout_copyset[],
                                  copyset_size_t existing_copyset_size,
                                  copyset_size_t* out_full_size,
-                                 bool fill_client_id,
-                                 bool* chain_out,
+                                 bool /*fill_client_id*/,
+                                 bool* /*chain_out*/,
                                  RNG& rng,
                                  bool retry) const {
+  return augmentImpl(inout_copyset,
+                     existing_copyset_size,
+                     out_full_size,
+                     /* excluded = */ nullptr,
+                     /* nexcluded = */ 0,
+                     rng,
+                     retry);
+}
+
+CopySetSelector::Result
+WeightedCopySetSelector::augmentExcluding(StoreChainLink inout_copyset[],
+                                          copyset_size_t existing_copyset_size,
+                                          copyset_size_t* out_full_size,
+                                          const ShardID excluded[],
+                                          size_t nexcluded,
+                                          RNG& rng) const {
+  return augmentImpl(inout_copyset,
+                     existing_copyset_size,
+                     out_full_size,
+                     excluded,
+                     nexcluded,
+                     rng,
+                     /* retry = */ true);
+}
+
+CopySetSelector::Result
+WeightedCopySetSelector::augmentImpl(StoreChainLink inout_copyset[],
+                                     copyset_size_t existing_copyset_size,
+                                     copyset_size_t* out_full_size,
+                                     const ShardID excluded[],
+                                     size_t nexcluded,
+                                     RNG& rng,
+                                     bool retry) const {
   // make a copy of original input for retry
   copyset_chain_t inout_copyset_dup(
       inout_copyset, inout_copyset + existing_copyset_size);
@@ -1120,13 +1221,13 @@ WeightedCopySetSelector::augment(StoreChainLink inout_copyset[],
       worker->resetGraylist();
     }
 
-    return augment(inout_copyset,
-                   existing_copyset_size,
-                   out_full_size,
-                   fill_client_id,
-                   chain_out,
-                   rng,
-                   false /* retry */
+    return augmentImpl(inout_copyset,
+                       existing_copyset_size,
+                       out_full_size,
+                       excluded,
+                       nexcluded,
+                       rng,
+                       false /* retry */
     );
   };
   NodeAvailabilityCache& cache = prepareCachedNodeAvailability();
@@ -1147,6 +1248,12 @@ WeightedCopySetSelector::augment(StoreChainLink inout_copyset[],
                        existing_domains,
                        have_local_copies);
 
+  for (size_t i = 0; i < nexcluded; ++i) {
+    if (hierarchy_.node_paths.count(excluded[i])) {
+      hierarchy.detachNode(excluded[i]);
+    }
+  }
+
   if (useful_existing_copies >= replication_) {
     // No new copies needed.
     return Result::SUCCESS;
@@ -68,6 +68,14 @@ class WeightedCopySetSelector : public CopySetSelector {
                                   RNG& rng = DefaultRNG::get(),
                                   bool retry = true) const override;
 
+  CopySetSelector::Result
+  augmentExcluding(StoreChainLink inout_copyset[],
+                   copyset_size_t existing_copyset_size,
+                   copyset_size_t* out_full_size,
+                   const ShardID excluded[],
+                   size_t nexcluded,
+                   RNG& rng = DefaultRNG::get()) const override;
+
   copyset_size_t getReplicationFactor() const override {
     return replication_;
   }
@@ -350,6 +358,12 @@ class WeightedCopySetSelector : public CopySetSelector {
                                      StoreChainLink* out_chain_links = nullptr,
                                      bool* out_chain = nullptr) const;
 
+  // Estimated latency of storing a record on the first replication_ shards of
+  // the given copyset, based on NodeSetState's per-shard latency estimates.
+  // Used by latency-aware copyset selection.
+  std::chrono::microseconds
+  estimateLatency(const StoreChainLink copyset[]) const;
+
   // Selects `replication` nodes from the `domain`, according to weights.
   // `domain`'s immediate children must be leaves. If it fails to draw
   // exactly according to weights, sets *out_biased = true.
@@ -376,6 +390,17 @@ class WeightedCopySetSelector : public CopySetSelector {
                            bool* out_biased,
                            RNG& rng) const;
 
+  // Implementation of augment() and augmentExcluding(). The `nexcluded`
+  // shards in `excluded` are detached from the hierarchy before picking new
+  // copies.
+  CopySetSelector::Result augmentImpl(StoreChainLink inout_copyset[],
+                                      copyset_size_t existing_copyset_size,
+                                      copyset_size_t* out_full_size,
+                                      const ShardID excluded[],
+                                      size_t nexcluded,
+                                      RNG& rng,
+                                      bool retry) const;
+
   // This is the first step of augment(). It separates the nodes of existing
   // copyset into "useful" and "redundant" (see below). Also fills out some
   // data structures that augment() will be using.
@@ -0,0 +1,156 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/WorkStealingExecutor.h"
+
+#include <folly/Conv.h>
+
+#include "logdevice/common/Thread.h"
+#include "logdevice/common/ThreadID.h"
+#include "logdevice/common/checks.h"
+#include "logdevice/common/debug.h"
+#include "logdevice/common/stats/ServerHistograms.h"
+#include "logdevice/common/stats/Stats.h"
+
+namespace facebook { namespace logdevice {
+
+namespace {
+// Set on the threads of an executor, to find their own queue.
+thread_local WorkStealingExecutor* this_thread_executor{nullptr};
+thread_local size_t this_thread_queue{0};
+} // namespace
+
+class WorkStealingExecutor::ExecThread : public Thread {
+ public:
+  ExecThread(WorkStealingExecutor* owner, size_t idx)
+      : owner_(owner), idx_(idx) {}
+
+ protected:
+  void run() override {
+    ThreadID::set(ThreadID::UTILITY, threadName());
+    this_thread_executor = owner_;
+    this_thread_queue = idx_;
+    owner_->runThread(idx_);
+  }
+
+  std::string threadName() override {
+    return "ld:cpu-exec" + folly::to<std::string>(idx_);
+  }
+
+ private:
+  WorkStealingExecutor* const owner_;
+  const size_t idx_;
+};
+
+WorkStealingExecutor::WorkStealingExecutor(size_t nthreads, StatsHolder* stats)
+    : stats_(stats) {
+  ld_check(nthreads > 0);
+  for (size_t i = 0; i < nthreads; ++i) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  for (size_t i = 0; i < nthreads; ++i) {
+    threads_.push_back(std::make_unique<ExecThread>(this, i));
+    int rv = threads_.back()->start();
+    ld_check(rv == 0);
+  }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+  shutdown();
+}
+
+void WorkStealingExecutor::add(folly::Func func) {
+  addWithHint(next_queue_.fetch_add(1, std::memory_order_relaxed),
+              std::move(func));
+}
+
+void WorkStealingExecutor::addWithHint(size_t hint, folly::Func func) {
+  // A task adding more work keeps it local, the thread will likely get to it
+  // while its data is still in cache. Others will steal it otherwise.
+  const size_t idx =
+      this_thread_executor == this ? this_thread_queue : hint % queues_.size();
+  enqueue(idx, std::move(func));
+}
+
+void WorkStealingExecutor::enqueue(size_t idx, folly::Func func) {
+  {
+    Queue& queue = *queues_[idx];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(
+        Task{std::move(func), std::chrono::steady_clock::now()});
+  }
+  STAT_INCR(stats_, cpu_executor_tasks_queued);
+
+  // Pairs with the increment of sleepers_ in runThread(): either the thread
+  // going to sleep sees the task, or we see the thread and wake it up.
+  pending_.fetch_add(1);
+  if (sleepers_.load() > 0) {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    sleep_cv_.notify_one();
+  }
+}
+
+bool WorkStealingExecutor::tryPop(size_t self, Task* out) {
+  const size_t n = queues_.size();
+  for (size_t i = 0; i < n; ++i) {
+    Queue& queue = *queues_[(self + i) % n];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      continue;
+    }
+    *out = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    pending_.fetch_sub(1);
+    if (i != 0) {
+      STAT_INCR(stats_, cpu_executor_tasks_stolen);
+    }
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingExecutor::runThread(size_t self) {
+  for (;;) {
+    Task task;
+    if (tryPop(self, &task)) {
+      auto queue_usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() -
+                            task.enqueue_time)
+                            .count();
+      HISTOGRAM_ADD(stats_, cpu_executor_queue_latency, queue_usec);
+      STAT_DECR(stats_, cpu_executor_tasks_queued);
+      task.func();
+      STAT_INCR(stats_, cpu_executor_tasks_executed);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    sleepers_.fetch_add(1);
+    sleep_cv_.wait(lock, [&] { return pending_.load() > 0 || stopping_; });
+    sleepers_.fetch_sub(1);
+    if (stopping_ && pending_.load() == 0) {
+      return;
+    }
+  }
+}
+
+void WorkStealingExecutor::shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    if (stopping_) {
+      return;
+    }
+    stopping_ = true;
+  }
+  sleep_cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread->join();
+  }
+  threads_.clear();
+}
+
+}} // namespace facebook::logdevice
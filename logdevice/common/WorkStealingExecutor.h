@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <folly/Executor.h>
+
+namespace facebook { namespace logdevice {
+
+class StatsHolder;
+
+/**
+ * @file Pool of threads for CPU-heavy work that doesn't need any state owned
+ * by a Worker, e.g. (de)compression, checksumming or serialization, so that
+ * such work doesn't delay everything else queued on the worker that happens
+ * to receive it.
+ *
+ * Each thread has its own queue. Work added by a Worker goes to the queue
+ * picked by the worker's index, work added from a pool thread goes to that
+ * thread's queue. A thread whose queue is empty takes the oldest task from
+ * another thread's queue, so one busy queue is drained by all threads.
+ *
+ * Workers normally use this through Worker::offloadToCpuExecutor(), which
+ * posts the result back to the worker.
+ */
+
+class WorkStealingExecutor : public folly::Executor {
+ public:
+  /**
+   * Starts `nthreads` threads.
+   *
+   * @param stats  if not nullptr, gets cpu_executor_* stats and the
+   *               cpu_executor_queue_latency histogram
+   */
+  WorkStealingExecutor(size_t nthreads, StatsHolder* stats);
+
+  /**
+   * Calls shutdown().
+   */
+  ~WorkStealingExecutor() override;
+
+  /**
+   * Runs `func` on one of the threads. Must not be called after shutdown().
+   */
+  void add(folly::Func func) override;
+
+  /**
+   * Like add(), but queues `func` on the queue chosen by `hint` (modulo the
+   * number of threads) unless called from one of the threads.
+   */
+  void addWithHint(size_t hint, folly::Func func);
+
+  /**
+   * Runs all queued tasks and joins the threads.
+   */
+  void shutdown();
+
+  size_t numThreads() const {
+    return queues_.size();
+  }
+
+ private:
+  class ExecThread;
+
+  struct Task {
+    folly::Func func;
+    std::chrono::steady_clock::time_point enqueue_time;
+  };
+
+  struct alignas(128) Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void enqueue(size_t idx, folly::Func func);
+  // Takes the oldest task of queue `self`, or else of another queue.
+  bool tryPop(size_t self, Task* out);
+  void runThread(size_t self);
+
+  StatsHolder* const stats_;
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::unique_ptr<ExecThread>> threads_;
+
+  // Tasks queued and not taken by any thread yet.
+  std::atomic<size_t> pending_{0};
+  // Threads blocked, or about to block, on sleep_cv_.
+  std::atomic<size_t> sleepers_{0};
+  std::atomic<size_t> next_queue_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  // Protected by sleep_mutex_.
+  bool stopping_{false};
+};
+
+}} // namespace facebook::logdevice
@@ -19,6 +19,7 @@
 
 #include "logdevice/common/AbortAppendersEpochRequest.h"
 #include "logdevice/common/AllSequencers.h"
+#include "logdevice/common/AppendLatencyBreakdown.h"
 #include "logdevice/common/AppendRequest.h"
 #include "logdevice/common/AppendRequestBase.h"
 #include "logdevice/common/Appender.h"
@@ -59,6 +60,7 @@
 #include "logdevice/common/TimeoutMap.h"
 #include "logdevice/common/TraceLogger.h"
 #include "logdevice/common/TrimRequest.h"
+#include "logdevice/common/WorkStealingExecutor.h"
 #include "logdevice/common/WorkerTimeoutStats.h"
 #include "logdevice/common/WriteMetaDataRecord.h"
 #include "logdevice/common/client_read_stream/AllClientReadStreams.h"
@@ -66,11 +68,13 @@
 #include "logdevice/common/configuration/UpdateableConfig.h"
 #include "logdevice/common/configuration/logs/LogsConfigManager.h"
 #include "logdevice/common/event_log/EventLogStateMachine.h"
+#include "logdevice/common/network/IOBufArena.h"
 #include "logdevice/common/network/LibeventCompatibilityConnectionFactory.h"
 #include "logdevice/common/network/OverloadDetector.h"
 #include "logdevice/common/protocol/APPENDED_Message.h"
 #include "logdevice/common/protocol/MessageDispatch.h"
 #include "logdevice/common/protocol/MessageTracer.h"
+#include "logdevice/common/request_util.h"
 #include "logdevice/common/stats/ServerHistograms.h"
 #include "logdevice/common/stats/Stats.h"
 #include "logdevice/include/Err.h"
@@ -127,7 +131,8 @@ class WorkerImpl {
                 getMyNodeIndex(w),
                 getMyLocation(config, w),
                 std::unique_ptr<IConnectionFactory>(
-                    new LibeventCompatibilityConnectionFactory(w->getEvBase())),
+                    new LibeventCompatibilityConnectionFactory(
+                        w->getEvBase(), *w->immutable_settings_)),
                 stats),
         activeAppenders_(w->immutable_settings_->server ? N_APPENDER_MAP_BUCKETS
                                                         : 1),
@@ -185,6 +190,7 @@ class WorkerImpl {
   std::unique_ptr<SequencerBackgroundActivator> sequencerBackgroundActivator_;
   std::unique_ptr<GraylistingTracker> graylistingTracker_;
   std::unique_ptr<ShapingContainer> read_shaping_container_;
+  IOBufArena serializationArena_;
 };
 
 std::string Worker::makeThreadName(Processor* processor,
@@ -219,6 +225,8 @@ Worker::Worker(WorkContext::KeepAlive event_loop,
       shutting_down_(false),
       accepting_work_(true),
       worker_timeout_stats_(std::make_unique<WorkerTimeoutStats>()),
+      append_latency_breakdowns_(
+          std::make_unique<RecentAppendLatencyBreakdowns>()),
       overload_detector_(std::make_unique<OverloadDetector>(
           std::make_unique<OverloadDetectorDependencies>())),
       worker_stall_error_injection_chance_(
@@ -922,6 +930,10 @@ void Worker::reportLoad() {
 
     ld_spew("%s reporting load %ld", getName().c_str(), load_delta);
     processor_->reportLoad(idx_, load_delta, worker_type_);
+
+    if (settings().client_connection_rebalancing) {
+      rebalanceClientConnections(now - last_load_time_);
+    }
   }
 
   last_load_ = now_load;
@@ -929,6 +941,30 @@ void Worker::reportLoad() {
   load_timer_->activate(seconds(10));
 }
 
+void Worker::rebalanceClientConnections(
+    std::chrono::steady_clock::duration interval) {
+  int64_t excess;
+  worker_id_t target = processor_->selectRebalancingTarget(
+      idx_, settings().client_connection_rebalancing_threshold, &excess);
+  if (target == WORKER_ID_INVALID) {
+    sender().resetClientConnectionsCpuTime();
+    return;
+  }
+  // `excess` is in CPU microseconds per second, same as the load. Move
+  // connections that used about that much over the last interval.
+  auto budget = std::chrono::microseconds(static_cast<int64_t>(
+      excess *
+      std::chrono::duration_cast<std::chrono::duration<double>>(interval)
+          .count()));
+  size_t moved = sender().migrateClientConnections(target, budget);
+  if (moved > 0) {
+    ld_debug("%s moved %zu client connections to %s",
+             getName().c_str(),
+             moved,
+             getName(worker_type_, target).c_str());
+  }
+}
+
 EventLogStateMachine* Worker::getEventLogStateMachine() {
   return event_log_;
 }
@@ -1165,6 +1201,10 @@ ShapingContainer& Worker::readShapingContainer() const {
   return *impl_->read_shaping_container_;
 }
 
+IOBufArena& Worker::serializationArena() const {
+  return impl_->serializationArena_;
+}
+
 GetSeqStateRequestMap& Worker::runningGetSeqState() const {
   return impl_->runningGetSeqState_;
 }
@@ -1340,6 +1380,10 @@ void Worker::add(folly::Func func) {
 }
 
 void Worker::addWithPriority(folly::Func func, int8_t priority) {
+  WorkContext::addWithPriority(wrapWork(std::move(func), priority), priority);
+}
+
+folly::Func Worker::wrapWork(folly::Func func, int8_t priority) {
   switch (priority) {
     case folly::Executor::HI_PRI:
       STAT_INCR(processor_->stats_, worker_enqueued_hi_pri_work);
@@ -1355,38 +1399,65 @@ void Worker::addWithPriority(folly::Func func, int8_t priority) {
   }
 
   num_requests_enqueued_.fetch_add(1, std::memory_order_relaxed);
-  WorkContext::addWithPriority(
-      [this,
-       func = std::move(func),
-       priority,
-       enqueue_time = std::chrono::steady_clock::now()]() mutable {
-        WorkerContextScopeGuard g(this);
-        num_requests_enqueued_.fetch_sub(1, std::memory_order_relaxed);
-
-        const auto queue_time =
-            std::chrono::duration_cast<std::chrono::microseconds>(
-                std::chrono::steady_clock::now() - enqueue_time);
-
-        HISTOGRAM_ADD(stats_, requests_queue_latency, queue_time.count());
-        switch (priority) {
-          case folly::Executor::HI_PRI:
-            HISTOGRAM_ADD(stats_, hi_pri_requests_latency, queue_time.count());
-            STAT_INCR(processor_->stats_, worker_executed_hi_pri_work);
-            break;
-          case folly::Executor::MID_PRI:
-            HISTOGRAM_ADD(stats_, mid_pri_requests_latency, queue_time.count());
-            STAT_INCR(processor_->stats_, worker_executed_mid_pri_work);
-            break;
-          case folly::Executor::LO_PRI:
-            HISTOGRAM_ADD(stats_, lo_pri_requests_latency, queue_time.count());
-            STAT_INCR(processor_->stats_, worker_executed_lo_pri_work);
-            break;
-          default:
-            break;
+  return [this,
+          func = std::move(func),
+          priority,
+          enqueue_time = std::chrono::steady_clock::now()]() mutable {
+    WorkerContextScopeGuard g(this);
+    num_requests_enqueued_.fetch_sub(1, std::memory_order_relaxed);
+
+    const auto queue_time =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - enqueue_time);
+
+    HISTOGRAM_ADD(stats_, requests_queue_latency, queue_time.count());
+    switch (priority) {
+      case folly::Executor::HI_PRI:
+        HISTOGRAM_ADD(stats_, hi_pri_requests_latency, queue_time.count());
+        STAT_INCR(processor_->stats_, worker_executed_hi_pri_work);
+        break;
+      case folly::Executor::MID_PRI:
+        HISTOGRAM_ADD(stats_, mid_pri_requests_latency, queue_time.count());
+        STAT_INCR(processor_->stats_, worker_executed_mid_pri_work);
+        break;
+      case folly::Executor::LO_PRI:
+        HISTOGRAM_ADD(stats_, lo_pri_requests_latency, queue_time.count());
+        STAT_INCR(processor_->stats_, worker_executed_lo_pri_work);
+        break;
+      default:
+        break;
+    }
+    func();
+  };
+}
+
+void Worker::offloadToCpuExecutorImpl(
+    folly::Function<folly::Function<void()>()> work) {
+  Processor* processor = processor_;
+  const worker_id_t idx = idx_;
+  const WorkerType worker_type = worker_type_;
+  // Workers hint their own queue, so that a busy worker's offloaded work is
+  // spread to other threads only by stealing.
+  processor->getCpuExecutor().addWithHint(
+      idx.val(),
+      [processor, idx, worker_type, work = std::move(work)]() mutable {
+        // FuncRequest wants a copyable function.
+        auto done = std::make_shared<folly::Function<void()>>(work());
+        std::unique_ptr<Request> rq =
+            FuncRequest::make(idx,
+                              worker_type,
+                              RequestType::CPU_EXECUTOR_RESULT,
+                              [done] { (*done)(); });
+        int rv = processor->postImportant(rq);
+        if (rv != 0 && err != E::SHUTDOWN) {
+          RATELIMIT_ERROR(std::chrono::seconds(10),
+                          2,
+                          "Failed to post CPU executor result to worker %s: "
+                          "%s",
+                          getName(worker_type, idx).c_str(),
+                          error_description(err));
         }
-        func();
-      },
-      priority);
+      });
 }
 
 int Worker::forcePost(std::unique_ptr<Request>& req) {
@@ -1400,16 +1471,70 @@ int Worker::forcePost(std::unique_ptr<Request>& req) {
     return -1;
   }
 
-  req->enqueue_time_ = std::chrono::steady_clock::now();
   auto priority = req->getExecutorPriority();
-  folly::Func func = [rq = std::move(req), this]() mutable {
-    processRequest(std::move(rq));
-  };
-  addWithPriority(std::move(func), priority);
+  addWithPriority(wrapRequest(req), priority);
 
   return 0;
 }
 
+int Worker::tryPostBatch(std::vector<std::unique_ptr<Request>>& reqs) {
+  if (shutting_down_) {
+    err = E::SHUTDOWN;
+    return -1;
+  }
+
+  if (num_requests_enqueued_.load(std::memory_order_relaxed) >
+      updateable_settings_->worker_request_pipe_capacity) {
+    err = E::NOBUFS;
+    return -1;
+  }
+
+  return forcePostBatch(reqs);
+}
+
+int Worker::forcePostBatch(std::vector<std::unique_ptr<Request>>& reqs) {
+  if (shutting_down_) {
+    err = E::SHUTDOWN;
+    return -1;
+  }
+
+  for (const auto& req : reqs) {
+    if (!req) {
+      err = E::INVALID_PARAM;
+      return -1;
+    }
+  }
+
+  auto* ev_loop = dynamic_cast<EventLoop*>(getExecutor());
+  if (ev_loop == nullptr) {
+    // Not running on an EventLoop, there is no batch to take advantage of.
+    for (auto& req : reqs) {
+      int rv = forcePost(req);
+      ld_check(rv == 0);
+    }
+    reqs.clear();
+    return 0;
+  }
+
+  EventLoopTaskQueue::TaskBatch batch;
+  batch.reserve(reqs.size());
+  for (auto& req : reqs) {
+    auto priority = req->getExecutorPriority();
+    batch.emplace_back(wrapWork(wrapRequest(req), priority), priority);
+  }
+  reqs.clear();
+  ev_loop->addBatch(std::move(batch));
+
+  return 0;
+}
+
+folly::Func Worker::wrapRequest(std::unique_ptr<Request>& req) {
+  req->enqueue_time_ = std::chrono::steady_clock::now();
+  return [rq = std::move(req), this]() mutable {
+    processRequest(std::move(rq));
+  };
+}
+
 void Worker::generateErrorInjection(double error_chance,
                                     std::chrono::milliseconds sleep_duration) {
   if (UNLIKELY(worker_type_ == WorkerType::GENERAL && error_chance > 0 &&
@@ -118,6 +118,7 @@ class Configuration;
 class EpochRecovery;
 class EventLogStateMachine;
 class GetSeqStateRequestMap;
+class IOBufArena;
 class LogStorageState;
 class LogsConfig;
 class LogsConfigManager;
@@ -126,6 +127,7 @@ class MetaDataLogReader;
 class Mutator;
 class Processor;
 class RebuildingCoordinatorInterface;
+class RecentAppendLatencyBreakdowns;
 class Request;
 class SSLFetcher;
 class Sender;
@@ -453,6 +455,9 @@ class Worker : public WorkContext {
   CheckSealRequestMap& runningCheckSeals() const;
   ShapingContainer& readShapingContainer() const;
 
+  // Buffers that Connections on this Worker serialize outgoing messages into.
+  IOBufArena& serializationArena() const;
+
   ConfigurationFetchRequestMap& runningConfigurationFetches() const;
 
   // a map of all currently running GetSeqStateRequests
@@ -758,6 +763,12 @@ class Worker : public WorkContext {
     return *worker_timeout_stats_;
   }
 
+  // Latency breakdowns of traced appends whose Appenders were reaped on this
+  // Worker, see "info append_latency_breakdown".
+  RecentAppendLatencyBreakdowns& appendLatencyBreakdowns() {
+    return *append_latency_breakdowns_;
+  }
+
   const std::unordered_set<node_index_t>& getGraylistedNodes() const;
   void resetGraylist();
 
@@ -790,7 +801,45 @@ class Worker : public WorkContext {
    */
   int forcePost(std::unique_ptr<Request>& req);
 
+  /**
+   * Like forcePost() for each of `reqs`, in order, but the worker thread is
+   * woken up once for the whole batch instead of once per request.
+   *
+   * @return 0 if all requests were posted, `reqs` is then cleared. Otherwise
+   * -1 with err set to SHUTDOWN or INVALID_PARAM (if any of the requests is
+   * nullptr), and none of the requests were posted.
+   */
+  int forcePostBatch(std::vector<std::unique_ptr<Request>>& reqs);
+
+  /**
+   * Like forcePostBatch() but fails with NOBUFS, without posting anything, if
+   * too many requests are already pending on this worker.
+   */
+  int tryPostBatch(std::vector<std::unique_ptr<Request>>& reqs);
+
   virtual void setupWorker();
+
+  /**
+   * Runs `fn` on the Processor's CPU executor (see WorkStealingExecutor),
+   * then `cb` with the value `fn` returned on this worker. Meant for
+   * CPU-heavy work that would otherwise hold up everything queued behind it
+   * on this worker.
+   *
+   * `fn` runs on another thread and must not touch state owned by this
+   * worker. `cb` isn't called if the worker shuts down before `fn`
+   * completes, and may then be destroyed on the executor's thread.
+   */
+  template <typename Fn, typename Cb>
+  void offloadToCpuExecutor(Fn fn, Cb cb) {
+    offloadToCpuExecutorImpl(
+        [fn = std::move(fn), cb = std::move(cb)]() mutable {
+          return folly::Function<void()>(
+              [cb = std::move(cb), result = fn()]() mutable {
+                cb(std::move(result));
+              });
+        });
+  }
+
   // Callback functions that register worker id and duration of slow/delayed
   // action.
   using SlowRequestCallback =
@@ -810,6 +859,22 @@ class Worker : public WorkContext {
   // assignment
   void reportLoad();
 
+  // Called by reportLoad() with --client-connection-rebalancing to move
+  // client connections to the least loaded worker if it's much less loaded
+  // than this one. `interval` is the time since the previous report.
+  void rebalanceClientConnections(std::chrono::steady_clock::duration interval);
+
+  // `work` runs on the CPU executor and returns what to run on this worker.
+  void offloadToCpuExecutorImpl(
+      folly::Function<folly::Function<void()>()> work);
+
+  // Wraps `func` added with `priority` to run with this Worker's context and
+  // to account for its queueing time.
+  folly::Func wrapWork(folly::Func func, int8_t priority);
+
+  // Function that executes `req` on this Worker.
+  folly::Func wrapRequest(std::unique_ptr<Request>& req);
+
   void disableSequencersDueIsolationTimeout();
 
   // Initializes subscriptions to config and setting updates
@@ -915,6 +980,8 @@ class Worker : public WorkContext {
 
   std::unique_ptr<WorkerTimeoutStats> worker_timeout_stats_;
 
+  std::unique_ptr<RecentAppendLatencyBreakdowns> append_latency_breakdowns_;
+
   std::unique_ptr<OverloadDetector> overload_detector_;
 
   // Counts the number of requests enqueued into the Worker for processing.
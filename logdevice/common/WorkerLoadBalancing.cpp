@@ -72,4 +72,31 @@ worker_id_t WorkerLoadBalancing::selectWorker() {
   return worker_id_t(coinflip < prob ? index2 : index1);
 }
 
+worker_id_t WorkerLoadBalancing::selectRebalancingTarget(
+    worker_id_t from,
+    double min_imbalance,
+    int64_t* excess) const {
+  ld_check(from.val_ >= 0);
+  ld_check(from.val_ < loads_.size());
+  ld_check(excess);
+
+  int min_idx = -1;
+  int64_t min_load = 0;
+  for (int i = 0; i < loads_.size(); ++i) {
+    auto load = loads_[i].val.load();
+    if (min_idx == -1 || load < min_load) {
+      min_idx = i;
+      min_load = load;
+    }
+  }
+
+  const int64_t from_load = loads_[from.val_].val.load();
+  if (min_idx == from.val_ || from_load <= 0 ||
+      from_load - min_load <= min_imbalance * from_load) {
+    return WORKER_ID_INVALID;
+  }
+  *excess = (from_load - min_load) / 2;
+  return worker_id_t(min_idx);
+}
+
 }} // namespace facebook::logdevice
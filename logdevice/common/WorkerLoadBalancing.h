@@ -54,6 +54,19 @@ class WorkerLoadBalancing {
    */
   worker_id_t selectWorker();
 
+  /**
+   * Used by busy workers to find a worker to move some of their connections
+   * to. If the load of `from` exceeds the load of the least loaded worker by
+   * more than `min_imbalance` (as a fraction of from's load), returns the
+   * least loaded worker and sets *excess to half the difference, the load to
+   * move for both to end up even. Otherwise returns WORKER_ID_INVALID.
+   *
+   * Thread-safe.
+   */
+  worker_id_t selectRebalancingTarget(worker_id_t from,
+                                      double min_imbalance,
+                                      int64_t* excess) const;
+
  private:
   struct PaddedLoad {
     std::atomic<int64_t> val{0};
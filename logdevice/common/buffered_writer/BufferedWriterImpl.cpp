@@ -657,6 +657,14 @@ int BufferedWriterImpl::flushAll() {
 }
 
 int BufferedWriterImpl::mapLogToShardIndex(logid_t log_id) const {
+  if (per_worker_log_predicate_) {
+    Worker* w = Worker::onThisThread(false);
+    if (w && w->worker_type_ == WorkerType::GENERAL &&
+        static_cast<size_t>(w->idx_.val_) < shards_.size() &&
+        per_worker_log_predicate_(log_id)) {
+      return w->idx_.val_;
+    }
+  }
   return folly::hash::hash_128_to_64(hash_salt_, log_id.val_) % shards_.size();
 }
 
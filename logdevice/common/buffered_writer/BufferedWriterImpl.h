@@ -223,6 +223,17 @@ class BufferedWriterImpl : public BufferedWriter {
     callback_ = cb;
   }
 
+  // If set, logs for which the predicate returns true are not pinned to a
+  // single shard. Instead, appends to them are buffered and flushed on the
+  // shard of the worker the append was made from (if it is called on a
+  // worker), so that a hot log can use more than one core. Appends made on
+  // the same worker stay ordered, there are no ordering guarantees across
+  // workers. The predicate is only evaluated on worker threads. Must be
+  // called before any appends.
+  void setPerWorkerLogPredicate(std::function<bool(logid_t)> pred) {
+    per_worker_log_predicate_ = std::move(pred);
+  }
+
   // Variant of append() that ensures that all appends go into the same batch.
   // They must all belong to the same log specified by @param log_id.
   int appendAtomic(logid_t log_id, std::vector<Append>&& appends);
@@ -363,6 +374,8 @@ class BufferedWriterImpl : public BufferedWriter {
   std::atomic<bool> shutting_down_{false};
   WaitableCounter num_background_tasks_;
   uint64_t hash_salt_;
+  // See setPerWorkerLogPredicate().
+  std::function<bool(logid_t)> per_worker_log_predicate_;
   bool prepend_checksums_ = false;
   // This will have exactly one entry for each Worker in the Processor's
   // thread pool.
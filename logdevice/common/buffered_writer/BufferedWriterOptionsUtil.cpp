@@ -91,6 +91,11 @@ void describeBufferedWriterOptions(options_description& po,
                        ->default_value(opts->memory_limit_mb),
                    "Approximate memory budget for buffered and inflight "
                    "writes, in megabytes.");
+  po.add_options()((prefix + "stream-inflight-window").c_str(),
+                   value<int32_t>(&opts->stream_inflight_window)
+                       ->default_value(opts->stream_inflight_window),
+                   "In stream mode, maximum number of batches per log in "
+                   "flight at a time. Zero or negative for no limit.");
 }
 
 std::string BufferedWriter::LogOptions::modeToString(Mode mode) {
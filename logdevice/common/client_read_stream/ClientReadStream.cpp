@@ -34,6 +34,7 @@
 #include "logdevice/common/Sender.h"
 #include "logdevice/common/SocketCallback.h"
 #include "logdevice/common/Timestamp.h"
+#include "logdevice/common/Tracepoints.h"
 #include "logdevice/common/Worker.h"
 #include "logdevice/common/client_read_stream/AllClientReadStreams.h"
 #include "logdevice/common/client_read_stream/ClientReadStreamBuffer.h"
@@ -3249,9 +3250,10 @@ int ClientReadStream::deliverRecord(
       std::chrono::system_clock::now().time_since_epoch());
 
   OffsetMap current_offsets = OffsetMap::fromRecord(record->attrs.offsets);
+  const size_t payload_size = record->payload.size();
   OffsetMap payload_size_map;
   // TODO(T33977412) Add record counter offset based on settings
-  payload_size_map.setCounter(BYTE_OFFSET, record->payload.size());
+  payload_size_map.setCounter(BYTE_OFFSET, payload_size);
 
   // we should always deliver the record at next_lsn_to_deliver_, which is at
   // the front of the buffer
@@ -3331,6 +3333,7 @@ int ClientReadStream::deliverRecord(
       // lsn appropriately in that case.
       last_delivered_lsn_ = lsn;
     }
+    tracepoints::clientReadStreamDeliver(log_id_, lsn, payload_size);
     if (MetaDataLog::isMetaDataLog(log_id_)) {
       if (wait_for_all_copies_) {
         WORKER_STAT_INCR(metadata_log_records_delivered_wait_for_all);
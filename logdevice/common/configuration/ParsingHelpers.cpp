@@ -894,6 +894,31 @@ bool parseTrafficShaping(const folly::dynamic& map, TrafficShapingConfig& tsc) {
     return false;
   }
 
+  tsc.compressed_traffic_classes.clear();
+  auto compressed_it = iter->second.find("compressed_traffic_classes");
+  if (compressed_it != iter->second.items().end()) {
+    const folly::dynamic& classes = compressed_it->second;
+    if (!classes.isArray()) {
+      ld_error("\"compressed_traffic_classes\" in the \"traffic_shaping\" "
+               "section must be an array of traffic class names");
+      err = E::INVALID_CONFIG;
+      return false;
+    }
+    for (const folly::dynamic& name : classes) {
+      std::string upper = name.isString() ? name.asString() : "";
+      std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+      TrafficClass tc = trafficClasses().reverseLookup(upper);
+      if (tc == trafficClasses().invalidEnum()) {
+        ld_error("Invalid traffic class %s in \"compressed_traffic_classes\" "
+                 "of the \"traffic_shaping\" section",
+                 folly::toJson(name).c_str());
+        err = E::INVALID_CONFIG;
+        return false;
+      }
+      tsc.compressed_traffic_classes.insert(tc);
+    }
+  }
+
   return true;
 }
 
@@ -29,6 +29,13 @@ folly::dynamic TrafficShapingConfig::toFollyDynamic() const {
   folly::dynamic result =
       folly::dynamic::object("default_read_traffic_class",
                              trafficClasses()[default_read_traffic_class]);
+  if (!compressed_traffic_classes.empty()) {
+    folly::dynamic compressed = folly::dynamic::array;
+    for (TrafficClass tc : compressed_traffic_classes) {
+      compressed.push_back(trafficClasses()[tc]);
+    }
+    result["compressed_traffic_classes"] = std::move(compressed);
+  }
   ShapingConfig::toFollyDynamic(result);
   return result;
 }
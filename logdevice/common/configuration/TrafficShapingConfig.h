@@ -8,6 +8,7 @@
 #pragma once
 
 #include <array>
+#include <set>
 
 #include "logdevice/common/configuration/ShapingConfig.h"
 
@@ -19,6 +20,10 @@ struct TrafficShapingConfig : public ShapingConfig {
   folly::dynamic toFollyDynamic() const;
 
   TrafficClass default_read_traffic_class = TrafficClass::READ_BACKLOG;
+
+  // Messages of these traffic classes are compressed on connections that
+  // negotiated compression (see Settings::connection_compression).
+  std::set<TrafficClass> compressed_traffic_classes;
 };
 
 }}} // namespace facebook::logdevice::configuration
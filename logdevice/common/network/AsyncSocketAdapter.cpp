@@ -17,6 +17,7 @@
 #include <folly/io/async/SSLContext.h>
 #include <folly/net/NetworkSocket.h>
 
+#include "logdevice/common/SSLFetcher.h"
 #include "logdevice/common/checks.h"
 #include "logdevice/common/debug.h"
 
@@ -115,6 +116,12 @@ AsyncSocketAdapter::getPeerCertificate() const {
   return transport_->getPeerCertificate();
 }
 
+bool AsyncSocketAdapter::isKernelTlsEnabled() const {
+  auto ssl_socket =
+      dynamic_cast<const folly::AsyncSSLSocket*>(transport_.get());
+  return ssl_socket && logdevice::isKernelTlsEnabled(ssl_socket->getSSL());
+}
+
 size_t AsyncSocketAdapter::getRawBytesWritten() const {
   return transport_->getRawBytesWritten();
 }
@@ -137,6 +144,10 @@ void AsyncSocketAdapter::writeChain(WriteCallback* callback,
   transport_->writeChain(callback, std::move(buf), flags);
 }
 
+bool AsyncSocketAdapter::setZeroCopy(bool enable) {
+  return transport_->setZeroCopy(enable);
+}
+
 int AsyncSocketAdapter::setSendBufSize(size_t bufsize) {
   return transport_->setSendBufSize(bufsize);
 }
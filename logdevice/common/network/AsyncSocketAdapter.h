@@ -216,6 +216,16 @@ class AsyncSocketAdapter : public SocketAdapter {
    */
   const folly::AsyncTransportCertificate* getPeerCertificate() const override;
 
+  bool isKernelTlsEnabled() const override;
+
+  /**
+   * AsyncSocket closes its fd without shutting the connection down and only
+   * reads when asked to by the read callback.
+   */
+  bool canDetachFd() const override {
+    return true;
+  }
+
   size_t getRawBytesWritten() const override;
   size_t getRawBytesReceived() const override;
 
@@ -236,6 +246,13 @@ class AsyncSocketAdapter : public SocketAdapter {
                   std::unique_ptr<folly::IOBuf>&& buf,
                   folly::WriteFlags flags = folly::WriteFlags::NONE) override;
 
+  /**
+   * Enable MSG_ZEROCOPY on the underlying AsyncSocket, which then tracks
+   * completion notifications from the socket error queue and holds on to the
+   * written IOBufs until they arrive.
+   */
+  bool setZeroCopy(bool enable) override;
+
   /**
    * Set the send bufsize
    */
@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/network/IOBufArena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "logdevice/common/checks.h"
+
+namespace facebook { namespace logdevice {
+
+namespace {
+// Carved buffers start at this alignment, like malloc()ed ones would.
+constexpr size_t kAlignment = alignof(std::max_align_t);
+} // namespace
+
+struct IOBufArena::Chunk {
+  Chunk() : refs(1) {}
+
+  // One for the arena while the chunk is current, one per carved IOBuf.
+  std::atomic<size_t> refs;
+
+  static Chunk* create(size_t size) {
+    void* mem = std::malloc(dataOffset() + size);
+    if (!mem) {
+      throw std::bad_alloc();
+    }
+    return new (mem) Chunk();
+  }
+
+  static constexpr size_t dataOffset() {
+    return (sizeof(Chunk) + kAlignment - 1) / kAlignment * kAlignment;
+  }
+
+  uint8_t* data() {
+    return reinterpret_cast<uint8_t*>(this) + dataOffset();
+  }
+
+  void decRef() {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      this->~Chunk();
+      std::free(this);
+    }
+  }
+};
+
+IOBufArena::IOBufArena(size_t chunk_size) : chunk_size_(chunk_size) {
+  ld_check(chunk_size_ >= kMaxCarveSize);
+}
+
+IOBufArena::~IOBufArena() {
+  if (chunk_) {
+    chunk_->decRef();
+  }
+}
+
+void IOBufArena::release(void* /* buf */, void* chunk) {
+  static_cast<Chunk*>(chunk)->decRef();
+}
+
+std::unique_ptr<folly::IOBuf> IOBufArena::allocate(size_t capacity) {
+  if (capacity == 0 || capacity > kMaxCarveSize) {
+    return folly::IOBuf::create(capacity);
+  }
+
+  if (!chunk_ || chunk_size_ - used_ < capacity) {
+    if (chunk_) {
+      chunk_->decRef();
+    }
+    chunk_ = Chunk::create(chunk_size_);
+    used_ = 0;
+    ++chunks_allocated_;
+  }
+
+  uint8_t* buf = chunk_->data() + used_;
+  used_ = std::min(
+      chunk_size_, (used_ + capacity + kAlignment - 1) / kAlignment * kAlignment);
+  chunk_->refs.fetch_add(1, std::memory_order_relaxed);
+  // If this throws, release() is called and the reference dropped.
+  return folly::IOBuf::takeOwnership(
+      buf, capacity, /* length */ 0, &IOBufArena::release, chunk_);
+}
+
+}} // namespace facebook::logdevice
@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <folly/io/IOBuf.h>
+
+namespace facebook { namespace logdevice {
+
+/**
+ * @file Carves small IOBufs out of large chunks of memory, so that the
+ *       buffers messages are serialized into are packed together instead of
+ *       each getting its own allocation. Every Worker owns one (see
+ *       Worker::serializationArena()), used by Connection::serializeMessage().
+ *
+ *       A chunk is freed once the arena moved on to the next one and every
+ *       IOBuf carved out of it was destroyed, which may happen on any thread.
+ *       The arena itself is not thread safe.
+ */
+
+class IOBufArena {
+ public:
+  static constexpr size_t kDefaultChunkSize = 64 * 1024;
+
+  // Requests larger than this are served by IOBuf::create(), they would
+  // waste too much of a chunk.
+  static constexpr size_t kMaxCarveSize = 4096;
+
+  explicit IOBufArena(size_t chunk_size = kDefaultChunkSize);
+  ~IOBufArena();
+
+  IOBufArena(const IOBufArena&) = delete;
+  IOBufArena& operator=(const IOBufArena&) = delete;
+
+  /**
+   * @return an empty IOBuf with exactly `capacity' bytes of tailroom.
+   */
+  std::unique_ptr<folly::IOBuf> allocate(size_t capacity);
+
+  // Number of chunks allocated so far.
+  size_t numChunksAllocated() const {
+    return chunks_allocated_;
+  }
+
+ private:
+  struct Chunk;
+
+  // IOBuf free function of carved buffers, drops a reference to the chunk.
+  static void release(void* buf, void* chunk);
+
+  const size_t chunk_size_;
+  Chunk* chunk_{nullptr};
+  // Offset of the first free byte of chunk_.
+  size_t used_{0};
+  size_t chunks_allocated_{0};
+};
+
+}} // namespace facebook::logdevice
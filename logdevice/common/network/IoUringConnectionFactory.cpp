@@ -0,0 +1,137 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/network/IoUringConnectionFactory.h"
+
+#include <folly/io/async/EventBase.h>
+
+#include "logdevice/common/Connection.h"
+#include "logdevice/common/FlowGroup.h"
+#include "logdevice/common/Sockaddr.h"
+#include "logdevice/common/SocketDependencies.h"
+#include "logdevice/common/checks.h"
+#include "logdevice/common/network/AsyncSocketConnectionFactory.h"
+#include "logdevice/common/network/IoUringContext.h"
+#include "logdevice/common/network/IoUringSocketAdapter.h"
+#include "logdevice/common/settings/Settings.h"
+
+namespace facebook { namespace logdevice {
+
+std::unique_ptr<IoUringConnectionFactory>
+IoUringConnectionFactory::create(folly::EventBase* base,
+                                 const Settings& settings) {
+  IoUringContext::Options options;
+  options.sq_entries = settings.io_uring_sq_entries;
+  options.nbuffers = settings.io_uring_buffers;
+  options.buffer_size = settings.io_uring_buffer_size;
+  auto ctx = IoUringContext::create(base, options);
+  if (!ctx) {
+    return nullptr;
+  }
+  return std::unique_ptr<IoUringConnectionFactory>(
+      new IoUringConnectionFactory(base, std::move(ctx)));
+}
+
+IoUringConnectionFactory::IoUringConnectionFactory(
+    folly::EventBase* base,
+    std::shared_ptr<IoUringContext> ctx)
+    : ctx_(std::move(ctx)),
+      ssl_factory_(std::make_unique<AsyncSocketConnectionFactory>(base)) {}
+
+IoUringConnectionFactory::~IoUringConnectionFactory() {}
+
+#if LOGDEVICE_HAVE_LIBURING
+
+std::unique_ptr<Connection> IoUringConnectionFactory::createConnection(
+    NodeID node_id,
+    SocketType socket_type,
+    ConnectionType connection_type,
+    PeerType peer_type,
+    FlowGroup& flow_group,
+    std::unique_ptr<SocketDependencies> deps) {
+  if (connection_type == ConnectionType::SSL) {
+    return ssl_factory_->createConnection(node_id,
+                                          socket_type,
+                                          connection_type,
+                                          peer_type,
+                                          flow_group,
+                                          std::move(deps));
+  }
+  return std::make_unique<Connection>(
+      node_id,
+      socket_type,
+      connection_type,
+      peer_type,
+      flow_group,
+      std::move(deps),
+      std::make_unique<IoUringSocketAdapter>(ctx_));
+}
+
+std::unique_ptr<Connection> IoUringConnectionFactory::createConnection(
+    int fd,
+    ClientID client_name,
+    const Sockaddr& client_address,
+    ResourceBudget::Token connection_token,
+    SocketType type,
+    ConnectionType connection_type,
+    FlowGroup& flow_group,
+    std::unique_ptr<SocketDependencies> deps) const {
+  if (connection_type == ConnectionType::SSL) {
+    return ssl_factory_->createConnection(fd,
+                                          client_name,
+                                          client_address,
+                                          std::move(connection_token),
+                                          type,
+                                          connection_type,
+                                          flow_group,
+                                          std::move(deps));
+  }
+  return std::make_unique<Connection>(
+      fd,
+      client_name,
+      client_address,
+      std::move(connection_token),
+      type,
+      connection_type,
+      flow_group,
+      std::move(deps),
+      std::make_unique<IoUringSocketAdapter>(
+          ctx_, folly::NetworkSocket::fromFd(fd)));
+}
+
+#else // LOGDEVICE_HAVE_LIBURING
+
+// IoUringContext::create() always fails without liburing, so no factory is
+// ever constructed.
+
+std::unique_ptr<Connection>
+IoUringConnectionFactory::createConnection(NodeID,
+                                           SocketType,
+                                           ConnectionType,
+                                           PeerType,
+                                           FlowGroup&,
+                                           std::unique_ptr<SocketDependencies>) {
+  ld_check(false);
+  return nullptr;
+}
+
+std::unique_ptr<Connection> IoUringConnectionFactory::createConnection(
+    int,
+    ClientID,
+    const Sockaddr&,
+    ResourceBudget::Token,
+    SocketType,
+    ConnectionType,
+    FlowGroup&,
+    std::unique_ptr<SocketDependencies>) const {
+  ld_check(false);
+  return nullptr;
+}
+
+#endif // LOGDEVICE_HAVE_LIBURING
+
+}} // namespace facebook::logdevice
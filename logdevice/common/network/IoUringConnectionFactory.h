@@ -0,0 +1,73 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include <memory>
+
+#include "logdevice/common/ClientID.h"
+#include "logdevice/common/NodeID.h"
+#include "logdevice/common/ResourceBudget.h"
+#include "logdevice/common/SocketTypes.h"
+#include "logdevice/common/network/IConnectionFactory.h"
+
+namespace folly {
+class EventBase;
+}
+
+namespace facebook { namespace logdevice {
+class AsyncSocketConnectionFactory;
+class Connection;
+class FlowGroup;
+class IoUringContext;
+class SockAddr;
+class SocketDependencies;
+struct Settings;
+
+/**
+ * Creates Connections whose I/O goes through the io_uring of the Worker
+ * (see IoUringSocketAdapter). SSL connections are delegated to
+ * AsyncSocketConnectionFactory.
+ */
+class IoUringConnectionFactory : public IConnectionFactory {
+ public:
+  /**
+   * @return a factory for connections on `base', or nullptr if io_uring
+   *         can't be used on this host (see IoUringContext::create()).
+   */
+  static std::unique_ptr<IoUringConnectionFactory>
+  create(folly::EventBase* base, const Settings& settings);
+
+  ~IoUringConnectionFactory() override;
+
+  std::unique_ptr<Connection>
+  createConnection(NodeID node_id,
+                   SocketType socket_type,
+                   ConnectionType connection_type,
+                   PeerType peer_type,
+                   FlowGroup& flow_group,
+                   std::unique_ptr<SocketDependencies> deps) override;
+
+  std::unique_ptr<Connection>
+  createConnection(int fd,
+                   ClientID client_name,
+                   const Sockaddr& client_address,
+                   ResourceBudget::Token connection_token,
+                   SocketType type,
+                   ConnectionType conntype,
+                   FlowGroup& flow_group,
+                   std::unique_ptr<SocketDependencies> deps) const override;
+
+ private:
+  IoUringConnectionFactory(folly::EventBase* base,
+                           std::shared_ptr<IoUringContext> ctx);
+
+  std::shared_ptr<IoUringContext> ctx_;
+  std::unique_ptr<AsyncSocketConnectionFactory> ssl_factory_;
+};
+
+}} // namespace facebook::logdevice
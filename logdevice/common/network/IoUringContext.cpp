@@ -0,0 +1,323 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/network/IoUringContext.h"
+
+#include "logdevice/common/checks.h"
+#include "logdevice/common/debug.h"
+#include "logdevice/include/Err.h"
+
+#if LOGDEVICE_HAVE_LIBURING
+
+#include <algorithm>
+#include <cstring>
+
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <liburing.h>
+
+namespace facebook { namespace logdevice {
+
+std::shared_ptr<IoUringContext>
+IoUringContext::create(folly::EventBase* evb, const Options& options) {
+  ld_check(evb);
+  std::shared_ptr<IoUringContext> ctx(new IoUringContext(evb, options));
+  if (ctx->init() != 0) {
+    return nullptr;
+  }
+  return ctx;
+}
+
+IoUringContext::IoUringContext(folly::EventBase* evb, const Options& options)
+    : folly::EventHandler(evb),
+      evb_(evb),
+      options_(options),
+      ring_(std::make_unique<io_uring>()) {}
+
+int IoUringContext::init() {
+  if (options_.nbuffers == 0 || options_.nbuffers > 32768 ||
+      (options_.nbuffers & (options_.nbuffers - 1)) != 0 ||
+      options_.buffer_size == 0) {
+    ld_error("Invalid io_uring buffer configuration: %zu buffers of %zu "
+             "bytes. The number of buffers must be a power of two not "
+             "greater than 32768.",
+             options_.nbuffers,
+             options_.buffer_size);
+    err = E::INVALID_PARAM;
+    return -1;
+  }
+
+  int rv = io_uring_queue_init(options_.sq_entries, ring_.get(), 0);
+  if (rv < 0) {
+    ld_error("io_uring_queue_init() failed: %s", strerror(-rv));
+    err = rv == -ENOMEM ? E::SYSLIMIT : E::NOTSUPPORTED;
+    return -1;
+  }
+  ring_initialized_ = true;
+
+  io_uring_probe* probe = io_uring_get_probe_ring(ring_.get());
+  if (!probe) {
+    ld_error("io_uring_get_probe_ring() failed");
+    err = E::NOTSUPPORTED;
+    return -1;
+  }
+  const bool have_required_ops =
+      io_uring_opcode_supported(probe, IORING_OP_RECV) &&
+      io_uring_opcode_supported(probe, IORING_OP_SENDMSG) &&
+      io_uring_opcode_supported(probe, IORING_OP_CONNECT) &&
+      io_uring_opcode_supported(probe, IORING_OP_LINK_TIMEOUT) &&
+      io_uring_opcode_supported(probe, IORING_OP_ASYNC_CANCEL);
+  send_zc_supported_ = io_uring_opcode_supported(probe, IORING_OP_SEND_ZC);
+  io_uring_free_probe(probe);
+  if (!have_required_ops) {
+    ld_error("Kernel io_uring lacks operations needed for sockets");
+    err = E::NOTSUPPORTED;
+    return -1;
+  }
+
+  // Receive buffers. Requires Linux 5.19+.
+  recv_buffers_ =
+      std::make_unique<uint8_t[]>(options_.nbuffers * options_.buffer_size);
+  recv_buf_ring_ = io_uring_setup_buf_ring(
+      ring_.get(), options_.nbuffers, kRecvBufferGroup, 0, &rv);
+  if (!recv_buf_ring_) {
+    ld_error("io_uring_setup_buf_ring() failed: %s", strerror(-rv));
+    err = rv == -ENOMEM ? E::SYSLIMIT : E::NOTSUPPORTED;
+    return -1;
+  }
+  const int mask = io_uring_buf_ring_mask(options_.nbuffers);
+  for (size_t i = 0; i < options_.nbuffers; ++i) {
+    io_uring_buf_ring_add(recv_buf_ring_,
+                          getRecvBuffer(i),
+                          options_.buffer_size,
+                          i,
+                          mask,
+                          i);
+  }
+  io_uring_buf_ring_advance(recv_buf_ring_, options_.nbuffers);
+
+  // Registered send buffers. Only useful with IORING_OP_SEND_ZC (Linux 6.0+).
+  if (send_zc_supported_) {
+    send_buffers_ =
+        std::make_unique<uint8_t[]>(options_.nbuffers * options_.buffer_size);
+    std::vector<iovec> iovs(options_.nbuffers);
+    for (size_t i = 0; i < options_.nbuffers; ++i) {
+      iovs[i].iov_base = getSendBuffer(i);
+      iovs[i].iov_len = options_.buffer_size;
+    }
+    rv = io_uring_register_buffers(ring_.get(), iovs.data(), iovs.size());
+    if (rv < 0) {
+      ld_warning("io_uring_register_buffers() failed: %s. Not using "
+                 "registered buffers for sends.",
+                 strerror(-rv));
+      send_buffers_.reset();
+      send_zc_supported_ = false;
+    } else {
+      free_send_buffers_.reserve(options_.nbuffers);
+      for (int i = options_.nbuffers - 1; i >= 0; --i) {
+        free_send_buffers_.push_back(i);
+      }
+    }
+  }
+
+  event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (event_fd_ < 0) {
+    ld_error("eventfd() failed: %s", strerror(errno));
+    err = E::SYSLIMIT;
+    return -1;
+  }
+  rv = io_uring_register_eventfd(ring_.get(), event_fd_);
+  if (rv < 0) {
+    ld_error("io_uring_register_eventfd() failed: %s", strerror(-rv));
+    err = E::NOTSUPPORTED;
+    return -1;
+  }
+  changeHandlerFD(folly::NetworkSocket::fromFd(event_fd_));
+  return 0;
+}
+
+IoUringContext::~IoUringContext() {
+  if (isHandlerRegistered()) {
+    unregisterHandler();
+  }
+  if (isLoopCallbackScheduled()) {
+    cancelLoopCallback();
+  }
+  if (ring_initialized_) {
+    if (recv_buf_ring_) {
+      io_uring_free_buf_ring(
+          ring_.get(), recv_buf_ring_, options_.nbuffers, kRecvBufferGroup);
+    }
+    // Tears down all outstanding operations. No more completions after this.
+    io_uring_queue_exit(ring_.get());
+  }
+  if (event_fd_ >= 0) {
+    ::close(event_fd_);
+  }
+  // Nobody is left to complete these. Destroying them releases the memory
+  // they kept alive for the kernel.
+  for (Operation* op : inflight_) {
+    delete op;
+  }
+}
+
+io_uring_sqe* IoUringContext::prepare(std::unique_ptr<Operation> op) {
+  ld_check(evb_->isInEventBaseThread());
+  io_uring_sqe* sqe = io_uring_get_sqe(ring_.get());
+  if (!sqe) {
+    // Submission queue is full, flush it.
+    submitNow();
+    sqe = io_uring_get_sqe(ring_.get());
+    ld_check(sqe);
+  }
+  io_uring_sqe_set_data(sqe, op.get());
+  inflight_.insert(op.release());
+  ++unsubmitted_;
+
+  if (!isLoopCallbackScheduled()) {
+    evb_->runInLoop(this);
+  }
+  // Only keep the EventBase loop alive while there are operations in flight,
+  // the same way AsyncSocket does with its events.
+  if (!isHandlerRegistered()) {
+    registerHandler(folly::EventHandler::READ | folly::EventHandler::PERSIST);
+  }
+  return sqe;
+}
+
+void IoUringContext::reserve(unsigned n) {
+  ld_check(n <= options_.sq_entries);
+  if (io_uring_sq_space_left(ring_.get()) < n) {
+    submitNow();
+  }
+}
+
+void IoUringContext::runLoopCallback() noexcept {
+  submitNow();
+}
+
+void IoUringContext::submitNow() {
+  if (unsubmitted_ == 0) {
+    return;
+  }
+  int rv = io_uring_submit(ring_.get());
+  if (rv < 0) {
+    // Entries stay in the submission queue, we'll retry at the end of the
+    // next iteration.
+    RATELIMIT_ERROR(std::chrono::seconds(10),
+                    1,
+                    "io_uring_submit() failed: %s",
+                    strerror(-rv));
+    if (!isLoopCallbackScheduled()) {
+      evb_->runInLoop(this);
+    }
+    return;
+  }
+  unsubmitted_ -= std::min<size_t>(rv, unsubmitted_);
+  if (unsubmitted_ > 0 && !isLoopCallbackScheduled()) {
+    evb_->runInLoop(this);
+  }
+}
+
+void IoUringContext::handlerReady(uint16_t /* events */) noexcept {
+  uint64_t count;
+  while (::read(event_fd_, &count, sizeof(count)) > 0) {
+  }
+  reapCompletions();
+}
+
+void IoUringContext::reapCompletions() {
+  struct Completion {
+    Operation* op;
+    int res;
+    uint32_t flags;
+  };
+  std::vector<Completion> completions;
+
+  // Copy completions out first and only then dispatch them: operations are
+  // free to prepare new SQEs (or cause other operations to be cancelled) from
+  // their completion handlers.
+  do {
+    completions.clear();
+    unsigned head;
+    io_uring_cqe* cqe;
+    io_uring_for_each_cqe(ring_.get(), head, cqe) {
+      completions.push_back(Completion{
+          static_cast<Operation*>(io_uring_cqe_get_data(cqe)),
+          cqe->res,
+          cqe->flags});
+    }
+    io_uring_cq_advance(ring_.get(), completions.size());
+
+    for (const Completion& c : completions) {
+      ld_check(c.op);
+      c.op->onComplete(c.res, c.flags);
+      if (!(c.flags & IORING_CQE_F_MORE)) {
+        size_t erased = inflight_.erase(c.op);
+        ld_check(erased == 1);
+        delete c.op;
+      }
+    }
+  } while (!completions.empty());
+
+  if (inflight_.empty() && isHandlerRegistered()) {
+    unregisterHandler();
+  }
+}
+
+uint8_t* IoUringContext::getRecvBuffer(uint16_t bid) const {
+  ld_check(bid < options_.nbuffers);
+  return recv_buffers_.get() + bid * options_.buffer_size;
+}
+
+void IoUringContext::recycleRecvBuffer(uint16_t bid) {
+  io_uring_buf_ring_add(recv_buf_ring_,
+                        getRecvBuffer(bid),
+                        options_.buffer_size,
+                        bid,
+                        io_uring_buf_ring_mask(options_.nbuffers),
+                        0);
+  io_uring_buf_ring_advance(recv_buf_ring_, 1);
+}
+
+int IoUringContext::acquireSendBuffer() {
+  if (free_send_buffers_.empty()) {
+    return -1;
+  }
+  int idx = free_send_buffers_.back();
+  free_send_buffers_.pop_back();
+  return idx;
+}
+
+uint8_t* IoUringContext::getSendBuffer(int idx) const {
+  ld_check(idx >= 0 && static_cast<size_t>(idx) < options_.nbuffers);
+  return send_buffers_.get() + idx * options_.buffer_size;
+}
+
+void IoUringContext::releaseSendBuffer(int idx) {
+  ld_check(idx >= 0 && static_cast<size_t>(idx) < options_.nbuffers);
+  free_send_buffers_.push_back(idx);
+}
+
+}} // namespace facebook::logdevice
+
+#else // LOGDEVICE_HAVE_LIBURING
+
+namespace facebook { namespace logdevice {
+
+std::shared_ptr<IoUringContext> IoUringContext::create(folly::EventBase*,
+                                                       const Options&) {
+  ld_error("LogDevice was built without liburing, io_uring is unavailable");
+  err = E::NOTSUPPORTED;
+  return nullptr;
+}
+
+}} // namespace facebook::logdevice
+
+#endif // LOGDEVICE_HAVE_LIBURING
@@ -0,0 +1,172 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <folly/container/F14Set.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventHandler.h>
+
+struct io_uring;
+struct io_uring_buf_ring;
+struct io_uring_sqe;
+
+namespace facebook { namespace logdevice {
+
+/**
+ * @file An io_uring instance shared by all IoUringSocketAdapters of one
+ * EventBase (i.e. of one Worker).
+ *
+ * - Submission is batched: operations prepared during an event loop
+ *   iteration are submitted with a single io_uring_enter() from a loop
+ *   callback at the end of the iteration.
+ * - Completions are signalled through an eventfd registered with the
+ *   EventBase, and are all reaped in one go when it becomes readable.
+ * - Receives use a ring of provided buffers, so that no memory is pinned for
+ *   idle connections: the kernel picks a buffer only once data arrives.
+ * - Small sends are coalesced into buffers registered with the ring.
+ *
+ * Not thread safe; all methods must be called on the EventBase thread.
+ */
+
+class IoUringContext : private folly::EventHandler,
+                       private folly::EventBase::LoopCallback {
+ public:
+  struct Options {
+    // Number of submission queue entries.
+    size_t sq_entries = 4096;
+    // Number of provided receive buffers, and of registered send buffers.
+    // Must be a power of two.
+    size_t nbuffers = 1024;
+    // Size of each of those buffers.
+    size_t buffer_size = 16 * 1024;
+  };
+
+  /**
+   * An operation submitted to the ring. The context owns it from
+   * prepare() until its last completion has been reaped (or the context is
+   * destroyed, whichever comes first).
+   */
+  class Operation {
+   public:
+    virtual ~Operation() {}
+
+    /**
+     * Called for every completion of this operation, with the res and flags
+     * fields of the CQE. If IORING_CQE_F_MORE is not set in flags, this is
+     * the last call and the operation is destroyed right after it returns.
+     */
+    virtual void onComplete(int res, uint32_t flags) = 0;
+  };
+
+  /**
+   * @return a new context, or nullptr if io_uring or one of the features we
+   *         depend on is unavailable (built without liburing, old kernel,
+   *         RLIMIT_MEMLOCK too low, ...), with err set to E::NOTSUPPORTED or
+   *         E::SYSLIMIT.
+   */
+  static std::shared_ptr<IoUringContext> create(folly::EventBase* evb,
+                                                const Options& options);
+
+  ~IoUringContext() override;
+
+  folly::EventBase* getEventBase() const {
+    return evb_;
+  }
+
+  /**
+   * Takes ownership of `op' and returns an SQE for it, to be filled in by the
+   * caller. The SQE is submitted at the end of the current event loop
+   * iteration. Never returns nullptr: if the submission queue is full, what
+   * was prepared so far is submitted right away.
+   */
+  io_uring_sqe* prepare(std::unique_ptr<Operation> op);
+
+  /**
+   * Makes sure the next `n' calls to prepare() get SQEs from the same
+   * submission, which linked operations (IOSQE_IO_LINK) require.
+   */
+  void reserve(unsigned n);
+
+  /**
+   * Submits prepared SQEs right away instead of at the end of the event loop
+   * iteration. Must be called before closing a file descriptor that prepared
+   * operations refer to, as the kernel only resolves the descriptor when the
+   * SQE is submitted.
+   */
+  void submitNow();
+
+  /**
+   * True if sends from registered buffers (IORING_OP_SEND_ZC) are supported.
+   */
+  bool canSendFromRegisteredBuffers() const {
+    return send_zc_supported_;
+  }
+
+  size_t getBufferSize() const {
+    return options_.buffer_size;
+  }
+
+  // Provided buffer group used by receives.
+  uint16_t getRecvBufferGroup() const {
+    return kRecvBufferGroup;
+  }
+  uint8_t* getRecvBuffer(uint16_t bid) const;
+  // Gives a receive buffer picked by the kernel back to the ring.
+  void recycleRecvBuffer(uint16_t bid);
+
+  /**
+   * @return index of a free registered send buffer, or -1 if all of them are
+   *         in use.
+   */
+  int acquireSendBuffer();
+  uint8_t* getSendBuffer(int idx) const;
+  void releaseSendBuffer(int idx);
+
+  size_t getNumInflightOps() const {
+    return inflight_.size();
+  }
+
+ private:
+  static constexpr uint16_t kRecvBufferGroup = 0;
+
+  IoUringContext(folly::EventBase* evb, const Options& options);
+  int init();
+
+  // folly::EventHandler, called when the eventfd becomes readable.
+  void handlerReady(uint16_t events) noexcept override;
+  // folly::EventBase::LoopCallback, submits prepared SQEs.
+  void runLoopCallback() noexcept override;
+
+  void reapCompletions();
+
+  folly::EventBase* evb_;
+  const Options options_;
+  std::unique_ptr<io_uring> ring_;
+  bool ring_initialized_{false};
+  int event_fd_{-1};
+  bool send_zc_supported_{false};
+
+  // Number of SQEs prepared but not yet submitted.
+  size_t unsubmitted_{0};
+
+  // Operations submitted and not fully completed yet.
+  folly::F14FastSet<Operation*> inflight_;
+
+  // Provided receive buffers.
+  io_uring_buf_ring* recv_buf_ring_{nullptr};
+  std::unique_ptr<uint8_t[]> recv_buffers_;
+
+  // Registered send buffers.
+  std::unique_ptr<uint8_t[]> send_buffers_;
+  std::vector<int> free_send_buffers_;
+};
+
+}} // namespace facebook::logdevice
@@ -0,0 +1,728 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/network/IoUringSocketAdapter.h"
+
+#if LOGDEVICE_HAVE_LIBURING
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <folly/SocketAddress.h>
+#include <folly/container/small_vector.h>
+#include <folly/io/IOBuf.h>
+#include <liburing.h>
+
+#include "logdevice/common/checks.h"
+#include "logdevice/common/debug.h"
+
+namespace facebook { namespace logdevice {
+
+using folly::AsyncSocketException;
+
+namespace {
+// Max number of iovecs in a single sendmsg.
+constexpr size_t kMaxSendIovecs = 64;
+} // namespace
+
+// Completion of an operation we don't care about, e.g. a cancellation or a
+// linked timeout.
+class IoUringSocketAdapter::NoopOp : public IoUringContext::Operation {
+ public:
+  void onComplete(int /* res */, uint32_t /* flags */) override {}
+};
+
+class IoUringSocketAdapter::ConnectOp : public IoUringContext::Operation {
+ public:
+  explicit ConnectOp(IoUringSocketAdapter* owner) : owner_(owner) {}
+
+  void onComplete(int res, uint32_t /* flags */) override {
+    if (owner_) {
+      owner_->onConnectComplete(res);
+    }
+  }
+
+  // nullptr once the adapter no longer cares about the result.
+  IoUringSocketAdapter* owner_;
+  // The kernel reads these when the SQE is submitted.
+  sockaddr_storage addr_;
+  socklen_t addrlen_{0};
+  __kernel_timespec timeout_{};
+};
+
+class IoUringSocketAdapter::RecvOp : public IoUringContext::Operation {
+ public:
+  RecvOp(IoUringSocketAdapter* owner, IoUringContext* ctx)
+      : owner_(owner), ctx_(ctx) {}
+
+  void onComplete(int res, uint32_t flags) override {
+    const uint8_t* data = nullptr;
+    int bid = -1;
+    if (flags & IORING_CQE_F_BUFFER) {
+      bid = flags >> IORING_CQE_BUFFER_SHIFT;
+      data = ctx_->getRecvBuffer(bid);
+    }
+    if (owner_) {
+      owner_->onRecvComplete(res, data);
+    }
+    // The data was copied out, the buffer can be reused by any socket.
+    if (bid >= 0) {
+      ctx_->recycleRecvBuffer(bid);
+    }
+  }
+
+  IoUringSocketAdapter* owner_;
+  IoUringContext* ctx_;
+};
+
+class IoUringSocketAdapter::SendOp : public IoUringContext::Operation {
+ public:
+  SendOp(IoUringSocketAdapter* owner, IoUringContext* ctx)
+      : owner_(owner), ctx_(ctx) {
+    memset(&msg_, 0, sizeof(msg_));
+  }
+
+  ~SendOp() override {
+    if (send_buffer_ >= 0) {
+      ctx_->releaseSendBuffer(send_buffer_);
+    }
+  }
+
+  void onComplete(int res, uint32_t flags) override {
+    if (flags & IORING_CQE_F_NOTIF) {
+      // IORING_OP_SEND_ZC notification: the kernel is done with the
+      // registered buffer, which the destructor releases.
+      return;
+    }
+    if (owner_) {
+      owner_->onSendComplete(res);
+    }
+  }
+
+  IoUringSocketAdapter* owner_;
+  IoUringContext* ctx_;
+  // Registered buffer the data was copied into, or -1 if sending from iov_.
+  int send_buffer_{-1};
+  folly::small_vector<iovec, 8> iov_;
+  msghdr msg_;
+  // Data iov_ points into, when the adapter goes away before the kernel is
+  // done with it.
+  std::vector<std::unique_ptr<folly::IOBuf>> keepalive_;
+};
+
+IoUringSocketAdapter::IoUringSocketAdapter(std::shared_ptr<IoUringContext> ctx)
+    : ctx_(std::move(ctx)) {
+  ld_check(ctx_);
+}
+
+IoUringSocketAdapter::IoUringSocketAdapter(std::shared_ptr<IoUringContext> ctx,
+                                           folly::NetworkSocket fd)
+    : ctx_(std::move(ctx)), fd_(fd.toFd()), state_(State::ESTABLISHED) {
+  ld_check(ctx_);
+  ld_check(fd_ >= 0);
+}
+
+IoUringSocketAdapter::~IoUringSocketAdapter() {
+  *alive_ = false;
+  closeFd();
+}
+
+void IoUringSocketAdapter::connect(ConnectCallback* callback,
+                                   const folly::SocketAddress& address,
+                                   int timeout,
+                                   const folly::SocketOptionMap& options,
+                                   const folly::SocketAddress& bindAddr) noexcept {
+  if (state_ != State::UNINIT) {
+    if (callback) {
+      callback->connectErr(AsyncSocketException(
+          AsyncSocketException::ALREADY_OPEN,
+          "connect() called with socket in invalid state"));
+    }
+    return;
+  }
+  connect_cb_ = callback;
+  state_ = State::CONNECTING;
+
+  auto fail_connect = [&](const char* what) {
+    fail(AsyncSocketException(
+        AsyncSocketException::INTERNAL_ERROR, what, errno));
+  };
+
+  fd_ = ::socket(
+      address.getFamily(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd_ < 0) {
+    fail_connect("failed to create socket");
+    return;
+  }
+  // Same default as AsyncSocket. `options' may override it.
+  if (address.getFamily() != AF_UNIX) {
+    int one = 1;
+    if (::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) != 0) {
+      fail_connect("failed to set TCP_NODELAY");
+      return;
+    }
+  }
+  for (const auto& opt : options) {
+    int val = opt.second;
+    if (::setsockopt(
+            fd_, opt.first.level, opt.first.optname, &val, sizeof(val)) != 0) {
+      fail_connect("failed to set socket option");
+      return;
+    }
+  }
+  if (bindAddr != folly::AsyncSocket::anyAddress()) {
+    sockaddr_storage bind_ss;
+    socklen_t bind_len = bindAddr.getAddress(&bind_ss);
+    if (::bind(fd_, reinterpret_cast<sockaddr*>(&bind_ss), bind_len) != 0) {
+      fail_connect("failed to bind to async socket");
+      return;
+    }
+  }
+  if (callback) {
+    callback->preConnect(folly::NetworkSocket::fromFd(fd_));
+  }
+
+  auto op = std::make_unique<ConnectOp>(this);
+  op->addrlen_ = address.getAddress(&op->addr_);
+  connect_op_ = op.get();
+  // The connect and its timeout must be submitted together.
+  ctx_->reserve(timeout > 0 ? 2 : 1);
+  io_uring_sqe* sqe = ctx_->prepare(std::move(op));
+  io_uring_prep_connect(sqe,
+                        fd_,
+                        reinterpret_cast<sockaddr*>(&connect_op_->addr_),
+                        connect_op_->addrlen_);
+  if (timeout > 0) {
+    sqe->flags |= IOSQE_IO_LINK;
+    connect_op_->timeout_.tv_sec = timeout / 1000;
+    connect_op_->timeout_.tv_nsec = (timeout % 1000) * 1000000L;
+    io_uring_sqe* timeout_sqe = ctx_->prepare(std::make_unique<NoopOp>());
+    io_uring_prep_link_timeout(timeout_sqe, &connect_op_->timeout_, 0);
+  }
+}
+
+void IoUringSocketAdapter::onConnectComplete(int res) {
+  connect_op_ = nullptr;
+  if (res < 0) {
+    // The connect is only cancelled by the linked timeout: if we cancel it
+    // ourselves we detach from it first.
+    fail(res == -ECANCELED
+             ? AsyncSocketException(
+                   AsyncSocketException::TIMED_OUT, "connect timed out")
+             : AsyncSocketException(
+                   AsyncSocketException::NOT_OPEN, "connect failed", -res));
+    return;
+  }
+
+  state_ = State::ESTABLISHED;
+  auto alive = alive_;
+  if (connect_cb_) {
+    auto cb = connect_cb_;
+    connect_cb_ = nullptr;
+    cb->connectSuccess();
+    if (!*alive) {
+      return;
+    }
+  }
+  startReading();
+  // Writes may have been queued while connecting.
+  startWriting();
+}
+
+void IoUringSocketAdapter::closeNow() {
+  if (state_ == State::CLOSED || state_ == State::ERROR) {
+    return;
+  }
+  const AsyncSocketException ex(
+      AsyncSocketException::NOT_OPEN, "socket closed locally");
+  const bool was_connecting = state_ == State::CONNECTING;
+  state_ = State::CLOSED;
+  closeFd();
+
+  auto alive = alive_;
+  if (was_connecting && connect_cb_) {
+    auto cb = connect_cb_;
+    connect_cb_ = nullptr;
+    cb->connectErr(ex);
+    if (!*alive) {
+      return;
+    }
+  }
+  failWrites(ex);
+  if (!*alive) {
+    return;
+  }
+  if (read_cb_) {
+    auto cb = read_cb_;
+    read_cb_ = nullptr;
+    cb->readEOF();
+  }
+}
+
+void IoUringSocketAdapter::close() {
+  if (write_queue_.empty() || state_ != State::ESTABLISHED) {
+    closeNow();
+    return;
+  }
+  state_ = State::CLOSING;
+  if (read_cb_) {
+    auto cb = read_cb_;
+    read_cb_ = nullptr;
+    cb->readEOF();
+  }
+}
+
+bool IoUringSocketAdapter::good() const {
+  return state_ == State::CONNECTING || state_ == State::ESTABLISHED;
+}
+
+bool IoUringSocketAdapter::readable() const {
+  if (!pending_read_.empty()) {
+    return true;
+  }
+  if (fd_ < 0) {
+    return false;
+  }
+  pollfd fds[1];
+  fds[0].fd = fd_;
+  fds[0].events = POLLIN;
+  fds[0].revents = 0;
+  return ::poll(fds, 1, 0) == 1;
+}
+
+bool IoUringSocketAdapter::connecting() const {
+  return state_ == State::CONNECTING;
+}
+
+void IoUringSocketAdapter::getLocalAddress(
+    folly::SocketAddress* address) const {
+  address->setFromLocalAddress(getNetworkSocket());
+}
+
+void IoUringSocketAdapter::getPeerAddress(folly::SocketAddress* address) const {
+  address->setFromPeerAddress(getNetworkSocket());
+}
+
+folly::NetworkSocket IoUringSocketAdapter::getNetworkSocket() const {
+  return folly::NetworkSocket::fromFd(fd_);
+}
+
+void IoUringSocketAdapter::setReadCB(ReadCallback* callback) {
+  read_cb_ = callback;
+  if (!read_cb_) {
+    // An outstanding receive stays armed; whatever it gets is kept in
+    // pending_read_.
+    return;
+  }
+  if (state_ == State::ERROR || eof_ || !pending_read_.empty()) {
+    scheduleDelivery();
+  }
+  startReading();
+}
+
+void IoUringSocketAdapter::scheduleDelivery() {
+  if (delivery_scheduled_) {
+    return;
+  }
+  delivery_scheduled_ = true;
+  ctx_->getEventBase()->runInLoop([this, alive = alive_] {
+    if (!*alive) {
+      return;
+    }
+    delivery_scheduled_ = false;
+    if (!read_cb_) {
+      return;
+    }
+    if (state_ == State::ERROR) {
+      ld_check(error_.has_value());
+      auto cb = read_cb_;
+      read_cb_ = nullptr;
+      cb->readErr(*error_);
+      return;
+    }
+    if (deliverPending()) {
+      startReading();
+    }
+  });
+}
+
+void IoUringSocketAdapter::startReading() {
+  if (!read_cb_ || recv_op_ || eof_ || state_ != State::ESTABLISHED) {
+    return;
+  }
+  auto op = std::make_unique<RecvOp>(this, ctx_.get());
+  recv_op_ = op.get();
+  io_uring_sqe* sqe = ctx_->prepare(std::move(op));
+  // The kernel picks a buffer from the provided buffer ring once data
+  // arrives; the length is capped by the buffer size.
+  io_uring_prep_recv(sqe, fd_, nullptr, ctx_->getBufferSize(), 0);
+  sqe->flags |= IOSQE_BUFFER_SELECT;
+  sqe->buf_group = ctx_->getRecvBufferGroup();
+}
+
+void IoUringSocketAdapter::onRecvComplete(int res, const uint8_t* data) {
+  recv_op_ = nullptr;
+  if (res > 0) {
+    ld_check(data);
+    bytes_received_ += res;
+    if (deliver(data, res)) {
+      startReading();
+    }
+    return;
+  }
+  if (res == 0) {
+    eof_ = true;
+    if (read_cb_ && pending_read_.empty()) {
+      auto cb = read_cb_;
+      read_cb_ = nullptr;
+      cb->readEOF();
+    }
+    return;
+  }
+  if (res == -ENOBUFS || res == -EINTR || res == -EAGAIN) {
+    // ENOBUFS means all provided buffers were picked by receives completed
+    // in the same batch. They are recycled as soon as those completions are
+    // processed, i.e. before the retry is submitted.
+    startReading();
+    return;
+  }
+  fail(AsyncSocketException(
+      AsyncSocketException::INTERNAL_ERROR, "recv() failed", -res));
+}
+
+bool IoUringSocketAdapter::deliver(const uint8_t* data, size_t len) {
+  auto alive = alive_;
+  while (len > 0 && read_cb_ && state_ == State::ESTABLISHED) {
+    ReadCallback* cb = read_cb_;
+    if (cb->isBufferMovable()) {
+      cb->readBufferAvailable(folly::IOBuf::copyBuffer(data, len));
+      if (!*alive) {
+        return false;
+      }
+      len = 0;
+      break;
+    }
+
+    void* buf = nullptr;
+    size_t buflen = 0;
+    cb->getReadBuffer(&buf, &buflen);
+    if (!*alive) {
+      return false;
+    }
+    if (buf == nullptr || buflen == 0) {
+      fail(AsyncSocketException(
+          AsyncSocketException::BAD_ARGS,
+          "ReadCallback::getReadBuffer() returned empty buffer"));
+      return *alive;
+    }
+    const size_t n = std::min(len, buflen);
+    memcpy(buf, data, n);
+    data += n;
+    len -= n;
+    cb->readDataAvailable(n);
+    if (!*alive) {
+      return false;
+    }
+  }
+  if (len > 0 && state_ == State::ESTABLISHED) {
+    pending_read_.append(folly::IOBuf::copyBuffer(data, len));
+  }
+  return true;
+}
+
+bool IoUringSocketAdapter::deliverPending() {
+  if (!pending_read_.empty()) {
+    auto chain = pending_read_.move();
+    const folly::IOBuf* p = chain.get();
+    do {
+      if (read_cb_ && state_ == State::ESTABLISHED) {
+        if (!deliver(p->data(), p->length())) {
+          return false;
+        }
+      } else if (state_ == State::ESTABLISHED) {
+        // The callback was uninstalled, keep the rest (after whatever
+        // deliver() put back) for the next one.
+        pending_read_.append(p->cloneOne());
+      }
+      p = p->next();
+    } while (p != chain.get());
+  }
+  if (eof_ && read_cb_ && pending_read_.empty()) {
+    auto cb = read_cb_;
+    read_cb_ = nullptr;
+    cb->readEOF();
+    return false;
+  }
+  return true;
+}
+
+void IoUringSocketAdapter::writeChain(WriteCallback* callback,
+                                      std::unique_ptr<folly::IOBuf>&& buf,
+                                      folly::WriteFlags /* flags */) {
+  if (!good()) {
+    if (callback) {
+      callback->writeErr(
+          0,
+          AsyncSocketException(AsyncSocketException::NOT_OPEN,
+                               "writeChain() called on a closed socket"));
+    }
+    return;
+  }
+  const size_t length = buf ? buf->computeChainDataLength() : 0;
+  if (length == 0) {
+    if (callback) {
+      callback->writeSuccess();
+    }
+    return;
+  }
+  write_queue_.push_back(
+      WriteRequest{callback, std::move(buf), length, length});
+  startWriting();
+}
+
+void IoUringSocketAdapter::startWriting() {
+  if (send_op_ || write_queue_.empty() ||
+      (state_ != State::ESTABLISHED && state_ != State::CLOSING)) {
+    return;
+  }
+  ld_check(writes_in_flight_ == 0);
+
+  auto op = std::make_unique<SendOp>(this, ctx_.get());
+  const size_t bufsize = ctx_->getBufferSize();
+  size_t nreqs = 0;
+  size_t total = 0;
+
+  if (ctx_->canSendFromRegisteredBuffers() &&
+      write_queue_.front().remaining <= bufsize &&
+      (op->send_buffer_ = ctx_->acquireSendBuffer()) >= 0) {
+    // Coalesce as many small writes as fit into a registered buffer. The
+    // kernel doesn't need to pin any pages to send it.
+    uint8_t* dst = ctx_->getSendBuffer(op->send_buffer_);
+    for (const WriteRequest& req : write_queue_) {
+      if (total + req.remaining > bufsize) {
+        break;
+      }
+      size_t skip = req.length - req.remaining;
+      for (folly::ByteRange range : *req.buf) {
+        if (skip >= range.size()) {
+          skip -= range.size();
+          continue;
+        }
+        memcpy(dst + total, range.data() + skip, range.size() - skip);
+        total += range.size() - skip;
+        skip = 0;
+      }
+      ++nreqs;
+    }
+    writes_in_flight_ = nreqs;
+    send_op_ = op.get();
+    io_uring_sqe* sqe = ctx_->prepare(std::move(op));
+    io_uring_prep_send_zc_fixed(
+        sqe, fd_, dst, total, MSG_NOSIGNAL, 0, send_op_->send_buffer_);
+    return;
+  }
+
+  // Send straight from the IOBufs, which stay in write_queue_ (or in
+  // keepalive_) until the send completes.
+  for (const WriteRequest& req : write_queue_) {
+    if (op->iov_.size() >= kMaxSendIovecs) {
+      break;
+    }
+    size_t skip = req.length - req.remaining;
+    for (folly::ByteRange range : *req.buf) {
+      if (skip >= range.size()) {
+        skip -= range.size();
+        continue;
+      }
+      if (op->iov_.size() >= kMaxSendIovecs) {
+        break;
+      }
+      iovec iov;
+      iov.iov_base = const_cast<uint8_t*>(range.data() + skip);
+      iov.iov_len = range.size() - skip;
+      op->iov_.push_back(iov);
+      skip = 0;
+    }
+    ++nreqs;
+  }
+  op->msg_.msg_iov = op->iov_.data();
+  op->msg_.msg_iovlen = op->iov_.size();
+  writes_in_flight_ = nreqs;
+  send_op_ = op.get();
+  io_uring_sqe* sqe = ctx_->prepare(std::move(op));
+  io_uring_prep_sendmsg(sqe, fd_, &send_op_->msg_, MSG_NOSIGNAL);
+}
+
+void IoUringSocketAdapter::onSendComplete(int res) {
+  send_op_ = nullptr;
+  size_t in_flight = writes_in_flight_;
+  writes_in_flight_ = 0;
+
+  if (res < 0) {
+    if (res == -EINTR || res == -EAGAIN) {
+      startWriting();
+      return;
+    }
+    fail(AsyncSocketException(
+        AsyncSocketException::INTERNAL_ERROR, "send() failed", -res));
+    return;
+  }
+
+  // Account for all the bytes first: callbacks may write more, which must
+  // not resend what was just sent.
+  bytes_written_ += res;
+  size_t n = res;
+  folly::small_vector<WriteCallback*, 16> done;
+  while (n > 0 && in_flight > 0) {
+    WriteRequest& req = write_queue_.front();
+    const size_t k = std::min(n, req.remaining);
+    req.remaining -= k;
+    n -= k;
+    if (req.remaining > 0) {
+      // Short send.
+      break;
+    }
+    if (req.callback) {
+      done.push_back(req.callback);
+    }
+    write_queue_.pop_front();
+    --in_flight;
+  }
+  ld_check(n == 0);
+
+  auto alive = alive_;
+  for (WriteCallback* cb : done) {
+    cb->writeSuccess();
+    if (!*alive) {
+      return;
+    }
+  }
+
+  if (state_ == State::CLOSING && write_queue_.empty()) {
+    closeNow();
+    return;
+  }
+  startWriting();
+}
+
+void IoUringSocketAdapter::fail(const AsyncSocketException& ex) {
+  if (state_ == State::CLOSED || state_ == State::ERROR) {
+    return;
+  }
+  const bool was_connecting = state_ == State::CONNECTING;
+  state_ = State::ERROR;
+  error_ = ex;
+  closeFd();
+
+  auto alive = alive_;
+  if (was_connecting && connect_cb_) {
+    auto cb = connect_cb_;
+    connect_cb_ = nullptr;
+    cb->connectErr(ex);
+    if (!*alive) {
+      return;
+    }
+  }
+  failWrites(ex);
+  if (!*alive) {
+    return;
+  }
+  if (read_cb_) {
+    auto cb = read_cb_;
+    read_cb_ = nullptr;
+    cb->readErr(ex);
+  }
+}
+
+void IoUringSocketAdapter::failWrites(const AsyncSocketException& ex) {
+  auto queue = std::move(write_queue_);
+  write_queue_.clear();
+  writes_in_flight_ = 0;
+
+  auto alive = alive_;
+  for (const WriteRequest& req : queue) {
+    if (req.callback) {
+      req.callback->writeErr(req.length - req.remaining, ex);
+      if (!*alive) {
+        return;
+      }
+    }
+  }
+}
+
+void IoUringSocketAdapter::closeFd() {
+  auto cancel = [this](IoUringContext::Operation* op) {
+    io_uring_sqe* sqe = ctx_->prepare(std::make_unique<NoopOp>());
+    io_uring_prep_cancel(sqe, op, 0);
+  };
+
+  if (connect_op_) {
+    connect_op_->owner_ = nullptr;
+    cancel(connect_op_);
+    connect_op_ = nullptr;
+  }
+  if (recv_op_) {
+    recv_op_->owner_ = nullptr;
+    cancel(recv_op_);
+    recv_op_ = nullptr;
+  }
+  if (send_op_) {
+    if (send_op_->send_buffer_ < 0) {
+      // The kernel may still read from these.
+      for (size_t i = 0; i < writes_in_flight_; ++i) {
+        send_op_->keepalive_.push_back(std::move(write_queue_[i].buf));
+      }
+    }
+    send_op_->owner_ = nullptr;
+    cancel(send_op_);
+    send_op_ = nullptr;
+  }
+
+  if (fd_ >= 0) {
+    // Operations prepared in this iteration must be bound to this socket
+    // before the descriptor can be reused.
+    ctx_->submitNow();
+    ::shutdown(fd_, SHUT_RDWR);
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+int IoUringSocketAdapter::setSendBufSize(size_t bufsize) {
+  int val = bufsize;
+  return setSockOptVirtual(SOL_SOCKET, SO_SNDBUF, &val, sizeof(val));
+}
+
+int IoUringSocketAdapter::setRecvBufSize(size_t bufsize) {
+  int val = bufsize;
+  return setSockOptVirtual(SOL_SOCKET, SO_RCVBUF, &val, sizeof(val));
+}
+
+int IoUringSocketAdapter::getSockOptVirtual(int level,
+                                            int optname,
+                                            void* optval,
+                                            socklen_t* optlen) {
+  return ::getsockopt(fd_, level, optname, optval, optlen);
+}
+
+int IoUringSocketAdapter::setSockOptVirtual(int level,
+                                            int optname,
+                                            void const* optval,
+                                            socklen_t optlen) {
+  return ::setsockopt(fd_, level, optname, optval, optlen);
+}
+
+}} // namespace facebook::logdevice
+
+#endif // LOGDEVICE_HAVE_LIBURING
@@ -0,0 +1,202 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include <deque>
+#include <memory>
+
+#include <folly/Optional.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/io/SocketOptionMap.h>
+#include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/AsyncSocketException.h>
+
+#include "logdevice/common/network/IoUringContext.h"
+#include "logdevice/common/network/SocketAdapter.h"
+
+#if LOGDEVICE_HAVE_LIBURING
+
+namespace facebook { namespace logdevice {
+
+/**
+ * @file SocketAdapter doing network I/O through the io_uring of the
+ * Worker's IoUringContext instead of readiness notifications plus
+ * read()/write() syscalls like AsyncSocket does.
+ *
+ * - At most one receive is outstanding per socket. It uses the context's
+ *   provided buffers, and received data is copied into the buffers handed
+ *   out by the ReadCallback.
+ * - Writes are queued and sent by at most one outstanding send per socket,
+ *   which preserves ordering. A send covers as many queued writes as fit:
+ *   if they fit in a registered buffer they are copied into one and sent
+ *   with IORING_OP_SEND_ZC, otherwise they are sent straight from the IOBufs
+ *   with IORING_OP_SENDMSG.
+ * - All operations are submitted in batches at the end of the event loop
+ *   iteration, so a Worker makes one io_uring_enter() per iteration no
+ *   matter how many sockets it serves.
+ *
+ * Plaintext TCP and unix sockets only; SSL connections keep using
+ * AsyncSocketAdapter. Only available when built with liburing.
+ */
+
+class IoUringSocketAdapter : public SocketAdapter {
+ public:
+  /**
+   * Create an unconnected socket. connect() must later be called on it.
+   */
+  explicit IoUringSocketAdapter(std::shared_ptr<IoUringContext> ctx);
+
+  /**
+   * Take over an already connected socket file descriptor, e.g. one returned
+   * by accept().
+   */
+  IoUringSocketAdapter(std::shared_ptr<IoUringContext> ctx,
+                       folly::NetworkSocket fd);
+
+  ~IoUringSocketAdapter() override;
+
+  void
+  connect(ConnectCallback* callback,
+          const folly::SocketAddress& address,
+          int timeout = 0,
+          const folly::SocketOptionMap& options = folly::emptySocketOptionMap,
+          const folly::SocketAddress& bindAddr =
+              folly::AsyncSocket::anyAddress()) noexcept override;
+
+  /**
+   * Close the socket immediately. Calls readEOF() on the read callback if
+   * there is one, and writeErr() on all outstanding writes.
+   */
+  void closeNow() override;
+
+  /**
+   * Close the socket after flushing queued writes. Stop reading immediately.
+   */
+  void close() override;
+
+  bool good() const override;
+  bool readable() const override;
+  bool connecting() const override;
+
+  void getLocalAddress(folly::SocketAddress* address) const override;
+  void getPeerAddress(folly::SocketAddress* address) const override;
+  folly::NetworkSocket getNetworkSocket() const override;
+
+  size_t getRawBytesWritten() const override {
+    return bytes_written_;
+  }
+  size_t getRawBytesReceived() const override {
+    return bytes_received_;
+  }
+
+  void setReadCB(ReadCallback* callback) override;
+  ReadCallback* getReadCallback() const override {
+    return read_cb_;
+  }
+
+  void writeChain(WriteCallback* callback,
+                  std::unique_ptr<folly::IOBuf>&& buf,
+                  folly::WriteFlags flags = folly::WriteFlags::NONE) override;
+
+  int setSendBufSize(size_t bufsize) override;
+  int setRecvBufSize(size_t bufsize) override;
+
+  int getSockOptVirtual(int level,
+                        int optname,
+                        void* optval,
+                        socklen_t* optlen) override;
+  int setSockOptVirtual(int level,
+                        int optname,
+                        void const* optval,
+                        socklen_t optlen) override;
+
+ private:
+  enum class State {
+    UNINIT,
+    CONNECTING,
+    ESTABLISHED,
+    // close() was called, flushing queued writes before closing.
+    CLOSING,
+    CLOSED,
+    ERROR,
+  };
+
+  class ConnectOp;
+  class RecvOp;
+  class SendOp;
+  class NoopOp;
+
+  struct WriteRequest {
+    WriteCallback* callback;
+    std::unique_ptr<folly::IOBuf> buf;
+    size_t length;
+    // Bytes of buf not yet accepted by the kernel.
+    size_t remaining;
+  };
+
+  // Arms a receive if there is a read callback and none is outstanding.
+  void startReading();
+  // Issues a send for queued writes if none is outstanding.
+  void startWriting();
+
+  void onConnectComplete(int res);
+  // `data' is nullptr if no data was received.
+  void onRecvComplete(int res, const uint8_t* data);
+  void onSendComplete(int res);
+
+  // Hands received bytes to the read callback. Whatever the callback does
+  // not take (because it was uninstalled) is kept in pending_read_. Returns
+  // false if this adapter was destroyed from a callback.
+  bool deliver(const uint8_t* data, size_t len);
+  bool deliverPending();
+  // Delivers pending data, EOF or error to a newly installed read callback
+  // from the event loop.
+  void scheduleDelivery();
+
+  // Moves to ERROR and notifies all callbacks.
+  void fail(const folly::AsyncSocketException& ex);
+  // Fails all queued writes with `ex'.
+  void failWrites(const folly::AsyncSocketException& ex);
+  // Detaches outstanding operations from this adapter and asks the kernel to
+  // cancel them, then closes the file descriptor.
+  void closeFd();
+
+  std::shared_ptr<IoUringContext> ctx_;
+  int fd_{-1};
+  State state_{State::UNINIT};
+
+  ReadCallback* read_cb_{nullptr};
+  ConnectCallback* connect_cb_{nullptr};
+
+  // Outstanding operations, owned by ctx_.
+  ConnectOp* connect_op_{nullptr};
+  RecvOp* recv_op_{nullptr};
+  SendOp* send_op_{nullptr};
+
+  std::deque<WriteRequest> write_queue_;
+  // Number of requests at the front of write_queue_ covered by send_op_.
+  size_t writes_in_flight_{0};
+
+  // Data received while no read callback was installed.
+  folly::IOBufQueue pending_read_{folly::IOBufQueue::cacheChainLength()};
+  bool eof_{false};
+  bool delivery_scheduled_{false};
+  // Set when state_ is ERROR.
+  folly::Optional<folly::AsyncSocketException> error_;
+
+  size_t bytes_written_{0};
+  size_t bytes_received_{0};
+
+  // Flipped to false in the destructor, so that code that invoked a callback
+  // can tell whether the callback destroyed this adapter.
+  std::shared_ptr<bool> alive_{std::make_shared<bool>(true)};
+};
+
+}} // namespace facebook::logdevice
+
+#endif // LOGDEVICE_HAVE_LIBURING
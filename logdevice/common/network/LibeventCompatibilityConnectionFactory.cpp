@@ -16,6 +16,9 @@
 #include "logdevice/common/debug.h"
 #include "logdevice/common/network/AsyncSocketConnectionFactory.h"
 #include "logdevice/common/network/ConnectionFactory.h"
+#include "logdevice/common/network/IoUringConnectionFactory.h"
+#include "logdevice/common/network/ShmConnectionFactory.h"
+#include "logdevice/common/settings/Settings.h"
 
 namespace facebook { namespace logdevice {
 
@@ -34,13 +37,64 @@ static bool forceSSLSockets() {
   return val;
 }
 
+// Setting the env forces all sockets on folly event bases to use io_uring,
+// as if --io-uring-sockets was set.
+static bool forceIoUringSockets() {
+  static std::atomic<int> force_io_uring{-1};
+  int val = force_io_uring.load();
+  if (val == -1) {
+    const char* env = getenv("LOGDEVICE_TEST_FORCE_IO_URING");
+    // Return false for null, "" and "0", true otherwise.
+    val = env != nullptr && strlen(env) > 0 && strcmp(env, "0") != 0;
+
+    force_io_uring.store(val);
+  }
+  return val;
+}
+
+// Setting the env forces plaintext connections over unix sockets on folly
+// event bases to go through shared memory, as if --shm-local-connections was
+// set.
+static bool forceShmConnections() {
+  static std::atomic<int> force_shm{-1};
+  int val = force_shm.load();
+  if (val == -1) {
+    const char* env = getenv("LOGDEVICE_TEST_FORCE_SHM");
+    // Return false for null, "" and "0", true otherwise.
+    val = env != nullptr && strlen(env) > 0 && strcmp(env, "0") != 0;
+
+    force_shm.store(val);
+  }
+  return val;
+}
+
 LibeventCompatibilityConnectionFactory::LibeventCompatibilityConnectionFactory(
-    EvBase& base) {
+    EvBase& base,
+    const Settings& settings) {
   if (base.getType() == EvBase::LEGACY_EVENTBASE) {
     concrete_factory_ = std::make_unique<ConnectionFactory>();
   } else if (base.getType() == EvBase::FOLLY_EVENTBASE) {
-    concrete_factory_ =
-        std::make_unique<AsyncSocketConnectionFactory>(base.getEventBase());
+    if (settings.io_uring_sockets || forceIoUringSockets()) {
+      concrete_factory_ =
+          IoUringConnectionFactory::create(base.getEventBase(), settings);
+      if (!concrete_factory_) {
+        RATELIMIT_WARNING(std::chrono::seconds(60),
+                          1,
+                          "Failed to set up io_uring (%s), falling back to "
+                          "AsyncSocket for network I/O.",
+                          error_name(err));
+      }
+    }
+    if (!concrete_factory_) {
+      concrete_factory_ =
+          std::make_unique<AsyncSocketConnectionFactory>(base.getEventBase());
+    }
+    if (settings.shm_local_connections || forceShmConnections()) {
+      concrete_factory_ =
+          std::make_unique<ShmConnectionFactory>(base.getEventBase(),
+                                                 settings.shm_ring_size,
+                                                 std::move(concrete_factory_));
+    }
   } else {
     ld_error("EvBase sent to factory of unrecognized type.");
     throw ConstructorFailed();
@@ -21,9 +21,11 @@ class FlowGroup;
 class SockAddr;
 class SocketDependencies;
 class ConnectThrottle;
+struct Settings;
 class LibeventCompatibilityConnectionFactory : public IConnectionFactory {
  public:
-  explicit LibeventCompatibilityConnectionFactory(EvBase& base);
+  LibeventCompatibilityConnectionFactory(EvBase& base,
+                                         const Settings& settings);
 
   std::unique_ptr<Connection>
   createConnection(NodeID node_id,
@@ -8,6 +8,9 @@
 
 #include "logdevice/common/network/MessageReader.h"
 
+#include <cstring>
+#include <vector>
+
 #include <folly/io/async/AsyncSocketException.h>
 
 #include "logdevice/common/IProtocolHandler.h"
@@ -15,59 +18,85 @@
 #include "logdevice/common/settings/Settings.h"
 
 namespace facebook { namespace logdevice {
+
+namespace {
+
+// Receive buffers nobody references any more, for reuse by the readers of
+// this thread.
+constexpr size_t kMaxPooledBuffers = 16;
+thread_local std::vector<std::unique_ptr<folly::IOBuf>> buffer_pool;
+
+// If a receive buffer still referenced by received messages has less room
+// left than this, a new one is used for the next read.
+constexpr size_t kMinReadSize = 4096;
+
+std::unique_ptr<folly::IOBuf> acquireBuffer() {
+  if (buffer_pool.empty()) {
+    return folly::IOBuf::create(MessageReader::kReadBufferSize);
+  }
+  auto buf = std::move(buffer_pool.back());
+  buffer_pool.pop_back();
+  return buf;
+}
+
+void releaseBuffer(std::unique_ptr<folly::IOBuf> buf) {
+  // Only buffers of the default size that no message refers to are reused.
+  if (buf->isSharedOne() ||
+      buf->capacity() >= 2 * MessageReader::kReadBufferSize ||
+      buffer_pool.size() >= kMaxPooledBuffers) {
+    return;
+  }
+  buf->clear();
+  buffer_pool.push_back(std::move(buf));
+}
+
+} // namespace
+
 MessageReader::MessageReader(IProtocolHandler& proto_handler, uint16_t proto)
-    : next_buffer_allocation_size_(sizeof(ProtocolHeader)),
-      read_buf_(folly::IOBuf::create(next_buffer_allocation_size_)),
-      proto_handler_(proto_handler),
-      proto_(proto) {}
+    : proto_handler_(proto_handler), proto_(proto) {}
 
 void MessageReader::getReadBuffer(void** bufReturn, size_t* lenReturn) {
-  if (!proto_handler_.good()) {
+  if (!proto_handler_.good() || failed_) {
     *bufReturn = nullptr;
     *lenReturn = 0;
     return;
   }
-  if (expecting_protocol_header_) {
-    ld_check_le(next_buffer_allocation_size_, sizeof(recv_message_ph_));
-    auto offset = sizeof(recv_message_ph_) - next_buffer_allocation_size_;
-    void* ptr =
-        static_cast<uint8_t*>(static_cast<void*>(&recv_message_ph_)) + offset;
-    *bufReturn = ptr;
-    *lenReturn = next_buffer_allocation_size_;
-  } else {
-    *bufReturn = read_buf_->writableTail();
-    *lenReturn = std::min(read_buf_->tailroom(), next_buffer_allocation_size_);
+  // The next thing to parse is either a header or the body whose header we
+  // already have. Both need to end up contiguous in read_buf_.
+  const size_t needed = have_header_ ? body_len_ : sizeof(ProtocolHeader);
+  if (!read_buf_ || read_buf_->tailroom() == 0 ||
+      read_buf_->length() + read_buf_->tailroom() < needed) {
+    reserve(needed);
   }
+  *bufReturn = read_buf_->writableTail();
+  *lenReturn = read_buf_->tailroom();
 }
 
-void MessageReader::prepareMessageBody() {
-  // Allocate the next read buffer to include current
-  // message's body. If checksum is not present in header,those 8 bytes in
-  // header belong to the message body. Copy the 8 bytes read earlier as part
-  // of ProtocolHeader if necessary, into this newly allocated buffer.
-  expecting_protocol_header_ = false;
-  auto payload_size = recv_message_ph_.len -
-      ProtocolHeader::bytesNeeded(recv_message_ph_.type, proto_);
-  next_buffer_allocation_size_ = payload_size;
-  read_buf_ = folly::IOBuf::create(next_buffer_allocation_size_);
-  // Add the 8 byte of message read if cksum is absent into the read_buf and
-  // move the writableTail().
-  if (!ProtocolHeader::needChecksumInHeader(recv_message_ph_.type, proto_)) {
-    memcpy(read_buf_->writableTail(),
-           &recv_message_ph_.cksum,
-           sizeof(recv_message_ph_.cksum));
-    read_buf_->append(sizeof(recv_message_ph_.cksum));
-    next_buffer_allocation_size_ -= read_buf_->length();
-    recv_message_ph_.cksum = 0;
+void MessageReader::reserve(size_t size) {
+  if (read_buf_ && !read_buf_->isSharedOne() && read_buf_->headroom() > 0 &&
+      read_buf_->capacity() >= size) {
+    // Nothing else refers to the buffer, move the unparsed bytes to its
+    // start.
+    read_buf_->retreat(read_buf_->headroom());
+    return;
+  }
+  auto buf = size <= kReadBufferSize ? acquireBuffer()
+                                     : folly::IOBuf::create(size);
+  if (read_buf_) {
+    // At most one partially received message.
+    memcpy(buf->writableTail(), read_buf_->data(), read_buf_->length());
+    buf->append(read_buf_->length());
+    releaseBuffer(std::move(read_buf_));
   }
-  ld_check_le(next_buffer_allocation_size_, read_buf_->capacity());
+  read_buf_ = std::move(buf);
+  ld_check_ge(read_buf_->length() + read_buf_->tailroom(), size);
 }
 
-bool MessageReader::validateHeader() {
+bool MessageReader::validateHeader(const ProtocolHeader& hdr) {
   // Validate the read header.
-  auto retval = proto_handler_.validateProtocolHeader(recv_message_ph_);
-  if (!retval) {
-    next_buffer_allocation_size_ = 0;
+  if (!proto_handler_.validateProtocolHeader(hdr) ||
+      hdr.len < ProtocolHeader::bytesNeeded(hdr.type, proto_)) {
+    failed_ = true;
     folly::AsyncSocketException ex(folly::AsyncSocketException::CORRUPTED_DATA,
                                    "Invalid Protocol Header received.",
                                    -1);
@@ -78,29 +107,75 @@ bool MessageReader::validateHeader() {
   return true;
 }
 
+bool MessageReader::readHeader() {
+  // The checksum is absent from the header of some messages (see
+  // ProtocolHeader::needChecksumInHeader()), look at the type first.
+  constexpr size_t min_protohdr_bytes =
+      sizeof(ProtocolHeader) - sizeof(ProtocolHeader::cksum);
+  if (read_buf_->length() < min_protohdr_bytes) {
+    return false;
+  }
+  ProtocolHeader hdr;
+  memcpy(&hdr, read_buf_->data(), min_protohdr_bytes);
+  const size_t protohdr_bytes = ProtocolHeader::bytesNeeded(hdr.type, proto_);
+  if (read_buf_->length() < protohdr_bytes) {
+    return false;
+  }
+  memcpy(&hdr, read_buf_->data(), protohdr_bytes);
+  if (!validateHeader(hdr)) {
+    return false;
+  }
+  read_buf_->trimStart(protohdr_bytes);
+  recv_message_ph_ = hdr;
+  body_len_ = hdr.len - protohdr_bytes;
+  have_header_ = true;
+  return true;
+}
+
 void MessageReader::readDataAvailable(size_t len) noexcept {
   ld_check(proto_handler_.good());
-  ld_check_ge(next_buffer_allocation_size_, len);
-  next_buffer_allocation_size_ -= len;
-  if (!expecting_protocol_header_) {
-    read_buf_->append(len);
-    if (next_buffer_allocation_size_ > 0) {
-      return;
+  ld_check(read_buf_);
+  ld_check_le(len, read_buf_->tailroom());
+  read_buf_->append(len);
+  dispatchBufferedMessages();
+}
+
+void MessageReader::dispatchBufferedMessages() {
+  while (read_buf_ && !failed_) {
+    if (!have_header_ && !readHeader()) {
+      break;
+    }
+    if (read_buf_->length() < body_len_) {
+      break;
     }
-    auto message_len = recv_message_ph_.len -
-        ProtocolHeader::bytesNeeded(recv_message_ph_.type, proto_);
-    // read_buf_ capacity can be greater than message len but that capacity
-    // should not be used.
-    ld_check_le(message_len, read_buf_->capacity());
-    ld_check(read_buf_->length() == message_len);
-    proto_handler_.dispatchMessageBody(recv_message_ph_, std::move(read_buf_));
-    expecting_protocol_header_ = true;
-    next_buffer_allocation_size_ = sizeof(ProtocolHeader);
+    std::unique_ptr<folly::IOBuf> body;
+    if (body_len_ * kMaxBufferToBodyRatio >= read_buf_->capacity()) {
+      // The body refers to the receive buffer, which remains ours to append
+      // to past the end of the body.
+      body = read_buf_->cloneOne();
+      body->trimEnd(body->length() - body_len_);
+    } else {
+      // Only the body is charged to the receive budget, don't let it pin a
+      // buffer many times its size.
+      body = folly::IOBuf::copyBuffer(read_buf_->data(), body_len_);
+    }
+    read_buf_->trimStart(body_len_);
+    const ProtocolHeader hdr = recv_message_ph_;
+    have_header_ = false;
     recv_message_ph_ = ProtocolHeader();
-  } else {
-    if (next_buffer_allocation_size_ == 0 && validateHeader()) {
-      prepareMessageBody();
+    if (proto_handler_.dispatchMessageBody(hdr, std::move(body)) != 0 ||
+        !proto_handler_.good()) {
+      // The connection is closing, or it stopped reading and will call
+      // dispatchBufferedMessages() once it is ready for more.
+      break;
     }
   }
+
+  if (read_buf_ && read_buf_->empty() &&
+      (!read_buf_->isSharedOne() || read_buf_->tailroom() < kMinReadSize)) {
+    // Don't hold on to an idle buffer, the connection may stay quiet for a
+    // long time.
+    releaseBuffer(std::move(read_buf_));
+  }
 }
 }} // namespace facebook::logdevice
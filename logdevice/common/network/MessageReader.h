@@ -19,27 +19,34 @@ namespace facebook { namespace logdevice {
  * MessageReader is installed in AsyncSocket to receive data read from
  * socket and forward it to Connection for further processing.
  *
- * Reader is in two states it's receiving protocol header or receiving a
- * message body. First thing received on the socket is the protocol header,
- * followed by message body and so on and so forth.
+ * Reader reads as much as the socket has into a large receive buffer
+ * (kReadBufferSize bytes, or the size of the message being received if that
+ * is larger) and then parses every complete message in it in one pass. A
+ * message body that takes a good part of the receive buffer is handed to the
+ * protocol handler as an IOBuf referencing that buffer, without copying; the
+ * buffer is then freed once all such messages are destroyed. Smaller bodies
+ * are copied, since the protocol handler only accounts for the body and a
+ * reference would keep the whole buffer allocated. Buffers left unreferenced
+ * once parsed are kept in a small per-thread pool for other readers to use.
  *
- * Reader maintains a buffer which it shares with AsyncSocket and all the
- * data is read into this buffer. The size of this buffer allocation depends on
- * the state we are in currently. The first buffer allocated has size equal to
- * the protocol header size. Once a protocol header is read, we save it in the
- * member variable and allocate a buffer to read in the message payload.
+ * If a message is only partially received, its header is parsed and
+ * validated right away and the rest of the message is awaited. getReadBuffer
+ * makes sure the buffer has room for the whole message, moving the received
+ * part into a new buffer if needed.
  *
- * On invoking getReadBuffer,  based on the state whether we are reading the
- * header or the tail , return the right buffer and remaining message
- * length or protocol header length to be read into the buffer to asyncsocket.
- *
- * On invoking readDataAvailable, check if the header or message body was read
- * completely. If we were expecting header and it was read completely allocate a
- * new buffer using the message len in header. If the message was read
- * completely, dispatch the message forward for processing.
+ * If the protocol handler fails to dispatch a message without closing the
+ * connection (e.g. it ran out of buffer space and uninstalled the read
+ * callback), the remaining messages stay buffered until
+ * dispatchBufferedMessages() is called.
  */
 class MessageReader : public folly::AsyncSocket::ReadCallback {
  public:
+  // Default size of receive buffers.
+  static constexpr size_t kReadBufferSize = 64 * 1024;
+  // Bodies smaller than 1/kMaxBufferToBodyRatio of the receive buffer are
+  // copied rather than referenced.
+  static constexpr size_t kMaxBufferToBodyRatio = 4;
+
   MessageReader(IProtocolHandler& conn, uint16_t proto);
 
   ~MessageReader() override {}
@@ -65,16 +72,40 @@ class MessageReader : public folly::AsyncSocket::ReadCallback {
     proto_handler_.notifyErrorOnSocket(ex);
   }
 
+  /**
+   * Dispatches the complete messages that were received but not dispatched
+   * yet because the protocol handler failed to process an earlier one.
+   */
+  void dispatchBufferedMessages();
+
+  /**
+   * Returns true if part of a message, or messages not dispatched yet, have
+   * been read from the socket.
+   */
+  bool hasBufferedData() const {
+    return have_header_ ||
+        (read_buf_ != nullptr && read_buf_->computeChainDataLength() > 0);
+  }
+
  private:
-  void expectProtocolHeader();
-  void expectMessageBody();
-  bool validateHeader();
-  void prepareMessageBody();
+  // Parses and validates the protocol header at the start of read_buf_ if it
+  // was fully received. Returns false if it was not or is invalid.
+  bool readHeader();
+  bool validateHeader(const ProtocolHeader& hdr);
+  // Makes room in read_buf_ for `size' bytes counting from its first
+  // unparsed byte.
+  void reserve(size_t size);
 
-  bool expecting_protocol_header_{true};
-  size_t next_buffer_allocation_size_;
+  // Unparsed bytes, from the first byte of the header of the next message or
+  // the first byte of the body if have_header_ is set.
   std::unique_ptr<folly::IOBuf> read_buf_;
+  // Header of the message being received.
   ProtocolHeader recv_message_ph_;
+  bool have_header_{false};
+  // Size of the body of the message being received, valid if have_header_.
+  size_t body_len_{0};
+  // Set once a header failed validation, no more data is accepted.
+  bool failed_{false};
   IProtocolHandler& proto_handler_;
   uint16_t proto_;
 };
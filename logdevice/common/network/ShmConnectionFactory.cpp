@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/network/ShmConnectionFactory.h"
+
+#include <sys/socket.h>
+
+#include <folly/io/async/EventBase.h>
+
+#include "logdevice/common/Connection.h"
+#include "logdevice/common/FlowGroup.h"
+#include "logdevice/common/Sockaddr.h"
+#include "logdevice/common/SocketDependencies.h"
+#include "logdevice/common/checks.h"
+#include "logdevice/common/network/ShmSocketAdapter.h"
+
+namespace facebook { namespace logdevice {
+
+ShmConnectionFactory::ShmConnectionFactory(
+    folly::EventBase* base,
+    size_t ring_size,
+    std::unique_ptr<IConnectionFactory> fallback)
+    : base_(base), ring_size_(ring_size), fallback_(std::move(fallback)) {
+  ld_check(base_);
+  ld_check(fallback_);
+  ld_check(ShmSegment::isValidRingSize(ring_size_));
+}
+
+std::unique_ptr<Connection> ShmConnectionFactory::createConnection(
+    NodeID node_id,
+    SocketType socket_type,
+    ConnectionType connection_type,
+    PeerType peer_type,
+    FlowGroup& flow_group,
+    std::unique_ptr<SocketDependencies> deps) {
+  // A node reachable through a unix socket is on this host.
+  if (connection_type != ConnectionType::PLAIN ||
+      !deps->getNodeSockaddr(node_id, socket_type, connection_type, peer_type)
+           .isUnixAddress()) {
+    return fallback_->createConnection(node_id,
+                                       socket_type,
+                                       connection_type,
+                                       peer_type,
+                                       flow_group,
+                                       std::move(deps));
+  }
+  return std::make_unique<Connection>(
+      node_id,
+      socket_type,
+      connection_type,
+      peer_type,
+      flow_group,
+      std::move(deps),
+      std::make_unique<ShmSocketAdapter>(base_, ring_size_));
+}
+
+std::unique_ptr<Connection> ShmConnectionFactory::createConnection(
+    int fd,
+    ClientID client_name,
+    const Sockaddr& client_address,
+    ResourceBudget::Token connection_token,
+    SocketType type,
+    ConnectionType connection_type,
+    FlowGroup& flow_group,
+    std::unique_ptr<SocketDependencies> deps) const {
+  int domain = AF_UNSPEC;
+  socklen_t len = sizeof(domain);
+  if (connection_type != ConnectionType::PLAIN ||
+      ::getsockopt(fd, SOL_SOCKET, SO_DOMAIN, &domain, &len) != 0 ||
+      domain != AF_UNIX) {
+    return fallback_->createConnection(fd,
+                                       client_name,
+                                       client_address,
+                                       std::move(connection_token),
+                                       type,
+                                       connection_type,
+                                       flow_group,
+                                       std::move(deps));
+  }
+  // Clients that don't use shared memory are served by an AsyncSocket the
+  // adapter switches to once it sees their first bytes.
+  return std::make_unique<Connection>(
+      fd,
+      client_name,
+      client_address,
+      std::move(connection_token),
+      type,
+      connection_type,
+      flow_group,
+      std::move(deps),
+      std::make_unique<ShmSocketAdapter>(
+          base_, folly::NetworkSocket::fromFd(fd)));
+}
+
+}} // namespace facebook::logdevice
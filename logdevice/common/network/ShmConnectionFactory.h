@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include <memory>
+
+#include "logdevice/common/ClientID.h"
+#include "logdevice/common/NodeID.h"
+#include "logdevice/common/ResourceBudget.h"
+#include "logdevice/common/SocketTypes.h"
+#include "logdevice/common/network/IConnectionFactory.h"
+
+namespace folly {
+class EventBase;
+}
+
+namespace facebook { namespace logdevice {
+class Connection;
+class FlowGroup;
+class SockAddr;
+class SocketDependencies;
+
+/**
+ * Creates Connections going through shared memory (see ShmSocketAdapter)
+ * for plaintext connections over unix sockets, i.e. with peers on the same
+ * host. All other connections are created by the wrapped factory.
+ */
+class ShmConnectionFactory : public IConnectionFactory {
+ public:
+  /**
+   * @param ring_size  Size of the rings of outgoing connections, see
+   *                   ShmSegment::isValidRingSize().
+   * @param fallback   Factory for the connections that can't use shared
+   *                   memory.
+   */
+  ShmConnectionFactory(folly::EventBase* base,
+                       size_t ring_size,
+                       std::unique_ptr<IConnectionFactory> fallback);
+
+  std::unique_ptr<Connection>
+  createConnection(NodeID node_id,
+                   SocketType socket_type,
+                   ConnectionType connection_type,
+                   PeerType peer_type,
+                   FlowGroup& flow_group,
+                   std::unique_ptr<SocketDependencies> deps) override;
+
+  std::unique_ptr<Connection>
+  createConnection(int fd,
+                   ClientID client_name,
+                   const Sockaddr& client_address,
+                   ResourceBudget::Token connection_token,
+                   SocketType type,
+                   ConnectionType conntype,
+                   FlowGroup& flow_group,
+                   std::unique_ptr<SocketDependencies> deps) const override;
+
+ private:
+  folly::EventBase* base_;
+  const size_t ring_size_;
+  std::unique_ptr<IConnectionFactory> fallback_;
+};
+
+}} // namespace facebook::logdevice
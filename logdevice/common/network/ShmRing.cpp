@@ -0,0 +1,212 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/network/ShmRing.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "logdevice/common/checks.h"
+#include "logdevice/common/debug.h"
+#include "logdevice/include/Err.h"
+
+namespace facebook { namespace logdevice {
+
+namespace {
+// The ring data starts at this offset of the segment, after the controls.
+constexpr size_t kDataOffset = 4096;
+static_assert(2 * sizeof(ShmRingControl) <= kDataOffset,
+              "ring controls must fit in the first page");
+} // namespace
+
+ShmRing::ShmRing(ShmRingControl* ctl, uint8_t* data, size_t capacity)
+    : ctl_(ctl),
+      data_(data),
+      capacity_(capacity),
+      local_head_(ctl->head.load(std::memory_order_acquire)),
+      local_tail_(ctl->tail.load(std::memory_order_acquire)) {
+  ld_check(capacity_ > 0 && (capacity_ & (capacity_ - 1)) == 0);
+}
+
+ssize_t ShmRing::write(const void* data, size_t len) {
+  const uint64_t head = ctl_->head.load(std::memory_order_acquire);
+  const uint64_t used = local_tail_ - head;
+  if (used > capacity_) {
+    err = E::BADMSG;
+    return -1;
+  }
+  const size_t n = std::min<size_t>(len, capacity_ - used);
+  if (n == 0) {
+    return 0;
+  }
+  const size_t offset = local_tail_ & (capacity_ - 1);
+  const size_t first = std::min(n, capacity_ - offset);
+  memcpy(data_ + offset, data, first);
+  memcpy(data_, static_cast<const uint8_t*>(data) + first, n - first);
+  local_tail_ += n;
+  ctl_->tail.store(local_tail_, std::memory_order_release);
+  return n;
+}
+
+ssize_t ShmRing::readable() const {
+  const uint64_t avail =
+      ctl_->tail.load(std::memory_order_acquire) - local_head_;
+  if (avail > capacity_) {
+    err = E::BADMSG;
+    return -1;
+  }
+  return avail;
+}
+
+ssize_t ShmRing::read(void* buf, size_t len) {
+  const ssize_t avail = readable();
+  if (avail <= 0) {
+    return avail;
+  }
+  const size_t n = std::min<size_t>(len, avail);
+  const size_t offset = local_head_ & (capacity_ - 1);
+  const size_t first = std::min(n, capacity_ - offset);
+  memcpy(buf, data_ + offset, first);
+  memcpy(static_cast<uint8_t*>(buf) + first, data_, n - first);
+  local_head_ += n;
+  ctl_->head.store(local_head_, std::memory_order_release);
+  return n;
+}
+
+// The waiting flags and the positions are a Dekker style handshake: each
+// side stores one, then loads the other, with a full fence in between. So
+// either the waiting side sees the progress, or the progressing side sees
+// the flag and signals.
+
+bool ShmRing::prepareToWaitForData() {
+  ctl_->consumer_waiting.store(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (ctl_->tail.load(std::memory_order_relaxed) != local_head_) {
+    ctl_->consumer_waiting.store(0, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+bool ShmRing::prepareToWaitForSpace() {
+  ctl_->producer_waiting.store(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (local_tail_ - ctl_->head.load(std::memory_order_relaxed) < capacity_) {
+    ctl_->producer_waiting.store(0, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+bool ShmRing::shouldWakeConsumer() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return ctl_->consumer_waiting.load(std::memory_order_relaxed) &&
+      ctl_->consumer_waiting.exchange(0, std::memory_order_relaxed);
+}
+
+bool ShmRing::shouldWakeProducer() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return ctl_->producer_waiting.load(std::memory_order_relaxed) &&
+      ctl_->producer_waiting.exchange(0, std::memory_order_relaxed);
+}
+
+bool ShmSegment::isValidRingSize(size_t ring_size) {
+  return ring_size >= kMinRingSize && ring_size <= kMaxRingSize &&
+      (ring_size & (ring_size - 1)) == 0;
+}
+
+size_t ShmSegment::mappingSize(size_t ring_size) {
+  return kDataOffset + 2 * ring_size;
+}
+
+std::unique_ptr<ShmSegment> ShmSegment::create(size_t ring_size) {
+  if (!isValidRingSize(ring_size)) {
+    err = E::INVALID_PARAM;
+    return nullptr;
+  }
+  int fd = ::memfd_create("logdevice-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    ld_error("memfd_create() failed: %s", strerror(errno));
+    err = E::SYSLIMIT;
+    return nullptr;
+  }
+  const size_t size = mappingSize(ring_size);
+  // The peer relies on the size never changing under it.
+  if (::ftruncate(fd, size) != 0 ||
+      ::fcntl(fd,
+              F_ADD_SEALS,
+              F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+    ld_error("Failed to size shared memory segment: %s", strerror(errno));
+    ::close(fd);
+    err = E::SYSLIMIT;
+    return nullptr;
+  }
+  void* addr =
+      ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    ld_error("Failed to map shared memory segment: %s", strerror(errno));
+    ::close(fd);
+    err = E::SYSLIMIT;
+    return nullptr;
+  }
+  return std::unique_ptr<ShmSegment>(new ShmSegment(fd, addr, ring_size));
+}
+
+std::unique_ptr<ShmSegment> ShmSegment::attach(int fd, size_t ring_size) {
+  auto fail = [fd](E error) -> std::unique_ptr<ShmSegment> {
+    ::close(fd);
+    err = error;
+    return nullptr;
+  };
+  if (!isValidRingSize(ring_size)) {
+    return fail(E::INVALID_PARAM);
+  }
+  const size_t size = mappingSize(ring_size);
+  struct stat st;
+  const int seals = ::fcntl(fd, F_GET_SEALS);
+  if (::fstat(fd, &st) != 0 || seals < 0 || st.st_size < 0 ||
+      static_cast<size_t>(st.st_size) < size || !(seals & F_SEAL_SHRINK)) {
+    // Accessing a mapping beyond the end of a file that shrunk would raise
+    // SIGBUS.
+    ld_error("Peer sent an invalid shared memory segment: size %jd, seals %d",
+             static_cast<intmax_t>(st.st_size),
+             seals);
+    return fail(E::INVALID_PARAM);
+  }
+  void* addr =
+      ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    ld_error("Failed to map shared memory segment: %s", strerror(errno));
+    return fail(E::SYSLIMIT);
+  }
+  return std::unique_ptr<ShmSegment>(new ShmSegment(fd, addr, ring_size));
+}
+
+ShmSegment::ShmSegment(int fd, void* addr, size_t ring_size)
+    : fd_(fd), addr_(addr), ring_size_(ring_size) {
+  auto base = static_cast<uint8_t*>(addr_);
+  auto ctl = reinterpret_cast<ShmRingControl*>(base);
+  rings_[0] =
+      std::make_unique<ShmRing>(&ctl[0], base + kDataOffset, ring_size_);
+  rings_[1] = std::make_unique<ShmRing>(
+      &ctl[1], base + kDataOffset + ring_size_, ring_size_);
+}
+
+ShmSegment::~ShmSegment() {
+  rings_[0].reset();
+  rings_[1].reset();
+  ::munmap(addr_, mappingSize(ring_size_));
+  ::close(fd_);
+}
+
+}} // namespace facebook::logdevice
@@ -0,0 +1,169 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <sys/types.h>
+
+namespace facebook { namespace logdevice {
+
+/**
+ * @file Single producer, single consumer byte ring living in memory shared
+ * by two processes, and the memfd backed segment holding the two rings (one
+ * per direction) of a shared memory connection (see ShmSocketAdapter).
+ *
+ * Neither side trusts the other: indexes read from shared memory are
+ * validated before being used, so a misbehaving peer can corrupt the byte
+ * stream of its own connection but not make us access memory outside the
+ * ring.
+ */
+
+// Shared part of a ring. Positions are byte counts since the ring was
+// created; they only grow.
+struct ShmRingControl {
+  // Bytes consumed, written by the consumer.
+  alignas(64) std::atomic<uint64_t> head;
+  // Bytes produced, written by the producer.
+  alignas(64) std::atomic<uint64_t> tail;
+  // Set by the consumer before it waits for data, and by the producer
+  // before it waits for space. Whoever makes progress on the other side
+  // clears the flag and, if it was set, signals the waiting side's eventfd.
+  alignas(64) std::atomic<uint32_t> consumer_waiting;
+  alignas(64) std::atomic<uint32_t> producer_waiting;
+};
+
+class ShmRing {
+ public:
+  // `capacity` must be a power of two.
+  ShmRing(ShmRingControl* ctl, uint8_t* data, size_t capacity);
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  /**
+   * Producer side. Copies as much of [data, data+len) as fits and publishes
+   * it.
+   *
+   * @return  number of bytes copied, -1 if the consumer corrupted the ring
+   *          (err is set to E::BADMSG).
+   */
+  ssize_t write(const void* data, size_t len);
+
+  /**
+   * Consumer side.
+   *
+   * @return  number of bytes ready to be read, -1 if the producer corrupted
+   *          the ring (err is set to E::BADMSG).
+   */
+  ssize_t readable() const;
+
+  /**
+   * Consumer side. Copies up to `len` bytes out of the ring and releases
+   * their space to the producer.
+   *
+   * @return  number of bytes copied, -1 if the ring is corrupted.
+   */
+  ssize_t read(void* buf, size_t len);
+
+  /**
+   * Consumer side, before waiting for the producer's signal.
+   *
+   * @return  false if data arrived meanwhile, in which case the consumer
+   *          must not wait.
+   */
+  bool prepareToWaitForData();
+
+  /**
+   * Producer side, before waiting for the consumer's signal.
+   *
+   * @return  false if space was released meanwhile, in which case the
+   *          producer must not wait.
+   */
+  bool prepareToWaitForSpace();
+
+  /**
+   * Producer side, after write(). @return  true if the consumer waits for
+   * data and must be signalled.
+   */
+  bool shouldWakeConsumer();
+
+  /**
+   * Consumer side, after read(). @return  true if the producer waits for
+   * space and must be signalled.
+   */
+  bool shouldWakeProducer();
+
+ private:
+  ShmRingControl* ctl_;
+  uint8_t* data_;
+  size_t capacity_;
+  // Positions this side owns, cached to avoid reading them back from shared
+  // memory where the peer could have changed them.
+  uint64_t local_head_;
+  uint64_t local_tail_;
+};
+
+class ShmSegment {
+ public:
+  static constexpr size_t kMinRingSize = 4096;
+  static constexpr size_t kMaxRingSize = 64 * 1024 * 1024;
+
+  /**
+   * Create a new segment with two rings of `ring_size` bytes in a sealed
+   * memfd.
+   *
+   * @return  the segment, nullptr on failure with err set to E::SYSLIMIT or
+   *          E::INVALID_PARAM.
+   */
+  static std::unique_ptr<ShmSegment> create(size_t ring_size);
+
+  /**
+   * Map a segment created by the peer. Takes ownership of `fd` (on success
+   * and on failure). Checks that the memfd is big enough and can't shrink.
+   *
+   * @return  the segment, nullptr on failure with err set.
+   */
+  static std::unique_ptr<ShmSegment> attach(int fd, size_t ring_size);
+
+  ~ShmSegment();
+
+  int fd() const {
+    return fd_;
+  }
+  size_t ringSize() const {
+    return ring_size_;
+  }
+
+  // The ring written by the side that created the segment.
+  ShmRing& creatorToAttacher() {
+    return *rings_[0];
+  }
+  // The ring written by the side that attached to the segment.
+  ShmRing& attacherToCreator() {
+    return *rings_[1];
+  }
+
+  static bool isValidRingSize(size_t ring_size);
+
+ private:
+  ShmSegment(int fd, void* addr, size_t ring_size);
+
+  static size_t mappingSize(size_t ring_size);
+
+  int fd_;
+  void* addr_;
+  size_t ring_size_;
+  std::unique_ptr<ShmRing> rings_[2];
+};
+
+}} // namespace facebook::logdevice
@@ -0,0 +1,933 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/network/ShmSocketAdapter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <folly/SocketAddress.h>
+#include <folly/container/small_vector.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/EventBase.h>
+
+#include "logdevice/common/checks.h"
+#include "logdevice/common/debug.h"
+#include "logdevice/common/network/AsyncSocketAdapter.h"
+
+namespace facebook { namespace logdevice {
+
+using folly::AsyncSocketException;
+
+// Read as the length of a message, "LDSH" is over 1GB, more than any valid
+// message.
+const char ShmSocketAdapter::kMagic[8] = {'L', 'D', 'S', 'H', 'M', 0, 0, 0};
+
+namespace {
+// File descriptor passed along with the preamble: the memfd.
+constexpr size_t kNumPreambleFds = 1;
+// File descriptors passed along with the ack: the eventfd the connecting
+// side waits on, the eventfd the accepting side waits on.
+constexpr size_t kNumAckFds = 2;
+
+union ControlBuffer {
+  char buf[CMSG_SPACE(sizeof(int) * kNumAckFds)];
+  cmsghdr align;
+};
+
+using PassedFds = folly::small_vector<int, kNumAckFds>;
+
+// Sends `len' bytes with file descriptors attached, without blocking.
+ssize_t sendWithFds(int sock,
+                    const void* data,
+                    size_t len,
+                    const int* fds,
+                    size_t nfds) {
+  ld_check(nfds <= kNumAckFds);
+  iovec iov{const_cast<void*>(data), len};
+  ControlBuffer control;
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = CMSG_SPACE(sizeof(int) * nfds);
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * nfds);
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * nfds);
+  return ::sendmsg(sock, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+
+// Receives up to `len' bytes and the file descriptors attached to them,
+// without blocking. The caller owns the descriptors put in `fds', even if
+// `truncated' is set because some could not be received.
+ssize_t recvWithFds(int sock,
+                    void* data,
+                    size_t len,
+                    PassedFds& fds,
+                    bool& truncated) {
+  iovec iov{data, len};
+  ControlBuffer control;
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+  const ssize_t n = ::recvmsg(sock, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+  if (n < 0) {
+    return n;
+  }
+  truncated = msg.msg_flags & MSG_CTRUNC;
+  for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      const size_t nfds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      for (size_t i = 0; i < nfds; ++i) {
+        int fd;
+        memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+        fds.push_back(fd);
+      }
+    }
+  }
+  return n;
+}
+
+void closeAll(const PassedFds& fds) {
+  for (int fd : fds) {
+    ::close(fd);
+  }
+}
+
+// Whether a descriptor the peer passed is a non-blocking eventfd, and not
+// e.g. a pipe that reads and writes could block on.
+bool isUsableEventFd(int fd) {
+  char path[32];
+  snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+  constexpr char kEventFdLink[] = "anon_inode:[eventfd]";
+  char link[sizeof(kEventFdLink)];
+  const ssize_t n = ::readlink(path, link, sizeof(link));
+  if (n != sizeof(kEventFdLink) - 1 || memcmp(link, kEventFdLink, n) != 0) {
+    return false;
+  }
+  const int flags = ::fcntl(fd, F_GETFL);
+  return flags >= 0 &&
+      ((flags & O_NONBLOCK) || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0);
+}
+} // namespace
+
+ShmSocketAdapter::ShmSocketAdapter(folly::EventBase* evb, size_t ring_size)
+    : evb_(evb),
+      ring_size_(ring_size),
+      accepted_(false),
+      control_handler_(evb, this, &ShmSocketAdapter::onControlReady),
+      notify_handler_(evb, this, &ShmSocketAdapter::onNotify) {
+  ld_check(evb_);
+  ld_check(ShmSegment::isValidRingSize(ring_size_));
+}
+
+ShmSocketAdapter::ShmSocketAdapter(folly::EventBase* evb,
+                                   folly::NetworkSocket fd)
+    : evb_(evb),
+      accepted_(true),
+      fd_(fd.toFd()),
+      state_(State::ESTABLISHED),
+      control_handler_(evb, this, &ShmSocketAdapter::onControlReady),
+      notify_handler_(evb, this, &ShmSocketAdapter::onNotify) {
+  ld_check(evb_);
+  ld_check(fd_ >= 0);
+  control_handler_.changeHandlerFD(fd);
+  control_handler_.registerHandler(folly::EventHandler::READ |
+                                   folly::EventHandler::PERSIST);
+}
+
+ShmSocketAdapter::~ShmSocketAdapter() {
+  *alive_ = false;
+  closeFds();
+}
+
+void ShmSocketAdapter::connect(ConnectCallback* callback,
+                               const folly::SocketAddress& address,
+                               int timeout,
+                               const folly::SocketOptionMap& options,
+                               const folly::SocketAddress& bindAddr) noexcept {
+  if (state_ != State::UNINIT) {
+    if (callback) {
+      callback->connectErr(AsyncSocketException(
+          AsyncSocketException::ALREADY_OPEN,
+          "connect() called with socket in invalid state"));
+    }
+    return;
+  }
+  connect_cb_ = callback;
+  state_ = State::CONNECTING;
+
+  if (address.getFamily() != AF_UNIX) {
+    fail(AsyncSocketException(
+        AsyncSocketException::BAD_ARGS,
+        "shared memory connections require a unix socket address"));
+    return;
+  }
+  auto fail_connect = [&](const char* what) {
+    fail(AsyncSocketException(
+        AsyncSocketException::INTERNAL_ERROR, what, errno));
+  };
+
+  fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd_ < 0) {
+    fail_connect("failed to create socket");
+    return;
+  }
+  for (const auto& opt : options) {
+    int val = opt.second;
+    if (::setsockopt(
+            fd_, opt.first.level, opt.first.optname, &val, sizeof(val)) != 0) {
+      fail_connect("failed to set socket option");
+      return;
+    }
+  }
+  if (bindAddr != folly::AsyncSocket::anyAddress()) {
+    sockaddr_storage bind_ss;
+    socklen_t bind_len = bindAddr.getAddress(&bind_ss);
+    if (::bind(fd_, reinterpret_cast<sockaddr*>(&bind_ss), bind_len) != 0) {
+      fail_connect("failed to bind to async socket");
+      return;
+    }
+  }
+  if (callback) {
+    callback->preConnect(folly::NetworkSocket::fromFd(fd_));
+  }
+  control_handler_.changeHandlerFD(folly::NetworkSocket::fromFd(fd_));
+
+  if (timeout > 0) {
+    // Covers both connecting the socket and the shared memory setup.
+    connect_timeout_ = folly::AsyncTimeout::make(*evb_, [this]() noexcept {
+      fail(AsyncSocketException(
+          AsyncSocketException::TIMED_OUT, "connect timed out"));
+    });
+    connect_timeout_->scheduleTimeout(timeout);
+  }
+
+  sockaddr_storage ss;
+  socklen_t len = address.getAddress(&ss);
+  if (::connect(fd_, reinterpret_cast<sockaddr*>(&ss), len) == 0) {
+    sendPreamble();
+    return;
+  }
+  if (errno == EINPROGRESS) {
+    control_handler_.registerHandler(folly::EventHandler::WRITE);
+    return;
+  }
+  // Unlike TCP, a unix socket whose listener's backlog is full fails with
+  // EAGAIN right away.
+  fail(AsyncSocketException(
+      AsyncSocketException::NOT_OPEN, "connect failed", errno));
+}
+
+void ShmSocketAdapter::sendPreamble() {
+  segment_ = ShmSegment::create(ring_size_);
+  if (!segment_) {
+    fail(AsyncSocketException(AsyncSocketException::INTERNAL_ERROR,
+                              "failed to create shared memory segment"));
+    return;
+  }
+  tx_ = &segment_->creatorToAttacher();
+  rx_ = &segment_->attacherToCreator();
+
+  Preamble preamble;
+  memcpy(preamble.magic, kMagic, sizeof(kMagic));
+  preamble.version = kVersion;
+  preamble.ring_size = ring_size_;
+  const int fds[kNumPreambleFds] = {segment_->fd()};
+
+  // The socket was just connected, its buffer is empty.
+  const ssize_t n =
+      sendWithFds(fd_, &preamble, sizeof(preamble), fds, kNumPreambleFds);
+  if (n != static_cast<ssize_t>(sizeof(preamble))) {
+    fail(AsyncSocketException(AsyncSocketException::NOT_OPEN,
+                              "failed to send shared memory setup",
+                              n < 0 ? errno : 0));
+    return;
+  }
+  control_handler_.registerHandler(folly::EventHandler::READ |
+                                   folly::EventHandler::PERSIST);
+}
+
+void ShmSocketAdapter::onControlReady(uint16_t /* events */) {
+  if (state_ == State::CONNECTING) {
+    if (segment_) {
+      onAck();
+      return;
+    }
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (::getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &len) != 0) {
+      error = errno;
+    }
+    if (error != 0) {
+      fail(AsyncSocketException(
+          AsyncSocketException::NOT_OPEN, "connect failed", error));
+      return;
+    }
+    control_handler_.unregisterHandler();
+    sendPreamble();
+    return;
+  }
+  if (accepted_ && !segment_) {
+    receivePreamble();
+    return;
+  }
+
+  // Nothing is sent over the control socket once shared memory is set up,
+  // readiness means the peer went away.
+  char c;
+  const ssize_t n = ::recv(fd_, &c, 1, MSG_DONTWAIT);
+  if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+    return;
+  }
+  if (n == 0 || (n < 0 && errno == ECONNRESET)) {
+    peer_closed_ = true;
+    control_handler_.unregisterHandler();
+    // Deliver what the peer wrote before closing, then fail our writes.
+    if (deliver() && flushWrites()) {
+      waitForPeer();
+    }
+    return;
+  }
+  fail(n > 0 ? AsyncSocketException(AsyncSocketException::INTERNAL_ERROR,
+                                    "unexpected data on control socket")
+             : AsyncSocketException(AsyncSocketException::INTERNAL_ERROR,
+                                    "recv() failed",
+                                    errno));
+}
+
+void ShmSocketAdapter::onAck() {
+  uint8_t ack = 0;
+  PassedFds fds;
+  bool truncated = false;
+  const ssize_t n = recvWithFds(fd_, &ack, 1, fds, truncated);
+  const int error = n < 0 ? errno : 0;
+  if (error == EAGAIN || error == EINTR) {
+    return;
+  }
+  if (n != 1 || ack != kAck) {
+    closeAll(fds);
+    // The peer doesn't accept shared memory connections on this socket.
+    fail(AsyncSocketException(AsyncSocketException::NOT_OPEN,
+                              "peer refused shared memory connection",
+                              error));
+    return;
+  }
+  if (truncated || fds.size() != kNumAckFds || !isUsableEventFd(fds[0]) ||
+      !isUsableEventFd(fds[1])) {
+    closeAll(fds);
+    fail(AsyncSocketException(AsyncSocketException::INTERNAL_ERROR,
+                              "invalid eventfds from peer"));
+    return;
+  }
+  notify_fd_ = fds[0];
+  peer_notify_fd_ = fds[1];
+  if (connect_timeout_) {
+    connect_timeout_->cancelTimeout();
+  }
+  state_ = State::ESTABLISHED;
+  auto alive = alive_;
+  if (connect_cb_) {
+    auto cb = connect_cb_;
+    connect_cb_ = nullptr;
+    cb->connectSuccess();
+    if (!*alive) {
+      return;
+    }
+  }
+  if (state_ == State::ESTABLISHED) {
+    startSharedMemory();
+  }
+}
+
+void ShmSocketAdapter::receivePreamble() {
+  Preamble preamble;
+  ssize_t n =
+      ::recv(fd_, &preamble, sizeof(preamble), MSG_PEEK | MSG_DONTWAIT);
+  if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+    return;
+  }
+  if (n <= 0 ||
+      memcmp(preamble.magic,
+             kMagic,
+             std::min<size_t>(n, sizeof(kMagic))) != 0) {
+    // EOF and errors are left for AsyncSocket to report too.
+    switchToFallback();
+    return;
+  }
+  if (static_cast<size_t>(n) < sizeof(preamble)) {
+    // Wait for the rest of the preamble.
+    return;
+  }
+
+  // Now actually receive it, with the memfd.
+  PassedFds fds;
+  bool truncated = false;
+  n = recvWithFds(fd_, &preamble, sizeof(preamble), fds, truncated);
+  if (n != static_cast<ssize_t>(sizeof(preamble)) || truncated ||
+      fds.size() != kNumPreambleFds || preamble.version != kVersion) {
+    closeAll(fds);
+    fail(AsyncSocketException(AsyncSocketException::INTERNAL_ERROR,
+                              "invalid shared memory setup from peer"));
+    return;
+  }
+
+  segment_ = ShmSegment::attach(fds[0], preamble.ring_size);
+  if (!segment_) {
+    fail(AsyncSocketException(AsyncSocketException::INTERNAL_ERROR,
+                              "invalid shared memory segment from peer"));
+    return;
+  }
+  ring_size_ = preamble.ring_size;
+  rx_ = &segment_->creatorToAttacher();
+  tx_ = &segment_->attacherToCreator();
+
+  // Create the eventfds here and hand them to the peer with the ack, rather
+  // than reading and writing whatever descriptors an untrusted peer passed.
+  notify_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  peer_notify_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (notify_fd_ < 0 || peer_notify_fd_ < 0) {
+    fail(AsyncSocketException(AsyncSocketException::INTERNAL_ERROR,
+                              "failed to create eventfd",
+                              errno));
+    return;
+  }
+
+  const uint8_t ack = kAck;
+  const int ack_fds[kNumAckFds] = {peer_notify_fd_, notify_fd_};
+  if (sendWithFds(fd_, &ack, 1, ack_fds, kNumAckFds) != 1) {
+    fail(AsyncSocketException(AsyncSocketException::NOT_OPEN,
+                              "failed to acknowledge shared memory setup",
+                              errno));
+    return;
+  }
+  startSharedMemory();
+}
+
+void ShmSocketAdapter::switchToFallback() {
+  control_handler_.unregisterHandler();
+  fallback_ = std::make_unique<AsyncSocketAdapter>(
+      evb_, folly::NetworkSocket::fromFd(fd_));
+  fd_ = -1;
+
+  auto alive = alive_;
+  auto queue = std::move(write_queue_);
+  write_queue_.clear();
+  if (read_cb_) {
+    auto cb = read_cb_;
+    read_cb_ = nullptr;
+    fallback_->setReadCB(cb);
+    if (!*alive) {
+      return;
+    }
+  }
+  for (WriteRequest& req : queue) {
+    fallback_->writeChain(req.callback, std::move(req.buf));
+    if (!*alive) {
+      return;
+    }
+  }
+}
+
+void ShmSocketAdapter::startSharedMemory() {
+  notify_handler_.changeHandlerFD(folly::NetworkSocket::fromFd(notify_fd_));
+  notify_handler_.registerHandler(folly::EventHandler::READ |
+                                  folly::EventHandler::PERSIST);
+  // Writes may have been queued and the peer may have written already.
+  if (deliver() && flushWrites()) {
+    waitForPeer();
+  }
+}
+
+void ShmSocketAdapter::onNotify(uint16_t /* events */) {
+  uint64_t count;
+  // Resets the eventfd. Nothing to do if someone else already did.
+  if (::read(notify_fd_, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+    fail(AsyncSocketException(
+        AsyncSocketException::INTERNAL_ERROR, "eventfd read failed", errno));
+    return;
+  }
+  if (deliver() && flushWrites()) {
+    waitForPeer();
+  }
+}
+
+void ShmSocketAdapter::waitForPeer() {
+  if (!segment_ || (state_ != State::ESTABLISHED && state_ != State::CLOSING)) {
+    return;
+  }
+  bool progress = false;
+  if (read_cb_ && !peer_closed_ && !rx_->prepareToWaitForData()) {
+    progress = true;
+  }
+  if (!write_queue_.empty() && !tx_->prepareToWaitForSpace()) {
+    progress = true;
+  }
+  if (progress) {
+    schedulePass();
+  }
+}
+
+void ShmSocketAdapter::schedulePass() {
+  if (pass_scheduled_) {
+    return;
+  }
+  pass_scheduled_ = true;
+  evb_->runInLoop([this, alive = alive_] {
+    if (!*alive) {
+      return;
+    }
+    pass_scheduled_ = false;
+    if (state_ == State::ERROR) {
+      ld_check(error_.has_value());
+      if (read_cb_) {
+        auto cb = read_cb_;
+        read_cb_ = nullptr;
+        cb->readErr(*error_);
+      }
+      return;
+    }
+    if (deliver() && flushWrites()) {
+      waitForPeer();
+    }
+  });
+}
+
+void ShmSocketAdapter::signalPeer() {
+  const uint64_t one = 1;
+  // Can only fail if the counter is about to overflow, in which case the
+  // peer is going to wake up anyway.
+  (void)::write(peer_notify_fd_, &one, sizeof(one));
+}
+
+bool ShmSocketAdapter::deliver() {
+  auto alive = alive_;
+  if (!segment_ || state_ != State::ESTABLISHED) {
+    return true;
+  }
+  auto corrupted = [&] {
+    fail(AsyncSocketException(AsyncSocketException::INTERNAL_ERROR,
+                              "shared memory ring corrupted by peer"));
+    return false;
+  };
+
+  // Hand out at most a ring's worth of data per pass, so that a fast writer
+  // can't keep the event loop busy with a single connection.
+  size_t budget = rx_->capacity();
+  while (read_cb_ && state_ == State::ESTABLISHED && budget > 0) {
+    const ssize_t avail = rx_->readable();
+    if (avail < 0) {
+      return corrupted();
+    }
+    if (avail == 0) {
+      break;
+    }
+    ReadCallback* cb = read_cb_;
+    if (cb->isBufferMovable()) {
+      const size_t len = std::min<size_t>(avail, budget);
+      auto buf = folly::IOBuf::create(len);
+      if (rx_->read(buf->writableData(), len) !=
+          static_cast<ssize_t>(len)) {
+        return corrupted();
+      }
+      buf->append(len);
+      bytes_received_ += len;
+      budget -= len;
+      if (rx_->shouldWakeProducer()) {
+        signalPeer();
+      }
+      cb->readBufferAvailable(std::move(buf));
+      if (!*alive) {
+        return false;
+      }
+      continue;
+    }
+
+    void* buf = nullptr;
+    size_t buflen = 0;
+    cb->getReadBuffer(&buf, &buflen);
+    if (!*alive) {
+      return false;
+    }
+    if (buf == nullptr || buflen == 0) {
+      fail(AsyncSocketException(
+          AsyncSocketException::BAD_ARGS,
+          "ReadCallback::getReadBuffer() returned empty buffer"));
+      return false;
+    }
+    const ssize_t n = rx_->read(buf, std::min(buflen, budget));
+    if (n <= 0) {
+      return corrupted();
+    }
+    bytes_received_ += n;
+    budget -= n;
+    if (rx_->shouldWakeProducer()) {
+      signalPeer();
+    }
+    cb->readDataAvailable(n);
+    if (!*alive) {
+      return false;
+    }
+  }
+
+  if (peer_closed_ && read_cb_ && state_ == State::ESTABLISHED &&
+      rx_->readable() == 0) {
+    auto cb = read_cb_;
+    read_cb_ = nullptr;
+    cb->readEOF();
+    return *alive;
+  }
+  return true;
+}
+
+bool ShmSocketAdapter::flushWrites() {
+  auto alive = alive_;
+  if (!segment_ || write_queue_.empty() ||
+      (state_ != State::ESTABLISHED && state_ != State::CLOSING)) {
+    return true;
+  }
+  if (peer_closed_) {
+    fail(AsyncSocketException(AsyncSocketException::NOT_OPEN,
+                              "peer closed the connection",
+                              EPIPE));
+    return false;
+  }
+
+  size_t written = 0;
+  bool corrupted = false;
+  folly::small_vector<WriteCallback*, 16> done;
+  while (!write_queue_.empty() && !corrupted) {
+    WriteRequest& req = write_queue_.front();
+    size_t skip = req.length - req.remaining;
+    for (folly::ByteRange range : *req.buf) {
+      if (skip >= range.size()) {
+        skip -= range.size();
+        continue;
+      }
+      const size_t len = range.size() - skip;
+      const ssize_t n = tx_->write(range.data() + skip, len);
+      if (n < 0) {
+        corrupted = true;
+        break;
+      }
+      req.remaining -= n;
+      written += n;
+      skip = 0;
+      if (static_cast<size_t>(n) < len) {
+        // The ring is full.
+        break;
+      }
+    }
+    if (req.remaining > 0) {
+      break;
+    }
+    if (req.callback) {
+      done.push_back(req.callback);
+    }
+    write_queue_.pop_front();
+  }
+
+  bytes_written_ += written;
+  if (written > 0 && tx_->shouldWakeConsumer()) {
+    signalPeer();
+  }
+  if (corrupted) {
+    fail(AsyncSocketException(AsyncSocketException::INTERNAL_ERROR,
+                              "shared memory ring corrupted by peer"));
+    return false;
+  }
+
+  for (WriteCallback* cb : done) {
+    cb->writeSuccess();
+    if (!*alive) {
+      return false;
+    }
+  }
+  if (state_ == State::CLOSING && write_queue_.empty()) {
+    closeNow();
+    return false;
+  }
+  return true;
+}
+
+void ShmSocketAdapter::closeNow() {
+  if (fallback_) {
+    fallback_->closeNow();
+    return;
+  }
+  if (state_ == State::CLOSED || state_ == State::ERROR) {
+    return;
+  }
+  const AsyncSocketException ex(
+      AsyncSocketException::NOT_OPEN, "socket closed locally");
+  const bool was_connecting = state_ == State::CONNECTING;
+  state_ = State::CLOSED;
+  closeFds();
+
+  auto alive = alive_;
+  if (was_connecting && connect_cb_) {
+    auto cb = connect_cb_;
+    connect_cb_ = nullptr;
+    cb->connectErr(ex);
+    if (!*alive) {
+      return;
+    }
+  }
+  failWrites(ex);
+  if (!*alive) {
+    return;
+  }
+  if (read_cb_) {
+    auto cb = read_cb_;
+    read_cb_ = nullptr;
+    cb->readEOF();
+  }
+}
+
+void ShmSocketAdapter::close() {
+  if (fallback_) {
+    fallback_->close();
+    return;
+  }
+  if (write_queue_.empty() || state_ != State::ESTABLISHED || !segment_) {
+    closeNow();
+    return;
+  }
+  state_ = State::CLOSING;
+  if (read_cb_) {
+    auto cb = read_cb_;
+    read_cb_ = nullptr;
+    cb->readEOF();
+  }
+}
+
+bool ShmSocketAdapter::good() const {
+  if (fallback_) {
+    return fallback_->good();
+  }
+  return state_ == State::CONNECTING || state_ == State::ESTABLISHED;
+}
+
+bool ShmSocketAdapter::readable() const {
+  if (fallback_) {
+    return fallback_->readable();
+  }
+  if (segment_ && state_ == State::ESTABLISHED) {
+    return peer_closed_ || rx_->readable() != 0;
+  }
+  if (fd_ < 0) {
+    return false;
+  }
+  pollfd fds[1];
+  fds[0].fd = fd_;
+  fds[0].events = POLLIN;
+  fds[0].revents = 0;
+  return ::poll(fds, 1, 0) == 1;
+}
+
+bool ShmSocketAdapter::writable() const {
+  if (fallback_) {
+    return fallback_->writable();
+  }
+  return good();
+}
+
+bool ShmSocketAdapter::connecting() const {
+  if (fallback_) {
+    return fallback_->connecting();
+  }
+  return state_ == State::CONNECTING;
+}
+
+void ShmSocketAdapter::getLocalAddress(folly::SocketAddress* address) const {
+  address->setFromLocalAddress(getNetworkSocket());
+}
+
+void ShmSocketAdapter::getPeerAddress(folly::SocketAddress* address) const {
+  address->setFromPeerAddress(getNetworkSocket());
+}
+
+folly::NetworkSocket ShmSocketAdapter::getNetworkSocket() const {
+  if (fallback_) {
+    return fallback_->getNetworkSocket();
+  }
+  return folly::NetworkSocket::fromFd(fd_);
+}
+
+size_t ShmSocketAdapter::getRawBytesWritten() const {
+  return fallback_ ? fallback_->getRawBytesWritten() : bytes_written_;
+}
+
+size_t ShmSocketAdapter::getRawBytesReceived() const {
+  return fallback_ ? fallback_->getRawBytesReceived() : bytes_received_;
+}
+
+void ShmSocketAdapter::setReadCB(ReadCallback* callback) {
+  if (fallback_) {
+    fallback_->setReadCB(callback);
+    return;
+  }
+  read_cb_ = callback;
+  if (read_cb_ && (segment_ || state_ == State::ERROR)) {
+    // Data may be waiting in the ring, and the consumer flag needs to be
+    // armed.
+    schedulePass();
+  }
+}
+
+ShmSocketAdapter::ReadCallback* ShmSocketAdapter::getReadCallback() const {
+  return fallback_ ? fallback_->getReadCallback() : read_cb_;
+}
+
+void ShmSocketAdapter::writeChain(WriteCallback* callback,
+                                  std::unique_ptr<folly::IOBuf>&& buf,
+                                  folly::WriteFlags flags) {
+  if (fallback_) {
+    fallback_->writeChain(callback, std::move(buf), flags);
+    return;
+  }
+  if (!good()) {
+    if (callback) {
+      callback->writeErr(
+          0,
+          AsyncSocketException(AsyncSocketException::NOT_OPEN,
+                               "writeChain() called on a closed socket"));
+    }
+    return;
+  }
+  const size_t length = buf ? buf->computeChainDataLength() : 0;
+  if (length == 0) {
+    if (callback) {
+      callback->writeSuccess();
+    }
+    return;
+  }
+  write_queue_.push_back(
+      WriteRequest{callback, std::move(buf), length, length});
+  if (flushWrites() && !write_queue_.empty()) {
+    waitForPeer();
+  }
+}
+
+void ShmSocketAdapter::fail(const AsyncSocketException& ex) {
+  if (state_ == State::CLOSED || state_ == State::ERROR) {
+    return;
+  }
+  const bool was_connecting = state_ == State::CONNECTING;
+  state_ = State::ERROR;
+  error_ = ex;
+  closeFds();
+
+  auto alive = alive_;
+  if (was_connecting && connect_cb_) {
+    auto cb = connect_cb_;
+    connect_cb_ = nullptr;
+    cb->connectErr(ex);
+    if (!*alive) {
+      return;
+    }
+  }
+  failWrites(ex);
+  if (!*alive) {
+    return;
+  }
+  if (read_cb_) {
+    auto cb = read_cb_;
+    read_cb_ = nullptr;
+    cb->readErr(ex);
+  }
+}
+
+void ShmSocketAdapter::failWrites(const AsyncSocketException& ex) {
+  auto queue = std::move(write_queue_);
+  write_queue_.clear();
+
+  auto alive = alive_;
+  for (const WriteRequest& req : queue) {
+    if (req.callback) {
+      req.callback->writeErr(req.length - req.remaining, ex);
+      if (!*alive) {
+        return;
+      }
+    }
+  }
+}
+
+void ShmSocketAdapter::closeFds() {
+  if (connect_timeout_) {
+    // Not destroyed, this may run from its callback.
+    connect_timeout_->cancelTimeout();
+  }
+  notify_handler_.unregisterHandler();
+  if (notify_fd_ >= 0) {
+    ::close(notify_fd_);
+    notify_fd_ = -1;
+  }
+  if (peer_notify_fd_ >= 0) {
+    ::close(peer_notify_fd_);
+    peer_notify_fd_ = -1;
+  }
+  rx_ = nullptr;
+  tx_ = nullptr;
+  segment_.reset();
+  control_handler_.unregisterHandler();
+  if (fd_ >= 0) {
+    // The peer sees EOF on its control socket, reads what is left in its
+    // ring and reports EOF.
+    ::shutdown(fd_, SHUT_RDWR);
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+int ShmSocketAdapter::setSendBufSize(size_t bufsize) {
+  int val = bufsize;
+  return setSockOptVirtual(SOL_SOCKET, SO_SNDBUF, &val, sizeof(val));
+}
+
+int ShmSocketAdapter::setRecvBufSize(size_t bufsize) {
+  int val = bufsize;
+  return setSockOptVirtual(SOL_SOCKET, SO_RCVBUF, &val, sizeof(val));
+}
+
+int ShmSocketAdapter::getSockOptVirtual(int level,
+                                        int optname,
+                                        void* optval,
+                                        socklen_t* optlen) {
+  if (fallback_) {
+    return fallback_->getSockOptVirtual(level, optname, optval, optlen);
+  }
+  return ::getsockopt(fd_, level, optname, optval, optlen);
+}
+
+int ShmSocketAdapter::setSockOptVirtual(int level,
+                                        int optname,
+                                        void const* optval,
+                                        socklen_t optlen) {
+  if (fallback_) {
+    return fallback_->setSockOptVirtual(level, optname, optval, optlen);
+  }
+  return ::setsockopt(fd_, level, optname, optval, optlen);
+}
+
+}} // namespace facebook::logdevice
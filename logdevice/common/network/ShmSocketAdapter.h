@@ -0,0 +1,257 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include <deque>
+#include <memory>
+
+#include <folly/Optional.h>
+#include <folly/io/SocketOptionMap.h>
+#include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/AsyncSocketException.h>
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/EventHandler.h>
+
+#include "logdevice/common/network/ShmRing.h"
+#include "logdevice/common/network/SocketAdapter.h"
+
+namespace facebook { namespace logdevice {
+
+/**
+ * @file SocketAdapter moving the byte stream of a connection between two
+ * processes on the same host through shared memory rings instead of the
+ * kernel's socket buffers.
+ *
+ * The connection is established over a unix domain socket. The connecting
+ * side then creates a ShmSegment and passes it to the accepting side over
+ * that socket (SCM_RIGHTS), preceded by a magic preamble. The accepting side
+ * acknowledges with the two eventfds the sides wake each other up with. It
+ * creates them itself, so it never reads or writes a file descriptor made
+ * by a peer it doesn't trust. From then on, all data goes through the rings:
+ *
+ * - writeChain() copies data into the outgoing ring right away and only
+ *   signals the peer's eventfd if the peer waits for data. Writes that don't
+ *   fit stay queued until the peer signals that it freed space.
+ * - Data is copied from the incoming ring straight into the buffers handed
+ *   out by the ReadCallback. While no callback is installed data stays in
+ *   the ring, which pushes back on the writer.
+ * - The unix socket stays open only to detect the peer closing the
+ *   connection or going away.
+ *
+ * An accepting adapter that sees anything other than the preamble (e.g. a
+ * client that doesn't have shared memory connections enabled) hands the
+ * socket over to an AsyncSocketAdapter, so the same listener serves both.
+ */
+
+class ShmSocketAdapter : public SocketAdapter {
+ public:
+  /**
+   * Create an unconnected socket. connect() must later be called on it with
+   * the address of a unix socket.
+   *
+   * @param ring_size  Size of each of the two rings, see
+   *                   ShmSegment::isValidRingSize().
+   */
+  ShmSocketAdapter(folly::EventBase* evb, size_t ring_size);
+
+  /**
+   * Take over a unix socket returned by accept(), and wait for the peer to
+   * set up shared memory or to start talking plain.
+   */
+  ShmSocketAdapter(folly::EventBase* evb, folly::NetworkSocket fd);
+
+  ~ShmSocketAdapter() override;
+
+  void
+  connect(ConnectCallback* callback,
+          const folly::SocketAddress& address,
+          int timeout = 0,
+          const folly::SocketOptionMap& options = folly::emptySocketOptionMap,
+          const folly::SocketAddress& bindAddr =
+              folly::AsyncSocket::anyAddress()) noexcept override;
+
+  /**
+   * Close the connection immediately. Calls readEOF() on the read callback
+   * if there is one, and writeErr() on all queued writes. The peer reads
+   * what was already written to the ring before seeing EOF.
+   */
+  void closeNow() override;
+
+  /**
+   * Close the connection once queued writes made it to the ring. Stop
+   * reading immediately.
+   */
+  void close() override;
+
+  bool good() const override;
+  bool readable() const override;
+  bool writable() const override;
+  bool connecting() const override;
+
+  void getLocalAddress(folly::SocketAddress* address) const override;
+  void getPeerAddress(folly::SocketAddress* address) const override;
+  folly::NetworkSocket getNetworkSocket() const override;
+
+  size_t getRawBytesWritten() const override;
+  size_t getRawBytesReceived() const override;
+
+  void setReadCB(ReadCallback* callback) override;
+  ReadCallback* getReadCallback() const override;
+
+  void writeChain(WriteCallback* callback,
+                  std::unique_ptr<folly::IOBuf>&& buf,
+                  folly::WriteFlags flags = folly::WriteFlags::NONE) override;
+
+  int setSendBufSize(size_t bufsize) override;
+  int setRecvBufSize(size_t bufsize) override;
+
+  int getSockOptVirtual(int level,
+                        int optname,
+                        void* optval,
+                        socklen_t* optlen) override;
+  int setSockOptVirtual(int level,
+                        int optname,
+                        void const* optval,
+                        socklen_t optlen) override;
+
+  /**
+   * @return  true once data goes through shared memory, false while the
+   *          connection is being set up or if the peer talks plain.
+   */
+  bool usingSharedMemory() const {
+    return segment_ != nullptr;
+  }
+
+ private:
+  enum class State {
+    UNINIT,
+    // Connecting the unix socket, then waiting for the peer to acknowledge
+    // the shared memory setup.
+    CONNECTING,
+    // Connected. For an accepting adapter, the peer may not have sent the
+    // preamble yet.
+    ESTABLISHED,
+    // close() was called, flushing queued writes before closing.
+    CLOSING,
+    CLOSED,
+    ERROR,
+  };
+
+  // Forwards readiness of a file descriptor to a member function.
+  class Handler : public folly::EventHandler {
+   public:
+    Handler(folly::EventBase* evb,
+            ShmSocketAdapter* owner,
+            void (ShmSocketAdapter::*fn)(uint16_t))
+        : folly::EventHandler(evb), owner_(owner), fn_(fn) {}
+
+    void handlerReady(uint16_t events) noexcept override {
+      (owner_->*fn_)(events);
+    }
+
+   private:
+    ShmSocketAdapter* owner_;
+    void (ShmSocketAdapter::*fn_)(uint16_t);
+  };
+
+  struct WriteRequest {
+    WriteCallback* callback;
+    std::unique_ptr<folly::IOBuf> buf;
+    size_t length;
+    // Bytes of buf not yet copied into the ring.
+    size_t remaining;
+  };
+
+  // The preamble the connecting side sends along with the memfd. Its first
+  // four bytes can't be the length of a valid message, so it can't be
+  // confused with a plain connection's first message.
+  struct Preamble {
+    char magic[8];
+    uint32_t version;
+    uint32_t ring_size;
+  } __attribute__((__packed__));
+
+  static const char kMagic[8];
+  static constexpr uint32_t kVersion = 2;
+  static constexpr uint8_t kAck = 1;
+
+  // Control socket events while connecting, while waiting for the
+  // preamble and, once established, to detect the peer going away.
+  void onControlReady(uint16_t events);
+  // The peer signalled our eventfd.
+  void onNotify(uint16_t events);
+
+  // Connecting side: the unix socket is connected, send the preamble.
+  void sendPreamble();
+  // Connecting side: the peer acknowledged, take its eventfds.
+  void onAck();
+  // Accepting side: look at what the peer sent first.
+  void receivePreamble();
+  // Accepting side: the peer is not using shared memory.
+  void switchToFallback();
+  // Starts polling the eventfd and moves pending data in both directions.
+  void startSharedMemory();
+
+  // Hands data from the incoming ring to the read callback, and delivers
+  // EOF once the peer went away and the ring is drained. Returns false if
+  // this adapter was destroyed or failed.
+  bool deliver();
+  // Copies queued writes into the outgoing ring. Returns false if this
+  // adapter was destroyed or failed.
+  bool flushWrites();
+  // Arms the waiting flags of both rings before going back to the event
+  // loop, or schedules another pass if the peer made progress meanwhile.
+  void waitForPeer();
+  void schedulePass();
+  void signalPeer();
+
+  // Moves to ERROR and notifies all callbacks.
+  void fail(const folly::AsyncSocketException& ex);
+  // Fails all queued writes with `ex'.
+  void failWrites(const folly::AsyncSocketException& ex);
+  void closeFds();
+
+  folly::EventBase* evb_;
+  size_t ring_size_{0};
+  const bool accepted_;
+  int fd_{-1};
+  State state_{State::UNINIT};
+
+  Handler control_handler_;
+  Handler notify_handler_;
+  std::unique_ptr<folly::AsyncTimeout> connect_timeout_;
+
+  std::unique_ptr<ShmSegment> segment_;
+  ShmRing* rx_{nullptr};
+  ShmRing* tx_{nullptr};
+  // Eventfd we wait on, and the one the peer waits on. Both are created by
+  // the accepting side.
+  int notify_fd_{-1};
+  int peer_notify_fd_{-1};
+  // The peer closed the connection, what is left in rx_ is all we'll get.
+  bool peer_closed_{false};
+  bool pass_scheduled_{false};
+
+  // Set if the accepting side found out the peer talks plain.
+  std::unique_ptr<SocketAdapter> fallback_;
+
+  ReadCallback* read_cb_{nullptr};
+  ConnectCallback* connect_cb_{nullptr};
+  std::deque<WriteRequest> write_queue_;
+  // Set when state_ is ERROR.
+  folly::Optional<folly::AsyncSocketException> error_;
+
+  size_t bytes_written_{0};
+  size_t bytes_received_{0};
+
+  // Flipped to false in the destructor, so that code that invoked a callback
+  // can tell whether the callback destroyed this adapter.
+  std::shared_ptr<bool> alive_{std::make_shared<bool>(true)};
+};
+
+}} // namespace facebook::logdevice
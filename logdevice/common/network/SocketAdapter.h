@@ -156,6 +156,24 @@ class SocketAdapter {
     return nullptr;
   }
 
+  /**
+   * True if this is a TLS socket whose record encryption was handed to
+   * kernel TLS after the handshake.
+   */
+  virtual bool isKernelTlsEnabled() const {
+    return false;
+  }
+
+  /**
+   * True if a duplicate of getNetworkSocket() can carry on the connection
+   * after this adapter is closed: closing must only close the adapter's own
+   * descriptor, and no data read from the socket may be left behind with the
+   * adapter. Connection migration to another worker relies on this.
+   */
+  virtual bool canDetachFd() const {
+    return false;
+  }
+
   virtual size_t getRawBytesWritten() const = 0;
   virtual size_t getRawBytesReceived() const = 0;
 
@@ -177,6 +195,20 @@ class SocketAdapter {
              std::unique_ptr<folly::IOBuf>&& buf,
              folly::WriteFlags flags = folly::WriteFlags::NONE) = 0;
 
+  /**
+   * Enable or disable MSG_ZEROCOPY for this socket. Once enabled, writes
+   * passed folly::WriteFlags::WRITE_MSG_ZEROCOPY are sent without copying the
+   * data into the socket buffer; the adapter keeps the written IOBufs alive
+   * until the kernel reports it is done with them, which may be long after
+   * writeSuccess().
+   *
+   * @return true if the socket now uses zero-copy sends. Adapters that do not
+   *         support it return false and ignore the flag.
+   */
+  virtual bool setZeroCopy(bool /* enable */) {
+    return false;
+  }
+
   /**
    * Set the send bufsize
    */
@@ -8,12 +8,36 @@
 #pragma once
 
 #include <deque>
+#include <memory>
 
 #include <folly/io/async/AsyncTransport.h>
 
 #include "logdevice/common/IProtocolHandler.h"
 
 namespace facebook { namespace logdevice {
+
+class Connection;
+
+/**
+ * A write sent with MSG_ZEROCOPY. Shared between its WriteUnit and a marker
+ * IOBuf appended to the written chain: the socket destroys the chain only
+ * once the kernel reports it is done reading from it, which can happen before
+ * or after writeSuccess() is processed.
+ */
+struct ZeroCopyWrite {
+  ZeroCopyWrite(size_t len, std::shared_ptr<Connection*> conn)
+      : length(len), owner(std::move(conn)) {}
+
+  const size_t length;
+  // writeSuccess() for this write was processed.
+  bool written{false};
+  // The socket released the written memory.
+  bool released{false};
+  // Connection to notify once the write is both written and released. Set to
+  // nullptr when the connection is closed.
+  const std::shared_ptr<Connection*> owner;
+};
+
 /**
  * SocketWriteCallback instance that can be reused across multiple AsyncSocket
  * write chain invocations. Class members not thread safe.
@@ -57,6 +81,8 @@ class SocketWriteCallback : public folly::AsyncSocket::WriteCallback {
   struct WriteUnit {
     size_t length;
     SteadyTimestamp write_time;
+    // Set if the chain was written with MSG_ZEROCOPY.
+    std::shared_ptr<ZeroCopyWrite> zerocopy;
   };
 
   // A single write callback is shared for all the writes. Hence , when write
@@ -0,0 +1,181 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/network/StreamCompression.h"
+
+#include <zstd.h>
+
+#include "logdevice/common/checks.h"
+#include "logdevice/common/debug.h"
+#include "logdevice/common/util.h"
+#include "logdevice/include/Err.h"
+
+namespace facebook { namespace logdevice {
+
+std::unique_ptr<StreamCompressor> StreamCompressor::create(int level) {
+  ZSTD_CCtx* ctx = ZSTD_createCCtx();
+  if (!ctx) {
+    ld_error("ZSTD_createCCtx() failed");
+    err = E::NOMEM;
+    return nullptr;
+  }
+  size_t rv = ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, level);
+  if (!ZSTD_isError(rv)) {
+    rv = ZSTD_CCtx_setParameter(ctx, ZSTD_c_windowLog, kWindowLog);
+  }
+  if (ZSTD_isError(rv)) {
+    ld_error("Failed to configure zstd stream: %s", ZSTD_getErrorName(rv));
+    ZSTD_freeCCtx(ctx);
+    err = E::INVALID_PARAM;
+    return nullptr;
+  }
+  return std::unique_ptr<StreamCompressor>(new StreamCompressor(ctx));
+}
+
+StreamCompressor::~StreamCompressor() {
+  ZSTD_freeCCtx(ctx_);
+}
+
+std::unique_ptr<folly::IOBuf>
+StreamCompressor::compress(const folly::IOBuf& data) {
+  auto start_time = std::chrono::steady_clock::now();
+  const size_t len = data.computeChainDataLength();
+
+  auto out = folly::IOBuf::create(ZSTD_compressBound(len));
+  folly::IOBuf* tail = out.get();
+  ZSTD_outBuffer output{tail->writableTail(), tail->tailroom(), 0};
+
+  // Feeds `input' to the stream until it is consumed (ZSTD_e_continue) or
+  // everything is flushed (ZSTD_e_flush), growing the output as needed.
+  auto run = [&](ZSTD_inBuffer& input, ZSTD_EndDirective mode) {
+    for (;;) {
+      size_t rv = ZSTD_compressStream2(ctx_, &output, &input, mode);
+      if (ZSTD_isError(rv)) {
+        RATELIMIT_ERROR(std::chrono::seconds(10),
+                        1,
+                        "ZSTD_compressStream2() failed: %s",
+                        ZSTD_getErrorName(rv));
+        return false;
+      }
+      if (output.pos == output.size) {
+        tail->append(output.pos);
+        tail->appendChain(folly::IOBuf::create(ZSTD_CStreamOutSize()));
+        tail = tail->next();
+        output = ZSTD_outBuffer{tail->writableTail(), tail->tailroom(), 0};
+      }
+      if (mode == ZSTD_e_continue ? input.pos == input.size : rv == 0) {
+        return true;
+      }
+    }
+  };
+
+  for (const folly::ByteRange range : data) {
+    ZSTD_inBuffer input{range.data(), range.size(), 0};
+    if (!run(input, ZSTD_e_continue)) {
+      return nullptr;
+    }
+  }
+  ZSTD_inBuffer empty{nullptr, 0, 0};
+  if (!run(empty, ZSTD_e_flush)) {
+    return nullptr;
+  }
+  tail->append(output.pos);
+
+  ++stats_.messages;
+  stats_.raw_bytes += len;
+  stats_.compressed_bytes += out->computeChainDataLength();
+  stats_.time += std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start_time);
+  return out;
+}
+
+std::unique_ptr<StreamDecompressor> StreamDecompressor::create() {
+  ZSTD_DCtx* ctx = ZSTD_createDCtx();
+  if (!ctx) {
+    ld_error("ZSTD_createDCtx() failed");
+    err = E::NOMEM;
+    return nullptr;
+  }
+  // Refuse streams needing a larger window than StreamCompressor uses.
+  size_t rv = ZSTD_DCtx_setParameter(
+      ctx, ZSTD_d_windowLogMax, StreamCompressor::kWindowLog);
+  if (ZSTD_isError(rv)) {
+    ld_error("Failed to configure zstd stream: %s", ZSTD_getErrorName(rv));
+    ZSTD_freeDCtx(ctx);
+    err = E::INVALID_PARAM;
+    return nullptr;
+  }
+  return std::unique_ptr<StreamDecompressor>(new StreamDecompressor(ctx));
+}
+
+StreamDecompressor::~StreamDecompressor() {
+  ZSTD_freeDCtx(ctx_);
+}
+
+std::unique_ptr<folly::IOBuf>
+StreamDecompressor::decompress(folly::io::Cursor cursor,
+                               size_t uncompressed_len) {
+  auto start_time = std::chrono::steady_clock::now();
+  size_t compressed_len = 0;
+
+  auto out = folly::IOBuf::create(uncompressed_len);
+  ZSTD_outBuffer output{out->writableData(), uncompressed_len, 0};
+
+  // Returns false on error or if `input' decompresses to more than
+  // uncompressed_len bytes.
+  auto run = [&](ZSTD_inBuffer& input) {
+    do {
+      const size_t in_pos = input.pos;
+      const size_t out_pos = output.pos;
+      size_t rv = ZSTD_decompressStream(ctx_, &output, &input);
+      if (ZSTD_isError(rv)) {
+        RATELIMIT_ERROR(std::chrono::seconds(10),
+                        1,
+                        "ZSTD_decompressStream() failed: %s",
+                        ZSTD_getErrorName(rv));
+        return false;
+      }
+      if (input.pos == in_pos && output.pos == out_pos) {
+        // No progress. Either the output is full and there is more to come,
+        // or the stream needs more input than we have.
+        return input.pos == input.size;
+      }
+    } while (input.pos < input.size || output.pos < output.size);
+    return true;
+  };
+
+  while (!cursor.isAtEnd()) {
+    const folly::ByteRange range = cursor.peekBytes();
+    ZSTD_inBuffer input{range.data(), range.size(), 0};
+    if (!run(input)) {
+      return nullptr;
+    }
+    compressed_len += range.size();
+    cursor.skip(range.size());
+  }
+  // Whatever zstd kept buffered.
+  ZSTD_inBuffer empty{nullptr, 0, 0};
+  if (!run(empty) || output.pos != uncompressed_len) {
+    RATELIMIT_ERROR(std::chrono::seconds(10),
+                    1,
+                    "Compressed message decompressed to %zu bytes, expected "
+                    "%zu",
+                    output.pos,
+                    uncompressed_len);
+    return nullptr;
+  }
+  out->append(output.pos);
+
+  ++stats_.messages;
+  stats_.raw_bytes += uncompressed_len;
+  stats_.compressed_bytes += compressed_len;
+  stats_.time += std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start_time);
+  return out;
+}
+
+}} // namespace facebook::logdevice
@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include <chrono>
+#include <memory>
+
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
+namespace facebook { namespace logdevice {
+
+/**
+ * @file One direction of the zstd stream that a Connection which negotiated
+ * compression keeps with its peer (see COMPRESSED_Message.h).
+ *
+ * Messages are compressed one at a time, each flushed at the end so that the
+ * peer can decompress it as soon as it arrives, while still referring back
+ * to previously sent messages. This is what makes compressing individual
+ * small messages (e.g. RECORDs with similar headers and payloads) worthwhile.
+ * As a consequence, messages must be decompressed in the order they were
+ * compressed, and a message that was compressed must be sent.
+ *
+ * The window is limited to kWindowLog to bound the memory used by each
+ * connection.
+ */
+
+struct StreamCompressionStats {
+  // Number of messages compressed or decompressed.
+  uint64_t messages{0};
+  // Uncompressed bytes.
+  uint64_t raw_bytes{0};
+  // Compressed bytes.
+  uint64_t compressed_bytes{0};
+  // Time spent compressing or decompressing.
+  std::chrono::microseconds time{0};
+};
+
+class StreamCompressor {
+ public:
+  // Maximum window size (log2) of the stream, 128KB.
+  static constexpr int kWindowLog = 17;
+
+  /**
+   * @return a compressor, or nullptr if zstd failed to allocate a context.
+   */
+  static std::unique_ptr<StreamCompressor> create(int level);
+
+  ~StreamCompressor();
+
+  /**
+   * Compresses `data' and flushes the stream.
+   *
+   * @return the compressed bytes, or nullptr on failure, after which the
+   *         stream is unusable.
+   */
+  std::unique_ptr<folly::IOBuf> compress(const folly::IOBuf& data);
+
+  const StreamCompressionStats& getStats() const {
+    return stats_;
+  }
+
+ private:
+  explicit StreamCompressor(ZSTD_CCtx_s* ctx) : ctx_(ctx) {}
+
+  ZSTD_CCtx_s* ctx_;
+  StreamCompressionStats stats_;
+};
+
+class StreamDecompressor {
+ public:
+  /**
+   * @return a decompressor, or nullptr if zstd failed to allocate a context.
+   */
+  static std::unique_ptr<StreamDecompressor> create();
+
+  ~StreamDecompressor();
+
+  /**
+   * Decompresses all remaining bytes of `cursor', which must decompress to
+   * exactly `uncompressed_len' bytes.
+   *
+   * @return the decompressed bytes, or nullptr if the input is corrupt, after
+   *         which the stream is unusable.
+   */
+  std::unique_ptr<folly::IOBuf> decompress(folly::io::Cursor cursor,
+                                           size_t uncompressed_len);
+
+  const StreamCompressionStats& getStats() const {
+    return stats_;
+  }
+
+ private:
+  explicit StreamDecompressor(ZSTD_DCtx_s* ctx) : ctx_(ctx) {}
+
+  ZSTD_DCtx_s* ctx_;
+  StreamCompressionStats stats_;
+};
+
+}} // namespace facebook::logdevice
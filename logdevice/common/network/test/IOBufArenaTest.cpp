@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/network/IOBufArena.h"
+
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace facebook { namespace logdevice {
+
+TEST(IOBufArenaTest, CarvesFromOneChunk) {
+  IOBufArena arena(8192);
+  std::vector<std::unique_ptr<folly::IOBuf>> bufs;
+  for (size_t size : {1, 100, 333, 1024}) {
+    auto buf = arena.allocate(size);
+    EXPECT_EQ(0, buf->headroom());
+    EXPECT_EQ(0, buf->length());
+    EXPECT_EQ(size, buf->tailroom());
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(buf->data()) %
+                  alignof(std::max_align_t));
+    memset(buf->writableTail(), static_cast<int>(size), size);
+    buf->append(size);
+    bufs.push_back(std::move(buf));
+  }
+  EXPECT_EQ(1, arena.numChunksAllocated());
+
+  // Buffers don't overlap.
+  for (const auto& buf : bufs) {
+    for (size_t i = 0; i < buf->length(); ++i) {
+      ASSERT_EQ(static_cast<uint8_t>(buf->length()), buf->data()[i]);
+    }
+  }
+}
+
+TEST(IOBufArenaTest, NewChunkWhenFull) {
+  IOBufArena arena(IOBufArena::kMaxCarveSize);
+  auto a = arena.allocate(IOBufArena::kMaxCarveSize - 16);
+  EXPECT_EQ(1, arena.numChunksAllocated());
+  auto b = arena.allocate(100);
+  EXPECT_EQ(2, arena.numChunksAllocated());
+  EXPECT_EQ(100, b->tailroom());
+
+  // The first chunk outlives the arena's interest in it.
+  a->append(a->tailroom());
+  memset(a->writableData(), 'a', a->length());
+  b.reset();
+  auto c = arena.allocate(100);
+  EXPECT_EQ(2, arena.numChunksAllocated());
+  EXPECT_EQ('a', a->data()[a->length() - 1]);
+}
+
+TEST(IOBufArenaTest, LargeBuffersAreNotCarved) {
+  IOBufArena arena;
+  auto buf = arena.allocate(IOBufArena::kMaxCarveSize + 1);
+  EXPECT_GE(buf->tailroom(), IOBufArena::kMaxCarveSize + 1);
+  EXPECT_EQ(0, arena.numChunksAllocated());
+}
+
+TEST(IOBufArenaTest, BuffersOutliveArena) {
+  std::unique_ptr<folly::IOBuf> buf;
+  {
+    IOBufArena arena;
+    buf = arena.allocate(64);
+  }
+  // Cloning shares the chunk reference, destroying both must free it once
+  // (checked by ASAN).
+  memset(buf->writableTail(), 'x', 64);
+  buf->append(64);
+  auto clone = buf->clone();
+  buf.reset();
+  EXPECT_EQ('x', clone->data()[63]);
+}
+
+}} // namespace facebook::logdevice
@@ -0,0 +1,161 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/network/IoUringSocketAdapter.h"
+
+#include <string>
+
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/EventBase.h>
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#if LOGDEVICE_HAVE_LIBURING
+
+namespace facebook { namespace logdevice {
+
+namespace {
+
+class TestReadCallback : public folly::AsyncSocket::ReadCallback {
+ public:
+  void getReadBuffer(void** bufReturn, size_t* lenReturn) override {
+    *bufReturn = buf_;
+    *lenReturn = sizeof(buf_);
+  }
+  void readDataAvailable(size_t len) noexcept override {
+    data.append(buf_, len);
+  }
+  void readEOF() noexcept override {
+    eof = true;
+  }
+  void readErr(const folly::AsyncSocketException&) noexcept override {
+    error = true;
+  }
+
+  std::string data;
+  bool eof{false};
+  bool error{false};
+
+ private:
+  char buf_[100];
+};
+
+class TestWriteCallback : public folly::AsyncSocket::WriteCallback {
+ public:
+  void writeSuccess() noexcept override {
+    ++nsuccess;
+  }
+  void writeErr(size_t,
+                const folly::AsyncSocketException&) noexcept override {
+    ++nerrors;
+  }
+
+  int nsuccess{0};
+  int nerrors{0};
+};
+
+class IoUringSocketAdapterTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    ctx_ = IoUringContext::create(&evb_, IoUringContext::Options());
+    if (!ctx_) {
+      GTEST_SKIP() << "io_uring is not available";
+    }
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    adapter_ = std::make_unique<IoUringSocketAdapter>(
+        ctx_, folly::NetworkSocket::fromFd(fds[0]));
+    peer_fd_ = fds[1];
+  }
+
+  void TearDown() override {
+    adapter_.reset();
+    ctx_.reset();
+    if (peer_fd_ >= 0) {
+      ::close(peer_fd_);
+    }
+  }
+
+ protected:
+  // Loops until `pred' is true or the EventBase runs out of work.
+  template <typename Pred>
+  void loopUntil(Pred pred) {
+    while (!pred() && evb_.loopOnce()) {
+    }
+  }
+
+  folly::EventBase evb_;
+  std::shared_ptr<IoUringContext> ctx_;
+  std::unique_ptr<IoUringSocketAdapter> adapter_;
+  int peer_fd_{-1};
+};
+
+} // namespace
+
+TEST_F(IoUringSocketAdapterTest, WriteAndRead) {
+  TestWriteCallback write_cb;
+  adapter_->writeChain(&write_cb, folly::IOBuf::copyBuffer("hello "));
+  auto chain = folly::IOBuf::copyBuffer("io");
+  chain->prependChain(folly::IOBuf::copyBuffer("_uring"));
+  adapter_->writeChain(&write_cb, std::move(chain));
+  loopUntil([&] { return write_cb.nsuccess == 2; });
+  EXPECT_EQ(2, write_cb.nsuccess);
+  EXPECT_EQ(0, write_cb.nerrors);
+  EXPECT_EQ(14, adapter_->getRawBytesWritten());
+
+  char buf[64];
+  ASSERT_EQ(14, ::read(peer_fd_, buf, sizeof(buf)));
+  EXPECT_EQ("hello io_uring", std::string(buf, 14));
+
+  // More than fits in the read callback's buffer at once.
+  const std::string payload(1000, 'x');
+  ASSERT_EQ(payload.size(), ::write(peer_fd_, payload.data(), payload.size()));
+  TestReadCallback read_cb;
+  adapter_->setReadCB(&read_cb);
+  loopUntil([&] { return read_cb.data.size() == payload.size(); });
+  EXPECT_EQ(payload, read_cb.data);
+  EXPECT_EQ(payload.size(), adapter_->getRawBytesReceived());
+
+  ::close(peer_fd_);
+  peer_fd_ = -1;
+  loopUntil([&] { return read_cb.eof; });
+  EXPECT_TRUE(read_cb.eof);
+  EXPECT_FALSE(read_cb.error);
+}
+
+TEST_F(IoUringSocketAdapterTest, DataReceivedWithoutReadCallback) {
+  TestReadCallback read_cb;
+  adapter_->setReadCB(&read_cb);
+  ASSERT_EQ(3, ::write(peer_fd_, "abc", 3));
+  loopUntil([&] { return read_cb.data.size() == 3; });
+  adapter_->setReadCB(nullptr);
+
+  // Data arriving now is kept until a callback is installed again.
+  ASSERT_EQ(3, ::write(peer_fd_, "def", 3));
+  evb_.loopOnce(EVLOOP_NONBLOCK);
+  adapter_->setReadCB(&read_cb);
+  loopUntil([&] { return read_cb.data.size() == 6; });
+  EXPECT_EQ("abcdef", read_cb.data);
+}
+
+TEST_F(IoUringSocketAdapterTest, CloseNowFailsQueuedWrites) {
+  TestWriteCallback write_cb;
+  adapter_->writeChain(&write_cb, folly::IOBuf::copyBuffer("abc"));
+  adapter_->closeNow();
+  EXPECT_EQ(0, write_cb.nsuccess);
+  EXPECT_EQ(1, write_cb.nerrors);
+  EXPECT_FALSE(adapter_->good());
+  // Outstanding operations must complete without touching the adapter.
+  adapter_.reset();
+  evb_.loop();
+  EXPECT_EQ(0, ctx_->getNumInflightOps());
+}
+
+}} // namespace facebook::logdevice
+
+#endif // LOGDEVICE_HAVE_LIBURING
@@ -0,0 +1,319 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/network/ShmSocketAdapter.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <folly/SocketAddress.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/EventBase.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "logdevice/common/network/ShmRing.h"
+#include "logdevice/include/Err.h"
+
+namespace facebook { namespace logdevice {
+
+namespace {
+
+class TestReadCallback : public folly::AsyncSocket::ReadCallback {
+ public:
+  void getReadBuffer(void** bufReturn, size_t* lenReturn) override {
+    *bufReturn = buf_;
+    *lenReturn = sizeof(buf_);
+  }
+  void readDataAvailable(size_t len) noexcept override {
+    data.append(buf_, len);
+  }
+  void readEOF() noexcept override {
+    eof = true;
+  }
+  void readErr(const folly::AsyncSocketException&) noexcept override {
+    error = true;
+  }
+
+  std::string data;
+  bool eof{false};
+  bool error{false};
+
+ private:
+  char buf_[100];
+};
+
+class TestWriteCallback : public folly::AsyncSocket::WriteCallback {
+ public:
+  void writeSuccess() noexcept override {
+    ++nsuccess;
+  }
+  void writeErr(size_t,
+                const folly::AsyncSocketException&) noexcept override {
+    ++nerrors;
+  }
+
+  int nsuccess{0};
+  int nerrors{0};
+};
+
+class TestConnectCallback : public folly::AsyncSocket::ConnectCallback {
+ public:
+  void connectSuccess() noexcept override {
+    connected = true;
+  }
+  void connectErr(const folly::AsyncSocketException&) noexcept override {
+    error = true;
+  }
+
+  bool connected{false};
+  bool error{false};
+};
+
+class ShmSocketAdapterTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    path_ = (dir_.path() / "sock").string();
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    ASSERT_GE(listen_fd_, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    ASSERT_LT(path_.size(), sizeof(addr.sun_path));
+    strcpy(addr.sun_path, path_.c_str());
+    ASSERT_EQ(
+        0,
+        ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+    ASSERT_EQ(0, ::listen(listen_fd_, 16));
+  }
+
+  void TearDown() override {
+    client_.reset();
+    server_.reset();
+    if (listen_fd_ >= 0) {
+      ::close(listen_fd_);
+    }
+  }
+
+ protected:
+  // Connects a shared memory client to an accepting adapter.
+  void connect(size_t ring_size = 4096) {
+    client_ = std::make_unique<ShmSocketAdapter>(&evb_, ring_size);
+    client_->connect(
+        &connect_cb_, folly::SocketAddress::makeFromPath(path_), 1000);
+    int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK);
+    ASSERT_GE(fd, 0);
+    server_ = std::make_unique<ShmSocketAdapter>(
+        &evb_, folly::NetworkSocket::fromFd(fd));
+    loopUntil([&] { return connect_cb_.connected || connect_cb_.error; });
+    ASSERT_TRUE(connect_cb_.connected);
+    ASSERT_TRUE(client_->usingSharedMemory());
+    ASSERT_TRUE(server_->usingSharedMemory());
+  }
+
+  // Loops until `pred' is true or the EventBase runs out of work.
+  template <typename Pred>
+  void loopUntil(Pred pred) {
+    while (!pred() && evb_.loopOnce()) {
+    }
+  }
+
+  folly::EventBase evb_;
+  folly::test::TemporaryDirectory dir_;
+  std::string path_;
+  int listen_fd_{-1};
+  TestConnectCallback connect_cb_;
+  std::unique_ptr<ShmSocketAdapter> client_;
+  std::unique_ptr<ShmSocketAdapter> server_;
+};
+
+} // namespace
+
+TEST_F(ShmSocketAdapterTest, WriteAndRead) {
+  connect();
+  TestReadCallback server_read;
+  server_->setReadCB(&server_read);
+  TestWriteCallback write_cb;
+  client_->writeChain(&write_cb, folly::IOBuf::copyBuffer("hello "));
+  auto chain = folly::IOBuf::copyBuffer("shared");
+  chain->prependChain(folly::IOBuf::copyBuffer(" memory"));
+  client_->writeChain(&write_cb, std::move(chain));
+  // Writes that fit in the ring complete right away.
+  EXPECT_EQ(2, write_cb.nsuccess);
+  EXPECT_EQ(19, client_->getRawBytesWritten());
+  loopUntil([&] { return server_read.data.size() == 19; });
+  EXPECT_EQ("hello shared memory", server_read.data);
+  EXPECT_EQ(19, server_->getRawBytesReceived());
+
+  TestReadCallback client_read;
+  client_->setReadCB(&client_read);
+  server_->writeChain(&write_cb, folly::IOBuf::copyBuffer("reply"));
+  loopUntil([&] { return client_read.data.size() == 5; });
+  EXPECT_EQ("reply", client_read.data);
+
+  // Data written before closing is read before EOF.
+  client_->writeChain(&write_cb, folly::IOBuf::copyBuffer("bye"));
+  client_->closeNow();
+  loopUntil([&] { return server_read.eof; });
+  EXPECT_EQ("hello shared memorybye", server_read.data);
+  EXPECT_TRUE(server_read.eof);
+  EXPECT_FALSE(server_read.error);
+  EXPECT_EQ(0, write_cb.nerrors);
+}
+
+TEST_F(ShmSocketAdapterTest, WritesWaitForSpaceInRing) {
+  connect(/* ring_size */ 4096);
+  // More than the ring holds, while nobody reads.
+  const std::string payload(10000, 'x');
+  TestWriteCallback write_cb;
+  client_->writeChain(&write_cb, folly::IOBuf::copyBuffer(payload));
+  evb_.loopOnce(EVLOOP_NONBLOCK);
+  EXPECT_EQ(0, write_cb.nsuccess);
+  EXPECT_EQ(4096, client_->getRawBytesWritten());
+
+  TestReadCallback read_cb;
+  server_->setReadCB(&read_cb);
+  loopUntil([&] {
+    return write_cb.nsuccess == 1 && read_cb.data.size() == payload.size();
+  });
+  EXPECT_EQ(payload, read_cb.data);
+  EXPECT_EQ(1, write_cb.nsuccess);
+  EXPECT_EQ(0, write_cb.nerrors);
+}
+
+TEST_F(ShmSocketAdapterTest, PlainPeer) {
+  // A client that doesn't use shared memory.
+  int fds[2];
+  ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  server_ = std::make_unique<ShmSocketAdapter>(
+      &evb_, folly::NetworkSocket::fromFd(fds[0]));
+  TestReadCallback read_cb;
+  server_->setReadCB(&read_cb);
+  // Queued until the adapter knows how the peer talks.
+  TestWriteCallback write_cb;
+  server_->writeChain(&write_cb, folly::IOBuf::copyBuffer("hi"));
+
+  // Starts like the magic, but isn't.
+  ASSERT_EQ(5, ::write(fds[1], "LDxyz", 5));
+  loopUntil([&] { return read_cb.data.size() == 5 && write_cb.nsuccess; });
+  EXPECT_EQ("LDxyz", read_cb.data);
+  EXPECT_FALSE(server_->usingSharedMemory());
+  char buf[16];
+  ASSERT_EQ(2, ::read(fds[1], buf, sizeof(buf)));
+  EXPECT_EQ("hi", std::string(buf, 2));
+
+  ::close(fds[1]);
+  loopUntil([&] { return read_cb.eof; });
+  EXPECT_TRUE(read_cb.eof);
+}
+
+TEST_F(ShmSocketAdapterTest, PeerWithoutSharedMemory) {
+  // The listener closes the connection without acknowledging the setup.
+  client_ = std::make_unique<ShmSocketAdapter>(&evb_, 4096);
+  client_->connect(
+      &connect_cb_, folly::SocketAddress::makeFromPath(path_), 1000);
+  int fd = ::accept4(listen_fd_, nullptr, nullptr, 0);
+  ASSERT_GE(fd, 0);
+  ::close(fd);
+  loopUntil([&] { return connect_cb_.connected || connect_cb_.error; });
+  EXPECT_TRUE(connect_cb_.error);
+  EXPECT_FALSE(client_->good());
+}
+
+TEST_F(ShmSocketAdapterTest, RejectsAckWithoutEventFds) {
+  // The listener acknowledges the setup, but passes pipes instead of the
+  // eventfds the sides wake each other up with.
+  client_ = std::make_unique<ShmSocketAdapter>(&evb_, 4096);
+  client_->connect(
+      &connect_cb_, folly::SocketAddress::makeFromPath(path_), 1000);
+  int fd = ::accept4(listen_fd_, nullptr, nullptr, 0);
+  ASSERT_GE(fd, 0);
+  int pipe_fds[2];
+  ASSERT_EQ(0, ::pipe(pipe_fds));
+
+  char ack = 1;
+  iovec iov{&ack, 1};
+  union {
+    char buf[CMSG_SPACE(sizeof(pipe_fds))];
+    cmsghdr align;
+  } control;
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(pipe_fds));
+  memcpy(CMSG_DATA(cmsg), pipe_fds, sizeof(pipe_fds));
+  ASSERT_EQ(1, ::sendmsg(fd, &msg, 0));
+
+  loopUntil([&] { return connect_cb_.connected || connect_cb_.error; });
+  EXPECT_TRUE(connect_cb_.error);
+  EXPECT_FALSE(client_->good());
+  ::close(pipe_fds[0]);
+  ::close(pipe_fds[1]);
+  ::close(fd);
+}
+
+TEST(ShmRingTest, SegmentIsShared) {
+  auto segment = ShmSegment::create(4096);
+  ASSERT_NE(nullptr, segment);
+  // The peer's view of the same memory.
+  auto peer = ShmSegment::attach(::dup(segment->fd()), 4096);
+  ASSERT_NE(nullptr, peer);
+
+  EXPECT_EQ(5, segment->creatorToAttacher().write("hello", 5));
+  EXPECT_EQ(5, peer->creatorToAttacher().readable());
+  char buf[8];
+  EXPECT_EQ(5, peer->creatorToAttacher().read(buf, sizeof(buf)));
+  EXPECT_EQ("hello", std::string(buf, 5));
+  EXPECT_EQ(0, segment->attacherToCreator().readable());
+
+  // Rings larger than the memfd, or a memfd that could shrink, are refused.
+  EXPECT_EQ(nullptr, ShmSegment::attach(::dup(segment->fd()), 8192));
+  int fd = ::memfd_create("test", MFD_CLOEXEC);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(0, ::ftruncate(fd, 1 << 20));
+  EXPECT_EQ(nullptr, ShmSegment::attach(fd, 4096));
+}
+
+TEST(ShmRingTest, RejectsCorruptedPositions) {
+  ShmRingControl ctl{};
+  std::vector<uint8_t> data(4096);
+  ShmRing producer(&ctl, data.data(), data.size());
+  ShmRing consumer(&ctl, data.data(), data.size());
+
+  // Wraps around the end of the ring.
+  const std::string payload(3000, 'x');
+  char buf[4096];
+  EXPECT_EQ(3000, producer.write(payload.data(), payload.size()));
+  EXPECT_EQ(3000, consumer.read(buf, sizeof(buf)));
+  EXPECT_EQ(3000, producer.write(payload.data(), payload.size()));
+  EXPECT_EQ(1096, producer.write(payload.data(), payload.size()));
+  EXPECT_EQ(0, producer.write(payload.data(), payload.size()));
+  EXPECT_EQ(4096, consumer.read(buf, sizeof(buf)));
+  EXPECT_EQ(payload, std::string(buf, 3000));
+
+  // A producer claiming to have written more than the ring holds.
+  ctl.tail.store(ctl.tail.load() + 4097);
+  EXPECT_EQ(-1, consumer.readable());
+  EXPECT_EQ(E::BADMSG, err);
+  EXPECT_EQ(-1, consumer.read(buf, sizeof(buf)));
+
+  // A consumer claiming to have read data that was never written.
+  ctl.head.store(ctl.head.load() + 5000);
+  EXPECT_EQ(-1, producer.write("a", 1));
+  EXPECT_EQ(E::BADMSG, err);
+}
+
+}} // namespace facebook::logdevice
@@ -50,6 +50,11 @@ struct ACK_Header {
   // INTERNAL             If some internal error in the recipient is preventing
   //                      it from accepting the connection.
   Status status;
+
+  // If set, both sides may send COMPRESSED messages wrapping a zstd stream
+  // over the connection. Only set in response to a HELLO with
+  // HELLO_Header::COMPRESSION_ZSTD.
+  static constexpr uint64_t COMPRESSION_ZSTD = 1ul << 0;
 } __attribute__((__packed__));
 
 using ACK_Message =
@@ -23,6 +23,7 @@
 #include "logdevice/common/Checksum.h"
 #include "logdevice/common/MetaDataLogWriter.h"
 #include "logdevice/common/Processor.h"
+#include "logdevice/common/Tracepoints.h"
 #include "logdevice/common/Worker.h"
 #include "logdevice/common/debug.h"
 #include "logdevice/common/plugin/PluginRegistry.h"
@@ -49,10 +50,16 @@ void APPEND_Message::serialize(ProtocolWriter& writer) const {
     proto_supported_header.flags &= ~(APPEND_Header::WRITE_STREAM_REQUEST |
                                       APPEND_Header::WRITE_STREAM_RESUME);
   }
+  if (writer.proto() < Compatibility::ProtocolVersion::APPEND_LATENCY_TRACE) {
+    proto_supported_header.flags &= ~APPEND_Header::LATENCY_TRACE;
+  }
   writer.write(proto_supported_header);
   if (header_.flags & APPEND_Header::LSN_BEFORE_REDIRECT) {
     writer.write(lsn_before_redirect_);
   }
+  if (proto_supported_header.flags & APPEND_Header::LATENCY_TRACE) {
+    writer.write(latency_trace_);
+  }
 
   if (header_.flags & APPEND_Header::CUSTOM_KEY) {
     uint8_t optional_keys_length = attrs_.optional_keys.size();
@@ -144,6 +151,15 @@ MessageReadResult APPEND_Message::deserialize(ProtocolReader& reader) {
     reader.read(&lsn_before_redirect);
   }
 
+  AppendLatencyTrace latency_trace{0, 0};
+  if (reader.proto() >= Compatibility::ProtocolVersion::APPEND_LATENCY_TRACE) {
+    if (header.flags & APPEND_Header::LATENCY_TRACE) {
+      reader.read(&latency_trace);
+    }
+  } else {
+    header.flags &= ~APPEND_Header::LATENCY_TRACE;
+  }
+
   AppendAttributes attrs;
 
   if (header.flags & APPEND_Header::CUSTOM_KEY) {
@@ -190,8 +206,10 @@ MessageReadResult APPEND_Message::deserialize(ProtocolReader& reader) {
   PayloadHolder ph = PayloadHolder::deserialize(reader, payload_size);
 
   return reader.result([&] {
-    return new APPEND_Message(
+    auto msg = new APPEND_Message(
         header, lsn_before_redirect, std::move(attrs), std::move(ph), req_id);
+    msg->latency_trace_ = latency_trace;
+    return msg;
   });
 }
 
@@ -204,6 +222,7 @@ Message::Disposition APPEND_Message::onReceived(const Address& from) {
   StatsHolder* stats = Worker::stats();
   STAT_INCR(stats, append_received);
   STAT_ADD(stats, append_payload_bytes, payload_size);
+  tracepoints::appendReceived(header_.logid, payload_size);
   // Bump the per-log-group stats
   if (auto log_path = Worker::getConfig()->getLogGroupPath(header_.logid)) {
     LOG_GROUP_TIME_SERIES_ADD(
@@ -222,6 +241,9 @@ Message::Disposition APPEND_Message::onReceived(const Address& from) {
   if (header_.flags & APPEND_Header::WRITE_STREAM_REQUEST) {
     append_prep->setWriteStreamRequestId(write_stream_request_id_);
   }
+  if (header_.flags & APPEND_Header::LATENCY_TRACE) {
+    append_prep->setLatencyTrace(latency_trace_);
+  }
   append_prep->execute();
 
   return Disposition::NORMAL;
@@ -277,6 +299,7 @@ APPEND_Message::getDebugInfo() const {
     FLAG(CUSTOM_KEY)
     FLAG(NO_ACTIVATION)
     FLAG(CUSTOM_COUNTERS)
+    FLAG(LATENCY_TRACE)
 #undef FLAG
     return folly::join('|', strings);
   };
@@ -290,6 +313,10 @@ APPEND_Message::getDebugInfo() const {
   add("client_timeout_ms", header_.timeout_ms);
   add("flags", flagsToString(header_.flags));
   add("lsn_before_redirect", lsn_to_string(lsn_before_redirect_));
+  if (header_.flags & APPEND_Header::LATENCY_TRACE) {
+    add("latency_trace_id", latency_trace_.trace_id);
+    add("client_queue_us", latency_trace_.client_queue_us);
+  }
   add("payload_size", payload_.size());
   if (!attrs_.optional_keys.empty()) {
     folly::dynamic map{folly::dynamic::object()};
@@ -71,6 +71,11 @@ struct APPEND_Header {
 
   static constexpr APPEND_flags_t CUSTOM_COUNTERS = 1u << 10; // 1024
 
+  // The append was sampled for a latency breakdown. An AppendLatencyTrace
+  // follows the header on the wire. The sequencer times each stage of the
+  // append and asks storage nodes to do the same.
+  static constexpr APPEND_flags_t LATENCY_TRACE = 1u << 11; // 2048
+
   // Append request belongs to a stream.
   static constexpr APPEND_flags_t WRITE_STREAM_REQUEST = 1u << 12; // 4096
   // Used by stream writer to denote that the append message is next in
@@ -80,6 +85,16 @@ struct APPEND_Header {
   static constexpr APPEND_flags_t FORCE = NO_REDIRECT | REACTIVATE_IF_PREEMPTED;
 } __attribute__((__packed__));
 
+// Trace context of an append sampled for a latency breakdown, see
+// Settings::append_latency_breakdown_sample_rate.
+struct AppendLatencyTrace {
+  // Random id chosen by the client. Joins the client's trace of the append
+  // with the sequencer's.
+  uint64_t trace_id;
+  // Time between the creation of the AppendRequest and sending this APPEND.
+  uint32_t client_queue_us;
+} __attribute__((__packed__));
+
 class APPEND_Message : public Message {
  public:
   APPEND_Message(const APPEND_Header& header,
@@ -117,12 +132,21 @@ class APPEND_Message : public Message {
   Disposition onReceived(const Address& from) override;
   bool cancelled() const override;
 
+  bool hasBufferedWriterPayload() const override {
+    return header_.flags & APPEND_Header::BUFFERED_WRITER_BLOB;
+  }
+
   static Message::deserializer_t deserialize;
 
   int8_t getExecutorPriority() const override {
     return folly::Executor::HI_PRI;
   }
 
+  // Sets the trace context sent if header_ has the LATENCY_TRACE flag.
+  void setLatencyTrace(const AppendLatencyTrace& trace) {
+    latency_trace_ = trace;
+  }
+
   const APPEND_Header header_;
 
   virtual std::vector<std::pair<std::string, folly::dynamic>>
@@ -146,6 +170,9 @@ class APPEND_Message : public Message {
   write_stream_request_id_t write_stream_request_id_ =
       WRITE_STREAM_REQUEST_ID_INVALID;
 
+  // Latency trace context, if the LATENCY_TRACE flag is set
+  AppendLatencyTrace latency_trace_{0, 0};
+
   friend class ChecksumTest;
   friend class MessageSerializationTest;
   friend class E2ETracingSerializationTest;
@@ -0,0 +1,47 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/protocol/COMPRESSED_Message.h"
+
+#include "logdevice/common/Sender.h"
+#include "logdevice/common/protocol/ProtocolReader.h"
+#include "logdevice/common/protocol/ProtocolWriter.h"
+
+namespace facebook { namespace logdevice {
+
+COMPRESSED_Message::COMPRESSED_Message(const COMPRESSED_Header& header,
+                                       std::unique_ptr<folly::IOBuf> payload)
+    : Message(MessageType::COMPRESSED, TrafficClass::HANDSHAKE),
+      header_(header),
+      payload_(std::move(payload)) {}
+
+void COMPRESSED_Message::serialize(ProtocolWriter&) const {
+  // Connection builds COMPRESSED messages directly from the output of its
+  // compression stream and never sends a COMPRESSED_Message.
+  ld_check(false);
+}
+
+MessageReadResult COMPRESSED_Message::deserialize(ProtocolReader& reader) {
+  COMPRESSED_Header hdr;
+  reader.read(&hdr);
+  auto payload = std::make_unique<folly::IOBuf>();
+  reader.readIOBuf(payload.get(), reader.bytesRemaining());
+  return reader.result(
+      [&] { return new COMPRESSED_Message(hdr, std::move(payload)); });
+}
+
+Message::Disposition COMPRESSED_Message::onReceived(const Address& from) {
+  RATELIMIT_ERROR(std::chrono::seconds(10),
+                  1,
+                  "PROTOCOL ERROR: got a COMPRESSED message from %s that the "
+                  "connection did not unwrap",
+                  Sender::describeConnection(from).c_str());
+  err = E::PROTO;
+  return Disposition::ERROR;
+}
+
+}} // namespace facebook::logdevice
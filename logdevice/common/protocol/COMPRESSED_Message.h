@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include <folly/io/IOBuf.h>
+
+#include "logdevice/common/protocol/Message.h"
+
+namespace facebook { namespace logdevice {
+
+/**
+ * @file COMPRESSED wraps another message whose body was compressed with the
+ *       zstd stream of the connection it was sent on. Each connection that
+ *       negotiated compression in HELLO/ACK (see HELLO_Header::COMPRESSION_ZSTD)
+ *       keeps one compression stream per direction. A COMPRESSED message
+ *       carries the bytes the sender's stream produced for one message body,
+ *       flushed so that the recipient can decompress it right away.
+ *
+ *       Connection unwraps COMPRESSED messages before deserializing them, so
+ *       that the rest of the system only ever sees the inner message.
+ */
+
+struct COMPRESSED_Header {
+  // type of the wrapped message
+  MessageType type;
+
+  // checksum of the uncompressed body of the wrapped message, as it would
+  // have been set in ProtocolHeader::cksum had it been sent uncompressed
+  uint64_t cksum;
+
+  // size of the uncompressed body of the wrapped message
+  uint32_t uncompressed_len;
+} __attribute__((__packed__));
+
+class COMPRESSED_Message : public Message {
+ public:
+  COMPRESSED_Message(const COMPRESSED_Header& header,
+                     std::unique_ptr<folly::IOBuf> payload);
+
+  COMPRESSED_Message(const COMPRESSED_Message&) noexcept = delete;
+  COMPRESSED_Message& operator=(const COMPRESSED_Message&) = delete;
+
+  // Never called: Connection writes COMPRESSED messages itself, see
+  // Connection::compressMessageBody().
+  void serialize(ProtocolWriter&) const override;
+  static Message::deserializer_t deserialize;
+
+  // COMPRESSED messages are unwrapped by Connection and never dispatched.
+  Disposition onReceived(const Address& from) override;
+
+  uint16_t getMinProtocolVersion() const override {
+    return Compatibility::CONNECTION_COMPRESSION_SUPPORT;
+  }
+
+  COMPRESSED_Header header_;
+  // compressed body of the wrapped message
+  std::unique_ptr<folly::IOBuf> payload_;
+};
+
+}} // namespace facebook::logdevice
@@ -53,6 +53,14 @@ enum ProtocolVersion : uint16_t {
 
   GET_RSM_SNAPSHOT_MESSAGE_SUPPORT, // = 103
 
+  // Connections may negotiate zstd compression of the message stream in
+  // HELLO/ACK and then send COMPRESSED messages
+  CONNECTION_COMPRESSION_SUPPORT, // = 104
+
+  // Sampled appends carry a latency trace in APPEND and STORE, and storage
+  // nodes report per-stage timings of traced STOREs in STORED
+  APPEND_LATENCY_TRACE, // = 105
+
   // NOTE: insert new protocol versions here
 
   // Maximum version number of the protocol this version of LogDevice
@@ -77,6 +85,8 @@ static_assert(HEALTH_MONITOR_SUPPORT_IN_GOSSIP == 100, "");
 static_assert(NODE_STATUS_AND_HASHMAP_SUPPORT_IN_CLUSTER_STATE == 101, "");
 static_assert(INCLUDE_VERSIONS_IN_GOSSIP == 102, "");
 static_assert(GET_RSM_SNAPSHOT_MESSAGE_SUPPORT == 103, "");
+static_assert(CONNECTION_COMPRESSION_SUPPORT == 104, "");
+static_assert(APPEND_LATENCY_TRACE == 105, "");
 
 constexpr uint16_t MIN_PROTOCOL_SUPPORTED = PROTOCOL_VERSION_LOWER_BOUND + 1;
 constexpr uint16_t MAX_PROTOCOL_SUPPORTED = PROTOCOL_VERSION_UPPER_BOUND - 1;
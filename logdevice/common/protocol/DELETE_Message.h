@@ -46,6 +46,9 @@ class DELETE_Message : public Message {
   void serialize(ProtocolWriter&) const override;
   Disposition onReceived(const Address&) override;
   static Message::deserializer_t deserialize;
+  logid_t getStripingLogID() const override {
+    return header_.rid.logid;
+  }
 
   const DELETE_Header& getHeader() const {
     return header_;
@@ -456,6 +456,11 @@ Message::Disposition HELLO_Message::onReceived(const Address& from) {
     }
   }
 
+  if (ackhdr.status == E::OK &&
+      acceptsCompression(ackhdr.proto, Worker::settings())) {
+    ackhdr.options |= ACK_Header::COMPRESSION_ZSTD;
+  }
+
   return sendReply(ackhdr,
                    from,
                    !(header_.flags & HELLO_Header::SOURCE_NODE),
@@ -463,6 +468,13 @@ Message::Disposition HELLO_Message::onReceived(const Address& from) {
                    build_info);
 }
 
+bool HELLO_Message::acceptsCompression(uint16_t proto,
+                                       const Settings& settings) const {
+  return (header_.flags & HELLO_Header::COMPRESSION_ZSTD) &&
+      settings.connection_compression &&
+      proto >= Compatibility::CONNECTION_COMPRESSION_SUPPORT;
+}
+
 MessageReadResult HELLO_Message::deserialize(ProtocolReader& reader) {
   std::unique_ptr<HELLO_Message> message(new HELLO_Message());
   reader.read(const_cast<HELLO_Header*>(&message->header_));
@@ -13,6 +13,8 @@
 
 namespace facebook { namespace logdevice {
 
+struct Settings;
+
 /**
  * @file HELLO is the first message that LogDevice clients and nodes
  *       send into a new connection that they just actively opened. Its
@@ -66,6 +68,11 @@ struct HELLO_Header {
 
   // If set, HELLO message will include the client location
   static constexpr HELLO_flags_t CLIENT_LOCATION = 1ul << 5;
+
+  // If set, the client is able to compress the message stream with zstd and
+  // asks the server to do so too. The server agrees by setting
+  // ACK_Header::COMPRESSION_ZSTD in its reply.
+  static constexpr HELLO_flags_t COMPRESSION_ZSTD = 1ul << 6;
 } __attribute__((__packed__));
 
 /**
@@ -83,6 +90,14 @@ class HELLO_Message : public Message {
   static Message::deserializer_t deserialize;
   Disposition onReceived(const Address& from) override;
 
+  /**
+   * @return true if the server agrees to compress the message stream of the
+   *         connection this HELLO was received on (see
+   *         HELLO_Header::COMPRESSION_ZSTD), given the negotiated protocol
+   *         and the server's settings.
+   */
+  bool acceptsCompression(uint16_t proto, const Settings& settings) const;
+
   // fixed-size header
   const HELLO_Header header_;
 
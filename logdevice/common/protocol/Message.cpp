@@ -29,12 +29,16 @@ void Message::onSent(Status st,
   onSent(st, to);
 }
 
-size_t Message::size(uint16_t proto) const {
+size_t Message::size(uint16_t proto, size_t* copied_bytes) const {
   ProtocolWriter writer(type_, static_cast<folly::IOBuf*>(nullptr), proto);
   serialize(writer);
   ssize_t size = writer.result();
   ld_check(size >= 0);
-  return ProtocolHeader::bytesNeeded(type_, proto) + size;
+  const size_t protohdr_bytes = ProtocolHeader::bytesNeeded(type_, proto);
+  if (copied_bytes) {
+    *copied_bytes = protohdr_bytes + writer.bytesCopied();
+  }
+  return protohdr_bytes + size;
 }
 
 }} // namespace facebook::logdevice
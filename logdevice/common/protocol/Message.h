@@ -82,8 +82,15 @@ struct Message {
   /**
    * Calculates how much space the message will take when transmitted,
    * including the protocol header.
+   *
+   * @param copied_bytes  if not null, set to the part of that which is copied
+   *                      into the output buffer when the message is
+   *                      serialized, that is, not written with
+   *                      ProtocolWriter::writeWithoutCopy(). Also includes
+   *                      the protocol header.
    */
-  size_t size(uint16_t proto = Compatibility::MAX_PROTOCOL_SUPPORTED) const;
+  size_t size(uint16_t proto = Compatibility::MAX_PROTOCOL_SUPPORTED,
+              size_t* copied_bytes = nullptr) const;
 
   /**
    * @return true if the message should be cancelled.
@@ -98,6 +105,27 @@ struct Message {
     return false;
   }
 
+  /**
+   * @return true if the payload of this message is a batch written by
+   *         BufferedWriter (see FLAG_BUFFERED_WRITER_BLOB), which is normally
+   *         compressed already. Connections that negotiated compression send
+   *         such messages uncompressed.
+   */
+  virtual bool hasBufferedWriterPayload() const {
+    return false;
+  }
+
+  /**
+   * @return the log this message is about if it may be sent on any of the
+   *         connections Sender keeps to the recipient (see
+   *         --connections-per-node), as long as all messages of that log
+   *         use the same one. LOGID_INVALID for messages that must use the
+   *         main connection to the recipient.
+   */
+  virtual logid_t getStripingLogID() const {
+    return LOGID_INVALID;
+  }
+
   /**
    * This enum lists actions that a Connection may take after calling
    * Message::onReceived() on a newly received message.
@@ -365,6 +365,10 @@ void ProtocolWriter::writeImpl(const void* data, size_t nbytes) {
 }
 
 void ProtocolWriter::writeWithoutCopy(const void* data, size_t nbytes) {
+  if (nbytes <= kMaxCopiedWithoutCopy) {
+    write(data, nbytes);
+    return;
+  }
   if (!isProtoVersionAllowed()) {
     return;
   }
@@ -373,9 +377,14 @@ void ProtocolWriter::writeWithoutCopy(const void* data, size_t nbytes) {
         [&] { return dest_->writeWithoutCopy(data, nbytes, nwritten_); });
   }
   nwritten_ += nbytes;
+  nwritten_without_copy_ += nbytes;
 }
 
 void ProtocolWriter::writeWithoutCopy(const folly::IOBuf* buffer) {
+  if (!buffer->isChained() && buffer->length() <= kMaxCopiedWithoutCopy) {
+    write(buffer->data(), buffer->length());
+    return;
+  }
   if (!isProtoVersionAllowed()) {
     return;
   }
@@ -383,6 +392,7 @@ void ProtocolWriter::writeWithoutCopy(const folly::IOBuf* buffer) {
     writeImplCb([&] { return dest_->writeWithoutCopy(buffer, nwritten_); });
   }
   nwritten_ += buffer->length();
+  nwritten_without_copy_ += buffer->length();
 }
 
 }} // namespace facebook::logdevice
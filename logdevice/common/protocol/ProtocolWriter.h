@@ -145,12 +145,17 @@ class ProtocolWriter {
    * Writes data without necessarily copying it.  The Message subclass should
    * ensure the region of memory is valid as long as it exists.
    *
+   * Ranges of at most kMaxCopiedWithoutCopy bytes are copied: that is cheaper
+   * than allocating an IOBuf to reference them.
+   *
    * TODO: After we get rid of EvbufferDestination, the IOBuf overload won't
    *       require the original IOBuf to remain alive after the call.
    */
   void writeWithoutCopy(const void* data, size_t size);
   void writeWithoutCopy(const folly::IOBuf* buffer);
 
+  static constexpr size_t kMaxCopiedWithoutCopy = 256;
+
   /**
    * Writes a vector.  std::string also welcome as it is sufficiently
    * vector-like.
@@ -220,6 +225,15 @@ class ProtocolWriter {
     return status_ == E::OK ? nwritten_ : -1;
   }
 
+  /**
+   * Number of bytes written so far that were copied into the destination, as
+   * opposed to passed to writeWithoutCopy(). Counted in dry runs too, so that
+   * callers can size the destination buffer exactly.
+   */
+  size_t bytesCopied() const {
+    return nwritten_ - nwritten_without_copy_;
+  }
+
   /**
    * Returns `true` if this ProtocolWriter doesn't care about the data being
    * written. This is used for optimizing message size calculations
@@ -303,6 +317,9 @@ class ProtocolWriter {
   const char* context_;
 
   size_t nwritten_ = 0;
+
+  // Part of nwritten_ passed to writeWithoutCopy().
+  size_t nwritten_without_copy_ = 0;
   // Connection protocol
   folly::Optional<uint16_t> proto_;
   // Protocol gate; write calls are ignored if `proto_' < `proto_gate_'
@@ -167,6 +167,9 @@ class RECORD_Message : public Message, boost::noncopyable {
   Disposition onReceived(const Address& from) override;
   static Message::deserializer_t deserialize;
   // onSent() handler lives in server/RECORD_onSent.cpp
+  bool hasBufferedWriterPayload() const override {
+    return header_.flags & RECORD_Header::BUFFERED_WRITER_BLOB;
+  }
 
   /**
    * @return a human-readable string with the record's log id, epoch, and ESN
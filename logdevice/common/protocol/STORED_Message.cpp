@@ -59,6 +59,15 @@ MessageReadResult STORED_Message::deserialize(ProtocolReader& reader) {
     reader.read(&rebuilding_id);
   }
 
+  STORED_LatencyTrace latency_trace{0, 0, 0};
+  if (reader.proto() >= Compatibility::ProtocolVersion::APPEND_LATENCY_TRACE) {
+    if (hdr.flags & STORED_Header::LATENCY_TRACE) {
+      reader.read(&latency_trace);
+    }
+  } else {
+    hdr.flags &= ~STORED_Header::LATENCY_TRACE;
+  }
+
   ShardID rebuildingRecipient;
   if (hdr.status == E::REBUILDING) {
     reader.read(&rebuildingRecipient);
@@ -75,18 +84,25 @@ MessageReadResult STORED_Message::deserialize(ProtocolReader& reader) {
   }
 
   return reader.result([&] {
-    return new STORED_Message(hdr,
-                              rebuilding_version,
-                              rebuilding_wave,
-                              rebuilding_id,
-                              flushToken,
-                              serverInstanceId,
-                              rebuildingRecipient);
+    auto msg = new STORED_Message(hdr,
+                                  rebuilding_version,
+                                  rebuilding_wave,
+                                  rebuilding_id,
+                                  flushToken,
+                                  serverInstanceId,
+                                  rebuildingRecipient);
+    msg->latency_trace_ = latency_trace;
+    return msg;
   });
 }
 
 void STORED_Message::serialize(ProtocolWriter& writer) const {
-  writer.write(&header_, STORED_Header::headerSize(writer.proto()));
+  STORED_Header proto_supported_header(header_);
+  if (writer.proto() < Compatibility::ProtocolVersion::APPEND_LATENCY_TRACE) {
+    proto_supported_header.flags &= ~STORED_Header::LATENCY_TRACE;
+  }
+  writer.write(
+      &proto_supported_header, STORED_Header::headerSize(writer.proto()));
   if (header_.flags & STORED_Header::REBUILDING) {
     writer.write(rebuilding_version_);
     writer.write(rebuilding_wave_);
@@ -94,6 +110,9 @@ void STORED_Message::serialize(ProtocolWriter& writer) const {
     writer.write(serverInstanceId_);
     writer.write(rebuilding_id_);
   }
+  if (proto_supported_header.flags & STORED_Header::LATENCY_TRACE) {
+    writer.write(latency_trace_);
+  }
   if (header_.status == E::REBUILDING) {
     writer.write(rebuildingRecipient_);
   }
@@ -102,7 +121,8 @@ void STORED_Message::serialize(ProtocolWriter& writer) const {
 Message::Disposition
 STORED_Message::handleOneMessage(const STORED_Header& header,
                                  ShardID from,
-                                 ShardID rebuildingRecipient) {
+                                 ShardID rebuildingRecipient,
+                                 const STORED_LatencyTrace* latency_trace) {
   Appender* appender{
       // Appender that sent the corresponding STORE
       Worker::onThisThread()->activeAppenders().map.find(header.rid)};
@@ -116,6 +136,10 @@ STORED_Message::handleOneMessage(const STORED_Header& header,
 
   ld_assert(header.rid == Appender::KeyExtractor()(*appender));
 
+  if (latency_trace && (header.flags & STORED_Header::LATENCY_TRACE)) {
+    appender->onStorageLatencyTrace(from, *latency_trace);
+  }
+
   return appender->onReply(header, from, rebuildingRecipient)
       ? Disposition::ERROR
       : Disposition::NORMAL;
@@ -175,7 +199,8 @@ Message::Disposition STORED_Message::onReceivedCommon(const Address& from) {
     }
   }
 
-  return handleOneMessage(header_, shard, rebuildingRecipient_);
+  return handleOneMessage(
+      header_, shard, rebuildingRecipient_, &latency_trace_);
 }
 
 /**
@@ -273,7 +298,8 @@ void STORED_Message::createAndSend(const STORED_Header& header,
                                    uint32_t rebuilding_wave,
                                    chunk_rebuilding_id_t rebuilding_id,
                                    FlushToken flushToken,
-                                   ShardID rebuildingRecipient) {
+                                   ShardID rebuildingRecipient,
+                                   STORED_LatencyTrace latency_trace) {
   ld_check(send_to.valid()); // must have been set by onReceived()
   Worker* worker = Worker::onThisThread();
 
@@ -358,6 +384,7 @@ void STORED_Message::createAndSend(const STORED_Header& header,
                                                 flushToken,
                                                 serverInstanceId,
                                                 rebuildingRecipient);
+    msg->latency_trace_ = latency_trace;
 
     if (target_worker.second == worker->idx_) {
       // the connection to origin is handled by this Worker thread
@@ -398,6 +425,7 @@ STORED_Message::getDebugInfo() const {
     FLAG(REBUILDING)
     FLAG(PREMPTED_BY_SOFT_SEAL_ONLY)
     FLAG(LOW_WATERMARK_NOSPC)
+    FLAG(LATENCY_TRACE)
 #undef FLAG
     return folly::join('|', strings);
   };
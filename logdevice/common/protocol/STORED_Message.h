@@ -97,6 +97,20 @@ struct STORED_Header {
   static const STORED_flags_t PREMPTED_BY_SOFT_SEAL_ONLY = 1ul << 4; //=16
   // the local log store's partition crossed low-watermark
   static const STORED_flags_t LOW_WATERMARK_NOSPC = 1ul << 5; //=32
+
+  // Reply to a STORE with the LATENCY_TRACE flag. STORED_LatencyTrace follows
+  // the header.
+  static const STORED_flags_t LATENCY_TRACE = 1ul << 6; //=64
+} __attribute__((__packed__));
+
+// How long a storage node spent on a STORE, see AppendLatencyBreakdown.
+struct STORED_LatencyTrace {
+  // STORE received -> started writing the batch that included it
+  uint32_t queue_us;
+  // writing the batch
+  uint32_t write_us;
+  // batch written -> synced; 0 if not synced
+  uint32_t sync_us;
 } __attribute__((__packed__));
 
 class STORED_Message : public Message {
@@ -150,7 +164,8 @@ class STORED_Message : public Message {
                             uint32_t rebuilding_wave,
                             chunk_rebuilding_id_t rebuilding_id,
                             FlushToken flushToken = FlushToken_INVALID,
-                            ShardID rebuildingRecipient = ShardID());
+                            ShardID rebuildingRecipient = ShardID(),
+                            STORED_LatencyTrace latency_trace = {0, 0, 0});
 
   STORED_Header header_;
 
@@ -178,6 +193,9 @@ class STORED_Message : public Message {
   // recipient in the copyset that is in the rebuilding set.
   ShardID rebuildingRecipient_;
 
+  // Only sent if the LATENCY_TRACE flag is set.
+  STORED_LatencyTrace latency_trace_{0, 0, 0};
+
   virtual std::vector<std::pair<std::string, folly::dynamic>>
   getDebugInfo() const override;
 
@@ -185,9 +203,11 @@ class STORED_Message : public Message {
   /**
    * Calls Appender::onReply() once (at most).  Helper function.
    */
-  static Message::Disposition handleOneMessage(const STORED_Header& header,
-                                               ShardID from,
-                                               ShardID rebuildingRecipient);
+  static Message::Disposition
+  handleOneMessage(const STORED_Header& header,
+                   ShardID from,
+                   ShardID rebuildingRecipient,
+                   const STORED_LatencyTrace* latency_trace = nullptr);
 
   friend Disposition STORED_onReceived(STORED_Message* msg,
                                        const Address& from);
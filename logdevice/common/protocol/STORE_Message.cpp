@@ -123,6 +123,9 @@ void STORE_Message::serialize(ProtocolWriter& writer) const {
   if (writer.proto() < Compatibility::ProtocolVersion::STREAM_WRITER_SUPPORT) {
     proto_supported_header.flags &= ~STORE_Header::WRITE_STREAM;
   }
+  if (writer.proto() < Compatibility::ProtocolVersion::APPEND_LATENCY_TRACE) {
+    proto_supported_header.flags &= ~STORE_Header::LATENCY_TRACE;
+  }
   writer.write(proto_supported_header);
 
   if (header_.flags & STORE_Header::RECOVERY) {
@@ -472,6 +475,7 @@ std::string STORE_Message::flagsToString(STORE_flags_t flags) {
   FLAG(EPOCH_BEGIN)
   FLAG(DRAINED)
   FLAG(WRITE_STREAM)
+  FLAG(LATENCY_TRACE)
 
 #undef FLAG
 
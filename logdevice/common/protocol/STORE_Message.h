@@ -166,6 +166,10 @@ struct STORE_Header {
   // RECORD_Header::WRITE_STREAM
   static const STORE_flags_t WRITE_STREAM = 1u << 22; //=4194304
 
+  // The record is an append sampled for a latency breakdown. The storage node
+  // reports how long it took to process the STORE in its STORED reply.
+  static const STORE_flags_t LATENCY_TRACE = 1u << 23; //=8388608
+
   // Please update STORE_Message::flagsToString() when adding flags.
 } __attribute__((__packed__));
 
@@ -284,6 +288,12 @@ class STORE_Message : public Message {
   // see Message.h
   bool cancelled() const override;
   void serialize(ProtocolWriter& writer) const override;
+  bool hasBufferedWriterPayload() const override {
+    return header_.flags & STORE_Header::BUFFERED_WRITER_BLOB;
+  }
+  logid_t getStripingLogID() const override {
+    return header_.rid.logid;
+  }
 
   // The onSent() logic is a bit different on client and server. This method
   // is the part that is shared by both. The server-specific part lives in
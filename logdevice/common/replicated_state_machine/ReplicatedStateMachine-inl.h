@@ -1445,6 +1445,23 @@ std::string ReplicatedStateMachine<T, D>::createSnapshotPayload(
     const T& data,
     lsn_t version,
     bool rsm_include_read_pointer_in_snapshot) {
+  RSMSnapshotHeader header;
+  std::string buf = serializeSnapshotPayload(
+      data, version, rsm_include_read_pointer_in_snapshot, header);
+  if (snapshot_compression_) {
+    return compressSnapshotPayload(rsm_type_, header, buf);
+  }
+
+  rsm_debug(rsm_type_, "buf size:%lu", buf.size());
+  return buf;
+}
+
+template <typename T, typename D>
+std::string ReplicatedStateMachine<T, D>::serializeSnapshotPayload(
+    const T& data,
+    lsn_t version,
+    bool rsm_include_read_pointer_in_snapshot,
+    RSMSnapshotHeader& header_out) {
   RSMSnapshotHeader header{
       /*format_version=*/rsm_include_read_pointer_in_snapshot
           ? RSMSnapshotHeader::CONTAINS_DELTA_LOG_READ_PTR_AND_LENGTH
@@ -1464,59 +1481,65 @@ std::string ReplicatedStateMachine<T, D>::createSnapshotPayload(
 
   // Serialize both header and uncompressed payload onto a buffer.
   std::string buf;
-  {
-    buf.resize(header_sz + uncompressed_payload_size);
-    uint8_t* ptr = reinterpret_cast<uint8_t*>(&buf[0]);
-    auto rv = RSMSnapshotHeader::serialize(header, ptr, header_sz);
-    ld_check(rv == header_sz);
-    ptr += header_sz;
-    rv = serializeState(data, ptr, uncompressed_payload_size);
-    ld_check(rv == uncompressed_payload_size);
-  }
-
-  if (snapshot_compression_) {
-    header.flags |= RSMSnapshotHeader::ZSTD_COMPRESSION;
-
-    // Allocate a new buffer to hold the header and compressed payload.
-    const size_t compressed_data_bound =
-        ZSTD_compressBound(uncompressed_payload_size);
-    ld_check(compressed_data_bound > 0);
-    std::string compressed_buf;
-    compressed_buf.resize(header_sz + compressed_data_bound);
-
-    // Serialize the header.
-    uint8_t* ptr = reinterpret_cast<uint8_t*>(&compressed_buf[0]);
-    auto rv = RSMSnapshotHeader::serialize(header, ptr, header_sz);
-    ld_check(rv == header_sz);
-    ptr += header_sz;
-
-    // Compress the paylaod.
-    const uint8_t* ptr_src = reinterpret_cast<uint8_t*>(&buf[0]) + header_sz;
-    const int ZSTD_LEVEL = 5;
-    auto compressed_size = ZSTD_compress(ptr,                   // dst
-                                         compressed_data_bound, // dstCapacity
-                                         ptr_src,               // src
-                                         uncompressed_payload_size, // srcSize
-                                         ZSTD_LEVEL);               // level
-    if (ZSTD_isError(compressed_size)) {
-      rsm_error(rsm_type_,
-                "ZSTD_compress() failed: %s",
-                ZSTD_getErrorName(compressed_size));
-      ld_check(false);
-      return std::string();
-    }
-    compressed_buf.resize(header_sz + compressed_size);
-    rsm_debug(rsm_type_,
-              "buf size: uncompressed:%lu, compressed:%lu",
-              buf.size(),
-              compressed_buf.size());
-    return compressed_buf;
-  }
+  buf.resize(header_sz + uncompressed_payload_size);
+  uint8_t* ptr = reinterpret_cast<uint8_t*>(&buf[0]);
+  auto rv = RSMSnapshotHeader::serialize(header, ptr, header_sz);
+  ld_check(rv == header_sz);
+  ptr += header_sz;
+  rv = serializeState(data, ptr, uncompressed_payload_size);
+  ld_check(rv == uncompressed_payload_size);
 
-  rsm_debug(rsm_type_, "buf size:%lu", buf.size());
+  header_out = header;
   return buf;
 }
 
+template <typename T, typename D>
+std::string ReplicatedStateMachine<T, D>::compressSnapshotPayload(
+    RSMType rsm_type,
+    RSMSnapshotHeader header,
+    const std::string& buf) {
+  header.flags |= RSMSnapshotHeader::ZSTD_COMPRESSION;
+  const size_t header_sz = RSMSnapshotHeader::computeLengthInBytes(header);
+  ld_check(buf.size() >= header_sz);
+  const size_t uncompressed_payload_size = buf.size() - header_sz;
+
+  // Allocate a new buffer to hold the header and compressed payload.
+  const size_t compressed_data_bound =
+      ZSTD_compressBound(uncompressed_payload_size);
+  ld_check(compressed_data_bound > 0);
+  std::string compressed_buf;
+  compressed_buf.resize(header_sz + compressed_data_bound);
+
+  // Serialize the header.
+  uint8_t* ptr = reinterpret_cast<uint8_t*>(&compressed_buf[0]);
+  auto rv = RSMSnapshotHeader::serialize(header, ptr, header_sz);
+  ld_check(rv == header_sz);
+  ptr += header_sz;
+
+  // Compress the paylaod.
+  const uint8_t* ptr_src =
+      reinterpret_cast<const uint8_t*>(buf.data()) + header_sz;
+  const int ZSTD_LEVEL = 5;
+  auto compressed_size = ZSTD_compress(ptr,                   // dst
+                                       compressed_data_bound, // dstCapacity
+                                       ptr_src,               // src
+                                       uncompressed_payload_size, // srcSize
+                                       ZSTD_LEVEL);               // level
+  if (ZSTD_isError(compressed_size)) {
+    rsm_error(rsm_type,
+              "ZSTD_compress() failed: %s",
+              ZSTD_getErrorName(compressed_size));
+    ld_check(false);
+    return std::string();
+  }
+  compressed_buf.resize(header_sz + compressed_size);
+  rsm_debug(rsm_type,
+            "buf size: uncompressed:%lu, compressed:%lu",
+            buf.size(),
+            compressed_buf.size());
+  return compressed_buf;
+}
+
 template <typename T, typename D>
 void ReplicatedStateMachine<T, D>::snapshot(std::function<void(Status st)> cb) {
   auto cb_or_noop = [=](Status st) {
@@ -1565,12 +1588,53 @@ void ReplicatedStateMachine<T, D>::snapshot(std::function<void(Status st)> cb) {
     return;
   }
 
+  RSMSnapshotHeader header;
   std::string payload =
-      createSnapshotPayload(*data_, version_, include_read_ptr);
+      serializeSnapshotPayload(*data_, version_, include_read_ptr, header);
+  const lsn_t version = version_;
+  const size_t byte_offset = delta_log_byte_offset_;
+  const size_t offset = delta_log_offset_;
 
-  // We'll capture these in the lambda below.
-  const size_t byte_offset_at_time_of_snapshot = delta_log_byte_offset_;
-  const size_t offset_at_time_of_snapshot = delta_log_offset_;
+  Worker* w = Worker::onThisThread(false);
+  if (snapshot_compression_ && w) {
+    // The state has to be serialized here, but compressing a large snapshot
+    // takes a while and doesn't need to hold up the worker.
+    snapshot_in_flight_ = true;
+    auto ref = callbackHelper_.getHolder().ref();
+    w->offloadToCpuExecutor(
+        [rsm_type = rsm_type_, header, payload = std::move(payload)] {
+          return compressSnapshotPayload(rsm_type, header, payload);
+        },
+        [ref, version, byte_offset, offset, cb](std::string compressed) {
+          ReplicatedStateMachine<T, D>* s = ref.get();
+          if (!s) {
+            return;
+          }
+          s->snapshot_in_flight_ = false;
+          s->writeSnapshotPayload(
+              std::move(compressed), version, byte_offset, offset, cb);
+        });
+    return;
+  }
+
+  if (snapshot_compression_) {
+    payload = compressSnapshotPayload(rsm_type_, header, payload);
+  }
+  writeSnapshotPayload(std::move(payload), version, byte_offset, offset, cb);
+}
+
+template <typename T, typename D>
+void ReplicatedStateMachine<T, D>::writeSnapshotPayload(
+    std::string payload,
+    lsn_t version,
+    size_t byte_offset_at_time_of_snapshot,
+    size_t offset_at_time_of_snapshot,
+    std::function<void(Status st)> cb) {
+  auto cb_or_noop = [=](Status st) {
+    if (cb) {
+      cb(st);
+    }
+  };
 
   auto ticket = callbackHelper_.ticket();
   auto snapshot_cb = [=](Status st, lsn_t lsn) {
@@ -1610,16 +1674,16 @@ void ReplicatedStateMachine<T, D>::snapshot(std::function<void(Status st)> cb) {
   };
 
   rsm_info(rsm_type_,
-           "%swriting snapshot, version_:%s, last_written_version_:%s, "
+           "%swriting snapshot, version:%s, last_written_version_:%s, "
            "payload size:%lu",
-           version_ > last_written_version_ ? "" : "Not ",
-           lsn_to_string(version_).c_str(),
+           version > last_written_version_ ? "" : "Not ",
+           lsn_to_string(version).c_str(),
            lsn_to_string(last_written_version_).c_str(),
            payload.size());
   if (snapshot_store_) {
-    if (version_ > last_written_version_) {
+    if (version > last_written_version_) {
       snapshot_in_flight_ = true;
-      snapshot_store_->writeSnapshot(version_, std::move(payload), snapshot_cb);
+      snapshot_store_->writeSnapshot(version, std::move(payload), snapshot_cb);
     } else {
       snapshot_cb(E::UPTODATE, last_written_version_);
     }
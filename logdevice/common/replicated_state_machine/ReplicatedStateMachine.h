@@ -453,6 +453,21 @@ class ReplicatedStateMachine {
                                     lsn_t version,
                                     bool rsm_include_read_pointer_in_snapshot);
 
+  // The uncompressed part of createSnapshotPayload(). `header_out` is set to
+  // the header written at the front of the returned payload.
+  std::string
+  serializeSnapshotPayload(const T& data,
+                           lsn_t version,
+                           bool rsm_include_read_pointer_in_snapshot,
+                           RSMSnapshotHeader& header_out);
+
+  // Compresses a payload returned by serializeSnapshotPayload() with the
+  // header it was serialized with. Doesn't touch the state machine, so may run
+  // on any thread. Returns an empty string on failure.
+  static std::string compressSnapshotPayload(RSMType rsm_type,
+                                             RSMSnapshotHeader header,
+                                             const std::string& buf);
+
   // Some metadata included inside delta records.
   struct DeltaHeader {
     uint32_t checksum{0};
@@ -602,6 +617,14 @@ class ReplicatedStateMachine {
   // Post a request on a worker. Mocked by tests.
   virtual void postRequestWithRetrying(std::unique_ptr<Request>& rq);
 
+  // Second half of snapshot(): writes `payload`, the snapshot of `version`,
+  // to the snapshot store or log.
+  void writeSnapshotPayload(std::string payload,
+                            lsn_t version,
+                            size_t byte_offset_at_time_of_snapshot,
+                            size_t offset_at_time_of_snapshot,
+                            std::function<void(Status st)> cb);
+
   // Create and post an AppendRequest, mocked by unit tests.
   virtual void postAppendRequest(logid_t logid,
                                  std::string payload,
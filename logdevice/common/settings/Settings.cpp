@@ -21,6 +21,7 @@
 #include "logdevice/common/Sockaddr.h"
 #include "logdevice/common/commandline_util_chrono.h"
 #include "logdevice/common/debug.h"
+#include "logdevice/common/network/ShmRing.h"
 #include "logdevice/common/protocol/Compatibility.h"
 #include "logdevice/common/protocol/MessageTypeNames.h"
 #include "logdevice/common/settings/Validators.h"
@@ -530,6 +531,138 @@ void Settings::defineSettings(SettingEasyInit& init) {
       "ones",
       SERVER | CLIENT,
       SettingsCategory::Network);
+  init("io-uring-sockets",
+       &io_uring_sockets,
+       "false",
+       nullptr, // no validation
+       "If true, workers perform network I/O for plaintext connections "
+       "through io_uring, with batched submission once per event loop "
+       "iteration, provided receive buffers and registered send buffers, "
+       "instead of AsyncSocket. Requires Linux 5.19 or newer and has no effect "
+       "with --use-legacy-eventbase. Falls back to AsyncSocket if io_uring is "
+       "unavailable.",
+       SERVER | CLIENT | REQUIRES_RESTART | EXPERIMENTAL,
+       SettingsCategory::Network);
+  init("io-uring-sq-entries",
+       &io_uring_sq_entries,
+       "4096",
+       [](size_t val) -> void {
+         if (val == 0 || val > 32768) {
+           throw boost::program_options::error(
+               "io-uring-sq-entries must be between 1 and 32768");
+         }
+       },
+       "Number of submission queue entries of each worker's io_uring. Only "
+       "used with --io-uring-sockets.",
+       SERVER | CLIENT | REQUIRES_RESTART | EXPERIMENTAL,
+       SettingsCategory::Network);
+  init("io-uring-buffers",
+       &io_uring_buffers,
+       "1024",
+       [](size_t val) -> void {
+         if (val == 0 || val > 32768 || (val & (val - 1)) != 0) {
+           throw boost::program_options::error(
+               "io-uring-buffers must be a power of two not greater than "
+               "32768");
+         }
+       },
+       "Number of receive buffers provided to, and of send buffers registered "
+       "with, each worker's io_uring. Receive buffers are shared by all "
+       "connections of the worker and only picked by the kernel when data "
+       "arrives. Must be a power of two. Only used with --io-uring-sockets.",
+       SERVER | CLIENT | REQUIRES_RESTART | EXPERIMENTAL,
+       SettingsCategory::Network);
+  init("io-uring-buffer-size",
+       &io_uring_buffer_size,
+       "16K",
+       parse_positive<size_t>(),
+       "Size of each io_uring receive and send buffer. Writes that fit in one "
+       "are coalesced into a registered buffer before being sent. Only used "
+       "with --io-uring-sockets.",
+       SERVER | CLIENT | REQUIRES_RESTART | EXPERIMENTAL,
+       SettingsCategory::Network);
+  init("shm-local-connections",
+       &shm_local_connections,
+       "false",
+       nullptr, // no validation
+       "If true, plaintext connections over unix sockets (i.e. between "
+       "processes on the same host, such as a client and the node whose "
+       "--unix-socket it connects to) exchange data through shared memory "
+       "rings with eventfd notifications instead of going through the "
+       "kernel's socket buffers. Nodes accept both shared memory and regular "
+       "connections on their unix sockets when this is set, so enable it on "
+       "nodes before clients. Has no effect with --use-legacy-eventbase.",
+       SERVER | CLIENT | REQUIRES_RESTART | EXPERIMENTAL,
+       SettingsCategory::Network);
+  init("shm-ring-size",
+       &shm_ring_size,
+       "1M",
+       [](size_t val) -> void {
+         if (!ShmSegment::isValidRingSize(val)) {
+           throw boost::program_options::error(
+               "shm-ring-size must be a power of two between 4K and 64M");
+         }
+       },
+       "Size of each of the two rings (one per direction) of a shared memory "
+       "connection. Writes that don't fit wait for the peer to read. Only "
+       "used with --shm-local-connections.",
+       SERVER | CLIENT | REQUIRES_RESTART | EXPERIMENTAL,
+       SettingsCategory::Network);
+  init("zerocopy-send-threshold",
+       &zerocopy_send_threshold,
+       "0",
+       nullptr,
+       "If non-zero, writes of at least this many bytes to plaintext "
+       "connections (typically batches of large RECORD and STORE messages) "
+       "are sent with MSG_ZEROCOPY instead of being copied into the socket "
+       "buffer. The memory of such writes stays accounted against the output "
+       "buffer limits until the kernel is done with it. Only takes effect "
+       "for connections established after the change, on kernels and sockets "
+       "supporting SO_ZEROCOPY. 0 disables zero-copy sends.",
+       SERVER | CLIENT | EXPERIMENTAL,
+       SettingsCategory::Network);
+  init("connection-compression",
+       &connection_compression,
+       "false",
+       nullptr,
+       "Offer (when connecting) or accept (when accepting) zstd compression "
+       "of the message stream on new connections. Both ends need this "
+       "enabled. Only messages of the traffic classes listed in "
+       "\"compressed_traffic_classes\" of the \"traffic_shaping\" config "
+       "section are compressed, except for batches written by "
+       "BufferedWriter. Meant for connections crossing expensive links, "
+       "such as remote clients and readers.",
+       SERVER | CLIENT | EXPERIMENTAL,
+       SettingsCategory::Network);
+  init("connection-compression-min-size",
+       &connection_compression_min_size,
+       "512",
+       nullptr,
+       "Messages smaller than this are not compressed on connections that "
+       "negotiated compression (see --connection-compression).",
+       SERVER | CLIENT | EXPERIMENTAL,
+       SettingsCategory::Network);
+  init("connection-compression-level",
+       &connection_compression_level,
+       "1",
+       parse_validate_range<int>(1, ZSTD_maxCLevel()),
+       "zstd compression level used on connections that negotiated "
+       "compression (see --connection-compression). Only affects connections "
+       "established after the change.",
+       SERVER | CLIENT | EXPERIMENTAL,
+       SettingsCategory::Network);
+  init("connections-per-node",
+       &connections_per_node,
+       "1",
+       parse_validate_range<size_t>(1, 16),
+       "Number of DATA connections each worker keeps to every other node. "
+       "With more than one, STORE and DELETE messages, which carry record "
+       "payloads, are spread over all connections but the first by log id, "
+       "so that messages for the same log still arrive in order. All other "
+       "messages, including latency sensitive ones like RELEASE, use the "
+       "first connection and are not queued behind payloads.",
+       SERVER | REQUIRES_RESTART /* read in Sender ctor */ | EXPERIMENTAL,
+       SettingsCategory::Network);
   init(
       "outbuf-kb",
       &outbuf_overflow_kb,
@@ -736,6 +869,19 @@ void Settings::defineSettings(SettingEasyInit& init) {
        "a request to run FlowGroups and Sender::runFlowGroups() executing.",
        SERVER,
        SettingsCategory::ResourceManagement);
+  init("flow-groups-shared-budgets",
+       &flow_groups_shared_budgets,
+       "false",
+       nullptr, // no validation
+       "If true, the FlowGroups of network traffic shaping and read "
+       "throttling borrow bandwidth credit, whenever they run out, from token "
+       "buckets shared by all workers and refilled at the configured rates, "
+       "instead of receiving an allotment from the traffic shaper thread "
+       "every millisecond. Idle workers are then not woken up to receive "
+       "credit and bandwidth limits do not depend on how quickly workers "
+       "process the allotments.",
+       SERVER | REQUIRES_RESTART | EXPERIMENTAL,
+       SettingsCategory::ResourceManagement);
   init("read-messages",
        &incoming_messages_max_per_socket,
        "128",
@@ -1064,6 +1210,36 @@ void Settings::defineSettings(SettingEasyInit& init) {
        "client request timeout.",
        SERVER,
        SettingsCategory::WritePath);
+  init("store-hedging",
+       &store_hedging,
+       "false",
+       nullptr, // no validation
+       "if true, sequencers send an extra copy of a record to a replacement "
+       "storage node when a STORE has not been acknowledged within the "
+       "estimated tail latency of its recipient, rather than waiting for the "
+       "whole store timeout. Replies to the original and to the extra "
+       "STOREs all count toward replication.",
+       SERVER | EXPERIMENTAL,
+       SettingsCategory::WritePath);
+  init("store-hedging-delay",
+       &store_hedging_delay,
+       "5ms..500ms",
+       validate_positive<ssize_t>(),
+       "bounds for the delay after which an unacknowledged STORE is hedged "
+       "when --store-hedging is enabled. The delay is the estimated tail "
+       "STORE latency of the recipient, clamped to this range. The upper "
+       "bound is used for storage nodes with no latency estimate yet.",
+       SERVER | EXPERIMENTAL,
+       SettingsCategory::WritePath);
+  init("store-hedging-max-outstanding",
+       &store_hedging_max_outstanding,
+       "1",
+       validate_range<size_t>(1, COPYSET_SIZE_MAX),
+       "do not hedge a wave of STOREs if more than this many STOREs of the "
+       "wave are still outstanding. Used only when --store-hedging is "
+       "enabled.",
+       SERVER | EXPERIMENTAL,
+       SettingsCategory::WritePath);
   init("connect-throttle",
        &connect_throttle,
        "1ms..10s",
@@ -1190,6 +1366,34 @@ void Settings::defineSettings(SettingEasyInit& init) {
        "LogDevice protocol handshake timeout",
        SERVER | CLIENT,
        SettingsCategory::Network);
+  init("client-connection-rebalancing",
+       &client_connection_rebalancing,
+       "false",
+       nullptr, // no validation
+       "Assign new client connections to workers based on their CPU load, and "
+       "have busy workers move client connections that are idle between "
+       "messages to the least loaded worker, along with their handshake "
+       "state. Only plain TCP connections without compression and without "
+       "server state attached to them (e.g. read streams) are moved.",
+       SERVER | EXPERIMENTAL,
+       SettingsCategory::Network);
+  init("client-connection-rebalancing-threshold",
+       &client_connection_rebalancing_threshold,
+       "0.2",
+       validate_range<double>(0, 1.0),
+       "With --client-connection-rebalancing, a worker moves client "
+       "connections when its CPU load exceeds the load of the least loaded "
+       "worker by more than this fraction of its own load.",
+       SERVER,
+       SettingsCategory::Network);
+  init("client-connection-migration-min-idle",
+       &client_connection_migration_min_idle,
+       "100ms",
+       validate_nonnegative<ssize_t>(),
+       "With --client-connection-rebalancing, only client connections that "
+       "haven't received a message for this long are moved to another worker.",
+       SERVER,
+       SettingsCategory::Network);
   init("inline-message-execution",
        &inline_message_execution,
        "false",
@@ -1688,6 +1892,16 @@ void Settings::defineSettings(SettingEasyInit& init) {
       "how big a checksum to include with newly appended records (0, 32 or 64)",
       SERVER | CLIENT,
       SettingsCategory::WritePath);
+  init("append-latency-breakdown-sample-rate",
+       &append_latency_breakdown_sample_rate,
+       "0",
+       validate_range<double>(0, 1.0),
+       "Fraction of appends for which the client asks the sequencer and "
+       "storage nodes to record how long each stage of the append took. "
+       "Traced appends can be inspected with \"info append_latency_breakdown\" "
+       "on sequencers. 1e-4 is cheap enough to leave on in production.",
+       CLIENT,
+       SettingsCategory::WritePath);
   init(
       "mutation-timeout",
       &mutation_timeout,
@@ -1980,6 +2194,19 @@ void Settings::defineSettings(SettingEasyInit& init) {
        "TTL for an SSL certificate that we have loaded from disk.",
        SERVER | CLIENT | REQUIRES_RESTART /* used in Worker ctor */,
        SettingsCategory::Security);
+  init("ssl-ktls",
+       &ssl_ktls,
+       "false",
+       nullptr, // no validation
+       "Offload encryption of SSL connections to kernel TLS (kTLS) once the "
+       "handshake is done, which saves userspace CPU on bulk record traffic. "
+       "Requires OpenSSL built with kTLS support and the kernel tls module; "
+       "connections for which the offload fails keep encrypting in "
+       "userspace. See the ssl_ktls_connections and ssl_ktls_fallbacks "
+       "stats.",
+       SERVER | CLIENT | REQUIRES_RESTART /* used in Processor ctor */ |
+           EXPERIMENTAL,
+       SettingsCategory::Security);
   init("ssl-boundary",
        &ssl_boundary,
        "none",
@@ -2036,6 +2263,18 @@ void Settings::defineSettings(SettingEasyInit& init) {
        "\"any\" or \"\" to keep the default.",
        SERVER | REQUIRES_RESTART /* used once when ExecStorageThread starts */,
        SettingsCategory::ResourceManagement);
+  init("numa-aware-placement",
+       &numa_aware_placement,
+       "false",
+       nullptr, // no validation
+       "On hosts with more than one NUMA node, bind the storage threads of "
+       "each shard to the CPUs of the node its disk is attached to, spread "
+       "workers over the nodes in proportion to their CPUs, and allocate the "
+       "block cache from per-node jemalloc arenas. Has no effect on hosts "
+       "with a single NUMA node.",
+       SERVER | REQUIRES_RESTART /* threads are bound when they start */ |
+           EXPERIMENTAL,
+       SettingsCategory::ResourceManagement);
 
   init("checksumming-enabled",
        &checksumming_enabled,
@@ -2347,6 +2586,18 @@ void Settings::defineSettings(SettingEasyInit& init) {
       "benefit of batching and recompressing would be small.",
       SERVER,
       SettingsCategory::Batching);
+  init("sequencer-batching-per-worker-logs",
+       &sequencer_batching_per_worker_logs,
+       "",
+       parse_log_set,
+       "Comma-separated list of log IDs of very hot logs for which sequencer "
+       "batching (if used) happens on the worker that received each append, "
+       "instead of on a single worker chosen by log ID. This lets the append "
+       "throughput of a single log scale past one core. Appends received on "
+       "the same worker keep their order; appends received on different "
+       "workers may be batched and sequenced in any order.",
+       SERVER,
+       SettingsCategory::Batching);
   init("num-processor-background-threads",
        &num_processor_background_threads,
        "0",
@@ -2356,6 +2607,15 @@ void Settings::defineSettings(SettingEasyInit& init) {
        "large batches.  If 0 (default), use num-workers.",
        SERVER | CLIENT | REQUIRES_RESTART,
        SettingsCategory::Execution);
+  init("num-cpu-executor-threads",
+       &num_cpu_executor_threads,
+       "0",
+       nullptr, // no validation
+       "Number of threads of the work stealing executor that workers offload "
+       "CPU-heavy work to, e.g. decompression, checksumming or "
+       "serialization. If 0 (default), use num-workers.",
+       SERVER | CLIENT | REQUIRES_RESTART,
+       SettingsCategory::Execution);
   init("buffered-writer-bg-thread-bytes-threshold",
        &buffered_writer_bg_thread_bytes_threshold,
        "4096",
@@ -2860,6 +3120,39 @@ void Settings::defineSettings(SettingEasyInit& init) {
        SERVER,
        SettingsCategory::WritePath);
 
+  init("latency-aware-copyset-selection",
+       &latency_aware_copyset_selection,
+       "false",
+       nullptr, // no validation
+       "If true, sequencers track per-shard STORE->STORED latency estimates "
+       "and WeightedCopySetSelector picks, among "
+       "--latency-aware-copyset-candidates valid copysets, the one whose "
+       "slowest shard has the lowest estimated tail latency. Helps append "
+       "latency when some disks are degraded but not yet graylisted.",
+       SERVER,
+       SettingsCategory::WritePath);
+
+  init("latency-aware-copyset-candidates",
+       &latency_aware_copyset_candidates,
+       "2",
+       validate_range<size_t>(2, 8),
+       "Number of candidate copysets to choose from when "
+       "--latency-aware-copyset-selection is enabled. Higher values skew "
+       "load away from slow shards more aggressively.",
+       SERVER,
+       SettingsCategory::WritePath);
+
+  init("latency-aware-copyset-random-fraction",
+       &latency_aware_copyset_random_fraction,
+       "0.1",
+       validate_range<double>(0, 1),
+       "When --latency-aware-copyset-selection is enabled, this fraction of "
+       "copysets is picked purely according to weights, ignoring latency. "
+       "Keeps data distribution reasonably balanced and latency estimates of "
+       "slow shards up to date.",
+       SERVER,
+       SettingsCategory::WritePath);
+
   init("test-do-not-pick-in-copysets",
        &test_do_not_pick_in_copysets,
        "",
@@ -3425,6 +3718,17 @@ void Settings::defineSettings(SettingEasyInit& init) {
        "and use HHWheelTimer backend.",
        SERVER | CLIENT | REQUIRES_RESTART,
        SettingsCategory::Core);
+  init("worker-timing-wheel",
+       &worker_timing_wheel,
+       "false",
+       nullptr, // no validation
+       "Keep the timers of each worker in a hierarchical timing wheel on the "
+       "worker's own thread, driven by a single libevent timer, so that "
+       "activating, cancelling and firing a timer take constant time however "
+       "many timers are pending. Takes precedence over "
+       "--enable-hh-wheel-backed-timers.",
+       SERVER | CLIENT | REQUIRES_RESTART | EXPERIMENTAL,
+       SettingsCategory::Core);
   init("enable-store-histograms-calculations",
        &enable_store_histogram_calculations,
        "false",
@@ -182,6 +182,44 @@ struct Settings : public SettingsBundle {
   // setsockopt(TCP_NODELAY).
   bool nagle;
 
+  // If true, Workers running on folly EventBases do network I/O for plaintext
+  // connections through an io_uring (see IoUringSocketAdapter) instead of
+  // AsyncSocket. Falls back to AsyncSocket if io_uring is unavailable.
+  bool io_uring_sockets;
+
+  // Number of submission queue entries of each Worker's io_uring.
+  size_t io_uring_sq_entries;
+
+  // Number of provided receive buffers, and of registered send buffers, of
+  // each Worker's io_uring, and the size of each of those buffers.
+  size_t io_uring_buffers;
+  size_t io_uring_buffer_size;
+
+  // If true, plaintext connections over unix sockets, i.e. to and from
+  // processes on the same host, move data through shared memory rings (see
+  // ShmSocketAdapter) instead of the kernel's socket buffers.
+  bool shm_local_connections;
+
+  // Size of each of the two rings of a shared memory connection.
+  size_t shm_ring_size;
+
+  // Writes of at least this many bytes to plaintext AsyncSocket connections
+  // are sent with MSG_ZEROCOPY. 0 disables zero-copy sends.
+  size_t zerocopy_send_threshold;
+
+  // Negotiate zstd compression of the message stream on new connections.
+  // Messages are compressed if their traffic class is listed in
+  // compressed_traffic_classes of the traffic shaping config and their body
+  // is at least connection_compression_min_size bytes.
+  bool connection_compression;
+  size_t connection_compression_min_size;
+  int connection_compression_level;
+
+  // Number of DATA connections each Worker keeps to another node. Stores
+  // and deletes are striped across all but the first one by log id; every
+  // other message, including small ones like RELEASE, uses the first one.
+  size_t connections_per_node;
+
   // Forces no scd mode for read streams associated with RSM.
   bool rsm_force_all_send_all;
 
@@ -401,6 +439,20 @@ struct Settings : public SettingsBundle {
   // rather than timeouts when initiating STORE retries.
   chrono_expbackoff_t<std::chrono::milliseconds> store_timeout;
 
+  // If true, Appender sends an extra copy of a record to a replacement node
+  // when a STORE has not been acknowledged within that node's estimated tail
+  // latency, instead of waiting for the whole store timeout. See
+  // Appender::onHedgeTimeout().
+  bool store_hedging;
+
+  // Bounds for the adaptive delay after which an outstanding STORE is hedged.
+  // The upper bound is used for nodes without a latency estimate.
+  chrono_interval_t<std::chrono::microseconds> store_hedging_delay;
+
+  // Do not hedge a wave that has more than this many outstanding STOREs;
+  // at that point a regular store timeout is the better remedy.
+  size_t store_hedging_max_outstanding;
+
   // Timeout after it which two nodes retry to connect when they loose a
   // a connection. Backoff for throttling Connection reinitiation attempts.
   chrono_expbackoff_t<std::chrono::milliseconds> connect_throttle;
@@ -470,6 +522,19 @@ struct Settings : public SettingsBundle {
   // handshake to be completed before giving up. Unlimited if set to 0.
   std::chrono::milliseconds handshake_timeout;
 
+  // If true, new client connections go to the least loaded workers, and
+  // workers periodically move idle client connections to less loaded
+  // workers.
+  bool client_connection_rebalancing;
+
+  // Minimum difference in load between a worker and the least loaded worker,
+  // as a fraction of the former's load, for client connections to be moved.
+  double client_connection_rebalancing_threshold;
+
+  // Only client connections that haven't received a message for this long
+  // can be moved to another worker.
+  std::chrono::milliseconds client_connection_migration_min_idle;
+
   // Message read from tcp socket and push into worker task queue for further
   // processing. Setting this true all messages would be processed
   // as soon as they are deserialized.
@@ -711,6 +776,11 @@ struct Settings : public SettingsBundle {
   // reasonable space overhead (4 bytes) and is fast with SSE4.2.
   int checksum_bits;
 
+  // (client-only setting) Fraction of appends that carry a latency trace
+  // through the sequencer and storage nodes. The sequencer reports how long
+  // each stage of a traced append took in "info append_latency_breakdown".
+  double append_latency_breakdown_sample_rate;
+
   // Initial timeout used during the mutation phase of recovery. If replicating
   // a record takes longer, Mutator will try to pick a few extra nodes to send
   // mutations to.
@@ -851,6 +921,10 @@ struct Settings : public SettingsBundle {
   // TTL for the cert loaded from file
   std::chrono::seconds ssl_cert_refresh_interval;
 
+  // If true, ask OpenSSL to hand established TLS sessions to kernel TLS, so
+  // that records are encrypted and decrypted by the kernel.
+  bool ssl_ktls;
+
   // Sets the boundary which triggers enabling SSL. Communication that crosses
   // this boundary will be encrypted; communication that doesn't will not.
   // For instance, if set to NodeLocationScope::RACK, all cross-rack traffic
@@ -869,6 +943,10 @@ struct Settings : public SettingsBundle {
   // See man ioprio_set for possible values.
   folly::Optional<std::pair<int, int>> slow_ioprio;
 
+  // Bind the storage threads of each shard to the NUMA node of the shard's
+  // disk, and spread workers over the NUMA nodes.
+  bool numa_aware_placement;
+
   // (client-only setting) Timeout after which ClientReadStream considers a
   // storage node down if it does not send any data for some time but the socket
   // to it remains open. This can happen if:
@@ -1022,11 +1100,19 @@ struct Settings : public SettingsBundle {
   // batching and recompressing would be small.
   ssize_t sequencer_batching_passthru_threshold;
 
+  // Hot logs for which sequencer batching happens on the worker that
+  // received the append instead of on a single worker chosen by log ID.
+  std::unordered_set<logid_t> sequencer_batching_per_worker_logs;
+
   // Number of background threads.  Currently, background threads are used by
   // BufferedWriter to construct/compress large batches.  If 0 (the default),
   // use num_workers.
   int num_processor_background_threads;
 
+  // Number of threads of the Processor's work stealing CPU executor. If 0
+  // (the default), use num_workers.
+  int num_cpu_executor_threads;
+
   // BufferedWriter can send batches to a background thread.  For small batches,
   // where the overhead dominates, this will just slow things down.  If the
   // total size of the batch is less than this, it will constructed / compressed
@@ -1064,6 +1150,11 @@ struct Settings : public SettingsBundle {
   // a request to run FlowGroups and Sender::runFlowGroups() executing.
   std::chrono::microseconds flow_groups_run_deadline;
 
+  // If true, FlowGroups borrow bandwidth from process wide token buckets
+  // when they need it instead of receiving periodic allotments from the
+  // TrafficShaper.
+  bool flow_groups_shared_budgets;
+
   // TODO T29642728, DEPRECATED and will remove finally
   // How often the sequencer sends byte offsets to storage nodes. Measured in
   // bytes. This option will be ignored if byte_offsets feature is disabled.
@@ -1081,6 +1172,10 @@ struct Settings : public SettingsBundle {
   // and use HHWheelTimer backend.
   bool enable_hh_wheel_backed_timers;
 
+  // If true, timers of workers are kept in a hierarchical timing wheel of
+  // their EventLoop. Takes precedence over enable_hh_wheel_backed_timers.
+  bool worker_timing_wheel;
+
   // If true, use the new version of timers which run on a different thread
   // and use HHWheelTimer backend.
   bool enable_store_histogram_calculations;
@@ -1271,6 +1366,18 @@ struct Settings : public SettingsBundle {
 
   NodeLocationScope copyset_locality_min_scope;
 
+  // If true, WeightedCopySetSelector draws several valid copysets and picks
+  // the one with the lowest estimated STORE latency. See .cpp.
+  bool latency_aware_copyset_selection;
+
+  // Number of candidate copysets to draw when latency-aware copyset selection
+  // is enabled.
+  size_t latency_aware_copyset_candidates;
+
+  // Fraction of copysets picked without regard to latency, to keep the load
+  // balanced and to keep latency estimates of slow nodes fresh.
+  double latency_aware_copyset_random_fraction;
+
   // Defaults to false, allows clients to opt-in to traffic shadowing
   bool traffic_shadow_enabled;
 
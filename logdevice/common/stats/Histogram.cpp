@@ -24,6 +24,7 @@
 #include <folly/Conv.h>
 #include <folly/Format.h>
 #include <folly/Likely.h>
+#include <folly/Varint.h>
 #include <folly/lang/Bits.h>
 #include <folly/small_vector.h>
 #include <folly/stats/Histogram.h>
@@ -963,37 +964,357 @@ CompactHistogram& CompactHistogram::operator=(const CompactHistogram& rhs) {
   return *this;
 }
 
+static const std::vector<HistogramUnit>* latencyUnits() {
+  static std::vector<HistogramUnit> units{{1l, "us"},
+                                          {1000l, "ms"},
+                                          {1000000l, "s"},
+                                          {60000000l, "min"},
+                                          {3600000000l, "hr"}};
+  return &units;
+}
+
+static const std::vector<HistogramUnit>* sizeUnits() {
+  static std::vector<HistogramUnit> units{{1l, "B"},
+                                          {1l << 10, "KiB"},
+                                          {1l << 20, "MiB"},
+                                          {1l << 30, "GiB"},
+                                          {1l << 40, "TiB"},
+                                          {1l << 50, "PiB"}};
+  return &units;
+}
+
+static const std::vector<HistogramUnit>* noUnits() {
+  static std::vector<HistogramUnit> units{{1l, ""},
+                                          {1000l, "K"},
+                                          {1000000l, "M"},
+                                          {1000000000l, "B"},
+                                          {1000000000000l, "T"}};
+  return &units;
+}
+
 CompactLatencyHistogram::CompactLatencyHistogram(
     folly::Optional<PublishRange> publish_range)
-    : CompactHistogram(
-          [] {
-            static std::vector<Unit> units{{1l, "us"},
-                                           {1000l, "ms"},
-                                           {1000000l, "s"},
-                                           {60000000l, "min"},
-                                           {3600000000l, "hr"}};
-            return &units;
-          }(),
-          std::move(publish_range)) {}
-
-CompactSizeHistogram::CompactSizeHistogram()
-    : CompactHistogram([] {
-        static std::vector<Unit> units{{1l, "B"},
-                                       {1l << 10, "KiB"},
-                                       {1l << 20, "MiB"},
-                                       {1l << 30, "GiB"},
-                                       {1l << 40, "TiB"},
-                                       {1l << 50, "PiB"}};
-        return &units;
-      }()) {}
+    : CompactHistogram(latencyUnits(), std::move(publish_range)) {}
+
+CompactSizeHistogram::CompactSizeHistogram() : CompactHistogram(sizeUnits()) {}
 
 CompactNoUnitHistogram::CompactNoUnitHistogram()
-    : CompactHistogram([] {
-        static std::vector<Unit> units{{1l, ""},
-                                       {1000l, "K"},
-                                       {1000000l, "M"},
-                                       {1000000000l, "B"},
-                                       {1000000000000l, "T"}};
-        return &units;
-      }()) {}
+    : CompactHistogram(noUnits()) {}
+
+constexpr double HighResHistogram::DEFAULT_RELATIVE_ACCURACY;
+constexpr uint8_t HighResHistogram::SERIALIZATION_VERSION;
+
+HighResHistogram::HighResHistogram(const std::vector<HistogramUnit>* units,
+                                   double relative_accuracy)
+    : units_(units),
+      relative_accuracy_(relative_accuracy),
+      log_gamma_(std::log1p(2 * relative_accuracy / (1 - relative_accuracy))),
+      inv_log_gamma_(1 / log_gamma_),
+      // Bucket 0 for values <= 0, then enough buckets to reach INT64_MAX.
+      num_buckets_(2 +
+                   static_cast<size_t>(std::ceil(
+                       std::log(std::numeric_limits<int64_t>::max()) *
+                       inv_log_gamma_))),
+      buckets_(new std::atomic<uint64_t>[num_buckets_]) {
+  ld_check(relative_accuracy > 0 && relative_accuracy < 1);
+  clear();
+}
+
+HighResHistogram::HighResHistogram(const HighResHistogram& rhs)
+    : units_(rhs.units_),
+      relative_accuracy_(rhs.relative_accuracy_),
+      log_gamma_(rhs.log_gamma_),
+      inv_log_gamma_(rhs.inv_log_gamma_),
+      num_buckets_(rhs.num_buckets_),
+      buckets_(new std::atomic<uint64_t>[num_buckets_]) {
+  assign(rhs);
+}
+
+HighResHistogram& HighResHistogram::operator=(const HighResHistogram& rhs) {
+  assign(rhs);
+  return *this;
+}
+
+size_t HighResHistogram::valueToIndex(int64_t value) const {
+  if (value <= 0) {
+    return 0;
+  }
+  double k = std::ceil(std::log(static_cast<double>(value)) * inv_log_gamma_);
+  // k can come out as -0 for value 1, and rounding can push the biggest
+  // values past the last bucket.
+  return std::min(1 + static_cast<size_t>(std::max(k, 0.)), num_buckets_ - 1);
+}
+
+double HighResHistogram::bucketUpperBound(size_t index) const {
+  ld_check(index > 0);
+  return std::exp((index - 1) * log_gamma_);
+}
+
+int64_t HighResHistogram::indexToValue(size_t index) const {
+  if (index == 0) {
+    return 0;
+  }
+  // The point of (g^(k-1), g^k] with the same relative distance to both ends:
+  // 2*g^k/(g+1) = g^k*(1-a).
+  double v = bucketUpperBound(index) * (1 - relative_accuracy_);
+  if (v >= static_cast<double>(std::numeric_limits<int64_t>::max())) {
+    return std::numeric_limits<int64_t>::max();
+  }
+  return std::max(1l, static_cast<int64_t>(std::llround(v)));
+}
+
+uint32_t HighResHistogram::accuracyPpm() const {
+  return static_cast<uint32_t>(std::lround(relative_accuracy_ * 1e6));
+}
+
+void HighResHistogram::add(int64_t value) {
+  buckets_[valueToIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+}
+
+void HighResHistogram::clear() {
+  for (size_t i = 0; i < num_buckets_; ++i) {
+    buckets_[i].store(0, std::memory_order_relaxed);
+  }
+  sum_.store(0, std::memory_order_relaxed);
+}
+
+void HighResHistogram::assign(const HistogramInterface& other_if) {
+  auto& other = checked_cref_cast<HighResHistogram>(other_if);
+  ld_check(units_ == other.units_);
+  ld_check_eq(num_buckets_, other.num_buckets_);
+
+  for (size_t i = 0; i < num_buckets_; ++i) {
+    buckets_[i].store(other.buckets_[i].load(std::memory_order_relaxed),
+                      std::memory_order_relaxed);
+  }
+  sum_.store(
+      other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void HighResHistogram::merge(const HistogramInterface& other_if) {
+  auto& other = checked_cref_cast<HighResHistogram>(other_if);
+  ld_check(units_ == other.units_);
+  ld_check_eq(num_buckets_, other.num_buckets_);
+
+  for (size_t i = 0; i < num_buckets_; ++i) {
+    uint64_t x = other.buckets_[i].load(std::memory_order_relaxed);
+    if (x != 0) {
+      buckets_[i].fetch_add(x, std::memory_order_relaxed);
+    }
+  }
+  sum_.fetch_add(
+      other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void HighResHistogram::subtract(const HistogramInterface& other_if) {
+  auto& other = checked_cref_cast<HighResHistogram>(other_if);
+  ld_check(units_ == other.units_);
+  ld_check_eq(num_buckets_, other.num_buckets_);
+
+  for (size_t i = 0; i < num_buckets_; ++i) {
+    uint64_t x = other.buckets_[i].load(std::memory_order_relaxed);
+    if (x == 0) {
+      continue;
+    }
+    uint64_t prev = buckets_[i].fetch_sub(x, std::memory_order_relaxed);
+    if (!dd_assert(x <= prev,
+                   "Histogram subtraction overflowed. Bucket %lu, this: %lu, "
+                   "right operand: %lu",
+                   i,
+                   prev,
+                   x)) {
+      buckets_[i].store(0, std::memory_order_relaxed);
+    }
+  }
+  sum_.fetch_sub(
+      other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void HighResHistogram::estimatePercentiles(const double* percentiles,
+                                           size_t npercentiles,
+                                           int64_t* samples_out,
+                                           uint64_t* count_out,
+                                           int64_t* sum_out) const {
+  // Copy the buckets so that concurrent add()s don't make the count
+  // inconsistent with what we see while walking the buckets.
+  std::vector<uint64_t> buckets(num_buckets_);
+  uint64_t count = 0;
+  for (size_t i = 0; i < num_buckets_; ++i) {
+    buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    count += buckets[i];
+  }
+  if (count_out) {
+    *count_out = count;
+  }
+  if (sum_out) {
+    *sum_out = sum_.load(std::memory_order_relaxed);
+  }
+
+  if (npercentiles == 0) {
+    return;
+  }
+
+  ld_check(samples_out != nullptr);
+  ld_check(std::is_sorted(percentiles, percentiles + npercentiles));
+  ld_check(std::all_of(percentiles, percentiles + npercentiles, [](double p) {
+    return p >= 0.0 && p <= 1.0;
+  }));
+
+  if (count == 0) {
+    std::fill(samples_out, samples_out + npercentiles, 0l);
+    return;
+  }
+
+  // Report the value of rank p*(count-1), i.e. the minimum for p = 0 and the
+  // maximum for p = 1, within relative accuracy.
+  size_t idx = 0;    // index in percentiles
+  uint64_t seen = 0; // count in buckets seen so far
+  for (size_t i = 0; i < num_buckets_ && idx < npercentiles; ++i) {
+    if (buckets[i] == 0) {
+      continue;
+    }
+    seen += buckets[i];
+    while (idx < npercentiles &&
+           (percentiles[idx] * (count - 1) < seen || seen == count)) {
+      samples_out[idx] = indexToValue(i);
+      ++idx;
+    }
+  }
+
+  ld_check(idx == npercentiles);
+}
+
+const HistogramUnit& HighResHistogram::pickUnit(int64_t value) const {
+  ld_check(units_ != nullptr);
+  ld_check(!units_->empty());
+
+  // Find the biggest unit smaller than value.
+  size_t idx = units_->size() - 1;
+  while (idx > 0 && (*units_)[idx].unit > value) {
+    --idx;
+  }
+  return (*units_)[idx];
+}
+
+void HighResHistogram::print(std::ostream& out) const {
+  std::array<double, 4> pct = {.5, .75, .95, .99};
+
+  std::vector<uint64_t> buckets(num_buckets_);
+  uint64_t count = 0;
+  for (size_t i = 0; i < num_buckets_; ++i) {
+    buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    count += buckets[i];
+  }
+
+  size_t idx = 0;    // in `pct`
+  uint64_t seen = 0; // count in buckets seen so far
+  for (size_t i = 0; i < num_buckets_; ++i) {
+    uint64_t x = buckets[i];
+    if (x == 0) {
+      continue;
+    }
+
+    double max = i ? bucketUpperBound(i) : 0;
+    double min = i ? max / std::exp(log_gamma_) : 0;
+    uint64_t next = seen + x;
+
+    const HistogramUnit& u = pickUnit(static_cast<int64_t>(min));
+    std::string label =
+        folly::sformat("{:.3f}..{:.3f}{}", min / u.unit, max / u.unit, u.name);
+
+    std::string pct_str;
+    while (idx < pct.size() &&
+           (pct[idx] * (count - 1) < next || next == count)) {
+      pct_str += folly::sformat(" p{}", static_cast<int>(pct[idx] * 100 + .5));
+      ++idx;
+    }
+
+    out << std::setw(24) << std::right << label << std::setw(1) << " : "
+        << std::setw(10) << std::left << x << std::setw(1) << pct_str
+        << std::endl;
+
+    seen = next;
+  }
+}
+
+std::string HighResHistogram::getUnitName() const {
+  return units_->at(0).name;
+}
+
+std::string HighResHistogram::valueToString(int64_t value) const {
+  const HistogramUnit& u = pickUnit(value);
+  return folly::sformat("{:.3f}{}", 1. * value / u.unit, u.name);
+}
+
+bool HighResHistogram::serialize(std::string* out) const {
+  ld_check(out != nullptr);
+  uint8_t buf[folly::kMaxVarintLength64];
+  auto append_varint = [&](uint64_t v) {
+    size_t len = folly::encodeVarint(v, buf);
+    out->append(reinterpret_cast<const char*>(buf), len);
+  };
+
+  out->push_back(static_cast<char>(SERIALIZATION_VERSION));
+  append_varint(accuracyPpm());
+  append_varint(folly::encodeZigZag(sum_.load(std::memory_order_relaxed)));
+  size_t prev = 0;
+  for (size_t i = 0; i < num_buckets_; ++i) {
+    uint64_t x = buckets_[i].load(std::memory_order_relaxed);
+    if (x == 0) {
+      continue;
+    }
+    append_varint(i - prev);
+    append_varint(x);
+    prev = i;
+  }
+  return true;
+}
+
+bool HighResHistogram::mergeSerialized(folly::StringPiece data) {
+  folly::ByteRange range(data);
+  if (range.empty() || range[0] != SERIALIZATION_VERSION) {
+    return false;
+  }
+  range.advance(1);
+
+  // Decode everything before touching the buckets so that a malformed input
+  // leaves the histogram unchanged.
+  int64_t sum;
+  std::vector<std::pair<size_t, uint64_t>> buckets;
+  try {
+    if (folly::decodeVarint(range) != accuracyPpm()) {
+      return false;
+    }
+    sum = folly::decodeZigZag(folly::decodeVarint(range));
+    size_t idx = 0;
+    while (!range.empty()) {
+      uint64_t delta = folly::decodeVarint(range);
+      uint64_t count = folly::decodeVarint(range);
+      // Indices are strictly increasing, except that the first one may be 0.
+      if ((delta == 0 && !buckets.empty()) || delta >= num_buckets_ - idx) {
+        return false;
+      }
+      idx += delta;
+      buckets.emplace_back(idx, count);
+    }
+  } catch (...) {
+    return false;
+  }
+
+  for (const auto& b : buckets) {
+    buckets_[b.first].fetch_add(b.second, std::memory_order_relaxed);
+  }
+  sum_.fetch_add(sum, std::memory_order_relaxed);
+  return true;
+}
+
+HighResLatencyHistogram::HighResLatencyHistogram(double relative_accuracy)
+    : HighResHistogram(latencyUnits(), relative_accuracy) {}
+
+HighResSizeHistogram::HighResSizeHistogram(double relative_accuracy)
+    : HighResHistogram(sizeUnits(), relative_accuracy) {}
+
+HighResNoUnitHistogram::HighResNoUnitHistogram(double relative_accuracy)
+    : HighResHistogram(noUnits(), relative_accuracy) {}
 }} // namespace facebook::logdevice
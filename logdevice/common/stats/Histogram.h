@@ -186,6 +186,37 @@ class HistogramInterface {
   // bucket boundaries are printed by print(). E.g. for latency histogram
   // 1234567 would be turned into something like "1.234 s"
   virtual std::string valueToString(int64_t value) const = 0;
+
+  /**
+   * Appends a compact binary encoding of this histogram to `out`, for
+   * publishing or sending to another process, where mergeSerialized() of the
+   * same type of histogram can merge it. Unlike percentiles, such histograms
+   * from different nodes can be combined into cluster-wide percentiles.
+   *
+   * @return  false if this kind of histogram doesn't support it
+   */
+  virtual bool serialize(std::string* /*out*/) const {
+    return false;
+  }
+
+  /**
+   * Merges a histogram encoded by serialize() into this one.
+   *
+   * @return  false if `data` is malformed or comes from an incompatible
+   *          histogram, or if this kind of histogram doesn't support it. This
+   *          histogram is unchanged then.
+   */
+  virtual bool mergeSerialized(folly::StringPiece /*data*/) {
+    return false;
+  }
+};
+
+// A unit of measurement used when printing histograms, e.g. {1000, "ms"} for
+// a histogram of microseconds.
+struct HistogramUnit {
+  // What value constitutes one of this unit. E.g. 1<<20 for "MiB".
+  int64_t unit;
+  const char* name;
 };
 
 // A mix of linear and exponential histograms: a collection of linear histograms
@@ -466,11 +497,7 @@ class CompactHistogram : public HistogramInterface {
   FrequencyCounters getFrequencyCounters() const override;
 
  protected:
-  struct Unit {
-    // What value constitutes one of this unit. E.g. 1<<20 for "MiB".
-    int64_t unit;
-    const char* name;
-  };
+  using Unit = HistogramUnit;
 
   explicit CompactHistogram(
       const std::vector<Unit>* units,
@@ -503,4 +530,103 @@ class CompactNoUnitHistogram : public CompactHistogram {
   CompactNoUnitHistogram();
 };
 
+// Histogram with logarithmically sized buckets, such that percentile
+// estimates have a bounded relative error (as in DDSketch): with relative
+// accuracy `a`, bucket i > 0 holds values in (g^(i-2), g^(i-1)] with
+// g = (1+a)/(1-a), and the estimate for any value in it is within a*value of
+// that value. Bucket 0 holds values <= 0. With the default 1% accuracy, all
+// of int64_t takes about 2200 buckets.
+//
+// Compared to the other histograms:
+//  + precision is the same at all scales, and tunable
+//  + add() is lock-free, one log() and one relaxed atomic add; all methods
+//    are thread-safe
+//  + serialize() produces a compact encoding (only nonempty buckets) that
+//    other nodes can merge, so cluster-wide percentiles are as accurate as
+//    per-node ones
+//  - bigger than CompactHistogram: ~17KB at 1% accuracy
+//
+// The HighRes*Histogram subclasses can replace the histograms with the same
+// units one by one, e.g. LatencyHistogram with HighResLatencyHistogram.
+class HighResHistogram : public HistogramInterface {
+ public:
+  static constexpr double DEFAULT_RELATIVE_ACCURACY = 0.01;
+
+  // Must be the same subclass with the same accuracy.
+  HighResHistogram(const HighResHistogram& rhs);
+  HighResHistogram& operator=(const HighResHistogram& rhs);
+
+  void add(int64_t value) override;
+  void clear() override;
+  void assign(const HistogramInterface& other) override;
+  void merge(const HistogramInterface& other) override;
+  void subtract(const HistogramInterface& other) override;
+  void estimatePercentiles(const double* percentiles,
+                           size_t npercentiles,
+                           int64_t* samples_out,
+                           uint64_t* count_out = nullptr,
+                           int64_t* sum_out = nullptr) const override;
+  void print(std::ostream& out) const override;
+
+  std::string getUnitName() const override;
+  std::string valueToString(int64_t value) const override;
+
+  // Format: a version byte, the relative accuracy in parts per million and
+  // the sum of values, then the (index delta, count) of each nonempty bucket,
+  // all varints.
+  bool serialize(std::string* out) const override;
+  bool mergeSerialized(folly::StringPiece data) override;
+
+  double getRelativeAccuracy() const {
+    return relative_accuracy_;
+  }
+
+  size_t getNumBuckets() const {
+    return num_buckets_;
+  }
+
+ protected:
+  HighResHistogram(const std::vector<HistogramUnit>* units,
+                   double relative_accuracy);
+
+ private:
+  static constexpr uint8_t SERIALIZATION_VERSION = 1;
+
+  size_t valueToIndex(int64_t value) const;
+  // The value reported for values in bucket `index`.
+  int64_t indexToValue(size_t index) const;
+  // g^(index-1), the upper bound of values in bucket `index` > 0.
+  double bucketUpperBound(size_t index) const;
+  uint32_t accuracyPpm() const;
+  const HistogramUnit& pickUnit(int64_t value) const;
+
+  const std::vector<HistogramUnit>* units_;
+  const double relative_accuracy_;
+  // ln(g) and 1/ln(g)
+  const double log_gamma_;
+  const double inv_log_gamma_;
+  const size_t num_buckets_;
+  std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+  // Exact sum of values added.
+  std::atomic<int64_t> sum_{0};
+};
+
+class HighResLatencyHistogram : public HighResHistogram {
+ public:
+  explicit HighResLatencyHistogram(
+      double relative_accuracy = DEFAULT_RELATIVE_ACCURACY);
+};
+
+class HighResSizeHistogram : public HighResHistogram {
+ public:
+  explicit HighResSizeHistogram(
+      double relative_accuracy = DEFAULT_RELATIVE_ACCURACY);
+};
+
+class HighResNoUnitHistogram : public HighResHistogram {
+ public:
+  explicit HighResNoUnitHistogram(
+      double relative_accuracy = DEFAULT_RELATIVE_ACCURACY);
+};
+
 }} // namespace facebook::logdevice
@@ -46,6 +46,8 @@ struct PerShardHistograms : public PerShardHistogramBundle {
         {"flushed_log_run_length", &flushed_log_run_length},
         {"compacted_log_run_length", &compacted_log_run_length},
         {"trimmed_record_age", &trimmed_record_age},
+        {"sync_latency", &sync_latency},
+        {"sync_batch_size", &sync_batch_size},
 
         // Rebuilding related histograms
         {"record_rebuilding", &record_rebuilding},
@@ -113,6 +115,12 @@ struct PerShardHistograms : public PerShardHistogramBundle {
   // The Histogram of trimmed records age, in seconds
   record_age_histogram_t trimmed_record_age;
 
+  // Duration of LocalLogStore::sync() calls made by SyncingStorageThread.
+  latency_histogram_t sync_latency;
+
+  // Number of tasks released by each of those sync() calls.
+  compact_no_unit_histogram_t sync_batch_size;
+
   // Latency of RecordRebuilding state machine.
   compact_latency_histogram_t record_rebuilding;
 
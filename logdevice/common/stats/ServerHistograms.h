@@ -50,6 +50,7 @@ struct ServerHistograms : public HistogramBundle {
         {"logsconfig_manager_delta_apply_latency",
          &logsconfig_manager_delta_apply_latency},
         {"background_thread_duration", &background_thread_duration},
+        {"cpu_executor_queue_latency", &cpu_executor_queue_latency},
         {"nodes_configuration_manager_propagation_latency",
          &nodes_configuration_manager_propagation_latency},
 #define REQUEST_TYPE(name)              \
@@ -68,8 +69,9 @@ struct ServerHistograms : public HistogramBundle {
 #include "logdevice/common/storage_task_types.inc" // nolint
     };
   }
-  // Latency of appends as seen by the sequencer
-  LatencyHistogram append_latency;
+  // Latency of appends as seen by the sequencer. High resolution so that
+  // percentiles can be merged across sequencers.
+  HighResLatencyHistogram append_latency;
 
   LatencyHistogram write_to_read_latency;
 
@@ -134,6 +136,9 @@ struct ServerHistograms : public HistogramBundle {
 
   CompactLatencyHistogram background_thread_duration;
 
+  // Time tasks spend queued in the Processor's work stealing CPU executor.
+  CompactLatencyHistogram cpu_executor_queue_latency;
+
   // How long did it take between when the config is published and when it
   // was received on the server in msec.
   CompactLatencyHistogram nodes_configuration_manager_propagation_latency;
@@ -116,6 +116,16 @@ void PerLogStats::aggregate(PerLogStats const& other,
 #include "logdevice/common/stats/per_log_stats.inc" // nolint
 }
 
+void PerLogStats::reset() {
+#define STAT_DEFINE(name, _) name = {};
+#include "logdevice/common/stats/per_log_stats.inc" // nolint
+
+  std::lock_guard<std::mutex> guard(mutex);
+#define TIME_SERIES_DEFINE(name, _, __, ___) name.reset();
+#include "logdevice/common/stats/per_log_time_series.inc" // nolint
+  custom_counters.reset();
+}
+
 void PerTrafficClassStats::aggregate(PerTrafficClassStats const& other,
                                      StatsAggOptional agg_override) {
 #define STAT_DEFINE(name, agg) \
@@ -297,6 +307,26 @@ Stats& Stats::operator=(const Stats& other) {
   return *this;
 }
 
+PerLogStats& Stats::addPerLogStats(const std::string& log_name) {
+  PerLogStats* log_stats;
+  {
+    auto stats_ulock = per_log_stats.ulock();
+    auto stats_it = stats_ulock->find(log_name);
+    if (stats_it != stats_ulock->end()) {
+      // Added by aggregate() into this Stats object.
+      log_stats = stats_it->second.get();
+    } else {
+      // No risk of deadlock because we are the only writer thread.
+      auto stats_ptr = std::make_shared<PerLogStats>();
+      log_stats = stats_ptr.get();
+      stats_ulock.moveFromUpgradeToWrite()->emplace_hint(
+          stats_it, log_name, std::move(stats_ptr));
+    }
+  }
+  per_log_stats_cache.emplace(log_name, log_stats);
+  return *log_stats;
+}
+
 Stats::Stats(Stats&& other) noexcept(true) = default;
 
 Stats& Stats::operator=(Stats&& other) noexcept(false) = default;
@@ -450,22 +480,23 @@ void Stats::aggregateCompoundStats(Stats const& other,
         other.per_storage_task_type_stats[i], agg_override);
   }
 
-  // Aggregate per log stats. Use synchronizedCopy() to copy other's
-  // per_log_stats into temporary vector, to avoid holding a read lock on it
-  // while we aggregate.
-  this->per_log_stats.withWLock(
-      [&agg_override,
-       other_per_log_stats_entries = other.synchronizedCopy(
-           &Stats::per_log_stats)](auto& this_per_log_stats) {
-        for (const auto& kv : other_per_log_stats_entries) {
-          ld_check(kv.second != nullptr);
-          auto& stats_ptr = this_per_log_stats[kv.first];
-          if (stats_ptr == nullptr) {
-            stats_ptr = std::make_shared<PerLogStats>();
-          }
-          stats_ptr->aggregate(*kv.second, agg_override);
+  // Aggregate per log stats. No need to copy other's per_log_stats out
+  // first: the thread owning it only takes the write lock for log groups it
+  // hasn't seen before (see perLogStats()), so holding the read lock while
+  // we aggregate doesn't get in its way.
+  other.per_log_stats.withRLock([&](const auto& other_per_log_stats) {
+    this->per_log_stats.withWLock([&](auto& this_per_log_stats) {
+      this_per_log_stats.reserve(other_per_log_stats.size());
+      for (const auto& kv : other_per_log_stats) {
+        ld_check(kv.second != nullptr);
+        auto& stats_ptr = this_per_log_stats[kv.first];
+        if (stats_ptr == nullptr) {
+          stats_ptr = std::make_shared<PerLogStats>();
         }
-      });
+        stats_ptr->aggregate(*kv.second, agg_override);
+      }
+    });
+  });
 
   // Aggregate per worker stats. Also use synchronizedCopy()
   this->per_worker_stats.withWLock(
@@ -560,7 +591,10 @@ void Stats::reset() {
 
       per_worker_stats.wlock()->clear();
 
-      per_log_stats.wlock()->clear();
+      // Zeroed rather than removed, perLogStats() holds on to them.
+      for (auto& kv : *per_log_stats.rlock()) {
+        kv.second->reset();
+      }
       break;
     case StatsParams::StatsSet::LDBENCH_WORKER:
 #define STAT_DEFINE(name, _) ldbench->name = {};
@@ -939,24 +973,84 @@ StatsHolder::StatsHolder(StatsParams params)
 Stats StatsHolder::aggregate() const {
   Stats result(&params_);
 
+  std::vector<std::shared_ptr<Stats>> live_stats;
   {
     auto accessor = thread_stats_.accessAllThreads();
     result.aggregate(dead_stats_);
     for (const auto& x : accessor) {
-      result.aggregate(x.stats);
+      live_stats.push_back(x.stats);
     }
   }
+  // See the comment on thread_stats_ for why this doesn't count any thread
+  // twice.
+  for (const auto& stats : live_stats) {
+    result.aggregate(*stats);
+  }
 
   result.deriveStats();
 
   return result;
 }
 
+namespace {
+
+// Adds the per-log-group counters of `stats` to `totals`.
+void addPerLogCounters(
+    const Stats& stats,
+    std::unordered_map<std::string, PerLogCounters>& totals) {
+  stats.per_log_stats.withRLock([&](const auto& per_log_stats) {
+    for (const auto& kv : per_log_stats) {
+      ld_check(kv.second != nullptr);
+      PerLogCounters& counters = totals[kv.first];
+#define STAT_DEFINE(name, _) counters.name += kv.second->name;
+#include "logdevice/common/stats/per_log_stats.inc" // nolint
+    }
+  });
+}
+
+} // namespace
+
+std::unordered_map<std::string, PerLogCounters>
+StatsHolder::perLogStatsDelta() {
+  std::unordered_map<std::string, PerLogCounters> totals;
+
+  // Same as in aggregate(), see the comment on thread_stats_.
+  std::vector<std::shared_ptr<Stats>> live_stats;
+  {
+    auto accessor = thread_stats_.accessAllThreads();
+    addPerLogCounters(dead_stats_, totals);
+    for (const auto& x : accessor) {
+      live_stats.push_back(x.stats);
+    }
+  }
+  for (const auto& stats : live_stats) {
+    addPerLogCounters(*stats, totals);
+  }
+
+  std::unordered_map<std::string, PerLogCounters> delta;
+  per_log_last_read_.withWLock([&](auto& last_read) {
+    for (const auto& kv : totals) {
+      PerLogCounters& last = last_read[kv.first];
+      PerLogCounters change;
+      bool changed = false;
+#define STAT_DEFINE(name, _)                \
+  change.name = kv.second.name - last.name; \
+  changed = changed || change.name != 0;
+#include "logdevice/common/stats/per_log_stats.inc" // nolint
+      if (changed) {
+        delta.emplace(kv.first, change);
+      }
+      last = kv.second;
+    }
+  });
+  return delta;
+}
+
 void StatsHolder::reset() {
   auto accessor = thread_stats_.accessAllThreads();
   dead_stats_.reset();
   for (auto& x : accessor) {
-    x.stats.reset();
+    x.stats->reset();
   }
 }
 
@@ -137,6 +137,13 @@ struct PerLogStats {
    * Add or subtract most values from @param other.
    */
   void aggregate(PerLogStats const& other, StatsAggOptional agg_override);
+
+  /**
+   * Zeroes all counters and drops the time series. Unlike removing the
+   * object, this keeps pointers to it valid, see Stats::perLogStats().
+   */
+  void reset();
+
 #define STAT_DEFINE(name, _) StatsCounter name{};
 #include "logdevice/common/stats/per_log_stats.inc" // nolint
 
@@ -151,6 +158,15 @@ struct PerLogStats {
   std::mutex mutex;
 };
 
+/**
+ * Plain values of the counters of a PerLogStats, see
+ * StatsHolder::perLogStatsDelta().
+ */
+struct PerLogCounters {
+#define STAT_DEFINE(name, _) int64_t name{0};
+#include "logdevice/common/stats/per_log_stats.inc" // nolint
+};
+
 struct PerTrafficClassStats {
   PerTrafficClassStats() {}
 
@@ -684,11 +700,29 @@ struct Stats final {
   std::array<PerStorageTaskTypeStats, static_cast<int>(StorageTaskType::MAX)>
       per_storage_task_type_stats = {};
 
-  // Per-log-group stats
+  /**
+   * Returns the stats of log group `log_name`, creating them if needed. Only
+   * the thread owning this Stats object (see StatsHolder::get()) may call
+   * this. Takes no lock unless the log group is new to this thread.
+   */
+  PerLogStats& perLogStats(const std::string& log_name) {
+    auto it = per_log_stats_cache.find(log_name);
+    if (LIKELY(it != per_log_stats_cache.end())) {
+      return *it->second;
+    }
+    return addPerLogStats(log_name);
+  }
+
+  // Per-log-group stats. Entries are never removed, reset() zeroes them
+  // instead.
   folly::Synchronized<
       std::unordered_map<std::string, std::shared_ptr<PerLogStats>>>
       per_log_stats;
 
+  // The entries of per_log_stats, for lookups by perLogStats() without
+  // locking. Only used by the thread owning this Stats object.
+  folly::F14FastMap<std::string, PerLogStats*> per_log_stats_cache;
+
   // Server histograms. Initialized only on servers.
   std::unique_ptr<ServerHistograms> server_histograms;
 
@@ -789,6 +823,10 @@ struct Stats final {
   // if this Stats object is local to a particular worker thread of type
   // GENERAL, this will contain its id, and -1 otherwise
   worker_id_t worker_id;
+
+ private:
+  // Slow path of perLogStats().
+  PerLogStats& addPerLogStats(const std::string& log_name);
 };
 
 class Stats::EnumerationCallbacks {
@@ -865,6 +903,15 @@ class StatsHolder {
    */
   void reset();
 
+  /**
+   * Returns how much the per-log-group counters of all threads changed since
+   * the previous call. Log groups that didn't change are left out. Cheaper
+   * than diffing two aggregate() results when most log groups are idle: only
+   * per-log counters are read, and nothing is kept per thread. Counts
+   * dropped by reset() show up as negative changes.
+   */
+  std::unordered_map<std::string, PerLogCounters> perLogStatsDelta();
+
   /**
    * Returns the Stats object for the current thread.
    */
@@ -886,6 +933,10 @@ class StatsHolder {
   // Stats aggregated for all destroyed threads.
   Stats dead_stats_;
 
+  // Per-log-group counters as of the previous perLogStatsDelta() call.
+  folly::Synchronized<std::unordered_map<std::string, PerLogCounters>>
+      per_log_last_read_;
+
   // Stats for running threads.
   //
   // We use AccessModeStrict to prevent race conditions around dead_stats_;
@@ -919,20 +970,27 @@ class StatsHolder {
   // thread_stats_'s list of threads and dead_stats_ together, so in
   // aggregate()'s view each thread's stats are accounted once: either in
   // dead_stats_ or in thread_stats_.
+  //
+  // aggregate() only holds the mutex to read dead_stats_ and to take a
+  // reference to each thread's Stats. It reads those after releasing the
+  // mutex, so that threads don't wait for it to start or exit. A thread
+  // exiting in the meantime adds its stats to dead_stats_ only after
+  // aggregate() is done with dead_stats_.
   folly::ThreadLocalPtr<StatsWrapper, Tag, folly::AccessModeStrict>
       thread_stats_;
 };
 
 struct StatsHolder::StatsWrapper {
-  Stats stats;
+  // Shared with aggregate() while it reads it.
+  std::shared_ptr<Stats> stats;
   StatsHolder* owner;
 
   explicit StatsWrapper(StatsHolder* owner)
-      : stats(&owner->params_), owner(owner) {}
+      : stats(std::make_shared<Stats>(&owner->params_)), owner(owner) {}
 
   ~StatsWrapper() {
     if (owner) {
-      owner->dead_stats_.aggregateForDestroyedThread(stats);
+      owner->dead_stats_.aggregateForDestroyedThread(*stats);
     }
   }
 };
@@ -943,7 +1001,7 @@ Stats& StatsHolder::get() {
     wrapper = new StatsWrapper(this);
     thread_stats_.reset(wrapper);
   }
-  return wrapper->stats;
+  return *wrapper->stats;
 }
 
 template <typename Func>
@@ -951,7 +1009,7 @@ void StatsHolder::runForEach(const Func& func) {
   auto accessor = thread_stats_.accessAllThreads();
   func(dead_stats_);
   for (auto& x : accessor) {
-    func(x.stats);
+    func(*x.stats);
   }
 }
 
@@ -1064,89 +1122,37 @@ class PerShardStatToken {
     }                                     \
   } while (0)
 
-#define LOG_GROUP_STAT_ADD(stats_struct, log_name, name, val)            \
-  do {                                                                   \
-    if (stats_struct) {                                                  \
-      auto stats_ulock = (stats_struct)->get().per_log_stats.ulock();    \
-      auto stats_it = stats_ulock->find((log_name));                     \
-      if (stats_it != stats_ulock->end()) {                              \
-        /* PerLogStats for log_name already exist (common case). */      \
-        /* Just atomically increment the value.  */                      \
-        stats_it->second->name += (val);                                 \
-      } else {                                                           \
-        /* PerLogStats for log_name do not exist yet (rare case). */     \
-        /* Upgrade ulock to wlock and emplace new PerLogStats. */        \
-        /* No risk of deadlock because we are the only writer thread. */ \
-        auto stats_ptr = std::make_shared<PerLogStats>();                \
-        stats_ptr->name += (val);                                        \
-        stats_ulock.moveFromUpgradeToWrite()->emplace_hint(              \
-            stats_it, (log_name), std::move(stats_ptr));                 \
-      }                                                                  \
-    }                                                                    \
+#define LOG_GROUP_STAT_ADD(stats_struct, log_name, name, val)      \
+  do {                                                             \
+    if (stats_struct) {                                            \
+      (stats_struct)->get().perLogStats((log_name)).name += (val); \
+    }                                                              \
   } while (0)
 
 #define LOG_GROUP_TIME_SERIES_ADD(stats_struct, stat_name, log_name, val)      \
   do {                                                                         \
     if (stats_struct) {                                                        \
-      auto stats_ulock = (stats_struct)->get().per_log_stats.ulock();          \
-      /* Unfortunately, the type of the lock after a downgrade from write to   \
-       * upgrade isn't the same as the type of upgrade lock initially acquired \
-       */                                                                      \
-      folly::LockedPtr<decltype(stats_ulock)::Synchronized,                    \
-                       folly::LockPolicyFromExclusiveToUpgrade>                \
-          stats_downgraded_ulock;                                              \
-      auto stats_it = stats_ulock->find((log_name));                           \
-      if (UNLIKELY(stats_it == stats_ulock->end())) {                          \
-        /* PerLogStats for log_name do not exist yet (rare case). */           \
-        /* Upgrade ulock to wlock and emplace new PerLogStats. */              \
-        /* No risk of deadlock because we are the only writer thread. */       \
-        auto stats_ptr = std::make_shared<PerLogStats>();                      \
-        auto stats_wlock = stats_ulock.moveFromUpgradeToWrite();               \
-        stats_it =                                                             \
-            stats_wlock->emplace((log_name), std::move(stats_ptr)).first;      \
-        stats_downgraded_ulock = stats_wlock.moveFromWriteToUpgrade();         \
-      }                                                                        \
-      {                                                                        \
-        std::lock_guard<std::mutex> guard(stats_it->second->mutex);            \
-        if (UNLIKELY(!stats_it->second->stat_name)) {                          \
-          stats_it->second->stat_name = std::make_shared<PerLogTimeSeries>(    \
-              (stats_struct)->params_.get()->num_buckets_##stat_name,          \
-              (stats_struct)->params_.get()->time_intervals_##stat_name);      \
-        }                                                                      \
-        stats_it->second->stat_name->addValue(val);                            \
+      PerLogStats& log_stats_ = (stats_struct)->get().perLogStats((log_name)); \
+      std::lock_guard<std::mutex> guard(log_stats_.mutex);                     \
+      if (UNLIKELY(!log_stats_.stat_name)) {                                   \
+        log_stats_.stat_name = std::make_shared<PerLogTimeSeries>(             \
+            (stats_struct)->params_.get()->num_buckets_##stat_name,            \
+            (stats_struct)->params_.get()->time_intervals_##stat_name);        \
       }                                                                        \
+      log_stats_.stat_name->addValue(val);                                     \
     }                                                                          \
   } while (0)
 
 #define LOG_GROUP_CUSTOM_COUNTERS_ADD(stats_struct, log_name, val)             \
   do {                                                                         \
     if (stats_struct) {                                                        \
-      auto stats_ulock = (stats_struct)->get().per_log_stats.ulock();          \
-      /* Unfortunately, the type of the lock after a downgrade from write to   \
-       * upgrade isn't the same as the type of upgrade lock initially acquired \
-       */                                                                      \
-      folly::LockedPtr<decltype(stats_ulock)::Synchronized,                    \
-                       folly::LockPolicyFromExclusiveToUpgrade>                \
-          stats_downgraded_ulock;                                              \
-      auto stats_it = stats_ulock->find((log_name));                           \
-      if (UNLIKELY(stats_it == stats_ulock->end())) {                          \
-        /* PerLogStats for log_name do not exist yet (rare case). */           \
-        /* Upgrade ulock to wlock and emplace new PerLogStats. */              \
-        /* No risk of deadlock because we are the only writer thread. */       \
-        auto stats_ptr = std::make_shared<PerLogStats>();                      \
-        auto stats_wlock = stats_ulock.moveFromUpgradeToWrite();               \
-        stats_it =                                                             \
-            stats_wlock->emplace((log_name), std::move(stats_ptr)).first;      \
-        stats_downgraded_ulock = stats_wlock.moveFromWriteToUpgrade();         \
-      }                                                                        \
-      {                                                                        \
-        std::lock_guard<std::mutex> guard(stats_it->second->mutex);            \
-        if (UNLIKELY(!stats_it->second->custom_counters)) {                    \
-          stats_it->second->custom_counters =                                  \
-              std::make_shared<CustomCountersTimeSeries>();                    \
-        }                                                                      \
-        stats_it->second->custom_counters->addCustomCounters(val);             \
+      PerLogStats& log_stats_ = (stats_struct)->get().perLogStats((log_name)); \
+      std::lock_guard<std::mutex> guard(log_stats_.mutex);                     \
+      if (UNLIKELY(!log_stats_.custom_counters)) {                             \
+        log_stats_.custom_counters =                                           \
+            std::make_shared<CustomCountersTimeSeries>();                      \
       }                                                                        \
+      log_stats_.custom_counters->addCustomCounters(val);                      \
     }                                                                          \
   } while (0)
 
@@ -10,8 +10,10 @@
 #include <unordered_map>
 
 #include <folly/Memory.h>
+#include <folly/Optional.h>
 #include <gtest/gtest.h>
 
+#include "logdevice/common/AppendLatencyBreakdown.h"
 #include "logdevice/common/ExponentialBackoffAdaptiveVariable.h"
 #include "logdevice/common/LinearCopySetSelector.h"
 #include "logdevice/common/NoopTraceLogger.h"
@@ -23,6 +25,7 @@
 #include "logdevice/common/configuration/UpdateableConfig.h"
 #include "logdevice/common/debug.h"
 #include "logdevice/common/protocol/APPENDED_Message.h"
+#include "logdevice/common/protocol/APPEND_Message.h"
 #include "logdevice/common/protocol/DELETE_Message.h"
 #include "logdevice/common/protocol/RELEASE_Message.h"
 #include "logdevice/common/protocol/STORED_Message.h"
@@ -127,6 +130,7 @@ class AppenderTest : public ::testing::Test {
   // through calls to activateStoreTimer() and activateRetryTimer(), and
   bool store_timer_active_{false};
   bool retry_timer_active_{false};
+  bool hedge_timer_active_{false};
 
   // Keep track of which nodes are not available following Appender calling
   // setNotAvailableUntil(). Used by checkNotAvailableUntil() to inform the
@@ -161,6 +165,13 @@ class AppenderTest : public ::testing::Test {
   // Indicate if the Appender already retired (set by retireAppender()).
   bool retired_{false};
 
+  // If set, start() makes the Appender trace its latency breakdown.
+  folly::Optional<AppendLatencyTrace> latency_trace_;
+
+  // Breakdown of a traced Appender, set by onLatencyBreakdown() when it's
+  // reaped.
+  folly::Optional<AppendLatencyBreakdown> latency_breakdown_;
+
   // Store the information regarding whether or not the Sequencer was preempted.
   // Set by noteAppenderPreempted() and read by checkIfPreempted().
   epoch_t preempted_epoch_{EPOCH_INVALID};
@@ -189,6 +200,9 @@ class AppenderTest : public ::testing::Test {
   // call Appender::onTimeout().
   void triggerTimeout();
 
+  // call Appender::onHedgeTimeout().
+  void triggerHedgeTimeout();
+
   // Trigger the on socket close callback for `nid`.
   void triggerOnSocketClosed(ShardID shard);
 
@@ -201,6 +215,17 @@ class AppenderTest : public ::testing::Test {
                                      std::set<ShardID> shards);
   void checkNoStoreMsg();
   void onStoredSent(Status status, uint32_t wave, std::set<ShardID> shards);
+  // Replies E::OK to the STORE sent to `shard` with the storage timings of a
+  // traced STORE, as STORED_Message does.
+  void onTracedStoredSent(uint32_t wave,
+                          ShardID shard,
+                          const STORED_LatencyTrace& trace);
+  // Overrides the timestamps of the traced Appender, relative to its
+  // creation. `store_sent` is left as recorded by the Appender if not set.
+  void setLatencyTraceTimes(
+      std::chrono::microseconds started,
+      folly::Optional<std::chrono::microseconds> store_sent,
+      std::chrono::microseconds replicated);
   void checkAppended(Status status);
   void checkDeleteMsg(std::set<ShardID> shards);
   void checkReleaseMsg(std::set<ShardID> shards);
@@ -250,7 +275,8 @@ class AppenderTest::TestCopySetSelectorDeps
  private:
   int checkConnection(NodeID nid,
                       ClientID* our_name_at_peer,
-                      bool) const override {
+                      bool,
+                      logid_t) const override {
     auto it = node_status_.find(nid);
     if (it != node_status_.end() &&
         it->second.connection_state_ != Status::OK) {
@@ -288,7 +314,9 @@ class AppenderTest::TestCopySetSelectorDeps
     return true;
   }
 
-  int connect(NodeID /*nid*/, bool /*allow_unencrypted*/) const override {
+  int connect(NodeID /*nid*/,
+              bool /*allow_unencrypted*/,
+              logid_t /*log_id*/) const override {
     // Called by when checkNode() sees a node that's not
     // connected. Ignored.
     return 0;
@@ -478,6 +506,13 @@ class AppenderTest::MockAppender : public Appender {
   bool retryTimerIsActive() override {
     return test_->retry_timer_active_;
   }
+  void initHedgeTimer() override {}
+  void activateHedgeTimer(std::chrono::microseconds) override {
+    test_->hedge_timer_active_ = true;
+  }
+  void cancelHedgeTimer() override {
+    test_->hedge_timer_active_ = false;
+  }
   bool isNodeAlive(NodeID node) override {
     // if we can't find the node in dead_nodes_, it is alive.
     return test_->dead_nodes_.find(node) == test_->dead_nodes_.end();
@@ -516,6 +551,10 @@ class AppenderTest::MockAppender : public Appender {
     return NodeID(10, 20);
   }
 
+  void onLatencyBreakdown(const AppendLatencyBreakdown& breakdown) override {
+    test_->latency_breakdown_ = breakdown;
+  }
+
   template <typename T>
   void onMessageReceived(std::unique_ptr<Message>& msg,
                          message_map_t<T>& map,
@@ -679,6 +718,9 @@ void AppenderTest::start(bool stream_message) {
     write_stream_request_id_t rqid = {stream_id, seq_num};
     appender_->setWriteStreamAppendInfo(rqid, true);
   }
+  if (latency_trace_) {
+    appender_->setLatencyTrace(*latency_trace_);
+  }
   appender_->start(nullptr, LSN);
 }
 
@@ -744,6 +786,12 @@ void AppenderTest::triggerTimeout() {
   appender_->onTimeout();
 }
 
+void AppenderTest::triggerHedgeTimeout() {
+  ASSERT_TRUE(hedge_timer_active_);
+  hedge_timer_active_ = false;
+  appender_->onHedgeTimeout();
+}
+
 void AppenderTest::triggerOnSocketClosed(ShardID shard) {
   auto it = on_close_cb_map_.find(shard.asNodeID());
   ASSERT_NE(on_close_cb_map_.end(), it);
@@ -937,6 +985,26 @@ void AppenderTest::onStoredSent(Status status,
   }
 }
 
+void AppenderTest::onTracedStoredSent(uint32_t wave,
+                                      ShardID shard,
+                                      const STORED_LatencyTrace& trace) {
+  appender_->onStorageLatencyTrace(shard, trace);
+  appender_->onReply(storedHeader(wave, E::OK), shard);
+}
+
+void AppenderTest::setLatencyTraceTimes(
+    std::chrono::microseconds started,
+    folly::Optional<std::chrono::microseconds> store_sent,
+    std::chrono::microseconds replicated) {
+  ASSERT_NE(nullptr, appender_->latency_trace_);
+  Appender::LatencyTrace& trace = *appender_->latency_trace_;
+  trace.started = appender_->creation_time_ + started;
+  if (store_sent.has_value()) {
+    trace.store_sent = appender_->creation_time_ + store_sent.value();
+  }
+  trace.replicated = appender_->creation_time_ + replicated;
+}
+
 // Reply with a STORED message with E::PREEMPTED.
 #define ON_STORED_SENT_PREEMPTED(preempted_by, wave, ...)         \
   {                                                               \
@@ -1159,6 +1227,80 @@ TEST_F(AppenderTest, ChainSending) {
   CHECK_RELEASE_MSG(N0S0, N1S0, N3S0);
 }
 
+// A traced append's breakdown takes the storage node's timings from the copy
+// that completed replication. The rest of that copy's STORE->STORED round
+// trip is network time.
+TEST_F(AppenderTest, LatencyBreakdown) {
+  using std::chrono::microseconds;
+  updateConfig();
+  first_candidate_idx_ = 0;
+  latency_trace_ = AppendLatencyTrace{0x1234, 50};
+  start();
+  ASSERT_TRUE(getHeader(store_msgs_[N0S0].get()).flags &
+              STORE_Header::LATENCY_TRACE);
+  CHECK_STORE_MSG(1, N4S0);
+  CHECK_STORE_MSG_AND_TRIGGER_ON_SENT(E::OK, 1, N0S0, N1S0, N2S0, N3S0);
+  onTracedStoredSent(1, N0S0, STORED_LatencyTrace{1, 2, 3});
+  onTracedStoredSent(1, N1S0, STORED_LatencyTrace{10, 20, 30});
+  // Completes replication.
+  onTracedStoredSent(1, N3S0, STORED_LatencyTrace{100, 200, 300});
+  CHECK_APPENDED(E::OK);
+  ASSERT_TRUE(retired_);
+  CHECK_DELETE_MSG(N2S0, N4S0);
+  setLatencyTraceTimes(
+      microseconds(1000), microseconds(1500), microseconds(3500));
+  Appender::Reaper()(appender_);
+  CHECK_RELEASE_MSG(N0S0, N1S0, N3S0);
+
+  ASSERT_TRUE(latency_breakdown_.has_value());
+  const AppendLatencyBreakdown& b = *latency_breakdown_;
+  EXPECT_EQ(0x1234, b.trace_id);
+  EXPECT_EQ(LOG_ID, b.log_id);
+  EXPECT_EQ(LSN, b.lsn);
+  EXPECT_EQ(N3S0, b.shard);
+  EXPECT_EQ(50, b.client_queue_us);
+  EXPECT_EQ(1000, b.sequencer_us);
+  EXPECT_EQ(500, b.store_fanout_us);
+  EXPECT_EQ(100, b.storage_queue_us);
+  EXPECT_EQ(200, b.storage_write_us);
+  EXPECT_EQ(300, b.wal_sync_us);
+  EXPECT_EQ(2000 - 600, b.network_us);
+  EXPECT_EQ(3500, b.total_us);
+}
+
+// With chain sending, only the first copy is sent by the sequencer. The
+// fan-out of the others isn't known, and is counted as network time.
+// Timings from a copy that didn't complete replication aren't used.
+TEST_F(AppenderTest, LatencyBreakdownChainSending) {
+  using std::chrono::microseconds;
+  settings_.disable_chain_sending = false;
+  updateConfig();
+  first_candidate_idx_ = 0;
+  latency_trace_ = AppendLatencyTrace{0x1234, 50};
+  start();
+  CHECK_STORE_MSG_AND_TRIGGER_ON_SENT(E::OK, 1, N0S0);
+  CHECK_NO_STORE_MSG();
+  onTracedStoredSent(1, N0S0, STORED_LatencyTrace{1, 2, 3});
+  ON_STORED_SENT(E::OK, 1, N1S0, N3S0);
+  CHECK_APPENDED(E::OK);
+  CHECK_DELETE_MSG(N2S0, N4S0);
+  ASSERT_TRUE(retired_);
+  setLatencyTraceTimes(microseconds(1000), folly::none, microseconds(3500));
+  Appender::Reaper()(appender_);
+  CHECK_RELEASE_MSG(N0S0, N1S0, N3S0);
+
+  ASSERT_TRUE(latency_breakdown_.has_value());
+  const AppendLatencyBreakdown& b = *latency_breakdown_;
+  EXPECT_EQ(N3S0, b.shard);
+  EXPECT_EQ(1000, b.sequencer_us);
+  EXPECT_EQ(0, b.store_fanout_us);
+  EXPECT_EQ(0, b.storage_queue_us);
+  EXPECT_EQ(0, b.storage_write_us);
+  EXPECT_EQ(0, b.wal_sync_us);
+  EXPECT_EQ(2500, b.network_us);
+  EXPECT_EQ(3500, b.total_us);
+}
+
 // Test chain sending failures. Even though we are notified we cannot send
 // STORE to only one node, we should still start another wave immediately as
 // this other node was supposed to forward to others.
@@ -1498,6 +1640,150 @@ TEST_F(AppenderTest, SubsequentWavesAmendDirect) {
       << "N3S0 failed on first wave, should not have amended";
 }
 
+// A STORE that is not acknowledged within the hedge delay is hedged: a STORE
+// to a replacement node is added to the current wave. A late reply from the
+// original recipient still counts toward replication.
+TEST_F(AppenderTest, StoreHedging) {
+  shards_ = {N0S0, N1S0, N2S0, N3S0};
+  replication_ = 3;
+  extras_ = 0;
+  settings_.store_hedging = true;
+  // Below the 1ms store timeout Appender uses outside of a Worker.
+  settings_.store_hedging_delay = {
+      std::chrono::microseconds(100), std::chrono::microseconds(500)};
+  updateConfig();
+
+  first_candidate_idx_ = 0;
+  start();
+  ASSERT_TRUE(hedge_timer_active_);
+  CHECK_STORE_MSG_AND_TRIGGER_ON_SENT(E::OK, 1, N0S0, N1S0, N2S0);
+  ON_STORED_SENT(E::OK, 1, N0S0, N1S0);
+
+  // N2S0 is late. The copyset selector completes {N0S0, N1S0} with N3S0.
+  first_candidate_idx_ = 3;
+  triggerHedgeTimeout();
+  ASSERT_EQ(1, appender_->getStats()->aggregate().appender_store_hedged);
+  {
+    auto it = store_msgs_.find(N3S0);
+    ASSERT_NE(store_msgs_.end(), it);
+    const STORE_Header& hdr = getHeader(it->second.get());
+    ASSERT_FALSE(hdr.flags & STORE_Header::AMEND);
+    ASSERT_EQ(4, hdr.copyset_size);
+  }
+  CHECK_STORE_MSG_AND_TRIGGER_ON_SENT(E::OK, 1, N3S0);
+  CHECK_NO_STORE_MSG();
+  // At most one hedge per Appender.
+  ASSERT_FALSE(hedge_timer_active_);
+
+  // The late reply to the original STORE completes the append.
+  ON_STORED_SENT(E::OK, 1, N2S0);
+  CHECK_APPENDED(E::OK);
+  ASSERT_EQ(0, appender_->getStats()->aggregate().appender_store_hedge_won);
+  ASSERT_TRUE(retired_);
+  // The hedge copy is an extra now; the others have the right copyset.
+  CHECK_DELETE_MSG(N3S0);
+  CHECK_NO_STORE_MSG();
+  Appender::Reaper()(appender_);
+}
+
+// If the hedge copy completes the append, the copies stored before the hedge
+// are amended with the copyset that includes it.
+TEST_F(AppenderTest, StoreHedgingWon) {
+  shards_ = {N0S0, N1S0, N2S0, N3S0};
+  replication_ = 3;
+  extras_ = 0;
+  settings_.store_hedging = true;
+  // Below the 1ms store timeout Appender uses outside of a Worker.
+  settings_.store_hedging_delay = {
+      std::chrono::microseconds(100), std::chrono::microseconds(500)};
+  updateConfig();
+
+  first_candidate_idx_ = 0;
+  start();
+  CHECK_STORE_MSG_AND_TRIGGER_ON_SENT(E::OK, 1, N0S0, N1S0, N2S0);
+  ON_STORED_SENT(E::OK, 1, N0S0, N1S0);
+
+  first_candidate_idx_ = 3;
+  triggerHedgeTimeout();
+  CHECK_STORE_MSG_AND_TRIGGER_ON_SENT(E::OK, 1, N3S0);
+
+  ON_STORED_SENT(E::OK, 1, N3S0);
+  CHECK_APPENDED(E::OK);
+  ASSERT_EQ(1, appender_->getStats()->aggregate().appender_store_hedge_won);
+  ASSERT_TRUE(retired_);
+  CHECK_DELETE_MSG(N2S0);
+  for (ShardID shard : {N0S0, N1S0}) {
+    auto it = store_msgs_.find(shard);
+    ASSERT_NE(store_msgs_.end(), it) << shard.toString();
+    const STORE_Header& hdr = getHeader(it->second.get());
+    ASSERT_TRUE(hdr.flags & STORE_Header::AMEND);
+    ASSERT_EQ(1, hdr.wave);
+    ASSERT_EQ(4, hdr.copyset_size);
+    store_msgs_.erase(it);
+  }
+  CHECK_NO_STORE_MSG();
+  Appender::Reaper()(appender_);
+}
+
+// A wave with more outstanding STOREs than --store-hedging-max-outstanding
+// is left to the store timeout.
+TEST_F(AppenderTest, StoreHedgingTooManyOutstanding) {
+  shards_ = {N0S0, N1S0, N2S0, N3S0, N4S0};
+  replication_ = 3;
+  extras_ = 0;
+  settings_.store_hedging = true;
+  // Below the 1ms store timeout Appender uses outside of a Worker.
+  settings_.store_hedging_delay = {
+      std::chrono::microseconds(100), std::chrono::microseconds(500)};
+  settings_.store_hedging_max_outstanding = 1;
+  updateConfig();
+
+  first_candidate_idx_ = 0;
+  start();
+  CHECK_STORE_MSG_AND_TRIGGER_ON_SENT(E::OK, 1, N0S0, N1S0, N2S0);
+  ON_STORED_SENT(E::OK, 1, N0S0);
+
+  first_candidate_idx_ = 3;
+  triggerHedgeTimeout();
+  CHECK_NO_STORE_MSG();
+  ASSERT_EQ(0, appender_->getStats()->aggregate().appender_store_hedged);
+  ASSERT_EQ(
+      1, appender_->getStats()->aggregate().appender_store_hedge_skipped);
+  ASSERT_TRUE(store_timer_active_);
+
+  // The store timeout sends a regular wave.
+  triggerTimeout();
+  CHECK_STORE_MSG(2, N3S0, N4S0, N0S0);
+}
+
+// A hedge is skipped if the only possible replacement is the late node.
+TEST_F(AppenderTest, StoreHedgingNoReplacement) {
+  shards_ = {N0S0, N1S0, N2S0};
+  replication_ = 3;
+  extras_ = 0;
+  settings_.store_hedging = true;
+  // Below the 1ms store timeout Appender uses outside of a Worker.
+  settings_.store_hedging_delay = {
+      std::chrono::microseconds(100), std::chrono::microseconds(500)};
+  updateConfig();
+
+  first_candidate_idx_ = 0;
+  start();
+  CHECK_STORE_MSG_AND_TRIGGER_ON_SENT(E::OK, 1, N0S0, N1S0, N2S0);
+  ON_STORED_SENT(E::OK, 1, N0S0, N1S0);
+
+  triggerHedgeTimeout();
+  CHECK_NO_STORE_MSG();
+  ASSERT_EQ(0, appender_->getStats()->aggregate().appender_store_hedged);
+  ASSERT_EQ(
+      1, appender_->getStats()->aggregate().appender_store_hedge_skipped);
+
+  ON_STORED_SENT(E::OK, 1, N2S0);
+  CHECK_APPENDED(E::OK);
+  ASSERT_TRUE(retired_);
+  Appender::Reaper()(appender_);
+}
+
 // When chain-sending, amends have to be handled delicately. If any nodes in
 // the chain need the payload, we have to transmit it; cannot just send
 // amends.
@@ -20,6 +20,7 @@
 #include "logdevice/common/buffered_writer/BufferedWriterSingleLog.h"
 #include "logdevice/common/debug.h"
 #include "logdevice/common/protocol/RECORD_Message.h"
+#include "logdevice/common/request_util.h"
 #include "logdevice/common/settings/Settings.h"
 #include "logdevice/common/settings/util.h"
 #include "logdevice/common/test/TestUtil.h"
@@ -347,6 +348,10 @@ class BufferedWriterTest : public ::testing::Test {
     return writer.memory_available_.load();
   }
 
+  static int mapLogToShardIndex(BufferedWriterImpl& writer, logid_t log_id) {
+    return writer.mapLogToShardIndex(log_id);
+  }
+
   void explicitFlushTest(BufferedWriter::Options::Mode,
                          size_t numAppendsBeforePosting);
   void roundTripTest(Compression, bool payloads_compressible);
@@ -833,6 +838,51 @@ TEST_F(BufferedWriterTest, CheckShard) {
   ASSERT_EQ(std::vector<Status>(v.size(), E::SEQNOBUFS), rv);
 }
 
+// Test that logs matching the per-worker predicate are buffered on the shard
+// of the worker the append is made on, while other logs keep their shard
+TEST_F(BufferedWriterTest, PerWorkerLogs) {
+  TestCallback cb;
+  auto writer = this->createWriter(&cb);
+  const logid_t HOT_LOG(1);
+  const logid_t OTHER_LOG(2);
+  const int hot_shard = mapLogToShardIndex(*writer, HOT_LOG);
+  const int other_shard = mapLogToShardIndex(*writer, OTHER_LOG);
+  writer->setPerWorkerLogPredicate(
+      [&](logid_t log_id) { return log_id == HOT_LOG; });
+
+  // Off worker threads the predicate doesn't apply.
+  EXPECT_EQ(hot_shard, mapLogToShardIndex(*writer, HOT_LOG));
+
+  const int nworkers = processor_->getWorkerCount(WorkerType::GENERAL);
+  ASSERT_GT(nworkers, 1);
+  for (int i = 0; i < nworkers; ++i) {
+    auto shards = run_on_worker(processor_.get(), i, [&]() {
+      return std::make_pair(mapLogToShardIndex(*writer, HOT_LOG),
+                            mapLogToShardIndex(*writer, OTHER_LOG));
+    });
+    EXPECT_EQ(i, shards.first);
+    EXPECT_EQ(other_shard, shards.second);
+  }
+
+  // Appends made on every worker make it through their own shards.
+  std::set<std::string> expected;
+  for (int i = 0; i < nworkers; ++i) {
+    std::string payload = std::to_string(i);
+    expected.insert(payload);
+    int rv = run_on_worker(processor_.get(), i, [&]() {
+      return writer->append(HOT_LOG, std::string(payload), NULL_CONTEXT);
+    });
+    ASSERT_EQ(0, rv);
+  }
+  ASSERT_EQ(0, writer->flushAll());
+  for (int i = 0; i < nworkers; ++i) {
+    cb.sem.wait();
+  }
+  ASSERT_EQ(0, cb.failures.size());
+  ASSERT_EQ(expected, cb.payloadsSucceededAsSet());
+  ASSERT_EQ(size_t(nworkers), sink_->getFlushedBlobs(HOT_LOG).size());
+}
+
 // Test that we delete payloads if instructed to do so
 TEST_F(BufferedWriterTest, DestroyPayloads) {
   TestCallback cb;
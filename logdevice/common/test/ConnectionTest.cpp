@@ -317,6 +317,48 @@ TEST_F(ClientConnectionTest, SerializationStages) {
   CHECK_SERIALIZEQ();
 }
 
+// Messages sent during one event loop iteration are written into the socket
+// together.
+TEST_F(ClientConnectionTest, WritesBatchedPerLoopIteration) {
+  std::vector<std::unique_ptr<folly::IOBuf>> writes;
+  ON_CALL(*sock_, connect_(_, _, _, _, _))
+      .WillByDefault(SaveArg<0>(&conn_callback_));
+  ON_CALL(*sock_, writeChain_(_, _, _))
+      .WillByDefault(
+          Invoke([this, &writes](folly::AsyncSocket::WriteCallback* cb,
+                                 folly::IOBuf* buf,
+                                 folly::WriteFlags) {
+            wr_callback_ = cb;
+            writes.emplace_back(buf);
+          }));
+  ON_CALL(*sock_, setReadCB(_)).WillByDefault(SaveArg<0>(&rd_callback_));
+  EXPECT_EQ(conn_->connect(), 0);
+  conn_callback_->connectSuccess();
+  ev_base_folly_.loopOnce();
+  writeSuccess();
+  CHECK_ON_SENT(MessageType::HELLO, E::OK);
+  receiveAckMessage();
+  ASSERT_TRUE(handshaken());
+  ASSERT_EQ(1, writes.size());
+
+  size_t total_size = 0;
+  for (int i = 0; i < 3; ++i) {
+    auto envelope = create_message(*socket_);
+    ASSERT_NE(envelope, nullptr);
+    total_size += envelope->cost();
+    socket_->releaseMessage(*envelope);
+  }
+  CHECK_SERIALIZEQ();
+  EXPECT_EQ(1, writes.size());
+  ev_base_folly_.loopOnce();
+  ASSERT_EQ(2, writes.size());
+  EXPECT_EQ(total_size, writes[1]->computeChainDataLength());
+  writeSuccess();
+  CHECK_ON_SENT(MessageType::GET_SEQ_STATE, E::OK);
+  CHECK_ON_SENT(MessageType::GET_SEQ_STATE, E::OK);
+  CHECK_ON_SENT(MessageType::GET_SEQ_STATE, E::OK);
+}
+
 // Verify that handshake works for a server Socket.
 TEST_F(ServerConnectionTest, Handshake) {
   // Simulate HELLO to be received by the server.
@@ -596,6 +638,107 @@ TEST_F(ClientConnectionTest, MessageChangesSizeAfterHandshake) {
   CHECK_SERIALIZEQ();
 }
 
+// Writes above --zerocopy-send-threshold are sent with MSG_ZEROCOPY, and
+// their bytes stay accounted as pending until the socket releases them.
+TEST_F(ClientConnectionTest, ZeroCopyWriteAccountedUntilReleased) {
+  settings_.zerocopy_send_threshold = 1;
+  std::unique_ptr<folly::IOBuf> hello_buf;
+  folly::WriteFlags write_flags = folly::WriteFlags::NONE;
+  ON_CALL(*sock_, connect_(_, _, _, _, _))
+      .WillByDefault(SaveArg<0>(&conn_callback_));
+  EXPECT_CALL(*sock_, setZeroCopy(true)).WillOnce(Return(true));
+  ON_CALL(*sock_, writeChain_(_, _, _))
+      .WillByDefault(Invoke([&](folly::AsyncSocket::WriteCallback* cb,
+                                folly::IOBuf* buf,
+                                folly::WriteFlags flags) {
+        wr_callback_ = cb;
+        hello_buf.reset(buf);
+        write_flags = flags;
+      }));
+  ON_CALL(*sock_, setReadCB(_)).WillByDefault(SaveArg<0>(&rd_callback_));
+  EXPECT_EQ(conn_->connect(), 0);
+  conn_callback_->connectSuccess();
+  EXPECT_TRUE(connected());
+  ev_base_folly_.loopOnce();
+  ASSERT_NE(hello_buf, nullptr);
+  EXPECT_EQ(folly::WriteFlags::WRITE_MSG_ZEROCOPY, write_flags);
+
+  const size_t hello_size = hello_buf->computeChainDataLength();
+  EXPECT_EQ(hello_size, bytes_pending_);
+  writeSuccess();
+  CHECK_ON_SENT(MessageType::HELLO, E::OK);
+  // The kernel may still be reading from the written memory.
+  EXPECT_EQ(hello_size, bytes_pending_);
+  EXPECT_EQ(hello_size, conn_->getBytesPending());
+
+  // The socket releases the chain once the kernel reports completion.
+  hello_buf.reset();
+  EXPECT_EQ(0, bytes_pending_);
+  EXPECT_EQ(0, conn_->getBytesPending());
+}
+
+// --zerocopy-send-threshold applies to each buffer of the batch written in one
+// loop iteration, not to the size of the whole batch.
+TEST_F(ClientConnectionTest, ZeroCopyThresholdAppliesPerBuffer) {
+  settings_.zerocopy_send_threshold = 1 << 20;
+  std::vector<std::unique_ptr<folly::IOBuf>> writes;
+  std::vector<folly::WriteFlags> write_flags;
+  ON_CALL(*sock_, connect_(_, _, _, _, _))
+      .WillByDefault(SaveArg<0>(&conn_callback_));
+  EXPECT_CALL(*sock_, setZeroCopy(true)).WillOnce(Return(true));
+  ON_CALL(*sock_, writeChain_(_, _, _))
+      .WillByDefault(Invoke([&](folly::AsyncSocket::WriteCallback* cb,
+                                folly::IOBuf* buf,
+                                folly::WriteFlags flags) {
+        wr_callback_ = cb;
+        writes.emplace_back(buf);
+        write_flags.push_back(flags);
+      }));
+  ON_CALL(*sock_, setReadCB(_)).WillByDefault(SaveArg<0>(&rd_callback_));
+  EXPECT_EQ(conn_->connect(), 0);
+  conn_callback_->connectSuccess();
+  ev_base_folly_.loopOnce();
+  writeSuccess();
+  CHECK_ON_SENT(MessageType::HELLO, E::OK);
+  receiveAckMessage();
+  ASSERT_TRUE(handshaken());
+  ASSERT_EQ(1, writes.size());
+  EXPECT_EQ(folly::WriteFlags::NONE, write_flags[0]);
+
+  size_t small_size = 0;
+  for (int i = 0; i < 3; ++i) {
+    auto envelope = create_message(*socket_);
+    ASSERT_NE(envelope, nullptr);
+    small_size += envelope->cost();
+    socket_->releaseMessage(*envelope);
+  }
+  // Each small message is below the threshold but together they are above it.
+  settings_.zerocopy_send_threshold = small_size - 1;
+  auto envelope = socket_->registerMessage(
+      std::make_unique<VarLengthTestMessage>(
+          Compatibility::MIN_PROTOCOL_SUPPORTED, 4 * small_size));
+  ASSERT_NE(envelope, nullptr);
+  const size_t large_size = envelope->cost();
+  socket_->releaseMessage(*envelope);
+  ev_base_folly_.loopOnce();
+
+  ASSERT_EQ(3, writes.size());
+  EXPECT_EQ(folly::WriteFlags::NONE, write_flags[1]);
+  EXPECT_EQ(small_size, writes[1]->computeChainDataLength());
+  EXPECT_EQ(folly::WriteFlags::WRITE_MSG_ZEROCOPY, write_flags[2]);
+  EXPECT_EQ(large_size, writes[2]->computeChainDataLength());
+  writeSuccess();
+  writeSuccess();
+  CHECK_ON_SENT(MessageType::GET_SEQ_STATE, E::OK);
+  CHECK_ON_SENT(MessageType::GET_SEQ_STATE, E::OK);
+  CHECK_ON_SENT(MessageType::GET_SEQ_STATE, E::OK);
+  CHECK_ON_SENT(MessageType::TEST, E::OK);
+  // Only the zero-copy write stays pinned until the socket releases it.
+  EXPECT_EQ(large_size, conn_->getBytesPending());
+  writes.clear();
+  EXPECT_EQ(0, conn_->getBytesPending());
+}
+
 // Verify the behavior when up to --connection-retries connect attempts failed.
 // Enqueued messages should have their onSent(st=E::TIMEDOUT) called.
 TEST_F(ClientConnectionTest, ConnectionTimeout) {
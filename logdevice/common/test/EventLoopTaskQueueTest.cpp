@@ -8,6 +8,7 @@
 #include "logdevice/common/EventLoopTaskQueue.h"
 
 #include <memory>
+#include <vector>
 
 #include <folly/Executor.h>
 #include <gtest/gtest.h>
@@ -94,3 +95,31 @@ TEST(EventLoopTaskQueue, PostPrioritizedWork) {
   EXPECT_EQ(num_mid_pri_task, num_mid_pri_executed);
   EXPECT_EQ(num_lo_pri_task, num_lo_pri_executed);
 }
+
+TEST(EventLoopTaskQueue, AddBatch) {
+  auto el = std::make_unique<EventLoop>();
+  Semaphore start_loop, primed;
+  el->add([&start_loop, &primed]() {
+    primed.post();
+    start_loop.wait();
+  });
+  primed.wait();
+
+  // Tasks of a batch run in order within each priority, higher priorities
+  // first.
+  std::vector<int> executed;
+  EventLoopTaskQueue::TaskBatch batch;
+  for (int i = 0; i < 10; ++i) {
+    auto priority =
+        i % 2 == 0 ? folly::Executor::LO_PRI : folly::Executor::HI_PRI;
+    batch.emplace_back([&executed, i] { executed.push_back(i); }, priority);
+  }
+  el->addBatch(std::move(batch));
+  start_loop.post();
+
+  Semaphore gate;
+  el->add([&gate] { gate.post(); });
+  gate.wait();
+  std::vector<int> expected{1, 3, 5, 7, 9, 0, 2, 4, 6, 8};
+  EXPECT_EQ(expected, executed);
+}
@@ -369,4 +369,62 @@ TEST_F(FlowGroupTest, AllowCompleteBandwidthUsageForBurstyTraffic) {
   }
 }
 
+TEST_F(FlowGroupTest, SharedBudget) {
+  // Process wide policy. The refill rate is low enough for the buckets not
+  // to refill noticeably during the test.
+  FlowGroupPolicy policy;
+  policy.setEnabled(true);
+  for (Priority p = Priority::MAX; p < Priority::NUM_PRIORITIES;
+       p = priorityBelow(p)) {
+    policy.set(p, /*burst*/ 1000, /*Bps*/ 1);
+  }
+  policy.set(FlowGroup::PRIORITYQ_PRIORITY, /*burst*/ 1000, /*Bps*/ 1);
+  auto budget = std::make_shared<SharedFlowBudget>();
+  budget->configure(NodeLocationScope::ROOT, policy);
+  EXPECT_FALSE(flow_group->applySharedBudgetPolicy(policy, budget));
+
+  // The meter is filled from the priority's bucket on first use...
+  ASSERT_TRUE(flow_group->drain(600, Priority::MAX));
+  EXPECT_EQ(400, flow_group->level(Priority::MAX));
+  ASSERT_TRUE(flow_group->drain(600, Priority::MAX));
+  EXPECT_EQ(200, flow_group->debt(Priority::MAX));
+
+  // ... then from the shared pool, paying off the debt first.
+  ASSERT_TRUE(flow_group->drain(1, Priority::MAX));
+  EXPECT_EQ(799, flow_group->level(Priority::MAX));
+  ASSERT_TRUE(flow_group->drain(1000, Priority::MAX));
+
+  // Both are now empty.
+  auto op = std::make_unique<FlowOperation>(sent, "Test Op", 10);
+  ASSERT_FALSE(flow_group->canDrain(Priority::MAX));
+  ASSERT_FALSE(flow_group->drain(op->cost(), Priority::MAX));
+  flow_group->push(*op.release(), Priority::MAX);
+  EXPECT_NE(std::chrono::microseconds::max(),
+            flow_group->sharedBudgetWaitTime());
+  run();
+  CHECK_SENDQ();
+
+  // Credit returned beyond the meter's capacity goes back to the shared
+  // budget for other workers to use.
+  EXPECT_EQ(3799, flow_group->returnCredits(Priority::MAX, 5000));
+  EXPECT_EQ(1000, flow_group->level(Priority::MAX));
+  EXPECT_EQ(0, flow_group->sharedBudgetWaitTime().count());
+  run();
+  CHECK_SENT("Test Op", 10);
+  ASSERT_TRUE(flow_group->drain(990, Priority::MAX));
+  ASSERT_TRUE(flow_group->drain(1, Priority::MAX));
+  EXPECT_EQ(999, flow_group->level(Priority::MAX));
+
+  // Disabling the policy releases blocked callbacks.
+  resetMeter(-1);
+  flow_group->push(
+      *new FlowOperation(sent, "Test Op", 20), Priority::CLIENT_LOW);
+  EXPECT_TRUE(flow_group->applySharedBudgetPolicy(
+      policy.normalize(/*Senders*/ 1, std::chrono::seconds(1)), budget));
+  policy.setEnabled(false);
+  EXPECT_TRUE(flow_group->applySharedBudgetPolicy(policy, budget));
+  run();
+  CHECK_SENT("Test Op", 20);
+}
+
 } // anonymous namespace
@@ -8,6 +8,10 @@
 
 #include "logdevice/common/network/MessageReader.h"
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "logdevice/common/protocol/Compatibility.h"
@@ -18,51 +22,83 @@ using ::testing::_;
 using ::testing::Return;
 using namespace facebook::logdevice;
 
+namespace {
+
+const size_t store_msg_size = 100;
+
+// Writes a STORE message with a body of `body_len' bytes set to `fill' at
+// `buf'. Returns the number of bytes written.
+size_t writeStore(void* buf, size_t body_len, char fill) {
+  ProtocolHeader hdr;
+  hdr.type = MessageType::STORE;
+  hdr.len = body_len + sizeof(ProtocolHeader);
+  hdr.cksum = 0;
+  memcpy(buf, &hdr, sizeof(hdr));
+  memset(static_cast<uint8_t*>(buf) + sizeof(hdr), fill, body_len);
+  return hdr.len;
+}
+
+// Captures bodies passed to dispatchMessageBody().
+struct DispatchedMessages {
+  std::vector<ProtocolHeader> headers;
+  std::vector<std::unique_ptr<folly::IOBuf>> bodies;
+
+  void expectOn(MockProtocolHandler& mock_conn, int times, int rv = 0) {
+    EXPECT_CALL(mock_conn, dispatchMessageBody(_, _))
+        .Times(times)
+        .WillRepeatedly(Invoke(
+            [this, rv](const ProtocolHeader& hdr,
+                       std::unique_ptr<folly::IOBuf> body) {
+              headers.push_back(hdr);
+              bodies.push_back(std::move(body));
+              return rv;
+            }));
+  }
+};
+
+} // namespace
+
 TEST(MessageReaderTest, EntireMessageReceivedTest) {
   MockProtocolHandler mock_conn;
   MessageReader read_cb(mock_conn, Compatibility::MAX_PROTOCOL_SUPPORTED);
   EXPECT_CALL(mock_conn, validateProtocolHeader(_))
       .Times(2)
       .WillRepeatedly(Return(true));
-  EXPECT_CALL(mock_conn, dispatchMessageBody(_, _)).Times(1);
+  DispatchedMessages dispatched;
+  dispatched.expectOn(mock_conn, 1);
   ON_CALL(mock_conn, good()).WillByDefault(Return(true));
   void* bufReturn = nullptr;
   size_t lenReturn = 0;
   read_cb.getReadBuffer(&bufReturn, &lenReturn);
   ASSERT_NE(nullptr, bufReturn);
-  ASSERT_EQ(sizeof(ProtocolHeader), lenReturn);
-  ProtocolHeader* hdr = (ProtocolHeader*)bufReturn;
-  const size_t store_msg_size = 100;
-  hdr->type = MessageType::STORE;
-  hdr->len = store_msg_size + sizeof(ProtocolHeader);
-  hdr->cksum = 0;
-  read_cb.readDataAvailable(lenReturn);
+  ASSERT_GE(lenReturn, MessageReader::kReadBufferSize);
+  void* first_buf_ptr = bufReturn;
+  size_t len = writeStore(bufReturn, store_msg_size, 'a');
+  read_cb.readDataAvailable(sizeof(ProtocolHeader));
   read_cb.getReadBuffer(&bufReturn, &lenReturn);
   ASSERT_NE(nullptr, bufReturn);
-  ASSERT_EQ(store_msg_size, lenReturn);
-  read_cb.readDataAvailable(store_msg_size);
-  // This test knowns something about the implementation and would need to
-  // change once implementation changes. Don't like it but it's ok I guess.
-  void* prev_buf_ptr = bufReturn;
+  ASSERT_GE(lenReturn, store_msg_size);
+  read_cb.readDataAvailable(len - sizeof(ProtocolHeader));
+  ASSERT_EQ(1, dispatched.bodies.size());
+  EXPECT_EQ(len, dispatched.headers[0].len);
+  EXPECT_EQ(store_msg_size, dispatched.bodies[0]->computeChainDataLength());
+  EXPECT_EQ('a', dispatched.bodies[0]->data()[store_msg_size - 1]);
+
+  // The body was copied, so the next message is read into the same buffer
+  // from its start.
   read_cb.getReadBuffer(&bufReturn, &lenReturn);
   ASSERT_NE(nullptr, bufReturn);
-  ASSERT_EQ(sizeof(ProtocolHeader), lenReturn);
+  ASSERT_EQ(first_buf_ptr, bufReturn);
   // Calling it again should get the same buffer.
-  prev_buf_ptr = bufReturn;
+  void* prev_buf_ptr = bufReturn;
   read_cb.getReadBuffer(&bufReturn, &lenReturn);
   ASSERT_EQ(bufReturn, prev_buf_ptr);
-  ASSERT_EQ(sizeof(ProtocolHeader), lenReturn);
-  // Add another store message header of store_msg_size
-  hdr = (ProtocolHeader*)bufReturn;
-  hdr->type = MessageType::STORE;
-  hdr->len = store_msg_size + sizeof(ProtocolHeader);
-  hdr->cksum = 0;
-  read_cb.readDataAvailable(lenReturn);
-  // Calling getReadBuffer again should get buffer of  msg_size +
-  // sizeof(ProtocolHeader).
+  // Another store message header, without its body.
+  writeStore(bufReturn, store_msg_size, 'b');
+  read_cb.readDataAvailable(sizeof(ProtocolHeader));
   read_cb.getReadBuffer(&bufReturn, &lenReturn);
   ASSERT_NE(nullptr, bufReturn);
-  ASSERT_EQ(store_msg_size, lenReturn);
+  ASSERT_GE(lenReturn, store_msg_size);
 }
 
 TEST(MessageReaderTest, PartialHeaderReceived) {
@@ -71,80 +107,197 @@ TEST(MessageReaderTest, PartialHeaderReceived) {
   EXPECT_CALL(mock_conn, validateProtocolHeader(_))
       .Times(1)
       .WillRepeatedly(Return(true));
+  DispatchedMessages dispatched;
+  dispatched.expectOn(mock_conn, 1);
   ON_CALL(mock_conn, good()).WillByDefault(Return(true));
+  uint8_t msg[sizeof(ProtocolHeader) + store_msg_size];
+  writeStore(msg, store_msg_size, 'a');
   void* bufReturn = nullptr;
   size_t lenReturn = 0;
-  void* prev_buf_ptr = bufReturn;
-  for (size_t total_buffer_size = sizeof(ProtocolHeader); total_buffer_size > 1;
-       total_buffer_size--) {
+  void* prev_buf_ptr = nullptr;
+  // One byte at a time.
+  for (size_t i = 0; i < sizeof(msg); ++i) {
     read_cb.getReadBuffer(&bufReturn, &lenReturn);
+    ASSERT_NE(nullptr, bufReturn);
     if (prev_buf_ptr != nullptr) {
       ASSERT_EQ((uint8_t*)prev_buf_ptr + 1, (uint8_t*)bufReturn);
     }
-    ASSERT_EQ(lenReturn, total_buffer_size);
+    ASSERT_GE(lenReturn, 1);
+    *(uint8_t*)bufReturn = msg[i];
     read_cb.readDataAvailable(1);
     prev_buf_ptr = bufReturn;
+    ASSERT_EQ(i == sizeof(msg) - 1 ? 1 : 0, dispatched.bodies.size());
   }
-  // Get the last byte so that we can write the header contents.
-  read_cb.getReadBuffer(&bufReturn, &lenReturn);
-  ASSERT_EQ((uint8_t*)prev_buf_ptr + 1, (uint8_t*)bufReturn);
-  ASSERT_EQ(lenReturn, 1);
-  ProtocolHeader* hdr =
-      (ProtocolHeader*)((uint8_t*)bufReturn - sizeof(ProtocolHeader) + 1);
-  const size_t store_msg_size = 100;
-  hdr->type = MessageType::STORE;
-  hdr->len = store_msg_size + sizeof(ProtocolHeader);
-  hdr->cksum = 0;
-  read_cb.readDataAvailable(1);
+  ASSERT_EQ(store_msg_size, dispatched.bodies[0]->computeChainDataLength());
+  EXPECT_EQ(0,
+            memcmp(msg + sizeof(ProtocolHeader),
+                   dispatched.bodies[0]->data(),
+                   store_msg_size));
+}
 
+TEST(MessageReaderTest, PartialMessageReceived) {
+  MockProtocolHandler mock_conn;
+  MessageReader read_cb(mock_conn, Compatibility::MAX_PROTOCOL_SUPPORTED);
+  EXPECT_CALL(mock_conn, validateProtocolHeader(_))
+      .Times(2)
+      .WillRepeatedly(Return(true));
+  ON_CALL(mock_conn, good()).WillByDefault(Return(true));
+  DispatchedMessages dispatched;
+  dispatched.expectOn(mock_conn, 1);
+  void* bufReturn = nullptr;
+  size_t lenReturn = 0;
   read_cb.getReadBuffer(&bufReturn, &lenReturn);
   ASSERT_NE(nullptr, bufReturn);
-  ASSERT_EQ(store_msg_size, lenReturn);
+  // The first message and the header of the second one arrive together,
+  // the second body is awaited.
+  uint8_t* ptr = (uint8_t*)bufReturn;
+  writeStore(ptr, store_msg_size, 'a');
+  ptr += sizeof(ProtocolHeader) + store_msg_size;
+  writeStore(ptr, store_msg_size, 'b');
+  ptr += sizeof(ProtocolHeader);
+  read_cb.readDataAvailable(ptr - (uint8_t*)bufReturn);
+  ASSERT_EQ(1, dispatched.bodies.size());
+
+  read_cb.getReadBuffer(&bufReturn, &lenReturn);
+  ASSERT_EQ(ptr, bufReturn);
+  ASSERT_GE(lenReturn, store_msg_size);
+  read_cb.readDataAvailable(store_msg_size - 1);
+  ASSERT_EQ(1, dispatched.bodies.size());
 }
 
-TEST(MessageReaderTest, PartialMessageReceived) {
+TEST(MessageReaderTest, BatchOfMessages) {
   MockProtocolHandler mock_conn;
   MessageReader read_cb(mock_conn, Compatibility::MAX_PROTOCOL_SUPPORTED);
+  const size_t nmessages = 20;
   EXPECT_CALL(mock_conn, validateProtocolHeader(_))
-      .Times(2)
+      .Times(nmessages)
       .WillRepeatedly(Return(true));
   ON_CALL(mock_conn, good()).WillByDefault(Return(true));
+  DispatchedMessages dispatched;
+  dispatched.expectOn(mock_conn, nmessages);
   void* bufReturn = nullptr;
   size_t lenReturn = 0;
   read_cb.getReadBuffer(&bufReturn, &lenReturn);
   ASSERT_NE(nullptr, bufReturn);
-  ASSERT_EQ(sizeof(ProtocolHeader), lenReturn);
-  ProtocolHeader* hdr = (ProtocolHeader*)bufReturn;
-  const size_t store_msg_size = 100;
-  hdr->type = MessageType::STORE;
-  hdr->len = store_msg_size + sizeof(ProtocolHeader);
-  hdr->cksum = 0;
-  read_cb.readDataAvailable(lenReturn);
-  bufReturn = nullptr;
-  void* prev_buf_ptr = bufReturn;
-  EXPECT_CALL(mock_conn, dispatchMessageBody(_, _)).Times(1);
-  for (size_t total_buffer_size = store_msg_size; total_buffer_size > 0;
-       total_buffer_size--) {
-    read_cb.getReadBuffer(&bufReturn, &lenReturn);
-    if (prev_buf_ptr != nullptr) {
-      ASSERT_EQ((uint8_t*)prev_buf_ptr + 1, (uint8_t*)bufReturn);
+  uint8_t* ptr = (uint8_t*)bufReturn;
+  for (size_t i = 0; i < nmessages; ++i) {
+    ptr += writeStore(ptr, i, 'a' + i);
+  }
+  read_cb.readDataAvailable(ptr - (uint8_t*)bufReturn);
+
+  ASSERT_EQ(nmessages, dispatched.bodies.size());
+  for (size_t i = 0; i < nmessages; ++i) {
+    const auto& body = dispatched.bodies[i];
+    ASSERT_EQ(i, body->computeChainDataLength());
+    for (size_t j = 0; j < i; ++j) {
+      ASSERT_EQ('a' + i, body->data()[j]);
+    }
+    // Small bodies are copied out of the receive buffer.
+    if (i > 0) {
+      EXPECT_TRUE(body->data() < (uint8_t*)bufReturn || body->data() >= ptr);
     }
-    ASSERT_EQ(lenReturn, total_buffer_size);
-    read_cb.readDataAvailable(1);
-    prev_buf_ptr = bufReturn;
   }
-  // Get the last byte so that we can write the header contents.
+}
+
+TEST(MessageReaderTest, LargeBodiesReferToReadBuffer) {
+  MockProtocolHandler mock_conn;
+  MessageReader read_cb(mock_conn, Compatibility::MAX_PROTOCOL_SUPPORTED);
+  EXPECT_CALL(mock_conn, validateProtocolHeader(_))
+      .Times(2)
+      .WillRepeatedly(Return(true));
+  ON_CALL(mock_conn, good()).WillByDefault(Return(true));
+  DispatchedMessages dispatched;
+  dispatched.expectOn(mock_conn, 2);
+  void* bufReturn = nullptr;
+  size_t lenReturn = 0;
   read_cb.getReadBuffer(&bufReturn, &lenReturn);
   ASSERT_NE(nullptr, bufReturn);
-  ASSERT_EQ(lenReturn, sizeof(ProtocolHeader));
-  hdr = (ProtocolHeader*)bufReturn;
-  hdr->type = MessageType::STORE;
-  hdr->len = store_msg_size + sizeof(ProtocolHeader);
-  hdr->cksum = 0;
-  read_cb.readDataAvailable(sizeof(ProtocolHeader));
+  const size_t large_body_size = MessageReader::kReadBufferSize / 2;
+  uint8_t* ptr = (uint8_t*)bufReturn;
+  ptr += writeStore(ptr, large_body_size, 'a');
+  ptr += writeStore(ptr, store_msg_size, 'b');
+  read_cb.readDataAvailable(ptr - (uint8_t*)bufReturn);
+
+  ASSERT_EQ(2, dispatched.bodies.size());
+  const auto& large = dispatched.bodies[0];
+  ASSERT_EQ(large_body_size, large->computeChainDataLength());
+  EXPECT_EQ((uint8_t*)bufReturn + sizeof(ProtocolHeader), large->data());
+  // The small body does not keep the buffer allocated.
+  const auto& small = dispatched.bodies[1];
+  ASSERT_EQ(store_msg_size, small->computeChainDataLength());
+  EXPECT_TRUE(small->data() < (uint8_t*)bufReturn || small->data() >= ptr);
+  EXPECT_FALSE(small->isSharedOne());
+  EXPECT_EQ('b', small->data()[0]);
+}
+
+TEST(MessageReaderTest, MessageLargerThanReadBuffer) {
+  MockProtocolHandler mock_conn;
+  MessageReader read_cb(mock_conn, Compatibility::MAX_PROTOCOL_SUPPORTED);
+  EXPECT_CALL(mock_conn, validateProtocolHeader(_))
+      .Times(2)
+      .WillRepeatedly(Return(true));
+  ON_CALL(mock_conn, good()).WillByDefault(Return(true));
+  DispatchedMessages dispatched;
+  dispatched.expectOn(mock_conn, 2);
+  const size_t large_msg_size = 3 * MessageReader::kReadBufferSize;
+  std::vector<uint8_t> stream(2 * sizeof(ProtocolHeader) + store_msg_size +
+                              large_msg_size);
+  size_t len = writeStore(stream.data(), store_msg_size, 'a');
+  writeStore(stream.data() + len, large_msg_size, 'b');
+
+  size_t pos = 0;
+  while (pos < stream.size()) {
+    void* bufReturn = nullptr;
+    size_t lenReturn = 0;
+    read_cb.getReadBuffer(&bufReturn, &lenReturn);
+    ASSERT_NE(nullptr, bufReturn);
+    ASSERT_GT(lenReturn, 0);
+    lenReturn = std::min(lenReturn, stream.size() - pos);
+    memcpy(bufReturn, stream.data() + pos, lenReturn);
+    read_cb.readDataAvailable(lenReturn);
+    pos += lenReturn;
+  }
+  ASSERT_EQ(2, dispatched.bodies.size());
+  EXPECT_EQ(store_msg_size, dispatched.bodies[0]->computeChainDataLength());
+  const auto& large = dispatched.bodies[1];
+  ASSERT_EQ(large_msg_size, large->computeChainDataLength());
+  // The large message was received into a single buffer.
+  EXPECT_FALSE(large->isChained());
+  EXPECT_EQ('b', large->data()[0]);
+  EXPECT_EQ('b', large->data()[large_msg_size - 1]);
+}
+
+TEST(MessageReaderTest, DispatchFailureStopsBatch) {
+  MockProtocolHandler mock_conn;
+  MessageReader read_cb(mock_conn, Compatibility::MAX_PROTOCOL_SUPPORTED);
+  EXPECT_CALL(mock_conn, validateProtocolHeader(_))
+      .Times(1)
+      .WillRepeatedly(Return(true));
+  ON_CALL(mock_conn, good()).WillByDefault(Return(true));
+  DispatchedMessages dispatched;
+  // The first message can't be processed, e.g. the worker is out of buffer
+  // space.
+  dispatched.expectOn(mock_conn, 1, -1);
+  void* bufReturn = nullptr;
+  size_t lenReturn = 0;
   read_cb.getReadBuffer(&bufReturn, &lenReturn);
-  ASSERT_NE(nullptr, bufReturn);
-  ASSERT_EQ(store_msg_size, lenReturn);
+  uint8_t* ptr = (uint8_t*)bufReturn;
+  for (char c : {'a', 'b', 'c'}) {
+    ptr += writeStore(ptr, store_msg_size, c);
+  }
+  read_cb.readDataAvailable(ptr - (uint8_t*)bufReturn);
+  ASSERT_EQ(1, dispatched.bodies.size());
+
+  Mock::VerifyAndClearExpectations(&mock_conn);
+  EXPECT_CALL(mock_conn, validateProtocolHeader(_))
+      .Times(2)
+      .WillRepeatedly(Return(true));
+  ON_CALL(mock_conn, good()).WillByDefault(Return(true));
+  dispatched.expectOn(mock_conn, 2);
+  read_cb.dispatchBufferedMessages();
+  ASSERT_EQ(3, dispatched.bodies.size());
+  EXPECT_EQ('b', dispatched.bodies[1]->data()[0]);
+  EXPECT_EQ('c', dispatched.bodies[2]->data()[0]);
 }
 
 TEST(MessageReaderTest, HitErrorWhenProcessingMessageOrHeader) {
@@ -164,13 +317,8 @@ TEST(MessageReaderTest, HitErrorWhenProcessingMessageOrHeader) {
   size_t lenReturn = 0;
   read_cb.getReadBuffer(&bufReturn, &lenReturn);
   ASSERT_NE(nullptr, bufReturn);
-  ASSERT_EQ(sizeof(ProtocolHeader), lenReturn);
-  ProtocolHeader* hdr = (ProtocolHeader*)bufReturn;
-  const size_t store_msg_size = 100;
-  hdr->type = MessageType::STORE;
-  hdr->len = store_msg_size + sizeof(ProtocolHeader);
-  hdr->cksum = 0;
-  read_cb.readDataAvailable(lenReturn);
+  writeStore(bufReturn, store_msg_size, 'a');
+  read_cb.readDataAvailable(sizeof(ProtocolHeader));
   read_cb.getReadBuffer(&bufReturn, &lenReturn);
   ASSERT_EQ(nullptr, bufReturn);
   ASSERT_EQ(0, lenReturn);
@@ -188,17 +336,14 @@ TEST(MessageReaderTest, FailProtocolHeaderValidation) {
       .WillOnce(Return(true))
       .WillOnce(Return(false));
   EXPECT_CALL(mock_conn, notifyErrorOnSocket(_)).Times(1);
+  EXPECT_CALL(mock_conn, dispatchMessageBody(_, _)).Times(0);
   void* bufReturn = nullptr;
   size_t lenReturn = 0;
   read_cb.getReadBuffer(&bufReturn, &lenReturn);
   ASSERT_NE(nullptr, bufReturn);
-  ASSERT_EQ(sizeof(ProtocolHeader), lenReturn);
-  ProtocolHeader* hdr = (ProtocolHeader*)bufReturn;
-  const size_t store_msg_size = 100;
-  hdr->type = MessageType::STORE;
-  hdr->len = store_msg_size + sizeof(ProtocolHeader);
-  hdr->cksum = 0;
-  read_cb.readDataAvailable(lenReturn);
+  // Even though the whole message arrived, it must not be dispatched.
+  size_t len = writeStore(bufReturn, store_msg_size, 'a');
+  read_cb.readDataAvailable(len);
   read_cb.getReadBuffer(&bufReturn, &lenReturn);
   ASSERT_EQ(nullptr, bufReturn);
   ASSERT_EQ(0, lenReturn);
@@ -37,6 +37,7 @@
 #include "logdevice/common/protocol/STARTED_Message.h"
 #include "logdevice/common/protocol/START_Message.h"
 #include "logdevice/common/protocol/STOP_Message.h"
+#include "logdevice/common/protocol/STORED_Message.h"
 #include "logdevice/common/protocol/STORE_Message.h"
 #include "logdevice/common/request_util.h"
 #include "logdevice/common/test/TestUtil.h"
@@ -110,12 +111,15 @@ class MessageSerializationTest : public ::testing::Test {
     ASSERT_EQ(sent.header_.nsync, recv.header_.nsync);
     ASSERT_EQ(sent.header_.copyset_offset, recv.header_.copyset_offset);
     ASSERT_EQ(sent.header_.copyset_size, recv.header_.copyset_size);
-    if (proto >= Compatibility::ProtocolVersion::STREAM_WRITER_SUPPORT) {
+    if (proto >= Compatibility::ProtocolVersion::APPEND_LATENCY_TRACE) {
       ASSERT_EQ(sent.header_.flags, recv.header_.flags);
     } else {
-      APPEND_flags_t flag1 = sent.header_.flags, flag2 = recv.header_.flags;
-      flag1 &= ~STORE_Header::WRITE_STREAM;
-      flag2 &= ~STORE_Header::WRITE_STREAM;
+      STORE_flags_t flag1 = sent.header_.flags, flag2 = recv.header_.flags;
+      if (proto < Compatibility::ProtocolVersion::STREAM_WRITER_SUPPORT) {
+        flag1 &= ~STORE_Header::WRITE_STREAM;
+        flag2 &= ~STORE_Header::WRITE_STREAM;
+      }
+      flag1 &= ~STORE_Header::LATENCY_TRACE;
       ASSERT_EQ(flag1, flag2);
     }
     ASSERT_EQ(sent.header_.timeout_ms, recv.header_.timeout_ms);
@@ -165,16 +169,24 @@ class MessageSerializationTest : public ::testing::Test {
     ASSERT_EQ(m.header_.logid, m2.header_.logid);
     ASSERT_EQ(m.header_.seen, m2.header_.seen);
     ASSERT_EQ(m.header_.timeout_ms, m2.header_.timeout_ms);
-    if (proto >= Compatibility::ProtocolVersion::STREAM_WRITER_SUPPORT) {
+    if (proto >= Compatibility::ProtocolVersion::APPEND_LATENCY_TRACE) {
       ASSERT_EQ(m.header_.flags, m2.header_.flags);
     } else {
       APPEND_flags_t flag1 = m.header_.flags, flag2 = m2.header_.flags;
-      flag1 &= ~(APPEND_Header::WRITE_STREAM_REQUEST |
-                 APPEND_Header::WRITE_STREAM_RESUME);
-      flag2 &= ~(APPEND_Header::WRITE_STREAM_REQUEST |
-                 APPEND_Header::WRITE_STREAM_RESUME);
+      if (proto < Compatibility::ProtocolVersion::STREAM_WRITER_SUPPORT) {
+        flag1 &= ~(APPEND_Header::WRITE_STREAM_REQUEST |
+                   APPEND_Header::WRITE_STREAM_RESUME);
+        flag2 &= ~(APPEND_Header::WRITE_STREAM_REQUEST |
+                   APPEND_Header::WRITE_STREAM_RESUME);
+      }
+      flag1 &= ~APPEND_Header::LATENCY_TRACE;
       ASSERT_EQ(flag1, flag2);
     }
+    if (m2.header_.flags & APPEND_Header::LATENCY_TRACE) {
+      ASSERT_EQ(m.latency_trace_.trace_id, m2.latency_trace_.trace_id);
+      ASSERT_EQ(
+          m.latency_trace_.client_queue_us, m2.latency_trace_.client_queue_us);
+    }
     ASSERT_EQ(m.attrs_.optional_keys, m2.attrs_.optional_keys);
     ASSERT_EQ(m.attrs_.counters.has_value(), m2.attrs_.counters.has_value());
     if (m.attrs_.counters.has_value()) {
@@ -194,6 +206,39 @@ class MessageSerializationTest : public ::testing::Test {
               m2.payload_.getPayload().toString());
   }
 
+  void checkSTORED(const STORED_Message& m,
+                   const STORED_Message& m2,
+                   uint16_t proto) {
+    ASSERT_EQ(m.header_.rid, m2.header_.rid);
+    ASSERT_EQ(m.header_.wave, m2.header_.wave);
+    ASSERT_EQ(m.header_.status, m2.header_.status);
+    ASSERT_EQ(m.header_.redirect, m2.header_.redirect);
+    ASSERT_EQ(m.header_.shard, m2.header_.shard);
+    if (proto >= Compatibility::ProtocolVersion::APPEND_LATENCY_TRACE) {
+      ASSERT_EQ(m.header_.flags, m2.header_.flags);
+    } else {
+      ASSERT_EQ(m.header_.flags & ~STORED_Header::LATENCY_TRACE,
+                m2.header_.flags);
+    }
+    if (m2.header_.flags & STORED_Header::LATENCY_TRACE) {
+      ASSERT_EQ(m.latency_trace_.queue_us, m2.latency_trace_.queue_us);
+      ASSERT_EQ(m.latency_trace_.write_us, m2.latency_trace_.write_us);
+      ASSERT_EQ(m.latency_trace_.sync_us, m2.latency_trace_.sync_us);
+    }
+  }
+
+  // Serializes `m` for protocol `proto`, in hex.
+  static std::string serializedHex(const Message& m, uint16_t proto) {
+    std::unique_ptr<folly::IOBuf> iobuf =
+        folly::IOBuf::create(IOBUF_ALLOCATION_UNIT);
+    ProtocolWriter writer(m.type_, iobuf.get(), proto);
+    m.serialize(writer);
+    ssize_t sz = writer.result();
+    EXPECT_EQ(E::OK, writer.status());
+    std::string serialized = iobuf->coalesce().str();
+    return hexdump_buf(&serialized[0], sz);
+  }
+
   void checkRECORD(const RECORD_Message& m,
                    const RECORD_Message& m2,
                    uint16_t proto) {
@@ -386,6 +431,9 @@ struct TestStoreMessageFactory {
     if (proto < Compatibility::STREAM_WRITER_SUPPORT) {
       flags &= ~STORE_Header::WRITE_STREAM;
     }
+    if (proto < Compatibility::APPEND_LATENCY_TRACE) {
+      flags &= ~STORE_Header::LATENCY_TRACE;
+    }
     std::string rv = "CE0465BE038BE5C5E25152C7813ABC0F" // rid
                      "8EEC9DDEBF2549EB"                 // timestamp
                      "BBB8ECEB"                         // last_known_good
@@ -626,6 +674,66 @@ TEST_F(MessageSerializationTest, STORE_WithWriteStreamFlagSet) {
           nullptr);
 }
 
+// LATENCY_TRACE is only a flag in STORE, dropped for older protocols.
+TEST_F(MessageSerializationTest, STORE_WithLatencyTraceFlagSet) {
+  TestStoreMessageFactory factory;
+
+  factory.setFlags(STORE_Header::LATENCY_TRACE);
+
+  STORE_Message m = factory.message();
+  auto check = [&](const STORE_Message& m2, uint16_t proto) {
+    checkSTORE(m, m2, proto);
+  };
+  DO_TEST(m,
+          check,
+          Compatibility::MIN_PROTOCOL_SUPPORTED,
+          Compatibility::MAX_PROTOCOL_SUPPORTED,
+          std::bind(&TestStoreMessageFactory::serialized, &factory, arg::_1),
+          nullptr);
+}
+
+TEST_F(MessageSerializationTest, STORED_WithLatencyTrace) {
+  STORED_Header h;
+  h.rid = RecordID(0xc5e58b03be6504ce, logid_t(0x0fbc3a81c75251e2));
+  h.wave = 2;
+  h.status = E::OK;
+  h.redirect = NodeID();
+  h.flags = STORED_Header::SYNCED;
+  h.shard = 1;
+  STORED_Message untraced(h,
+                          LSN_INVALID,
+                          0,
+                          CHUNK_REBUILDING_ID_INVALID,
+                          FlushToken_INVALID,
+                          ServerInstanceId_INVALID);
+  h.flags |= STORED_Header::LATENCY_TRACE;
+  STORED_Message m(h,
+                   LSN_INVALID,
+                   0,
+                   CHUNK_REBUILDING_ID_INVALID,
+                   FlushToken_INVALID,
+                   ServerInstanceId_INVALID);
+  m.latency_trace_ = STORED_LatencyTrace{1000, 2000, 3000};
+
+  auto check = [&](const STORED_Message& m2, uint16_t proto) {
+    checkSTORED(m, m2, proto);
+  };
+  auto expected_fn = [](uint16_t) { return std::string(); };
+  DO_TEST(m,
+          check,
+          Compatibility::MIN_PROTOCOL_SUPPORTED,
+          Compatibility::MAX_PROTOCOL_SUPPORTED,
+          expected_fn,
+          nullptr);
+
+  // Older protocols get exactly what they'd get for an untraced STORE.
+  const uint16_t proto = Compatibility::APPEND_LATENCY_TRACE;
+  EXPECT_EQ(serializedHex(untraced, proto - 1), serializedHex(m, proto - 1));
+  EXPECT_EQ(serializedHex(untraced, proto).size() +
+                2 * sizeof(STORED_LatencyTrace),
+            serializedHex(m, proto).size());
+}
+
 TEST_F(MessageSerializationTest, SHUTDOWN_WithServerInstanceId) {
   SHUTDOWN_Header h = {E::SHUTDOWN, ServerInstanceId(10)};
 
@@ -878,6 +986,38 @@ TEST_F(MessageSerializationTest, APPEND) {
   }
 }
 
+TEST_F(MessageSerializationTest, APPEND_WithLatencyTrace) {
+  APPEND_Header h = {request_id_t(0xb64a0f255e281e45),
+                     logid_t(0x3c3b4fa7a1299851),
+                     epoch_t(0xee396b50),
+                     0xed5b3efc,
+                     APPEND_Header::CHECKSUM_64BIT};
+  AppendAttributes attrs;
+  APPEND_Message untraced(
+      h, LSN_INVALID, attrs, PayloadHolder::copyString("hello"));
+  h.flags |= APPEND_Header::LATENCY_TRACE;
+  APPEND_Message m(h, LSN_INVALID, attrs, PayloadHolder::copyString("hello"));
+  m.setLatencyTrace(AppendLatencyTrace{0x0123456789abcdef, 1234});
+
+  auto check = [&](const APPEND_Message& m2, uint16_t proto) {
+    checkAPPEND(m, m2, proto);
+  };
+  auto expected_fn = [](uint16_t) { return std::string(); };
+  DO_TEST(m,
+          check,
+          Compatibility::MIN_PROTOCOL_SUPPORTED,
+          Compatibility::MAX_PROTOCOL_SUPPORTED,
+          expected_fn,
+          nullptr);
+
+  // Older protocols get exactly what they'd get for an untraced APPEND.
+  const uint16_t proto = Compatibility::APPEND_LATENCY_TRACE;
+  EXPECT_EQ(serializedHex(untraced, proto - 1), serializedHex(m, proto - 1));
+  EXPECT_EQ(serializedHex(untraced, proto).size() +
+                2 * sizeof(AppendLatencyTrace),
+            serializedHex(m, proto).size());
+}
+
 TEST_F(MessageSerializationTest, RECORD) {
   RECORD_Header h = {
       logid_t(0xb1ae6d3809c1cdad),
@@ -54,6 +54,7 @@ class MockSocketAdapter : public SocketAdapter {
                   folly::WriteFlags flags) override {
     writeChain_(callback, buf.release(), flags);
   }
+  MOCK_METHOD1(setZeroCopy, bool(bool));
   MOCK_METHOD1(setSendBufSize, int(size_t));
   MOCK_METHOD1(setRecvBufSize, int(size_t));
   MOCK_METHOD4(getSockOptVirtual, int(int, int, void*, socklen_t*));
@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/NumaTopology.h"
+
+#include <boost/filesystem.hpp>
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <gtest/gtest.h>
+#include <sys/sysmacros.h>
+
+#include "logdevice/common/test/TestUtil.h"
+
+namespace fs = boost::filesystem;
+using namespace facebook::logdevice;
+
+namespace {
+
+class NumaTopologyTest : public ::testing::Test {
+ public:
+  NumaTopologyTest() : dir_("NumaTopologyTest") {}
+
+ protected:
+  void writeFile(const fs::path& rel, const std::string& contents) {
+    const fs::path path = dir_.path() / rel;
+    fs::create_directories(path.parent_path());
+    ASSERT_TRUE(folly::writeFile(contents, path.c_str()));
+  }
+
+  // Adds a block device at `devices_rel` (with an optional partition) whose
+  // firmware reports it on kernel node `numa_node`.
+  void addDisk(const std::string& devices_rel,
+               dev_t disk,
+               dev_t partition,
+               int numa_node) {
+    const fs::path disk_dir = dir_.path() / "devices" / devices_rel;
+    writeFile(fs::path("devices") / devices_rel / "device/numa_node",
+              folly::to<std::string>(numa_node, "\n"));
+    fs::create_directories(disk_dir / "part1");
+    fs::create_directories(dir_.path() / "dev/block");
+    fs::create_symlink(disk_dir, devLink(disk));
+    fs::create_symlink(disk_dir / "part1", devLink(partition));
+  }
+
+  fs::path devLink(dev_t dev) {
+    return dir_.path() / "dev/block" /
+        folly::to<std::string>(major(dev), ":", minor(dev));
+  }
+
+  NumaTopology topology() {
+    return NumaTopology(dir_.path().string());
+  }
+
+  TemporaryDirectory dir_;
+};
+
+} // namespace
+
+TEST(NumaTopologyParseTest, CpuList) {
+  std::vector<int> cpus;
+  ASSERT_EQ(0, parse_cpu_list("0-3,8,10-11\n", &cpus));
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 8, 10, 11}), cpus);
+  ASSERT_EQ(0, parse_cpu_list("", &cpus));
+  EXPECT_TRUE(cpus.empty());
+  EXPECT_EQ(-1, parse_cpu_list("3-1", &cpus));
+  EXPECT_EQ(-1, parse_cpu_list("a,b", &cpus));
+  EXPECT_EQ(-1, parse_cpu_list("1-2-3", &cpus));
+}
+
+TEST_F(NumaTopologyTest, TwoNodes) {
+  writeFile("devices/system/node/node0/cpulist", "0-3,8-11\n");
+  writeFile("devices/system/node/node1/cpulist", "4-7,12-15\n");
+  // A memory-only node is ignored.
+  writeFile("devices/system/node/node2/cpulist", "\n");
+  writeFile("devices/system/node/possible", "0-2\n");
+
+  auto t = topology();
+  ASSERT_EQ(2, t.numNodes());
+  EXPECT_TRUE(t.isMultiNode());
+  EXPECT_EQ(std::vector<int>({4, 5, 6, 7, 12, 13, 14, 15}), t.cpusOfNode(1));
+  EXPECT_EQ(0, t.nodeOfCpu(9));
+  EXPECT_EQ(1, t.nodeOfCpu(12));
+  EXPECT_EQ(-1, t.nodeOfCpu(16));
+
+  // Workers are split evenly since both nodes have as many CPUs.
+  std::vector<int> nodes;
+  for (int i = 0; i < 5; ++i) {
+    nodes.push_back(t.nodeForWorker(i, 5));
+  }
+  EXPECT_EQ(std::vector<int>({0, 0, 0, 1, 1}), nodes);
+  EXPECT_EQ(0, t.nodeForWorker(0, 1));
+}
+
+TEST_F(NumaTopologyTest, DeviceNode) {
+  writeFile("devices/system/node/node0/cpulist", "0-1\n");
+  writeFile("devices/system/node/node1/cpulist", "2-3\n");
+  addDisk("pci0000:00/nvme0n1", makedev(259, 0), makedev(259, 1), 1);
+  addDisk("pci0000:80/nvme1n1", makedev(259, 2), makedev(259, 3), -1);
+
+  auto t = topology();
+  EXPECT_EQ(1, t.nodeOfDevice(makedev(259, 0)));
+  // A partition is on the node of its disk.
+  EXPECT_EQ(1, t.nodeOfDevice(makedev(259, 1)));
+  // The firmware doesn't know.
+  EXPECT_EQ(-1, t.nodeOfDevice(makedev(259, 3)));
+  // Not a block device sysfs knows about, e.g. tmpfs.
+  EXPECT_EQ(-1, t.nodeOfDevice(makedev(0, 42)));
+}
+
+TEST_F(NumaTopologyTest, NoNumaDegradesToOneNode) {
+  // sysfs without a node directory, as on kernels without NUMA support.
+  auto t = topology();
+  ASSERT_EQ(1, t.numNodes());
+  EXPECT_FALSE(t.isMultiNode());
+  EXPECT_FALSE(t.cpusOfNode(0).empty());
+  EXPECT_EQ(-1, t.nodeForWorker(3, 4));
+  EXPECT_EQ(0, t.nodeOfDevice(makedev(8, 0)));
+  // Binding is a no-op.
+  EXPECT_EQ(0, t.bindThisThread(0));
+  EXPECT_EQ(0, t.currentNode());
+}
@@ -10,6 +10,7 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <thread>
 #include <vector>
 
@@ -25,6 +26,7 @@
 #include "logdevice/common/Semaphore.h"
 #include "logdevice/common/Worker.h"
 #include "logdevice/common/debug.h"
+#include "logdevice/common/request_util.h"
 #include "logdevice/common/stats/Stats.h"
 #include "logdevice/common/test/TestUtil.h"
 #include "logdevice/common/types_internal.h"
@@ -114,6 +116,79 @@ TEST_F(ProcessorTest, ThreadTargetingTest) {
   EXPECT_EQ(expected, counts);
 }
 
+/**
+ * Requests posted with postRequests() go to the same workers as with
+ * postRequest(), and requests that can't be posted stay with the caller.
+ */
+TEST_F(ProcessorTest, PostRequestsTest) {
+  Settings settings = create_default_settings<Settings>();
+  settings.num_workers = 3;
+  auto processor = make_test_processor(settings);
+  {
+    std::lock_guard<std::mutex> guard(requests_per_thread_map_lock);
+    requests_per_thread.clear();
+  }
+
+  // 100 requests to the first thread and one to the other two, interleaved,
+  // plus one to a worker that doesn't exist.
+  std::vector<std::unique_ptr<Request>> rqs;
+  for (int i = 0; i < 100; ++i) {
+    rqs.push_back(std::make_unique<ThreadCountingRequest>(0));
+    if (i == 10 || i == 50) {
+      rqs.push_back(std::make_unique<ThreadCountingRequest>(i == 10 ? 1 : 2));
+    }
+  }
+  rqs.push_back(std::make_unique<ThreadCountingRequest>(3));
+
+  int rv = processor->postRequests(folly::range(rqs));
+  EXPECT_EQ(-1, rv);
+  EXPECT_EQ(E::INVALID_PARAM, err);
+  for (size_t i = 0; i + 1 < rqs.size(); ++i) {
+    EXPECT_EQ(nullptr, rqs[i]);
+  }
+  EXPECT_NE(nullptr, rqs.back());
+
+  // Wait for the work to finish
+  processor.reset();
+
+  std::vector<int> counts;
+  for (const auto& it : requests_per_thread) {
+    counts.push_back(it.second);
+  }
+  sort(counts.begin(), counts.end());
+  std::vector<int> expected{1, 1, 100};
+  EXPECT_EQ(expected, counts);
+}
+
+TEST_F(ProcessorTest, ApplyToWorkersAndPostTest) {
+  Settings settings = create_default_settings<Settings>();
+  settings.num_workers = 4;
+  auto processor = make_test_processor(settings);
+
+  std::mutex mutex;
+  std::set<std::pair<WorkerType, int>> ran_on;
+  Semaphore sem;
+  int rv = processor->applyToWorkersAndPost([&](Worker& w) {
+    return FuncRequest::make(
+        w.idx_, w.worker_type_, RequestType::MISC, [&] {
+          Worker* worker = Worker::onThisThread();
+          {
+            std::lock_guard<std::mutex> guard(mutex);
+            ran_on.emplace(worker->worker_type_, worker->idx_.val());
+          }
+          sem.post();
+        });
+  });
+  ASSERT_EQ(0, rv);
+
+  const int nworkers = processor->getAllWorkersCount();
+  for (int i = 0; i < nworkers; ++i) {
+    sem.wait();
+  }
+  std::lock_guard<std::mutex> guard(mutex);
+  EXPECT_EQ(nworkers, static_cast<int>(ran_on.size()));
+}
+
 struct TargetedNoopRequest : public Request {
   explicit TargetedNoopRequest(worker_id_t target)
       : Request(RequestType::TEST_PROCESSOR_TARGETED_NOOP_REQUEST),
@@ -171,6 +246,50 @@ TEST_F(ProcessorTest, ShutdownPingPongTest) {
   processor.reset();
 }
 
+/**
+ * Work offloaded with Worker::offloadToCpuExecutor() runs off the worker, and
+ * its result is handed back on the worker that offloaded it.
+ */
+TEST_F(ProcessorTest, OffloadToCpuExecutorTest) {
+  Settings settings = create_default_settings<Settings>();
+  settings.num_workers = 3;
+  settings.num_cpu_executor_threads = 2;
+  auto processor = make_test_processor(settings);
+
+  Semaphore sem;
+  std::thread::id worker_thread, fn_thread, cb_thread;
+  bool fn_on_worker = true;
+  worker_id_t cb_worker(-1);
+  RunContext cb_context;
+  int result = 0;
+  run_on_worker(processor.get(), 1, [&]() {
+    worker_thread = std::this_thread::get_id();
+    Worker::onThisThread()->offloadToCpuExecutor(
+        [&] {
+          fn_thread = std::this_thread::get_id();
+          fn_on_worker = Worker::onThisThread(false) != nullptr;
+          return 42;
+        },
+        [&](int value) {
+          result = value;
+          cb_thread = std::this_thread::get_id();
+          cb_worker = Worker::onThisThread()->idx_;
+          cb_context = Worker::onThisThread()->currentlyRunning_;
+          sem.post();
+        });
+    return 0;
+  });
+  sem.wait();
+
+  EXPECT_EQ(42, result);
+  EXPECT_NE(worker_thread, fn_thread);
+  EXPECT_FALSE(fn_on_worker);
+  EXPECT_EQ(worker_thread, cb_thread);
+  EXPECT_EQ(worker_id_t(1), cb_worker);
+  EXPECT_EQ(RunContext::REQUEST, cb_context.type_);
+  EXPECT_EQ(RequestType::CPU_EXECUTOR_RESULT, cb_context.subtype_.request);
+}
+
 TEST_F(ProcessorTest, EventLoopKeepAliveTest) {
   {
     ASSERT_DEATH(
@@ -7,20 +7,38 @@
  */
 #include "logdevice/common/Sender.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <folly/ScopeGuard.h>
 #include <folly/executors/IOThreadPoolExecutor.h>
 #include <folly/io/async/EventBase.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include "logdevice/common/ClientIdxAllocator.h"
+#include "logdevice/common/Connection.h"
+#include "logdevice/common/Semaphore.h"
+#include "logdevice/common/SocketCallback.h"
+#include "logdevice/common/Worker.h"
 #include "logdevice/common/configuration/Node.h"
 #include "logdevice/common/configuration/ShapingConfig.h"
+#include "logdevice/common/configuration/UpdateableConfig.h"
+#include "logdevice/common/network/IoUringSocketAdapter.h"
 #include "logdevice/common/protocol/Message.h"
+#include "logdevice/common/protocol/ProtocolHeader.h"
+#include "logdevice/common/request_util.h"
 #include "logdevice/common/test/MockConnectionFactory.h"
 #include "logdevice/common/test/MockNodeServiceDiscovery.h"
 #include "logdevice/common/test/MockNodesConfiguration.h"
 #include "logdevice/common/test/MockSettings.h"
 #include "logdevice/common/test/MockShapingConfig.h"
+#include "logdevice/common/test/TestUtil.h"
 #include "logdevice/include/NodeLocationScope.h"
 
 namespace facebook { namespace logdevice {
@@ -65,4 +83,336 @@ TEST(SenderTest, StartStop) {
   // TODO: I haven't been able to mock socket right now,
   // because of very tricky construction.
 }
+
+class ClientConnectionMigrationTest : public ::testing::Test {
+ protected:
+  // Connects two TCP sockets over the loopback interface. Returns the
+  // accepted end in server_fd and the connecting end in client_fd.
+  static void connectLoopback(int* server_fd, int* client_fd) {
+    int listener = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    ASSERT_GE(listener, 0);
+    SCOPE_EXIT {
+      ::close(listener);
+    };
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(0, ::bind(listener, (sockaddr*)&addr, len));
+    ASSERT_EQ(0, ::listen(listener, 1));
+    ASSERT_EQ(0, ::getsockname(listener, (sockaddr*)&addr, &len));
+
+    *client_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    ASSERT_GE(*client_fd, 0);
+    ASSERT_EQ(0, ::connect(*client_fd, (sockaddr*)&addr, len));
+    *server_fd = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+    ASSERT_GE(*server_fd, 0);
+  }
+
+  // Pretends that the HELLO/ACK handshake went through and that the
+  // messages the client sent so far took `cpu_time` to process.
+  static void fakeHandshake(Connection& conn,
+                            std::chrono::microseconds cpu_time) {
+    conn.handshake_timeout_event_.cancelTimeout();
+    conn.proto_ = Compatibility::MAX_PROTOCOL_SUPPORTED;
+    conn.handshaken_ = true;
+    conn.cpu_time_ = cpu_time;
+  }
+
+  // Does the connection do its network I/O through io_uring?
+  static bool usesIoUring(Connection& conn) {
+#if LOGDEVICE_HAVE_LIBURING
+    return dynamic_cast<IoUringSocketAdapter*>(
+               conn.proto_handler_->sock()) != nullptr;
+#else
+    (void)conn;
+    return false;
+#endif
+  }
+
+  // Reads one message from fd, waiting at most `timeout` for each chunk.
+  static std::string readMessage(int fd, std::chrono::milliseconds timeout) {
+    std::string buf;
+    size_t want = sizeof(message_len_t);
+    while (buf.size() < want) {
+      pollfd pfd{fd, POLLIN, 0};
+      if (::poll(&pfd, 1, timeout.count()) != 1) {
+        break;
+      }
+      char chunk[4096];
+      ssize_t n = ::read(fd, chunk, std::min(sizeof(chunk), want - buf.size()));
+      if (n <= 0) {
+        break;
+      }
+      buf.append(chunk, n);
+      if (want == sizeof(message_len_t) && buf.size() == want) {
+        message_len_t len;
+        memcpy(&len, buf.data(), sizeof(len));
+        want = len;
+      }
+    }
+    return buf;
+  }
+};
+
+/**
+ * A handshaken client connection moved to another worker stays handshaken
+ * there, and messages sent to its old ClientID on the old worker are
+ * forwarded to it.
+ */
+TEST_F(ClientConnectionMigrationTest, ForwardsToOldClientID) {
+  Settings settings = create_default_settings<Settings>();
+  settings.num_workers = 2;
+  settings.client_connection_migration_min_idle = std::chrono::milliseconds(0);
+  settings.enable_config_synchronization = false;
+  auto processor = make_test_processor(settings);
+
+  int server_fd = -1;
+  int client_fd = -1;
+  ASSERT_NO_FATAL_FAILURE(connectLoopback(&server_fd, &client_fd));
+  SCOPE_EXIT {
+    ::close(client_fd);
+  };
+
+  ClientID old_name;
+  bool could_migrate = false;
+  size_t moved = run_on_worker(processor.get(), 0, [&]() -> size_t {
+    Sender& sender = Worker::onThisThread()->sender();
+    int rv = sender.addClient(server_fd,
+                              Sockaddr("127.0.0.1", 4440),
+                              ResourceBudget::Token(),
+                              SocketType::DATA,
+                              ConnectionType::PLAIN);
+    if (rv != 0) {
+      return 0;
+    }
+    sender.forAllClientConnections([&](Connection& conn) {
+      old_name = conn.peer_name_.asClientID();
+      EXPECT_FALSE(conn.canMigrate());
+      fakeHandshake(conn, std::chrono::microseconds(100));
+      could_migrate = conn.canMigrate();
+    });
+    return sender.migrateClientConnections(
+        worker_id_t(1), std::chrono::seconds(1));
+  });
+  ASSERT_TRUE(old_name.valid());
+  EXPECT_TRUE(could_migrate);
+  ASSERT_EQ(1, moved);
+
+  // Posted after the connection was handed over, so the target worker has
+  // it by the time the forwarded message gets there.
+  int rv = run_on_worker(processor.get(), 0, [&] {
+    auto msg = std::make_unique<FakeMessage>(
+        MessageType::GET_SEQ_STATE_REPLY, TrafficClass::READ_BACKLOG);
+    return Worker::onThisThread()->sender().sendMessage(
+        std::move(msg), old_name);
+  });
+  ASSERT_EQ(0, rv);
+
+  std::string received = readMessage(client_fd, std::chrono::seconds(10));
+  ASSERT_GT(received.size(), sizeof(message_len_t) + sizeof(MessageType));
+  EXPECT_EQ(static_cast<char>(MessageType::GET_SEQ_STATE_REPLY),
+            received[sizeof(message_len_t)]);
+  EXPECT_EQ("hello", received.substr(received.size() - 5));
+
+  std::vector<std::pair<ClientID, bool>> new_conns =
+      run_on_worker(processor.get(), 1, [&] {
+        std::vector<std::pair<ClientID, bool>> res;
+        Worker::onThisThread()->sender().forAllClientConnections(
+            [&](Connection& conn) {
+              res.emplace_back(
+                  conn.peer_name_.asClientID(), conn.isHandshaken());
+            });
+        return res;
+      });
+  ASSERT_EQ(1, new_conns.size());
+  EXPECT_NE(old_name, new_conns[0].first);
+  EXPECT_TRUE(new_conns[0].second);
+}
+
+/**
+ * Closing an io_uring socket shuts the TCP connection down and may drop a
+ * receive in flight, so a client connection using one is not migrated: it
+ * stays on its worker and keeps working there.
+ */
+TEST_F(ClientConnectionMigrationTest, IoUringConnectionStaysOnWorker) {
+  Settings settings = create_default_settings<Settings>();
+  settings.num_workers = 2;
+  settings.client_connection_migration_min_idle = std::chrono::milliseconds(0);
+  settings.enable_config_synchronization = false;
+  settings.io_uring_sockets = true;
+  auto processor = make_test_processor(settings);
+
+  int server_fd = -1;
+  int client_fd = -1;
+  ASSERT_NO_FATAL_FAILURE(connectLoopback(&server_fd, &client_fd));
+  SCOPE_EXIT {
+    ::close(client_fd);
+  };
+
+  ClientID name;
+  bool io_uring = false;
+  bool could_migrate = true;
+  size_t moved = run_on_worker(processor.get(), 0, [&]() -> size_t {
+    Sender& sender = Worker::onThisThread()->sender();
+    int rv = sender.addClient(server_fd,
+                              Sockaddr("127.0.0.1", 4440),
+                              ResourceBudget::Token(),
+                              SocketType::DATA,
+                              ConnectionType::PLAIN);
+    if (rv != 0) {
+      return 0;
+    }
+    sender.forAllClientConnections([&](Connection& conn) {
+      name = conn.peer_name_.asClientID();
+      io_uring = usesIoUring(conn);
+      fakeHandshake(conn, std::chrono::microseconds(100));
+      could_migrate = conn.canMigrate();
+    });
+    return sender.migrateClientConnections(
+        worker_id_t(1), std::chrono::seconds(1));
+  });
+  ASSERT_TRUE(name.valid());
+  if (!io_uring) {
+    GTEST_SKIP() << "io_uring is not available";
+  }
+  EXPECT_FALSE(could_migrate);
+  EXPECT_EQ(0, moved);
+
+  int rv = run_on_worker(processor.get(), 0, [&] {
+    auto msg = std::make_unique<FakeMessage>(
+        MessageType::GET_SEQ_STATE_REPLY, TrafficClass::READ_BACKLOG);
+    return Worker::onThisThread()->sender().sendMessage(std::move(msg), name);
+  });
+  ASSERT_EQ(0, rv);
+
+  std::string received = readMessage(client_fd, std::chrono::seconds(10));
+  ASSERT_GT(received.size(), sizeof(message_len_t) + sizeof(MessageType));
+  EXPECT_EQ(static_cast<char>(MessageType::GET_SEQ_STATE_REPLY),
+            received[sizeof(message_len_t)]);
+  EXPECT_EQ("hello", received.substr(received.size() - 5));
+
+  size_t on_target = run_on_worker(processor.get(), 1, [&] {
+    size_t n = 0;
+    Worker::onThisThread()->sender().forAllClientConnections(
+        [&](Connection&) { ++n; });
+    return n;
+  });
+  EXPECT_EQ(0, on_target);
+}
+
+// A STORE-like message that Sender stripes by log_id.
+struct StripedMessage : public FakeMessage {
+  explicit StripedMessage(logid_t log_id)
+      : FakeMessage(MessageType::STORE, TrafficClass::APPEND),
+        log_id_(log_id) {}
+
+  logid_t getStripingLogID() const override {
+    return log_id_;
+  }
+
+  logid_t log_id_;
+};
+
+struct CountingSocketCallback : public SocketCallback {
+  void operator()(Status, const Address&) override {
+    ++called;
+    sem.post();
+  }
+
+  std::atomic<int> called{0};
+  Semaphore sem;
+};
+
+/**
+ * With several connections per node, the close callbacks registered for a
+ * log's outstanding STOREs are on the connection those STOREs were striped
+ * to: closing it fails them and leaves the main connection's callbacks
+ * alone, and checkConnection() for that log stops reporting the node as
+ * reachable.
+ */
+TEST(SenderTest, StripeClosedWithStoresOutstanding) {
+  int listener = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  ASSERT_GE(listener, 0);
+  SCOPE_EXIT {
+    ::close(listener);
+  };
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  ASSERT_EQ(0, ::bind(listener, (sockaddr*)&addr, len));
+  ASSERT_EQ(0, ::listen(listener, 4));
+  ASSERT_EQ(0, ::getsockname(listener, (sockaddr*)&addr, &len));
+
+  // Node 1 is the peer accepting on `listener'.
+  auto nodes = createSimpleNodesConfig(2).getNodes();
+  nodes[1].address = Sockaddr("127.0.0.1", ntohs(addr.sin_port));
+  auto config = std::make_shared<UpdateableConfig>(
+      createSimpleConfig(ServerConfig::NodesConfig(std::move(nodes)), 1));
+
+  Settings settings = create_default_settings<Settings>();
+  settings.num_workers = 1;
+  settings.connections_per_node = 3;
+  // The peer never answers HELLO.
+  settings.handshake_timeout = std::chrono::minutes(1);
+  settings.enable_config_synchronization = false;
+  auto processor = make_test_processor(settings, config);
+
+  const NodeID peer(1, 1);
+  const logid_t log_id(1);
+  CountingSocketCallback main_cb;
+  CountingSocketCallback stripe_cb;
+  SCOPE_EXIT {
+    run_on_worker(processor.get(), 0, [&] {
+      main_cb.deactivate();
+      stripe_cb.deactivate();
+      return 0;
+    });
+  };
+
+  // Connect the main connection first, then send a STORE so that its stripe
+  // gets connected, and accept them in that order.
+  int rv = run_on_worker(processor.get(), 0, [&] {
+    return Worker::onThisThread()->sender().connect(peer, false);
+  });
+  ASSERT_EQ(0, rv);
+  int main_fd = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+  ASSERT_GE(main_fd, 0);
+  SCOPE_EXIT {
+    ::close(main_fd);
+  };
+
+  rv = run_on_worker(processor.get(), 0, [&] {
+    Sender& sender = Worker::onThisThread()->sender();
+    if (sender.sendMessage(std::make_unique<StripedMessage>(log_id), peer) !=
+        0) {
+      return -1;
+    }
+    // What Appender does for each Recipient of the STORE.
+    if (sender.registerOnSocketClosed(Address(peer), stripe_cb, log_id) != 0) {
+      return -1;
+    }
+    return sender.registerOnSocketClosed(Address(peer), main_cb);
+  });
+  ASSERT_EQ(0, rv);
+  int stripe_fd = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+  ASSERT_GE(stripe_fd, 0);
+
+  // The peer drops the stripe.
+  ::close(stripe_fd);
+  ASSERT_EQ(0,
+            stripe_cb.sem.timedwait(std::chrono::system_clock::now() +
+                                    std::chrono::seconds(10)));
+  EXPECT_EQ(1, stripe_cb.called.load());
+
+  Status st = run_on_worker(processor.get(), 0, [&] {
+    ClientID name;
+    int res = Worker::onThisThread()->sender().checkConnection(
+        peer, &name, false, log_id);
+    return res == 0 ? E::OK : err;
+  });
+  EXPECT_EQ(E::NOTFOUND, st);
+  EXPECT_EQ(0, main_cb.called.load());
+}
 }} // namespace facebook::logdevice
@@ -0,0 +1,215 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/SharedFlowBudget.h"
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace facebook::logdevice;
+using namespace std::chrono_literals;
+
+namespace {
+
+TEST(AtomicTokenBucketTest, RefillsAtRateUpToCapacity) {
+  AtomicTokenBucket bucket;
+  bucket.configure(/*Bps*/ 1000000, /*burst*/ 5000);
+  auto now = SteadyTimestamp::now();
+
+  // Starts full.
+  EXPECT_EQ(5000, bucket.borrow(10000, now));
+  EXPECT_EQ(0, bucket.borrow(1, now));
+
+  // 1 byte per microsecond.
+  EXPECT_EQ(100, bucket.borrow(10000, now + 100us));
+  EXPECT_EQ(50, bucket.borrow(50, now + 1ms));
+  EXPECT_EQ(850, bucket.borrow(10000, now + 1ms));
+
+  // No more than the capacity accrues while idle.
+  EXPECT_EQ(5000, bucket.borrow(10000, now + 1s));
+}
+
+TEST(AtomicTokenBucketTest, FractionalCreditIsNotLost) {
+  AtomicTokenBucket bucket;
+  bucket.configure(/*Bps*/ 1000, /*burst*/ 1000);
+  auto now = SteadyTimestamp::now();
+  ASSERT_EQ(1000, bucket.borrow(1000, now));
+
+  // 1 byte per millisecond, asked for every 400us.
+  int64_t total = 0;
+  for (int i = 1; i <= 25; ++i) {
+    total += bucket.borrow(1000, now + i * 400us);
+  }
+  EXPECT_EQ(10, total);
+}
+
+TEST(AtomicTokenBucketTest, GiveBackAndTimeUntilAvailable) {
+  AtomicTokenBucket bucket;
+  bucket.configure(/*Bps*/ 1000000, /*burst*/ 1000);
+  auto now = SteadyTimestamp::now();
+  ASSERT_EQ(1000, bucket.borrow(1000, now));
+
+  EXPECT_EQ(500us, bucket.timeUntilAvailable(500, now));
+  // Can't wait for more than the capacity.
+  EXPECT_EQ(1000us, bucket.timeUntilAvailable(2000, now));
+
+  bucket.giveBack(300);
+  EXPECT_EQ(300, bucket.level());
+  EXPECT_EQ(200us, bucket.timeUntilAvailable(500, now));
+  // Excess over capacity is discarded.
+  bucket.giveBack(5000);
+  EXPECT_EQ(1000, bucket.level());
+  EXPECT_EQ(0us, bucket.timeUntilAvailable(500, now));
+
+  bucket.configure(/*Bps*/ 0, /*burst*/ 100);
+  EXPECT_EQ(100, bucket.level());
+  EXPECT_EQ(100, bucket.borrow(1000, now + 1s));
+  EXPECT_EQ(std::chrono::microseconds::max(),
+            bucket.timeUntilAvailable(1, now + 1s));
+}
+
+TEST(AtomicTokenBucketTest, ConcurrentBorrowers) {
+  AtomicTokenBucket bucket;
+  // Make the bucket refill by 1MB during the test at most.
+  bucket.configure(/*Bps*/ 1000000, /*burst*/ 1000000);
+  auto start = SteadyTimestamp::now();
+  const auto deadline = start + 1s;
+
+  std::atomic<int64_t> total{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&] {
+      int64_t mine = 0;
+      for (int i = 0; i < 100000; ++i) {
+        auto now = std::min(SteadyTimestamp::now(), deadline);
+        mine += bucket.borrow(7, now);
+      }
+      total += mine;
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  auto elapsed = std::min(SteadyTimestamp::now(), deadline) - start;
+  // Initial burst plus what accrued while the threads ran.
+  int64_t accrued =
+      std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+  EXPECT_LE(total.load() + bucket.level(), 1000000 + accrued + 1);
+}
+
+class SharedFlowBudgetTest : public ::testing::Test {
+ public:
+  SharedFlowBudgetTest() {
+    policy.setEnabled(true);
+    for (Priority p = Priority::MAX; p < Priority::NUM_PRIORITIES;
+         p = priorityBelow(p)) {
+      policy.set(p, /*burst*/ 1000, /*Bps*/ 1000000);
+    }
+    policy.set(Priority::NUM_PRIORITIES, /*burst*/ 1000, /*Bps*/ 1000000);
+    budget.configure(NodeLocationScope::RACK, policy);
+  }
+
+  FlowGroupPolicy policy;
+  SharedFlowBudget budget;
+  SteadyTimestamp now = SteadyTimestamp::now();
+};
+
+TEST_F(SharedFlowBudgetTest, BorrowsFromPriorityThenPool) {
+  auto borrow = [&](NodeLocationScope scope,
+                    Priority p,
+                    int64_t amount,
+                    int64_t& transferred) {
+    return budget.borrow(scope, p, amount, transferred, now);
+  };
+  int64_t transferred;
+  EXPECT_EQ(
+      600, borrow(NodeLocationScope::RACK, Priority::MAX, 600, transferred));
+  EXPECT_EQ(0, transferred);
+
+  // 400 left for MAX, the rest comes from the pool.
+  EXPECT_EQ(
+      1000, borrow(NodeLocationScope::RACK, Priority::MAX, 1000, transferred));
+  EXPECT_EQ(600, transferred);
+
+  // The pool is shared by all priorities.
+  EXPECT_EQ(
+      1400, borrow(NodeLocationScope::RACK, Priority::IDLE, 2000, transferred));
+  EXPECT_EQ(400, transferred);
+
+  // Other scopes have budgets of their own.
+  EXPECT_EQ(
+      0, borrow(NodeLocationScope::ROOT, Priority::MAX, 1000, transferred));
+}
+
+TEST_F(SharedFlowBudgetTest, GiveBackReturnsCreditWhereItCameFrom) {
+  auto borrow = [&](Priority p, int64_t amount, int64_t& transferred) {
+    return budget.borrow(NodeLocationScope::RACK, p, amount, transferred, now);
+  };
+  int64_t transferred;
+  EXPECT_EQ(1500, borrow(Priority::MAX, 1500, transferred));
+  EXPECT_EQ(500, transferred);
+
+  // 500 of it goes back to the pool, 200 to the bucket of MAX.
+  budget.giveBack(NodeLocationScope::RACK, Priority::MAX, 700, 500);
+  EXPECT_EQ(2000, borrow(Priority::IDLE, 2000, transferred));
+  EXPECT_EQ(1000, transferred);
+  EXPECT_EQ(200, borrow(Priority::MAX, 1000, transferred));
+  EXPECT_EQ(0, transferred);
+
+  // The bucket of MAX holds at most 1000, the rest must be pool credit.
+  budget.giveBack(NodeLocationScope::RACK, Priority::MAX, 1500);
+  EXPECT_EQ(1500, borrow(Priority::BACKGROUND, 2000, transferred));
+  EXPECT_EQ(500, transferred);
+  EXPECT_EQ(1000, borrow(Priority::MAX, 2000, transferred));
+  EXPECT_EQ(0, transferred);
+}
+
+TEST_F(SharedFlowBudgetTest, PoolLimitedByMaxBandwidth) {
+  policy.set(
+      Priority::BACKGROUND, /*burst*/ 1000, /*Bps*/ 1000000, /*max*/ 1200000);
+  budget.configure(NodeLocationScope::RACK, policy);
+  auto borrow = [&](Priority p,
+                    int64_t amount,
+                    int64_t& transferred,
+                    std::chrono::microseconds t) {
+    return budget.borrow(
+        NodeLocationScope::RACK, p, amount, transferred, now + t);
+  };
+
+  int64_t transferred;
+  // The limit on pool transfers is a bucket of its own, with the priority's
+  // maximum burst, refilled at max_bw - guaranteed_bw.
+  EXPECT_EQ(2000, borrow(Priority::BACKGROUND, 5000, transferred, 0us));
+  EXPECT_EQ(1000, transferred);
+  EXPECT_EQ(0, borrow(Priority::BACKGROUND, 5000, transferred, 0us));
+  EXPECT_EQ(0, transferred);
+
+  // After 1ms the priority bucket and the pool got 1000 bytes, the limit 200.
+  EXPECT_EQ(1200, borrow(Priority::BACKGROUND, 5000, transferred, 1000us));
+  EXPECT_EQ(200, transferred);
+  EXPECT_EQ(
+      1000us,
+      budget.timeUntilAvailable(
+          NodeLocationScope::RACK, Priority::BACKGROUND, 1000, now + 1ms));
+
+  // Empty the pool.
+  EXPECT_EQ(1800, borrow(Priority::IDLE, 2000, transferred, 1000us));
+  EXPECT_EQ(800, transferred);
+  EXPECT_EQ(2000, borrow(Priority::IDLE, 2000, transferred, 2000us));
+  EXPECT_EQ(1000, transferred);
+
+  // The 200 bytes of limit taken for nothing when the pool was empty are
+  // returned to it.
+  EXPECT_EQ(1000, borrow(Priority::BACKGROUND, 5000, transferred, 2000us));
+  EXPECT_EQ(0, transferred);
+  EXPECT_EQ(400, borrow(Priority::BACKGROUND, 5000, transferred, 2200us));
+  EXPECT_EQ(200, transferred);
+}
+
+} // namespace
@@ -589,6 +589,59 @@ TEST_F(ClientSocketTest, CloseConnectionOnProtocolChecksumMismatch) {
       Compatibility::MIN_PROTOCOL_SUPPORTED, Message::MAX_LEN));
   ld_check(socket_->isClosed());
 }
+// Negotiate compression in the handshake and check that large messages of a
+// compressed traffic class go through the zstd stream. receiveMsg() serializes
+// with the socket itself, so the socket decompresses what it compressed.
+TEST_F(ClientSocketTest, CompressedMessages) {
+  settings_.connection_compression = true;
+  TrafficShapingConfig shaping;
+  shaping.compressed_traffic_classes.insert(TrafficClass::RECOVERY);
+  server_config_ = ServerConfig::fromDataTest(cluster_name_,
+                                              NodesConfig(),
+                                              MetaDataLogsConfig(),
+                                              PrincipalsConfig(),
+                                              SecurityConfig(),
+                                              shaping);
+
+  int rv = socket_->connect();
+  ASSERT_EQ(0, rv);
+  triggerEventConnected();
+  flushOutputEvBuffer();
+  CHECK_ON_SENT(MessageType::HELLO, E::OK);
+  ACK_Header ackhdr{ACK_Header::COMPRESSION_ZSTD,
+                    request_id_t(0),
+                    client_id_,
+                    max_proto_,
+                    E::OK};
+  receiveMsg(new TestACK_Message(ackhdr));
+  ASSERT_TRUE(handshaken());
+  ASSERT_NE(nullptr, socket_->compressor_);
+
+  // VarLengthTestMessage fills its body with spaces, which compress well.
+  const size_t size = 64 * 1024;
+  size_t received = bytesReceived();
+  receiveMsg(new VarLengthTestMessage(
+      Compatibility::MIN_PROTOCOL_SUPPORTED, size, TrafficClass::RECOVERY));
+  EXPECT_FALSE(socket_->isClosed());
+  EXPECT_LT(bytesReceived() - received, size / 10);
+  EXPECT_EQ(1, socket_->decompressor_->getStats().messages);
+
+  // Later messages go through the same decompression stream.
+  receiveMsg(new VarLengthTestMessage(
+      Compatibility::MIN_PROTOCOL_SUPPORTED, size, TrafficClass::RECOVERY));
+  EXPECT_FALSE(socket_->isClosed());
+  EXPECT_EQ(2, socket_->decompressor_->getStats().messages);
+
+  // Traffic classes that are not configured, and small messages, are sent
+  // as is.
+  receiveMsg(new VarLengthTestMessage(
+      Compatibility::MIN_PROTOCOL_SUPPORTED, size, TrafficClass::APPEND));
+  receiveMsg(new VarLengthTestMessage(
+      Compatibility::MIN_PROTOCOL_SUPPORTED, 16, TrafficClass::RECOVERY));
+  EXPECT_FALSE(socket_->isClosed());
+  EXPECT_EQ(2, socket_->decompressor_->getStats().messages);
+}
+
 // Test that we can reconnect after error
 TEST_F(ClientSocketTest, DISABLED_ReconnectPossible) {
   // If buffereventSocketConnect returns -1 with err set to ENETUNREACH,
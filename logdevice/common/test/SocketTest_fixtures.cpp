@@ -48,6 +48,10 @@ TestSocketDependencies::getSSLContext() const {
   return nullptr;
 }
 
+std::shared_ptr<ServerConfig> TestSocketDependencies::getServerConfig() const {
+  return owner_->server_config_;
+}
+
 bool TestSocketDependencies::shuttingDown() const {
   return false;
 }
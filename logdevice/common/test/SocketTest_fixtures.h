@@ -22,6 +22,7 @@
 #include "logdevice/common/SSLFetcher.h"
 #include "logdevice/common/SocketDependencies.h"
 #include "logdevice/common/Timestamp.h"
+#include "logdevice/common/configuration/ServerConfig.h"
 #include "logdevice/common/debug.h"
 #include "logdevice/common/libevent/compat.h"
 #include "logdevice/common/libevent/test/EvBaseMock.h"
@@ -54,6 +55,7 @@ class TestSocketDependencies : public SocketDependencies {
                                 folly::Optional<MessageType>) override;
   virtual size_t getBytesPending() const override;
   virtual std::shared_ptr<folly::SSLContext> getSSLContext() const override;
+  std::shared_ptr<ServerConfig> getServerConfig() const override;
   virtual bool shuttingDown() const override;
   virtual std::string dumpQueuedMessages(Address addr) const override;
   virtual const Sockaddr& getNodeSockaddr(NodeID node_id,
@@ -297,6 +299,9 @@ class SocketTest : public ::testing::Test {
   bool handshaken() const {
     return socket_->handshaken_;
   }
+  size_t bytesReceived() const {
+    return socket_->num_bytes_received_;
+  }
 
   int getDscp();
 
@@ -304,6 +309,8 @@ class SocketTest : public ::testing::Test {
   const uint16_t max_proto_ = Compatibility::MAX_PROTOCOL_SUPPORTED;
 
   Settings settings_;
+  // Returned by getServerConfig(), may be nullptr.
+  std::shared_ptr<ServerConfig> server_config_;
   NodeID server_name_;
   Sockaddr server_addr_;  // stays invalid on a client.
   NodeID source_node_id_; // stays invalid on a client.
@@ -10,11 +10,13 @@
 #include <array>
 #include <atomic>
 #include <condition_variable>
+#include <map>
 #include <mutex>
 #include <thread>
 #include <unistd.h>
 #include <vector>
 
+#include <folly/Conv.h>
 #include <folly/Random.h>
 #include <folly/ScopeGuard.h>
 #include <folly/stats/BucketedTimeSeries.h>
@@ -116,6 +118,104 @@ TEST(StatsTest, MultipleThreadsTest) {
   EXPECT_EQ(nthreads, total.store_synced);
 }
 
+// Per-log-group stats bumped on several threads add up, and keep counting
+// after a reset().
+TEST(StatsTest, PerLogStatsMultipleThreadsTest) {
+  StatsHolder holder(StatsParams().setIsServer(true));
+  constexpr int nthreads = 4;
+  constexpr int nlogs = 100;
+  auto log_name = [](int i) {
+    return "/log_group_" + folly::to<std::string>(i);
+  };
+
+  auto bump = [&] {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nthreads; ++t) {
+      threads.emplace_back([&] {
+        for (int i = 0; i < nlogs; ++i) {
+          LOG_GROUP_STAT_ADD(&holder, log_name(i), append_success, i + 1);
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+  };
+  // Returns the aggregated append_success of each log group.
+  auto get = [&] {
+    std::map<std::string, int64_t> res;
+    for (const auto& kv :
+         holder.aggregate().synchronizedCopy(&Stats::per_log_stats)) {
+      res[kv.first] = kv.second->append_success;
+    }
+    return res;
+  };
+
+  bump();
+  auto values = get();
+  ASSERT_EQ(nlogs, values.size());
+  for (int i = 0; i < nlogs; ++i) {
+    EXPECT_EQ(nthreads * (i + 1), values[log_name(i)]);
+  }
+
+  // This thread looks up log group 0 before and after the reset.
+  LOG_GROUP_STAT_ADD(&holder, log_name(0), append_success, 10);
+  holder.reset();
+  values = get();
+  ASSERT_EQ(nlogs, values.size());
+  for (const auto& kv : values) {
+    EXPECT_EQ(0, kv.second) << kv.first;
+  }
+  LOG_GROUP_STAT_ADD(&holder, log_name(0), append_success, 5);
+
+  bump();
+  values = get();
+  ASSERT_EQ(nlogs, values.size());
+  EXPECT_EQ(nthreads + 5, values[log_name(0)]);
+  for (int i = 1; i < nlogs; ++i) {
+    EXPECT_EQ(nthreads * (i + 1), values[log_name(i)]);
+  }
+}
+
+// perLogStatsDelta() reports what changed since the previous call, including
+// counts of threads that exited in between, and leaves out idle log groups.
+TEST(StatsTest, PerLogStatsDeltaTest) {
+  StatsHolder holder(StatsParams().setIsServer(true));
+  auto bump_on_thread = [&](const std::string& log_name, int64_t val) {
+    std::thread([&] {
+      LOG_GROUP_STAT_ADD(&holder, log_name, append_success, val);
+    }).join();
+  };
+
+  EXPECT_TRUE(holder.perLogStatsDelta().empty());
+
+  LOG_GROUP_STAT_ADD(&holder, "/a", append_success, 3);
+  LOG_GROUP_STAT_ADD(&holder, "/b", records_sent, 2);
+  bump_on_thread("/a", 4);
+  auto delta = holder.perLogStatsDelta();
+  ASSERT_EQ(2, delta.size());
+  EXPECT_EQ(7, delta["/a"].append_success);
+  EXPECT_EQ(0, delta["/a"].records_sent);
+  EXPECT_EQ(2, delta["/b"].records_sent);
+
+  EXPECT_TRUE(holder.perLogStatsDelta().empty());
+
+  LOG_GROUP_STAT_ADD(&holder, "/a", append_success, 1);
+  bump_on_thread("/c", 5);
+  delta = holder.perLogStatsDelta();
+  ASSERT_EQ(2, delta.size());
+  EXPECT_EQ(1, delta["/a"].append_success);
+  EXPECT_EQ(5, delta["/c"].append_success);
+
+  // Counts dropped by reset() show up as negative changes.
+  holder.reset();
+  delta = holder.perLogStatsDelta();
+  ASSERT_EQ(3, delta.size());
+  EXPECT_EQ(-8, delta["/a"].append_success);
+  EXPECT_EQ(-2, delta["/b"].records_sent);
+  EXPECT_EQ(-5, delta["/c"].append_success);
+}
+
 TEST(StatsTest, LatencyPercentileTest) {
   FastUpdateableSharedPtr<StatsParams> params(std::make_shared<StatsParams>());
   Stats s(&params);
@@ -297,6 +397,115 @@ TEST(StatsTest, CompactLatencyHistogramShouldGetFrequencyCounters) {
       << "Unexpected result of method getFrequencyCounters()";
 }
 
+TEST(StatsTest, HighResHistogramAccuracy) {
+  HighResLatencyHistogram hist;
+  const double accuracy = hist.getRelativeAccuracy();
+
+  // Log-uniform values from 1us to ~1000s, plus a few zeros.
+  std::vector<int64_t> values;
+  int64_t sum = 0;
+  for (int i = 0; i < 100000; ++i) {
+    int64_t v = i % 1000 == 0
+        ? 0
+        : static_cast<int64_t>(std::exp(folly::Random::randDouble(0, 21)));
+    values.push_back(v);
+    sum += v;
+    hist.add(v);
+  }
+  std::sort(values.begin(), values.end());
+
+  std::array<double, 8> pct = {0, .01, .25, .5, .9, .99, .999, 1};
+  std::array<int64_t, 8> out;
+  uint64_t count;
+  int64_t sum_out;
+  hist.estimatePercentiles(&pct[0], pct.size(), &out[0], &count, &sum_out);
+  EXPECT_EQ(values.size(), count);
+  EXPECT_EQ(sum, sum_out);
+  for (size_t i = 0; i < pct.size(); ++i) {
+    int64_t expected = values[static_cast<size_t>(pct[i] * (count - 1))];
+    // +1 for rounding the estimate to an integer.
+    EXPECT_LE(std::abs(out[i] - expected), expected * accuracy + 1)
+        << "p" << pct[i] * 100 << ": " << out[i] << " vs " << expected;
+  }
+
+  // Extreme values must not fall out of range.
+  HighResSizeHistogram extremes(0.05);
+  extremes.add(std::numeric_limits<int64_t>::max());
+  extremes.add(std::numeric_limits<int64_t>::min());
+  extremes.add(1);
+  EXPECT_GE(extremes.estimatePercentile(1),
+            std::numeric_limits<int64_t>::max() * 0.95);
+  EXPECT_EQ(0, extremes.estimatePercentile(0));
+  EXPECT_EQ(1, extremes.estimatePercentile(.5));
+}
+
+TEST(StatsTest, HighResHistogramSerializeAndMerge) {
+  // Two "nodes" with different distributions.
+  HighResLatencyHistogram a, b, all;
+  for (int i = 0; i < 10000; ++i) {
+    int64_t va = folly::Random::rand64(1000);
+    int64_t vb = 100000 + folly::Random::rand64(1000000);
+    a.add(va);
+    b.add(vb);
+    all.add(va);
+    all.add(vb);
+  }
+  b.add(-5);
+  all.add(-5);
+
+  std::string a_data, b_data;
+  ASSERT_TRUE(a.serialize(&a_data));
+  ASSERT_TRUE(b.serialize(&b_data));
+  // Only nonempty buckets are encoded.
+  EXPECT_LT(a_data.size() + b_data.size(), 4096);
+
+  HighResLatencyHistogram merged;
+  ASSERT_TRUE(merged.mergeSerialized(a_data));
+  ASSERT_TRUE(merged.mergeSerialized(b_data));
+
+  // Merging serialized histograms loses nothing.
+  std::array<double, 6> pct = {0, .25, .5, .75, .99, 1};
+  std::array<int64_t, 6> expected, actual;
+  uint64_t expected_count, actual_count;
+  int64_t expected_sum, actual_sum;
+  all.estimatePercentiles(
+      &pct[0], pct.size(), &expected[0], &expected_count, &expected_sum);
+  merged.estimatePercentiles(
+      &pct[0], pct.size(), &actual[0], &actual_count, &actual_sum);
+  EXPECT_EQ(expected, actual);
+  EXPECT_EQ(expected_count, actual_count);
+  EXPECT_EQ(expected_sum, actual_sum);
+
+  // Same for in-process merge.
+  HighResLatencyHistogram merged2(a);
+  merged2.merge(b);
+  merged2.estimatePercentiles(
+      &pct[0], pct.size(), &actual[0], &actual_count, &actual_sum);
+  EXPECT_EQ(expected, actual);
+  EXPECT_EQ(expected_sum, actual_sum);
+
+  // Malformed or incompatible inputs are rejected without side effects.
+  std::string merged_data;
+  ASSERT_TRUE(merged.serialize(&merged_data));
+  EXPECT_FALSE(merged.mergeSerialized(""));
+  EXPECT_FALSE(merged.mergeSerialized("garbage"));
+  EXPECT_FALSE(merged.mergeSerialized(
+      folly::StringPiece(a_data.data(), a_data.size() - 1)));
+  HighResLatencyHistogram coarse(0.05);
+  coarse.add(42);
+  std::string coarse_data;
+  ASSERT_TRUE(coarse.serialize(&coarse_data));
+  EXPECT_FALSE(merged.mergeSerialized(coarse_data));
+  std::string after;
+  ASSERT_TRUE(merged.serialize(&after));
+  EXPECT_EQ(merged_data, after);
+
+  // Histograms without a serialization say so.
+  std::string data;
+  EXPECT_FALSE(LatencyHistogram().serialize(&data));
+  EXPECT_FALSE(CompactLatencyHistogram().mergeSerialized(a_data));
+}
+
 TEST(StatsTest, PerNodeTimeSeriesSingleThread) {
   StatsHolder holder(
       StatsParams().setIsServer(false).setNodeStatsRetentionTimeOnClients(
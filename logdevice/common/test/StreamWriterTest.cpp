@@ -98,13 +98,14 @@ class TestStreamWriterAppendSink : public StreamWriterAppendSink {
   StreamState stream_state;
   std::unordered_set<StreamAppendRequest*> cancelled;
 
-  TestStreamWriterAppendSink()
+  explicit TestStreamWriterAppendSink(size_t max_inflight_window = 0)
       : StreamWriterAppendSink(std::shared_ptr<Processor>(nullptr),
                                nullptr,
                                std::chrono::milliseconds(10000),
                                chrono_expbackoff_t<std::chrono::milliseconds>(
                                    std::chrono::milliseconds(0),
-                                   std::chrono::milliseconds(0))) {}
+                                   std::chrono::milliseconds(0)),
+                               max_inflight_window) {}
 
   void updateSeenEpoch(epoch_t epoch) {
     if (epoch != EPOCH_INVALID && epoch > seen_epoch) {
@@ -412,6 +413,39 @@ TEST_F(StreamWriterAppendSinkTest, MultipleRequests) {
   ASSERT_EQ(5UL, test_sink_->getMaxPrefixAckedSeqNum(logid).val());
 }
 
+// With a fixed inflight window, at most that many appends are in flight and
+// the window is refilled as prefix ACKs arrive.
+TEST_F(StreamWriterAppendSinkTest, InflightWindow) {
+  test_sink_ = std::make_unique<TestStreamWriterAppendSink>(4);
+  int num_msg_received = 0;
+  auto callback = [&num_msg_received](
+                      Status status, const DataRecord&, NodeID) {
+    ASSERT_EQ(Status::OK, status);
+    num_msg_received++;
+  };
+
+  logid_t logid(1UL);
+  std::vector<TestCommand> cmds;
+  for (int i = 0; i < 10; ++i) {
+    cmds.push_back(TestCommand::create(ACCEPT, std::to_string(i)));
+  }
+  cmds.push_back(
+      TestCommand::create(REJECT_ONCE, "10").addArg(toString(E::CONNFAILED)));
+  for (auto& cmd : cmds) {
+    appendHelper(logid, cmd, callback);
+  }
+  ASSERT_EQ(4UL, test_sink_->incoming_queue.size());
+
+  // Each round acks the whole window and slides it forward.
+  test_sink_->processTestRequests(false);
+  ASSERT_EQ(4, num_msg_received);
+  ASSERT_EQ(4UL, test_sink_->incoming_queue.size());
+
+  test_sink_->processTestRequests();
+  ASSERT_EQ(11, num_msg_received);
+  ASSERT_EQ(11UL, test_sink_->getMaxPrefixAckedSeqNum(logid).val());
+}
+
 TEST_F(StreamWriterAppendSinkTest, MultipleLogs) {
   int num_msg_received_log1 = 0;
   logid_t logid1(1UL);
@@ -0,0 +1,157 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/TimingWheel.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace facebook::logdevice;
+using namespace std::chrono;
+using namespace std::chrono_literals;
+
+namespace {
+
+class TimingWheelTest : public ::testing::Test {
+ protected:
+  TimingWheel::Clock::time_point at(milliseconds t) const {
+    return start_ + t;
+  }
+
+  const TimingWheel::Clock::time_point start_{TimingWheel::Clock::now()};
+  TimingWheel wheel_{1ms, start_};
+};
+
+} // namespace
+
+TEST_F(TimingWheelTest, FiresOnTime) {
+  int fired = 0;
+  TimingWheel::Entry entry([&] { ++fired; });
+  wheel_.schedule(entry, 10ms, at(0ms));
+  EXPECT_TRUE(entry.isScheduled());
+  EXPECT_EQ(at(10ms), wheel_.expiryTime(entry));
+
+  EXPECT_EQ(0, wheel_.advance(at(9ms)));
+  EXPECT_EQ(0, fired);
+  EXPECT_EQ(1, wheel_.advance(at(10ms)));
+  EXPECT_EQ(1, fired);
+  EXPECT_FALSE(entry.isScheduled());
+  EXPECT_TRUE(wheel_.empty());
+}
+
+TEST_F(TimingWheelTest, RoundsUpAndNeverFiresEarly) {
+  int fired = 0;
+  TimingWheel::Entry entry([&] { ++fired; });
+  // Zero delay fires on the next tick.
+  wheel_.schedule(entry, 0ms, at(0ms));
+  EXPECT_EQ(0, wheel_.advance(at(0ms)));
+  EXPECT_EQ(1, wheel_.advance(at(1ms)));
+
+  // 1.5 ticks from 1ms is 2.5ms, so the 3ms tick.
+  wheel_.schedule(entry, 1500us, at(1ms));
+  EXPECT_EQ(0, wheel_.advance(at(2ms)));
+  EXPECT_EQ(1, wheel_.advance(at(3ms)));
+  EXPECT_EQ(2, fired);
+}
+
+TEST_F(TimingWheelTest, CancelAndReschedule) {
+  int fired = 0;
+  TimingWheel::Entry a([&] { ++fired; });
+  TimingWheel::Entry b([&] { fired += 10; });
+  wheel_.schedule(a, 5ms, at(0ms));
+  wheel_.schedule(b, 5ms, at(0ms));
+  EXPECT_EQ(2, wheel_.size());
+
+  a.cancel();
+  EXPECT_EQ(1, wheel_.size());
+  // Rescheduling moves the entry.
+  wheel_.schedule(b, 700ms, at(0ms));
+  EXPECT_EQ(1, wheel_.size());
+
+  EXPECT_EQ(0, wheel_.advance(at(699ms)));
+  EXPECT_EQ(1, wheel_.advance(at(700ms)));
+  EXPECT_EQ(10, fired);
+
+  {
+    TimingWheel::Entry c([&] { ++fired; });
+    wheel_.schedule(c, 1ms, at(700ms));
+  }
+  // Destroying the entry cancelled it.
+  EXPECT_TRUE(wheel_.empty());
+}
+
+TEST_F(TimingWheelTest, CallbackCanRescheduleItself) {
+  int fired = 0;
+  TimingWheel::Entry entry;
+  entry.setCallback([&] {
+    if (++fired < 3) {
+      wheel_.schedule(entry, 100ms, at(fired * 100ms));
+    }
+  });
+  wheel_.schedule(entry, 100ms, at(0ms));
+  EXPECT_EQ(3, wheel_.advance(at(1000ms)));
+  EXPECT_EQ(3, fired);
+}
+
+// Timers spread over all levels of the wheel fire in order, each at its own
+// tick.
+TEST_F(TimingWheelTest, ManyTimersAcrossLevels) {
+  std::mt19937_64 rng(42);
+  const milliseconds horizon = 20'000'000ms;
+  std::vector<milliseconds> delays;
+  for (int i = 0; i < 2000; ++i) {
+    delays.push_back(milliseconds(rng() % horizon.count()));
+  }
+
+  std::vector<std::unique_ptr<TimingWheel::Entry>> entries;
+  std::vector<milliseconds> fired_at(delays.size(), -1ms);
+  milliseconds now = 0ms;
+  for (size_t i = 0; i < delays.size(); ++i) {
+    entries.push_back(std::make_unique<TimingWheel::Entry>(
+        [&fired_at, &now, i] { fired_at[i] = now; }));
+    wheel_.schedule(*entries.back(), delays[i], at(0ms));
+  }
+
+  // Advance in irregular steps, sometimes skipping many ticks at once.
+  while (!wheel_.empty()) {
+    auto next = duration_cast<milliseconds>(wheel_.nextWakeUp() - start_);
+    ASSERT_GT(next, now);
+    now = rng() % 2 == 0 ? next : now + milliseconds(rng() % 5000);
+    wheel_.advance(at(now));
+  }
+
+  for (size_t i = 0; i < delays.size(); ++i) {
+    const milliseconds due = std::max(delays[i], 1ms);
+    EXPECT_GE(fired_at[i], due) << i;
+    // Fired on the first advance() at or after it was due.
+    EXPECT_LT(fired_at[i], due + 5000ms) << i;
+  }
+}
+
+TEST_F(TimingWheelTest, NextWakeUpIsExact) {
+  std::mt19937_64 rng(1);
+  for (int i = 0; i < 200; ++i) {
+    milliseconds delay(1 + rng() % 100'000);
+    int fired = 0;
+    TimingWheel::Entry entry([&] { ++fired; });
+    auto now = duration_cast<milliseconds>(wheel_.nextWakeUp() - start_);
+    wheel_.advance(at(now));
+    wheel_.schedule(entry, delay, at(now));
+    // Only wake up when told to, the entry must fire exactly when due.
+    while (fired == 0) {
+      auto next = duration_cast<milliseconds>(wheel_.nextWakeUp() - start_);
+      ASSERT_LE(next, now + delay);
+      wheel_.advance(at(next));
+      if (fired) {
+        EXPECT_EQ(now + delay, next);
+      }
+    }
+  }
+}
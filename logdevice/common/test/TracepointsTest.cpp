@@ -0,0 +1,163 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/Tracepoints.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <folly/Conv.h>
+#include <folly/String.h>
+#include <gtest/gtest.h>
+
+#include "logdevice/common/types_internal.h"
+
+#if defined(__ELF__) && defined(__x86_64__)
+#include <elf.h>
+#endif
+
+using namespace facebook::logdevice;
+
+namespace {
+
+// Signed size of each argument of a tracepoint, as recorded by FOLLY_SDT in
+// the argument description: "8@%rax" is an 8-byte unsigned value, "-4@..."
+// a 4-byte signed one.
+using ArgSizes = std::vector<int>;
+
+struct Tracepoint {
+  ArgSizes args;
+  // Address of the semaphore, 0 if the tracepoint has none.
+  uint64_t semaphore;
+};
+
+#if defined(__ELF__) && defined(__x86_64__)
+
+// Reads the stapsdt notes of provider "logdevice" from our own executable.
+// Returns every instance of each tracepoint by name.
+std::multimap<std::string, Tracepoint> readTracepoints() {
+  std::ifstream file("/proc/self/exe", std::ios::binary);
+  std::string elf((std::istreambuf_iterator<char>(file)),
+                  std::istreambuf_iterator<char>());
+  std::multimap<std::string, Tracepoint> res;
+  if (elf.size() < sizeof(Elf64_Ehdr)) {
+    ADD_FAILURE() << "Can't read /proc/self/exe";
+    return res;
+  }
+
+  const char* base = elf.data();
+  auto ehdr = reinterpret_cast<const Elf64_Ehdr*>(base);
+  auto shdrs = reinterpret_cast<const Elf64_Shdr*>(base + ehdr->e_shoff);
+  const char* shstrtab = base + shdrs[ehdr->e_shstrndx].sh_offset;
+
+  for (size_t i = 0; i < ehdr->e_shnum; ++i) {
+    if (strcmp(shstrtab + shdrs[i].sh_name, ".note.stapsdt") != 0) {
+      continue;
+    }
+    const char* p = base + shdrs[i].sh_offset;
+    const char* end = p + shdrs[i].sh_size;
+    while (p + sizeof(Elf64_Nhdr) <= end) {
+      auto nhdr = reinterpret_cast<const Elf64_Nhdr*>(p);
+      const char* name = p + sizeof(Elf64_Nhdr);
+      const char* desc = name + ((nhdr->n_namesz + 3) & ~3u);
+      p = desc + ((nhdr->n_descsz + 3) & ~3u);
+      if (nhdr->n_type != 3 || strcmp(name, "stapsdt") != 0) {
+        continue;
+      }
+      // Probe address, base address and semaphore address, followed by
+      // null-terminated provider, probe name and argument description.
+      uint64_t semaphore;
+      memcpy(&semaphore, desc + 2 * sizeof(uint64_t), sizeof(semaphore));
+      const char* provider = desc + 3 * sizeof(uint64_t);
+      const char* probe = provider + strlen(provider) + 1;
+      const char* args = probe + strlen(probe) + 1;
+      if (strcmp(provider, "logdevice") != 0) {
+        continue;
+      }
+      std::vector<folly::StringPiece> arg_descs;
+      folly::split(' ', args, arg_descs, /* ignoreEmpty */ true);
+      ArgSizes sizes;
+      for (folly::StringPiece arg : arg_descs) {
+        sizes.push_back(folly::to<int>(arg.split_step('@')));
+      }
+      res.emplace(probe, Tracepoint{std::move(sizes), semaphore});
+    }
+  }
+  return res;
+}
+
+#endif
+
+} // namespace
+
+// Calls every tracepoint and checks that each made it into the binary with
+// the documented arguments. Catches both probes that were compiled out and
+// signature changes that would silently break tracing scripts.
+TEST(TracepointsTest, CompiledInWithArguments) {
+  const logid_t log(42);
+  const lsn_t lsn = compose_lsn(epoch_t(3), esn_t(7));
+  tracepoints::appendReceived(log, 100);
+  tracepoints::appenderStart(log, lsn, 100);
+  tracepoints::appenderStoreSent(log, lsn, 1, node_index_t(5), 100);
+  tracepoints::appenderStored(log, lsn, 1, node_index_t(5), E::OK);
+  tracepoints::appenderRetired(log, lsn, E::OK, 12345);
+  tracepoints::writeStorageTaskEnqueue(log, lsn, 100);
+  tracepoints::writeStorageTaskExecute(log, lsn, 100, 4);
+  tracepoints::writeStorageTaskSync(log, lsn, 100, 500);
+  tracepoints::readStorageTaskEnqueue(log, lsn, LSN_MAX, 1 << 20);
+  tracepoints::readStorageTaskExecute(log, lsn, 10, 1000);
+  tracepoints::recordSent(log, lsn, 100);
+  tracepoints::clientReadStreamDeliver(log, lsn, 100);
+
+  // Nothing is attached.
+  EXPECT_FALSE(tracepoints::writeStorageTaskEnqueueEnabled());
+  EXPECT_FALSE(tracepoints::writeStorageTaskExecuteEnabled());
+  EXPECT_FALSE(tracepoints::writeStorageTaskSyncEnabled());
+
+#if defined(__ELF__) && defined(__x86_64__) && !FOLLY_DISABLE_SDT
+  const std::map<std::string, ArgSizes> expected = {
+      {"append_received", {8, 8}},
+      {"appender_start", {8, 8, 8}},
+      {"appender_store_sent", {8, 8, 4, 4, 8}},
+      {"appender_stored", {8, 8, 4, 4, 4}},
+      {"appender_retired", {8, 8, 4, -8}},
+      {"write_storage_task_enqueue", {8, 8, 8}},
+      {"write_storage_task_execute", {8, 8, 8, 8}},
+      {"write_storage_task_sync", {8, 8, 8, -8}},
+      {"read_storage_task_enqueue", {8, 8, 8, 8}},
+      {"read_storage_task_execute", {8, 8, 8, 8}},
+      {"record_sent", {8, 8, 8}},
+      {"client_read_stream_deliver", {8, 8, 8}},
+  };
+  // Tracepoints whose callers check *Enabled() first.
+  const std::set<std::string> with_semaphore = {
+      "write_storage_task_enqueue",
+      "write_storage_task_execute",
+      "write_storage_task_sync",
+  };
+
+  auto found = readTracepoints();
+  for (const auto& kv : expected) {
+    auto range = found.equal_range(kv.first);
+    EXPECT_NE(range.first, range.second) << kv.first << " not found";
+    for (auto it = range.first; it != range.second; ++it) {
+      EXPECT_EQ(kv.second, it->second.args) << kv.first;
+      EXPECT_EQ(with_semaphore.count(kv.first) > 0, it->second.semaphore != 0)
+          << kv.first;
+    }
+  }
+  // Tracepoints not listed above must be added to the test.
+  for (const auto& kv : found) {
+    EXPECT_EQ(1, expected.count(kv.first)) << kv.first;
+  }
+#endif
+}
@@ -12,6 +12,7 @@
 #include <logdevice/common/HashBasedSequencerLocator.h>
 
 #include "logdevice/common/configuration/ServerConfig.h"
+#include "logdevice/common/settings/util.h"
 #include "logdevice/common/stats/Stats.h"
 #include "logdevice/common/test/CopySetSelectorTestUtil.h"
 #include "logdevice/common/test/NodeSetTestUtil.h"
@@ -654,6 +655,39 @@ TEST_F(WeightedCopySetSelectorTest, Basic) {
   EXPECT_EQ(nodeset_indices_, cs);
 }
 
+TEST_F(WeightedCopySetSelectorTest, AugmentExcluding) {
+  addNodes("rg0.dc0.cl0.ro0.rk0", {1, 1, 1});
+  addNodes("rg0.dc0.cl0.ro0.rk1", {1, 1, 1});
+  replication_ = ReplicationProperty({{S::RACK, 2}, {S::NODE, 3}});
+  auto& selector = getSelector();
+
+  // N0 has a copy. N1 and N3 must not be picked, so the new copies are N2 or
+  // N4/N5, with at least one of the latter for the second rack.
+  const ShardID excluded[] = {N1, N3};
+  StoreChainLink cs[COPYSET_SIZE_MAX];
+  copyset_size_t size;
+  for (int i = 0; i < 100; ++i) {
+    cs[0] = StoreChainLink{N0, ClientID::INVALID};
+    ASSERT_EQ(CopySetSelector::Result::SUCCESS,
+              selector.augmentExcluding(cs, 1, &size, excluded, 2, rng_));
+    ASSERT_EQ(3, size);
+    EXPECT_EQ(N0, cs[0].destination);
+    int second_rack = 0;
+    for (int j = 1; j < size; ++j) {
+      EXPECT_NE(N1, cs[j].destination);
+      EXPECT_NE(N3, cs[j].destination);
+      second_rack += cs[j].destination == N4 || cs[j].destination == N5;
+    }
+    EXPECT_GE(second_rack, 1);
+  }
+
+  // Without the second rack there is no valid copyset.
+  const ShardID second_rack[] = {N3, N4, N5};
+  cs[0] = StoreChainLink{N0, ClientID::INVALID};
+  EXPECT_EQ(CopySetSelector::Result::FAILED,
+            selector.augmentExcluding(cs, 1, &size, second_rack, 3, rng_));
+}
+
 TEST_F(WeightedCopySetSelectorTest, ReplicationScope) {
   addNodes("rg0.dc0.cl0.ro0.rk0", {2, 2});
   addNodes("rg0.dc0.cl0.ro0.rk1", {3, 3});
@@ -910,3 +944,57 @@ TEST_F(WeightedCopySetSelectorTest, DisablingChainSending) {
   std::vector<ShardID> cs;
   EXPECT_EQ(CopySetSelector::Result::SUCCESS, select(cs, selector));
 }
+
+TEST_F(WeightedCopySetSelectorTest, LatencyAware) {
+  // NodeSetState that reports settings with latency-aware selection enabled.
+  class LatencyAwareNodeSetState : public NodeSetState {
+   public:
+    using NodeSetState::NodeSetState;
+    const Settings* getSettings() const override {
+      return &settings_;
+    }
+    Settings settings_ = create_default_settings<Settings>();
+  };
+
+  addNodes("rg.dc.cl.ro.rk0", {1, 1, 1, 1, 1, 1});
+  replication_ = ReplicationProperty({{S::NODE, 2}});
+  initIfNeeded();
+  auto nodeset_state = std::make_shared<LatencyAwareNodeSetState>(
+      nodeset_indices_, LOG_ID, NodeSetState::HealthCheck::DISABLED);
+  nodeset_state->settings_.latency_aware_copyset_selection = true;
+  nodeset_state->settings_.latency_aware_copyset_candidates = 8;
+  nodeset_state->settings_.latency_aware_copyset_random_fraction = 0;
+  nodeset_state_ = nodeset_state;
+
+  // N0 is slow, the rest are fast.
+  for (ShardID shard : nodeset_indices_) {
+    nodeset_state->recordStoreLatency(
+        shard, std::chrono::milliseconds(shard == N0 ? 100 : 1));
+  }
+  auto estimate = nodeset_state->getStoreLatencyEstimate(N0);
+  ASSERT_TRUE(estimate.has_value());
+  EXPECT_EQ(std::chrono::milliseconds(100), estimate->ewma);
+
+  // Without latency awareness N0 would be in a third of the copysets.
+  // With 8 candidates it's picked only if all of them contain N0.
+  auto& selector = getSelector(LOG_ID);
+  const int iterations = 1000;
+  int n0_picked = 0;
+  std::vector<ShardID> cs;
+  for (int i = 0; i < iterations; ++i) {
+    ASSERT_EQ(CopySetSelector::Result::SUCCESS, select(cs, selector));
+    n0_picked += std::count(cs.begin(), cs.end(), N0);
+  }
+  EXPECT_LT(n0_picked, iterations / 20);
+  EXPECT_EQ(iterations, stats.get().copyset_latency_aware);
+
+  // With the random floor at 100%, latency is ignored.
+  nodeset_state->settings_.latency_aware_copyset_random_fraction = 1;
+  n0_picked = 0;
+  for (int i = 0; i < iterations; ++i) {
+    ASSERT_EQ(CopySetSelector::Result::SUCCESS, select(cs, selector));
+    n0_picked += std::count(cs.begin(), cs.end(), N0);
+  }
+  EXPECT_GT(n0_picked, iterations / 5);
+  EXPECT_EQ(iterations, stats.get().copyset_latency_aware);
+}
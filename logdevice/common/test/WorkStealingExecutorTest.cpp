@@ -0,0 +1,60 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/common/WorkStealingExecutor.h"
+
+#include <atomic>
+#include <chrono>
+
+#include <folly/synchronization/Baton.h>
+#include <gtest/gtest.h>
+
+#include "logdevice/common/stats/Stats.h"
+
+using namespace facebook::logdevice;
+
+TEST(WorkStealingExecutorTest, RunsAllTasks) {
+  StatsHolder stats(StatsParams().setIsServer(true));
+  std::atomic<int> count{0};
+  {
+    WorkStealingExecutor executor(4, &stats);
+    for (int i = 0; i < 1000; ++i) {
+      executor.addWithHint(i % 3, [&] { ++count; });
+    }
+    // Tasks added by tasks run too.
+    executor.add([&] {
+      executor.add([&] { ++count; });
+    });
+    // Runs whatever is still queued.
+    executor.shutdown();
+  }
+  EXPECT_EQ(1001, count.load());
+  EXPECT_EQ(1002, stats.aggregate().cpu_executor_tasks_executed);
+  EXPECT_EQ(0, stats.aggregate().cpu_executor_tasks_queued);
+}
+
+TEST(WorkStealingExecutorTest, IdleThreadStealsFromBusyQueue) {
+  StatsHolder stats(StatsParams().setIsServer(true));
+  WorkStealingExecutor executor(2, &stats);
+
+  // Keep a thread busy with a task queued for queue 0, then queue more work
+  // behind it. The other thread must pick it up.
+  folly::Baton<> started, release, done;
+  executor.addWithHint(0, [&] {
+    started.post();
+    release.wait();
+  });
+  ASSERT_TRUE(started.try_wait_for(std::chrono::seconds(10)));
+  executor.addWithHint(0, [&] { done.post(); });
+  EXPECT_TRUE(done.try_wait_for(std::chrono::seconds(10)));
+  release.post();
+  executor.shutdown();
+
+  // Either the second task was stolen, or the first one was.
+  EXPECT_GE(stats.aggregate().cpu_executor_tasks_stolen, 1);
+  EXPECT_EQ(2, stats.aggregate().cpu_executor_tasks_executed);
+}
@@ -82,4 +82,26 @@ TEST(WorkerLoadBalancingTest, NewWorkRebalances) {
   ASSERT_LT(after_ratio, 2.2);
 }
 
+TEST(WorkerLoadBalancingTest, RebalancingTarget) {
+  WorkerLoadBalancing balancer(3);
+  balancer.reportLoad(W0, 1000);
+  balancer.reportLoad(W1, 200);
+  balancer.reportLoad(worker_id_t(2), 900);
+
+  int64_t excess = 0;
+  EXPECT_EQ(W1, balancer.selectRebalancingTarget(W0, 0.1, &excess));
+  EXPECT_EQ(400, excess);
+  // The least loaded worker has nowhere to go.
+  EXPECT_EQ(
+      WORKER_ID_INVALID, balancer.selectRebalancingTarget(W1, 0.1, &excess));
+  // Not imbalanced enough.
+  EXPECT_EQ(
+      WORKER_ID_INVALID, balancer.selectRebalancingTarget(W0, 0.9, &excess));
+
+  balancer.reportLoad(W1, 990);
+  balancer.reportLoad(worker_id_t(2), 1000);
+  EXPECT_EQ(
+      WORKER_ID_INVALID, balancer.selectRebalancingTarget(W0, 0.1, &excess));
+}
+
 }} // namespace facebook::logdevice
@@ -0,0 +1,219 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Random.h>
+#include <gflags/gflags.h>
+
+#include "logdevice/common/stats/Histogram.h"
+
+DEFINE_int32(histogram_threads, 8, "Number of threads for concurrent adds.");
+DEFINE_bool(report_accuracy,
+            true,
+            "Before running benchmarks, print how far cluster-wide "
+            "percentiles of each histogram type are from the exact ones.");
+
+namespace facebook { namespace logdevice {
+
+// Latency-like values: log-uniform from 1us to ~1000s.
+static std::vector<int64_t> makeValues(size_t n, uint64_t seed) {
+  folly::Random::DefaultGenerator rng(seed);
+  std::vector<int64_t> values(n);
+  for (auto& v : values) {
+    v = static_cast<int64_t>(std::exp(folly::Random::randDouble(0, 21, rng)));
+  }
+  return values;
+}
+
+template <typename H>
+static void benchAdd(size_t iters) {
+  std::unique_ptr<H> h;
+  std::vector<int64_t> values;
+  BENCHMARK_SUSPEND {
+    h = std::make_unique<H>();
+    values = makeValues(4096, 1);
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    h->add(values[i % values.size()]);
+  }
+  folly::doNotOptimizeAway(h->estimatePercentile(.5));
+}
+
+BENCHMARK(LatencyHistogramAdd, n) {
+  benchAdd<LatencyHistogram>(n);
+}
+BENCHMARK_RELATIVE(CompactLatencyHistogramAdd, n) {
+  benchAdd<CompactLatencyHistogram>(n);
+}
+BENCHMARK_RELATIVE(HighResLatencyHistogramAdd, n) {
+  benchAdd<HighResLatencyHistogram>(n);
+}
+
+BENCHMARK_DRAW_LINE();
+
+// All threads add to the same histogram.
+template <typename H>
+static void benchConcurrentAdd(size_t iters) {
+  std::unique_ptr<H> h;
+  std::vector<int64_t> values;
+  BENCHMARK_SUSPEND {
+    h = std::make_unique<H>();
+    values = makeValues(4096, 2);
+  }
+  std::vector<std::thread> threads;
+  size_t per_thread = iters / FLAGS_histogram_threads + 1;
+  for (int t = 0; t < FLAGS_histogram_threads; ++t) {
+    threads.emplace_back([&, t] {
+      for (size_t i = 0; i < per_thread; ++i) {
+        h->add(values[(i + t) % values.size()]);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
+BENCHMARK(LatencyHistogramConcurrentAdd, n) {
+  benchConcurrentAdd<LatencyHistogram>(n);
+}
+BENCHMARK_RELATIVE(CompactLatencyHistogramConcurrentAdd, n) {
+  benchConcurrentAdd<CompactLatencyHistogram>(n);
+}
+BENCHMARK_RELATIVE(HighResLatencyHistogramConcurrentAdd, n) {
+  benchConcurrentAdd<HighResLatencyHistogram>(n);
+}
+
+BENCHMARK_DRAW_LINE();
+
+// What stats aggregation does for each thread's histogram.
+template <typename H>
+static void benchMerge(size_t iters) {
+  std::unique_ptr<H> a, b;
+  BENCHMARK_SUSPEND {
+    a = std::make_unique<H>();
+    b = std::make_unique<H>();
+    for (int64_t v : makeValues(100000, 3)) {
+      b->add(v);
+    }
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    a->merge(*b);
+  }
+}
+
+BENCHMARK(LatencyHistogramMerge, n) {
+  benchMerge<LatencyHistogram>(n);
+}
+BENCHMARK_RELATIVE(CompactLatencyHistogramMerge, n) {
+  benchMerge<CompactLatencyHistogram>(n);
+}
+BENCHMARK_RELATIVE(HighResLatencyHistogramMerge, n) {
+  benchMerge<HighResLatencyHistogram>(n);
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(HighResLatencyHistogramSerialize, n) {
+  std::unique_ptr<HighResLatencyHistogram> h;
+  BENCHMARK_SUSPEND {
+    h = std::make_unique<HighResLatencyHistogram>();
+    for (int64_t v : makeValues(100000, 4)) {
+      h->add(v);
+    }
+  }
+  for (size_t i = 0; i < n; ++i) {
+    std::string data;
+    h->serialize(&data);
+    folly::doNotOptimizeAway(data);
+  }
+}
+
+BENCHMARK(HighResLatencyHistogramMergeSerialized, n) {
+  std::unique_ptr<HighResLatencyHistogram> h;
+  std::string data;
+  BENCHMARK_SUSPEND {
+    h = std::make_unique<HighResLatencyHistogram>();
+    HighResLatencyHistogram src;
+    for (int64_t v : makeValues(100000, 5)) {
+      src.add(v);
+    }
+    src.serialize(&data);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    h->mergeSerialized(data);
+  }
+}
+
+// Simulates nodes with different load and latency profiles, and compares the
+// exact cluster-wide percentiles with (a) the average of per-node percentiles
+// and (b) percentiles of the merged histogram.
+template <typename H>
+static void reportAccuracy(const char* name) {
+  constexpr int kNodes = 10;
+  std::array<double, 4> pct = {.5, .9, .99, .999};
+  std::vector<int64_t> all;
+  std::vector<std::unique_ptr<H>> nodes;
+  H merged;
+  std::array<double, 4> averaged{};
+  for (int n = 0; n < kNodes; ++n) {
+    // Node n is (n+1) times slower and gets (kNodes-n) times more traffic.
+    auto values = makeValues(20000 * (kNodes - n), 100 + n);
+    nodes.push_back(std::make_unique<H>());
+    for (int64_t& v : values) {
+      v = v / 1000 * (n + 1);
+      nodes.back()->add(v);
+    }
+    all.insert(all.end(), values.begin(), values.end());
+    merged.merge(*nodes.back());
+
+    std::array<int64_t, 4> out;
+    nodes.back()->estimatePercentiles(&pct[0], pct.size(), &out[0]);
+    for (size_t i = 0; i < pct.size(); ++i) {
+      averaged[i] += 1. * out[i] / kNodes;
+    }
+  }
+  std::sort(all.begin(), all.end());
+
+  std::array<int64_t, 4> merged_out;
+  merged.estimatePercentiles(&pct[0], pct.size(), &merged_out[0]);
+  for (size_t i = 0; i < pct.size(); ++i) {
+    double exact = all[static_cast<size_t>(pct[i] * (all.size() - 1))];
+    printf("%-24s p%-5g exact %12.0f  averaged %+8.2f%%  merged %+8.2f%%\n",
+           name,
+           pct[i] * 100,
+           exact,
+           (averaged[i] - exact) / exact * 100,
+           (merged_out[i] - exact) / exact * 100);
+  }
+}
+
+}} // namespace facebook::logdevice
+
+#ifndef BENCHMARK_BUNDLE
+
+int main(int argc, char** argv) {
+  using namespace facebook::logdevice;
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_report_accuracy) {
+    reportAccuracy<LatencyHistogram>("LatencyHistogram");
+    reportAccuracy<CompactLatencyHistogram>("CompactLatencyHistogram");
+    reportAccuracy<HighResLatencyHistogram>("HighResLatencyHistogram");
+  }
+  folly::runBenchmarks();
+  return 0;
+}
+#endif
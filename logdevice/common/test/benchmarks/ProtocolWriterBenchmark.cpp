@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/io/IOBuf.h>
+
+#include "logdevice/common/network/IOBufArena.h"
+#include "logdevice/common/protocol/Compatibility.h"
+#include "logdevice/common/protocol/MessageDeserializers.h"
+#include "logdevice/common/protocol/MessageReadResult.h"
+#include "logdevice/common/protocol/MessageTypeNames.h"
+#include "logdevice/common/protocol/ProtocolHeader.h"
+#include "logdevice/common/protocol/ProtocolReader.h"
+#include "logdevice/common/protocol/ProtocolWriter.h"
+#include "logdevice/common/types_internal.h"
+
+namespace facebook { namespace logdevice {
+
+/**
+ * @file Cost of serializing one message of every type the way
+ *       Connection::serializeMessage() does, into a heap buffer of
+ *       IOBUF_ALLOCATION_UNIT bytes vs. an IOBufArena buffer sized with
+ *       Message::size().
+ *
+ *       Sample messages are obtained by deserializing zero-filled bodies of
+ *       increasing length. Types that cannot be built that way are skipped
+ *       and listed on stderr.
+ */
+
+namespace {
+
+constexpr uint16_t kProto = Compatibility::MAX_PROTOCOL_SUPPORTED;
+constexpr size_t kMaxSampleBodySize = 1024;
+
+const std::vector<std::unique_ptr<Message>>& sampleMessages() {
+  static auto samples = [] {
+    std::vector<std::unique_ptr<Message>> res;
+    for (int i = 0; i < static_cast<int>(messageDeserializers.size()); ++i) {
+      const auto type = static_cast<MessageType>(i);
+      auto deserializer = messageDeserializers[i];
+      if (!deserializer || type == MessageType::INVALID) {
+        continue;
+      }
+      std::unique_ptr<Message> msg;
+      for (size_t len = 0; !msg && len <= kMaxSampleBodySize; len += 4) {
+        auto body = folly::IOBuf::create(len);
+        memset(body->writableData(), 0, len);
+        body->append(len);
+        ProtocolReader reader(type, std::move(body), kProto);
+        msg = deserializer(reader).msg;
+      }
+      if (msg) {
+        res.push_back(std::move(msg));
+      } else {
+        std::cerr << "Skipping " << messageTypeNames()[type] << std::endl;
+      }
+    }
+    return res;
+  }();
+  return samples;
+}
+
+template <typename AllocFn>
+void serializeAll(unsigned iters, AllocFn alloc) {
+  const std::vector<std::unique_ptr<Message>>* samples;
+  BENCHMARK_SUSPEND {
+    // Keep sample construction out of the measurement.
+    samples = &sampleMessages();
+  }
+  for (unsigned i = 0; i < iters; ++i) {
+    for (const auto& msg : *samples) {
+      const size_t protohdr_bytes =
+          ProtocolHeader::bytesNeeded(msg->type_, kProto);
+      auto io_buf = alloc(*msg, protohdr_bytes);
+      io_buf->advance(protohdr_bytes);
+      ProtocolWriter writer(msg->type_, io_buf.get(), kProto);
+      msg->serialize(writer);
+      folly::doNotOptimizeAway(writer.result());
+    }
+  }
+}
+
+} // namespace
+
+BENCHMARK(SerializeIntoHeapBuffer, iters) {
+  serializeAll(iters, [](const Message&, size_t) {
+    return folly::IOBuf::create(IOBUF_ALLOCATION_UNIT);
+  });
+}
+
+BENCHMARK_RELATIVE(SerializeIntoArenaBuffer, iters) {
+  IOBufArena arena;
+  serializeAll(iters, [&](const Message& msg, size_t protohdr_bytes) {
+    size_t copied;
+    msg.size(kProto, &copied);
+    return arena.allocate(std::max(protohdr_bytes, copied));
+  });
+}
+
+}} // namespace facebook::logdevice
@@ -7,6 +7,7 @@
  */
 #include <atomic>
 #include <chrono>
+#include <random>
 #include <thread>
 #include <vector>
 
@@ -14,7 +15,9 @@
 #include <folly/ScopeGuard.h>
 #include <folly/Singleton.h>
 
+#include "logdevice/common/EventLoop.h"
 #include "logdevice/common/LibeventTimer.h"
+#include "logdevice/common/TimingWheel.h"
 #include "logdevice/common/WheelTimer.h"
 #include "logdevice/common/debug.h"
 #include "logdevice/common/libevent/LibEventCompatibility.h"
@@ -73,6 +76,154 @@ BENCHMARK_RELATIVE(LibeventTimerParallel, n) {
   }
 }
 
+// Timers at the scale of a busy storage node: kConcurrentTimers are pending
+// while we measure the cost of pushing back or cancelling and reactivating
+// timers, as read streams and appenders do all the time. Libevent keeps its
+// timers in a heap, so each operation is O(log n) with poor locality, while
+// TimingWheel operations are O(1).
+namespace {
+constexpr size_t kConcurrentTimers = 1000000;
+
+std::vector<microseconds> randomDelays(size_t count) {
+  std::mt19937_64 rng(count);
+  std::vector<microseconds> delays(count);
+  for (auto& delay : delays) {
+    delay = microseconds(1000 + rng() % 600000000);
+  }
+  return delays;
+}
+} // namespace
+
+BENCHMARK(LibeventTimerRescheduleAmongMillion, n) {
+  std::unique_ptr<EvBase> base;
+  std::vector<std::unique_ptr<LibeventTimer>> timers;
+  std::vector<microseconds> delays;
+  BENCHMARK_SUSPEND {
+    dbg::currentLevel = dbg::Level::NONE;
+    base = std::make_unique<EvBase>();
+    auto rv = base->init();
+    assert(rv == EvBase::Status::OK);
+    delays = randomDelays(kConcurrentTimers);
+    timers.reserve(kConcurrentTimers);
+    for (size_t i = 0; i < kConcurrentTimers; ++i) {
+      timers.emplace_back(std::make_unique<LibeventTimer>(base.get(), [] {}));
+      timers.back()->activate(delays[i]);
+    }
+  }
+  for (size_t i = 0; i < n; ++i) {
+    timers[(i * 7919) % kConcurrentTimers]->activate(
+        delays[i % kConcurrentTimers]);
+  }
+  BENCHMARK_SUSPEND {
+    timers.clear();
+  }
+}
+
+BENCHMARK_RELATIVE(TimingWheelRescheduleAmongMillion, n) {
+  std::unique_ptr<TimingWheel> wheel;
+  std::vector<std::unique_ptr<TimingWheel::Entry>> entries;
+  std::vector<microseconds> delays;
+  BENCHMARK_SUSPEND {
+    wheel = std::make_unique<TimingWheel>(EventLoop::kTimingWheelTick);
+    delays = randomDelays(kConcurrentTimers);
+    entries.reserve(kConcurrentTimers);
+    for (size_t i = 0; i < kConcurrentTimers; ++i) {
+      entries.emplace_back(std::make_unique<TimingWheel::Entry>([] {}));
+      wheel->schedule(*entries.back(), delays[i]);
+    }
+  }
+  for (size_t i = 0; i < n; ++i) {
+    wheel->schedule(*entries[(i * 7919) % kConcurrentTimers],
+                    delays[i % kConcurrentTimers]);
+  }
+  BENCHMARK_SUSPEND {
+    entries.clear();
+    wheel.reset();
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(LibeventTimerCancelAndActivateAmongMillion, n) {
+  std::unique_ptr<EvBase> base;
+  std::vector<std::unique_ptr<LibeventTimer>> timers;
+  std::vector<microseconds> delays;
+  BENCHMARK_SUSPEND {
+    dbg::currentLevel = dbg::Level::NONE;
+    base = std::make_unique<EvBase>();
+    auto rv = base->init();
+    assert(rv == EvBase::Status::OK);
+    delays = randomDelays(kConcurrentTimers);
+    timers.reserve(kConcurrentTimers);
+    for (size_t i = 0; i < kConcurrentTimers; ++i) {
+      timers.emplace_back(std::make_unique<LibeventTimer>(base.get(), [] {}));
+      timers.back()->activate(delays[i]);
+    }
+  }
+  for (size_t i = 0; i < n; ++i) {
+    auto& timer = timers[(i * 7919) % kConcurrentTimers];
+    timer->cancel();
+    timer->activate(delays[i % kConcurrentTimers]);
+  }
+  BENCHMARK_SUSPEND {
+    timers.clear();
+  }
+}
+
+BENCHMARK_RELATIVE(TimingWheelCancelAndActivateAmongMillion, n) {
+  std::unique_ptr<TimingWheel> wheel;
+  std::vector<std::unique_ptr<TimingWheel::Entry>> entries;
+  std::vector<microseconds> delays;
+  BENCHMARK_SUSPEND {
+    wheel = std::make_unique<TimingWheel>(EventLoop::kTimingWheelTick);
+    delays = randomDelays(kConcurrentTimers);
+    entries.reserve(kConcurrentTimers);
+    for (size_t i = 0; i < kConcurrentTimers; ++i) {
+      entries.emplace_back(std::make_unique<TimingWheel::Entry>([] {}));
+      wheel->schedule(*entries.back(), delays[i]);
+    }
+  }
+  for (size_t i = 0; i < n; ++i) {
+    auto& entry = entries[(i * 7919) % kConcurrentTimers];
+    entry->cancel();
+    wheel->schedule(*entry, delays[i % kConcurrentTimers]);
+  }
+  BENCHMARK_SUSPEND {
+    entries.clear();
+    wheel.reset();
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+// Firing: a million timers spread over ten seconds, with the wheel advanced
+// tick by tick on a simulated clock.
+BENCHMARK(TimingWheelFireMillion, n) {
+  for (size_t iter = 0; iter < n; ++iter) {
+    std::unique_ptr<TimingWheel> wheel;
+    std::vector<std::unique_ptr<TimingWheel::Entry>> entries;
+    const auto start = TimingWheel::Clock::now();
+    size_t fired = 0;
+    BENCHMARK_SUSPEND {
+      wheel = std::make_unique<TimingWheel>(EventLoop::kTimingWheelTick, start);
+      entries.reserve(kConcurrentTimers);
+      for (size_t i = 0; i < kConcurrentTimers; ++i) {
+        entries.emplace_back(
+            std::make_unique<TimingWheel::Entry>([&fired] { ++fired; }));
+        wheel->schedule(*entries.back(), microseconds(i * 10), start);
+      }
+    }
+    for (auto t = start; fired < kConcurrentTimers;
+         t += EventLoop::kTimingWheelTick) {
+      wheel->advance(t);
+    }
+    BENCHMARK_SUSPEND {
+      entries.clear();
+      wheel.reset();
+    }
+  }
+}
+
 #ifndef BENCHMARK_BUNDLE
 
 int main(int argc, char** argv) {
@@ -245,6 +245,13 @@ class BufferedWriter {
     //
     // Negative for no limit.
     int32_t memory_limit_mb = -1;
+
+    // In STREAM mode, maximum number of batches per log that can be in flight
+    // (appended but not yet acknowledged as part of the in-order prefix).
+    // Further batches are sent as earlier ones get acknowledged. Resending
+    // after a sequencer failover is also limited to this window. Zero or
+    // negative for no limit. Ignored in other modes.
+    int32_t stream_inflight_window = -1;
   };
 
   /**
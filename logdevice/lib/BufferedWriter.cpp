@@ -37,7 +37,8 @@ BufferedWriter::create(std::shared_ptr<Client> client,
         std::make_unique<ClientBridgeImpl>(client_impl),
         client_impl->getTimeout(),
         chrono_expbackoff_t<std::chrono::milliseconds>(
-            options.retry_initial_delay, options.retry_max_delay));
+            options.retry_initial_delay, options.retry_max_delay),
+        std::max(options.stream_inflight_window, 0));
   } else {
     sink = (BufferedWriterAppendSink*)client_impl;
   }
@@ -16,6 +16,7 @@
 #include "logdevice/ops/ldquery/Table.h"
 #include "logdevice/ops/ldquery/TableRegistry.h"
 #include "logdevice/ops/ldquery/VirtualTable.h"
+#include "tables/AppendLatencyBreakdown.h"
 #include "tables/AppendOutliers.h"
 #include "tables/AppendThroughput.h"
 #include "tables/CatchupQueues.h"
@@ -141,6 +142,7 @@ LDQuery::LDQuery(std::string config_path,
   ctx_->config_path = config_path_;
   ctx_->use_ssl = use_ssl;
 
+  table_registry_.registerTable<tables::AppendLatencyBreakdown>(ctx_);
   table_registry_.registerTable<tables::AppendOutliers>(ctx_);
   table_registry_.registerTable<tables::AppendThroughput>(ctx_);
   table_registry_.registerTable<tables::CatchupQueues>(ctx_);
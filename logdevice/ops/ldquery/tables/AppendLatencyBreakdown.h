@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "../Context.h"
+#include "AdminCommandTable.h"
+
+namespace facebook {
+  namespace logdevice {
+    namespace ldquery {
+      namespace tables {
+
+class AppendLatencyBreakdown : public AdminCommandTable {
+ public:
+  explicit AppendLatencyBreakdown(std::shared_ptr<Context> ctx)
+      : AdminCommandTable(ctx) {}
+  static std::string getName() {
+    return "append_latency_breakdown";
+  }
+  std::string getDescription() override {
+    return "Where the time of recent traced appends went, as seen by their "
+           "sequencers. Clients trace a fraction of their appends given by "
+           "the \"append-latency-breakdown-sample-rate\" setting. Each "
+           "sequencer worker keeps the last 1000 traced appends that it "
+           "reaped.  total_us is the sum of sequencer_us, store_fanout_us, "
+           "network_us and the three storage stages. The storage stages are "
+           "0 if the storage node didn't report them, and network_us then "
+           "includes them.  Clients publish their side of each traced append "
+           "to the \"client_append_latency\" trace table; the time an append "
+           "spent between the client and the sequencer is the client's "
+           "latency minus client_queue_us and total_us.";
+  }
+  TableColumns getFetchableColumns() const override {
+    return {
+        {"time", DataType::TIME, "When the Appender was reaped."},
+        {"trace_id",
+         DataType::BIGINT,
+         "Random id of the append chosen by the client."},
+        {"log_id", DataType::LOGID, "Log the record was appended to."},
+        {"lsn", DataType::LSN, "LSN of the record."},
+        {"waves", DataType::INTEGER, "Number of waves of STOREs sent."},
+        {"shard",
+         DataType::TEXT,
+         "Storage shard whose reply completed replication of the record. "
+         "The network and storage stages are those of its copy."},
+        {"client_queue_us",
+         DataType::BIGINT,
+         "Time between the creation of the append on the client and sending "
+         "the APPEND, including earlier attempts to other sequencers."},
+        {"sequencer_us",
+         DataType::BIGINT,
+         "Time the append waited on the sequencer for an LSN, e.g. for the "
+         "sequencer to activate or for room in its sliding window."},
+        {"store_fanout_us",
+         DataType::BIGINT,
+         "Time from getting an LSN to sending the STORE to \"shard\", "
+         "including earlier waves."},
+        {"network_us",
+         DataType::BIGINT,
+         "Round trip time of the STORE to \"shard\" minus the storage "
+         "stages."},
+        {"storage_queue_us",
+         DataType::BIGINT,
+         "Time between the storage node receiving the STORE and starting to "
+         "write the batch that included it."},
+        {"storage_write_us",
+         DataType::BIGINT,
+         "Time spent writing that batch to the local log store."},
+        {"wal_sync_us",
+         DataType::BIGINT,
+         "Time the write waited to be synced, 0 if not synced."},
+        {"total_us",
+         DataType::BIGINT,
+         "Time from the sequencer receiving the append until the record was "
+         "fully replicated and the reply was sent."},
+        {"release_us",
+         DataType::BIGINT,
+         "Time from full replication until the record could be released to "
+         "readers, i.e. until all previous records were fully replicated."},
+    };
+  }
+  std::string getCommandToSend(QueryContext& /*ctx*/) const override {
+    return std::string("info append_latency_breakdown --json\n");
+  }
+};
+
+}}}} // namespace facebook::logdevice::ldquery::tables
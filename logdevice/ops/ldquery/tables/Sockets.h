@@ -92,6 +92,29 @@ class Sockets : public AdminCommandTable {
         {"fd",
          DataType::INTEGER,
          "The file descriptor of the underlying os socket."},
+        {"compression",
+         DataType::INTEGER,
+         "Set to true if this Connection negotiated compression of its "
+         "message stream with the peer (see \"connection-compression\")."},
+        {"compression_ratio_out",
+         DataType::REAL,
+         "Ratio of uncompressed to compressed bytes of the messages that were "
+         "compressed before being sent. 0 if none were."},
+        {"compression_ratio_in",
+         DataType::REAL,
+         "Ratio of uncompressed to compressed bytes of the compressed "
+         "messages received. 0 if none were."},
+        {"compression_cpu_ms",
+         DataType::REAL,
+         "Total time spent compressing and decompressing messages on this "
+         "Connection, in milliseconds."},
+        {"socket_writes",
+         DataType::BIGINT,
+         "Number of writes into the socket. Messages sent during the same "
+         "event loop iteration are written together."},
+        {"avg_write_size_b",
+         DataType::REAL,
+         "Average number of bytes per write into the socket."},
     };
   }
   std::string getCommandToSend(QueryContext& /*ctx*/) const override {
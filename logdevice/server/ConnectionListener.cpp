@@ -157,6 +157,9 @@ void ConnectionListener::connectionAccepted(
     target_worker_type = WorkerType::FAILURE_DETECTOR;
   } else {
     sock_type = SocketType::DATA;
+    if (processor->updateableSettings()->client_connection_rebalancing) {
+      wid = processor->selectWorkerLoadAware();
+    }
   }
   //  Storing relevant info and creating a one time event triggered by a read or
   //  a timeout.
@@ -8,6 +8,7 @@
 #include "logdevice/server/RECORD_onSent.h"
 
 #include "logdevice/common/Sender.h"
+#include "logdevice/common/Tracepoints.h"
 #include "logdevice/common/configuration/Configuration.h"
 #include "logdevice/common/debug.h"
 #include "logdevice/server/ServerWorker.h"
@@ -30,6 +31,9 @@ void RECORD_onSent(const RECORD_Message& msg,
     return;
   }
 
+  tracepoints::recordSent(
+      msg.header_.log_id, msg.header_.lsn, msg.payload_.size());
+
   ServerWorker* w = ServerWorker::onThisThread();
   WORKER_TRAFFIC_CLASS_STAT_INCR(msg.tc_, record_messages_sent);
   WORKER_TRAFFIC_CLASS_STAT_ADD(
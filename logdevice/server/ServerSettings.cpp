@@ -306,6 +306,18 @@ void ServerSettings::defineSettings(SettingEasyInit& init) {
      SERVER,
      SettingsCategory::Storage)
 
+    ("storage-thread-sync-pipelining",
+     &storage_thread_sync_pipelining,
+     "false",
+     nullptr,
+     "If true, syncing storage threads group-commit in a pipelined fashion: "
+     "tasks that arrive while a sync is in progress are synced as soon as it "
+     "completes, without waiting for --storage-thread-delaying-sync-interval, "
+     "and the delay before syncing a batch that starts from an idle thread is "
+     "capped at the average observed sync latency.",
+     SERVER | EXPERIMENTAL,
+     SettingsCategory::Storage)
+
     ("fd-limit", &fd_limit, "0",
      [](int val) -> void {
        if (val < 0) {
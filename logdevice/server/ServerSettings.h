@@ -60,6 +60,10 @@ struct ServerSettings : public SettingsBundle {
   // Interval between invoking syncs for delayable storage tasks.
   // Ignored when undelayable task is being enqueued.
   std::chrono::milliseconds storage_thread_delaying_sync_interval;
+  // If true, a sync is issued right after the previous one completes when
+  // tasks arrived while it was in progress, and the delay before syncing a
+  // batch started from idle is capped at the average sync latency.
+  bool storage_thread_sync_pipelining;
   std::string server_id;
   int fd_limit;
   bool eagerly_allocate_fdtable;
@@ -7,6 +7,7 @@
  */
 #include "logdevice/server/ServerWorker.h"
 
+#include "logdevice/common/NumaTopology.h"
 #include "logdevice/common/PermissionChecker.h"
 #include "logdevice/common/PrincipalParser.h"
 #include "logdevice/common/debug.h"
@@ -199,6 +200,14 @@ void ServerWorker::onServerConfigUpdated() {
 
 void ServerWorker::setupWorker() {
   Worker::setupWorker();
+  if (settings().numa_aware_placement && worker_type_ == WorkerType::GENERAL) {
+    // Spread workers over the NUMA nodes in proportion to their CPUs, like
+    // the storage threads of the shards they mostly talk to.
+    const NumaTopology& numa = NumaTopology::get();
+    numa_node_ = numa.nodeForWorker(
+        idx_.val(), processor_->getWorkerCount(worker_type_));
+    numa.bindThisThread(numa_node_);
+  }
   server_read_streams_->registerForShardAuthoritativeStatusUpdates();
   if ((idx_.val() ==
        NodeStatsController::getThreadAffinity(
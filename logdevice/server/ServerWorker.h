@@ -116,7 +116,17 @@ class ServerWorker : public Worker {
 
   BoycottingStatsHolder* getBoycottingStats();
 
+  /**
+   * Index in NumaTopology of the NUMA node this worker's thread is bound to,
+   * -1 if it isn't bound (see --numa-aware-placement).
+   */
+  int getNumaNode() const {
+    return numa_node_;
+  }
+
  private:
+  int numa_node_{-1};
+
   // Pimpl, contains most of the objects we provide getters for
   friend class ServerWorkerImpl;
   std::unique_ptr<ServerWorkerImpl> impl_;
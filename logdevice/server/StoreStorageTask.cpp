@@ -7,6 +7,7 @@
  */
 #include "logdevice/server/StoreStorageTask.h"
 
+#include <algorithm>
 #include <initializer_list>
 
 #include <folly/Format.h>
@@ -260,6 +261,33 @@ void StoreStorageTask::onDropped() {
   sendReply(E::DROPPED);
 }
 
+void StoreStorageTask::onSynced() {
+  if (flags_ & STORE_Header::LATENCY_TRACE) {
+    synced_time_ = std::chrono::steady_clock::now();
+  }
+}
+
+STORED_LatencyTrace StoreStorageTask::getLatencyTrace() const {
+  using namespace std::chrono;
+  auto us = [](steady_clock::duration d) {
+    return static_cast<uint32_t>(
+        std::max<int64_t>(0, duration_cast<microseconds>(d).count()));
+  };
+  STORED_LatencyTrace trace{0, 0, 0};
+  if (!execution_start_time_.has_value() ||
+      !execution_end_time_.has_value()) {
+    // The write failed before reaching the local log store.
+    return trace;
+  }
+  trace.queue_us = us(execution_start_time_.value() - start_time_);
+  trace.write_us =
+      us(execution_end_time_.value() - execution_start_time_.value());
+  if (synced_time_.has_value()) {
+    trace.sync_us = us(synced_time_.value() - execution_end_time_.value());
+  }
+  return trace;
+}
+
 shard_index_t StoreStorageTask::getShardIdx() const {
   return static_cast<shard_index_t>(storageThreadPool_->getShardIdx());
 }
@@ -317,13 +345,21 @@ void StoreStorageTask::sendReply(Status status) const {
     flags |= STORE_Header::OFFSET_MAP;
   }
 
+  STORED_LatencyTrace latency_trace{0, 0, 0};
+  if (flags_ & STORE_Header::LATENCY_TRACE) {
+    flags |= STORED_Header::LATENCY_TRACE;
+    latency_trace = getLatencyTrace();
+  }
+
   STORED_Message::createAndSend(
       STORED_Header{rid_, wave_, status, seal_.seq_node, flags, getShardIdx()},
       reply_to_,
       extra_.rebuilding_version,
       extra_.rebuilding_wave,
       extra_.rebuilding_id,
-      flushToken_);
+      flushToken_,
+      ShardID(),
+      latency_trace);
 }
 
 int StoreStorageTask::putCache() {
@@ -36,6 +36,7 @@ class LogStorageState;
 class LogStorageStateMap;
 class PayloadHolder;
 struct STORE_Header;
+struct STORED_LatencyTrace;
 
 class StoreStorageTask : public WriteStorageTask {
  public:
@@ -63,6 +64,7 @@ class StoreStorageTask : public WriteStorageTask {
   // specify what to do when it's done.
   void onDone() override;
   void onDropped() override;
+  void onSynced() override;
 
   bool isPreempted(Seal* preempted_by) override;
 
@@ -84,6 +86,10 @@ class StoreStorageTask : public WriteStorageTask {
 
   size_t getPayloadSize() const override;
 
+  RecordID getRecordID() const override {
+    return rid_;
+  }
+
   size_t getNumWriteOps() const override;
 
   size_t getWriteOps(const WriteOp** write_ops,
@@ -131,6 +137,10 @@ class StoreStorageTask : public WriteStorageTask {
   // Convenience wrapper for STORED_Message_createAndSend
   void sendReply(Status status) const;
 
+  // Timings of this STORE for the STORED reply if the STORE has the
+  // LATENCY_TRACE flag.
+  STORED_LatencyTrace getLatencyTrace() const;
+
   // called when the storage task is sent back to the worker thread,
   // in case record caching is on, free evicted cache entries previously
   // disposed on the same worker thread
@@ -170,6 +180,9 @@ class StoreStorageTask : public WriteStorageTask {
   // latency.
   std::chrono::steady_clock::time_point start_time_;
 
+  // When the write was synced. Only set for STOREs with LATENCY_TRACE flag.
+  folly::Optional<std::chrono::steady_clock::time_point> synced_time_;
+
   // This holds the record header as it will be written into the local log
   // store.  formRecordHeader() initializes this and returns a Payload that
   // points into this string.
@@ -25,6 +25,7 @@
 #include "logdevice/server/admincommands/Fill.h"
 #include "logdevice/server/admincommands/GossipBlacklist.h"
 #include "logdevice/server/admincommands/Info.h"
+#include "logdevice/server/admincommands/InfoAppendLatencyBreakdown.h"
 #include "logdevice/server/admincommands/InfoAppendOutliers.h"
 #include "logdevice/server/admincommands/InfoBoycotts.h"
 #include "logdevice/server/admincommands/InfoCatchupQueues.h"
@@ -99,6 +100,8 @@ AdminCommandFactory::AdminCommandFactory() {
   selector_.add<commands::FastShutdown>("fast_shutdown");
 
   selector_.add<commands::Info>("info");
+  selector_.add<commands::InfoAppendLatencyBreakdown>(
+      "info append_latency_breakdown");
   selector_.add<commands::InfoAppendOutliers>("info append_outliers");
   selector_.add<commands::InfoGossip>("info gossip");
   selector_.add<commands::InfoBoycotts>("info boycotts");
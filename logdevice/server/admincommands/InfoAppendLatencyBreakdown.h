@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include "logdevice/common/AdminCommandTable.h"
+#include "logdevice/common/AppendLatencyBreakdown.h"
+#include "logdevice/common/Worker.h"
+#include "logdevice/common/request_util.h"
+#include "logdevice/server/admincommands/AdminCommand.h"
+
+namespace facebook { namespace logdevice { namespace commands {
+
+class InfoAppendLatencyBreakdown : public AdminCommand {
+  using AdminCommand::AdminCommand;
+
+ private:
+  bool json_ = false;
+
+ public:
+  void getOptions(
+      boost::program_options::options_description& out_options) override {
+    out_options.add_options()(
+        "json", boost::program_options::bool_switch(&json_));
+  }
+
+  void getPositionalOptions(
+      boost::program_options::positional_options_description& /*out_options*/)
+      override {}
+
+  std::string getUsage() override {
+    return "info append_latency_breakdown [--json]";
+  }
+
+  void run() override {
+    InfoAppendLatencyBreakdownTable table(!json_,
+                                          "Time",
+                                          "Trace ID",
+                                          "Log ID",
+                                          "LSN",
+                                          "Waves",
+                                          "Shard",
+                                          "Client queue us",
+                                          "Sequencer us",
+                                          "Store fanout us",
+                                          "Network us",
+                                          "Storage queue us",
+                                          "Storage write us",
+                                          "WAL sync us",
+                                          "Total us",
+                                          "Release us");
+    auto tables = run_on_all_workers(server_->getProcessor(), [&]() {
+      InfoAppendLatencyBreakdownTable t(table);
+      for (const AppendLatencyBreakdown& b :
+           Worker::onThisThread()->appendLatencyBreakdowns().entries()) {
+        t.next()
+            .set<0>(b.time)
+            .set<1>(b.trace_id)
+            .set<2>(b.log_id)
+            .set<3>(b.lsn)
+            .set<4>(b.waves)
+            .set<5>(b.shard.toString())
+            .set<6>(b.client_queue_us)
+            .set<7>(b.sequencer_us)
+            .set<8>(b.store_fanout_us)
+            .set<9>(b.network_us)
+            .set<10>(b.storage_queue_us)
+            .set<11>(b.storage_write_us)
+            .set<12>(b.wal_sync_us)
+            .set<13>(b.total_us)
+            .set<14>(b.release_us);
+      }
+      return t;
+    });
+
+    for (int i = 0; i < tables.size(); ++i) {
+      table.mergeWith(std::move(tables[i]));
+    }
+
+    json_ ? table.printJson(out_) : table.print(out_);
+  }
+};
+
+}}} // namespace facebook::logdevice::commands
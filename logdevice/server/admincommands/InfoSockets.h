@@ -51,7 +51,13 @@ class InfoSockets : public AdminCommand {
                            "Sendbuf",
                            "Peer Config Version",
                            "Is ssl",
-                           "FD");
+                           "FD",
+                           "Compression",
+                           "Compression ratio out",
+                           "Compression ratio in",
+                           "Compression CPU (ms)",
+                           "Socket writes",
+                           "Avg write size (B)");
 
     auto tables = run_on_all_workers(server_->getProcessor(), [&]() {
       InfoSocketsTable t(table);
@@ -12,6 +12,8 @@
 #include <utility>
 #include <vector>
 
+#include <folly/String.h>
+
 #include "logdevice/common/AdminCommandTable.h"
 #include "logdevice/common/stats/PerShardHistograms.h"
 #include "logdevice/common/stats/ServerHistograms.h"
@@ -53,14 +55,15 @@ class StatsHistogramBase : public AdminCommand {
   static constexpr unsigned MeanColIdx = 10 + sizeof...(UniqueColTypes);
 
   std::string getUsage() override {
-    return "[--summary] [--clear] [--json]";
+    return "[--summary] [--clear] [--json] [--serialized]";
   }
 
   void getOptions(boost::program_options::options_description& opts) override {
     opts.add_options()(
         "summary", boost::program_options::bool_switch(&summary_))(
         "clear", boost::program_options::bool_switch(&clear_))(
-        "json", boost::program_options::bool_switch(&json_));
+        "json", boost::program_options::bool_switch(&json_))(
+        "serialized", boost::program_options::bool_switch(&serialized_));
   }
 
   void forEachHistogram(facebook::logdevice::Stats& stats,
@@ -96,7 +99,11 @@ class StatsHistogramBase : public AdminCommand {
 
     auto agg = statsh->aggregate();
 
-    if (summary_) {
+    if (serialized_) {
+      // One "<name> <hex>" line per histogram, for merging histograms of
+      // different nodes with HistogramInterface::mergeSerialized().
+      forEachHistogram(agg, [&](HistTuple& t) { printSerialized(t); });
+    } else if (summary_) {
       SummaryTable table(!json_,
                          "Name",
                          std::forward<S>(colNames)...,
@@ -152,10 +159,22 @@ class StatsHistogramBase : public AdminCommand {
     setUniqueCols(tuple, table);
   }
 
+  void printSerialized(HistTuple& tuple) {
+    std::string data;
+    if (!std::get<1>(tuple)->serialize(&data)) {
+      // This kind of histogram can't be merged across nodes.
+      return;
+    }
+    out_.printf("%s %s\r\n",
+                serializedLabel(tuple).c_str(),
+                folly::hexlify(data).c_str());
+  }
+
  protected:
   bool summary_{false};
   bool clear_{false};
   bool json_{false};
+  bool serialized_{false};
 
   virtual std::vector<HistTuple>
   findHistograms(facebook::logdevice::Stats& stats) = 0;
@@ -163,6 +182,11 @@ class StatsHistogramBase : public AdminCommand {
   virtual void printHist(HistTuple& tuple) = 0;
 
   virtual void setUniqueCols(HistTuple& /*tuple*/, SummaryTable& /*table*/) {}
+
+  // Identifies the histogram in --serialized output.
+  virtual std::string serializedLabel(HistTuple& tuple) {
+    return std::get<0>(tuple);
+  }
 };
 
 using ShardedStatsHistogramBase = StatsHistogramBase</*shard*/ int>;
@@ -272,6 +296,13 @@ class StatsHistogram : public ShardedStatsHistogramBase {
     }
   }
 
+  std::string serializedLabel(HistTuple& tuple) override {
+    shard_index_t shard_idx = std::get<2>(tuple);
+    return shard_idx >= 0
+        ? folly::sformat("{}.shard{}", std::get<0>(tuple), shard_idx)
+        : std::get<0>(tuple);
+  }
+
   void printHist(HistTuple& tuple) override {
     std::ostringstream oss;
     std::get<1>(tuple)->print(oss);
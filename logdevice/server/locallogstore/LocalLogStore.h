@@ -1154,6 +1154,14 @@ class ShardedLocalLogStore {
    */
   virtual void setSequencerInitiatedSpaceBasedRetention(int /* shard_idx */) {}
 
+  /**
+   * @return  index in NumaTopology of the NUMA node closest to the storage
+   *          device of the given shard, -1 if unknown.
+   */
+  virtual int getNumaNode(int /* shard_idx */) const {
+    return -1;
+  }
+
   virtual ~ShardedLocalLogStore() {}
 };
 
@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#include "logdevice/server/locallogstore/NumaArenaAllocator.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "logdevice/common/NumaTopology.h"
+#include "logdevice/common/checks.h"
+#include "logdevice/common/config.h"
+#include "logdevice/common/debug.h"
+
+#ifdef LOGDEVICE_USING_JEMALLOC
+// See StatsJemalloc.h: weak declarations instead of jemalloc.h, so that the
+// allocator can detect at runtime whether jemalloc is linked in.
+extern "C" int mallctl(const char*, void*, size_t*, void*, size_t)
+    __attribute__((__nothrow__, __weak__));
+extern "C" void* mallocx(size_t, int) __attribute__((__nothrow__, __weak__));
+extern "C" void dallocx(void*, int) __attribute__((__nothrow__, __weak__));
+#endif
+
+namespace facebook { namespace logdevice {
+
+namespace {
+// Flags of mallocx() and dallocx(), as defined in jemalloc.h.
+constexpr int mallocx_arena(unsigned arena) {
+  return static_cast<int>((arena + 1) << 20);
+}
+// Bypass the thread cache, which would mix memory of all arenas the thread
+// used.
+constexpr int kMallocxTcacheNone = 1 << 8;
+} // namespace
+
+NumaArenaAllocator::NumaArenaAllocator(const NumaTopology& topology,
+                                       std::vector<unsigned> arenas)
+    : topology_(topology), arenas_(std::move(arenas)) {
+  ld_check(arenas_.size() == topology_.numNodes());
+}
+
+std::shared_ptr<NumaArenaAllocator>
+NumaArenaAllocator::create(const NumaTopology& topology) {
+#ifdef LOGDEVICE_USING_JEMALLOC
+  if (mallctl == nullptr || mallocx == nullptr || dallocx == nullptr) {
+    ld_info("Not using per NUMA node arenas for the block cache: the process "
+            "doesn't use jemalloc");
+    return nullptr;
+  }
+  std::vector<unsigned> arenas;
+  for (size_t node = 0; node < topology.numNodes(); ++node) {
+    unsigned arena;
+    size_t len = sizeof(arena);
+    int rv = mallctl("arenas.create", &arena, &len, nullptr, 0);
+    if (rv != 0) {
+      ld_error("Failed to create jemalloc arena for NUMA node %zu: %s",
+               node,
+               strerror(rv));
+      return nullptr;
+    }
+    arenas.push_back(arena);
+  }
+  return std::shared_ptr<NumaArenaAllocator>(
+      new NumaArenaAllocator(topology, std::move(arenas)));
+#else
+  (void)topology;
+  return nullptr;
+#endif
+}
+
+void* NumaArenaAllocator::Allocate(size_t size) {
+#ifdef LOGDEVICE_USING_JEMALLOC
+  int node = topology_.currentNode();
+  if (node < 0) {
+    node = 0;
+  }
+  void* p = mallocx(size, mallocx_arena(arenas_[node]) | kMallocxTcacheNone);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+#else
+  ld_check(false);
+  return malloc(size);
+#endif
+}
+
+void NumaArenaAllocator::Deallocate(void* p) {
+#ifdef LOGDEVICE_USING_JEMALLOC
+  // jemalloc finds the arena from the pointer.
+  dallocx(p, kMallocxTcacheNone);
+#else
+  free(p);
+#endif
+}
+
+}} // namespace facebook::logdevice
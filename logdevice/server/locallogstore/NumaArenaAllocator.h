@@ -0,0 +1,59 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <rocksdb/memory_allocator.h>
+
+namespace facebook { namespace logdevice {
+
+class NumaTopology;
+
+/**
+ * @file Allocator for the RocksDB block cache that serves each allocation
+ * from a jemalloc arena dedicated to the NUMA node the calling thread runs
+ * on.
+ *
+ * Blocks are inserted into the cache by the thread that read them, which
+ * with --numa-aware-placement runs on the node of the shard's disk. Its
+ * first touch places the pages on that node, and since an arena only
+ * recycles its own pages, memory freed by blocks of one node is never
+ * handed to readers on another node.
+ */
+
+class NumaArenaAllocator : public rocksdb::MemoryAllocator {
+ public:
+  /**
+   * Creates one arena per node of `topology`, which must outlive the
+   * allocator.
+   *
+   * @return  the allocator, nullptr if the process doesn't use jemalloc or
+   *          creating arenas failed.
+   */
+  static std::shared_ptr<NumaArenaAllocator>
+  create(const NumaTopology& topology);
+
+  const char* Name() const override {
+    return "logdevice::NumaArenaAllocator";
+  }
+
+  void* Allocate(size_t size) override;
+  void Deallocate(void* p) override;
+
+ private:
+  NumaArenaAllocator(const NumaTopology& topology,
+                     std::vector<unsigned> arenas);
+
+  const NumaTopology& topology_;
+  // jemalloc arena index for each node.
+  const std::vector<unsigned> arenas_;
+};
+
+}} // namespace facebook::logdevice
@@ -9,12 +9,15 @@
 
 namespace facebook { namespace logdevice {
 
-RocksDBCache::RocksDBCache(UpdateableSettings<RocksDBSettings> rocksdb_settings)
+RocksDBCache::RocksDBCache(
+    UpdateableSettings<RocksDBSettings> rocksdb_settings,
+    std::shared_ptr<rocksdb::MemoryAllocator> allocator)
     : rocksdb_settings_(rocksdb_settings) {
   rocksdb::LRUCacheOptions opt;
   opt.capacity = rocksdb_settings_->cache_size_;
   opt.num_shard_bits = rocksdb_settings_->cache_numshardbits_;
   opt.high_pri_pool_ratio = rocksdb_settings_->cache_high_pri_pool_ratio_;
+  opt.memory_allocator = std::move(allocator);
 
   cache_ = rocksdb::NewLRUCache(opt);
 }
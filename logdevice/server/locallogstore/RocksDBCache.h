@@ -8,6 +8,7 @@
 #pragma once
 
 #include <rocksdb/cache.h>
+#include <rocksdb/memory_allocator.h>
 
 #include "logdevice/server/locallogstore/RocksDBSettings.h"
 
@@ -19,7 +20,12 @@ namespace facebook { namespace logdevice {
 
 class RocksDBCache : public rocksdb::Cache {
  public:
-  explicit RocksDBCache(UpdateableSettings<RocksDBSettings> rocksdb_settings);
+  /**
+   * @param allocator  if not nullptr, allocates the memory of cached blocks
+   */
+  explicit RocksDBCache(
+      UpdateableSettings<RocksDBSettings> rocksdb_settings,
+      std::shared_ptr<rocksdb::MemoryAllocator> allocator = nullptr);
 
   const char* Name() const override;
   rocksdb::Status Insert(const rocksdb::Slice& key,
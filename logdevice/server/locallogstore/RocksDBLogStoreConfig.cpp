@@ -33,7 +33,8 @@ RocksDBLogStoreConfig::RocksDBLogStoreConfig(
     UpdateableSettings<RebuildingSettings> rebuilding_settings,
     rocksdb::EnvWrapper* env,
     std::shared_ptr<UpdateableConfig> updateable_config,
-    StatsHolder* stats)
+    StatsHolder* stats,
+    std::shared_ptr<rocksdb::MemoryAllocator> block_cache_allocator)
     : rocksdb_settings_(rocksdb_settings),
       rebuilding_settings_(rebuilding_settings) {
   options_ = rocksdb_settings_->passThroughRocksDBOptions();
@@ -75,8 +76,8 @@ RocksDBLogStoreConfig::RocksDBLogStoreConfig(
       rocksdb::NewCappedPrefixTransform(DataKey::PREFIX_LENGTH));
 
   if (rocksdb_settings_->cache_size_ > 0) {
-    table_options_.block_cache =
-        std::make_shared<RocksDBCache>(rocksdb_settings_);
+    table_options_.block_cache = std::make_shared<RocksDBCache>(
+        rocksdb_settings_, std::move(block_cache_allocator));
   }
 
   size_t compressed_cache_size = rocksdb_settings_->compressed_cache_size_;
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <rocksdb/env.h>
+#include <rocksdb/memory_allocator.h>
 
 #include "logdevice/common/configuration/UpdateableConfig.h"
 #include "logdevice/common/settings/RebuildingSettings.h"
@@ -51,13 +52,17 @@ struct RocksDBLogStoreConfig {
    *                            RocksDBTablePropertiesCollector to collect stats
    *                            about table files. @see RocksDBListener.h
    * @param stats               StatsHolder object.
+   * @param block_cache_allocator If not nullptr, allocates the memory of the
+   *                            uncompressed block cache.
    */
   RocksDBLogStoreConfig(
       UpdateableSettings<RocksDBSettings> rocksdb_settings,
       UpdateableSettings<RebuildingSettings> rebuilding_settings,
       rocksdb::EnvWrapper* env,
       std::shared_ptr<UpdateableConfig> updateable_config,
-      StatsHolder* stats);
+      StatsHolder* stats,
+      std::shared_ptr<rocksdb::MemoryAllocator> block_cache_allocator =
+          nullptr);
 
   // Copyable.
   RocksDBLogStoreConfig(const RocksDBLogStoreConfig& rhs) = default;
@@ -22,6 +22,7 @@
 #include <sys/stat.h>
 
 #include "logdevice/common/ConstructorFailed.h"
+#include "logdevice/common/NumaTopology.h"
 #include "logdevice/common/RandomAccessQueue.h"
 #include "logdevice/common/ThreadID.h"
 #include "logdevice/common/settings/RebuildingSettings.h"
@@ -30,6 +31,7 @@
 #include "logdevice/server/fatalsignal.h"
 #include "logdevice/server/locallogstore/FailingLocalLogStore.h"
 #include "logdevice/server/locallogstore/IOTracing.h"
+#include "logdevice/server/locallogstore/NumaArenaAllocator.h"
 #include "logdevice/server/locallogstore/PartitionedRocksDBStore.h"
 #include "logdevice/server/locallogstore/RocksDBKeyFormat.h"
 #include "logdevice/server/locallogstore/RocksDBListener.h"
@@ -133,8 +135,16 @@ void ShardedRocksDBLocalLogStore::init(
     env_->SetBackgroundThreads(num_bg_threads_hi, rocksdb::Env::HIGH);
   }
 
-  rocksdb_config_ = RocksDBLogStoreConfig(
-      db_settings_, rebuilding_settings, env_.get(), updateable_config, stats_);
+  std::shared_ptr<rocksdb::MemoryAllocator> block_cache_allocator;
+  if (settings.numa_aware_placement && NumaTopology::get().isMultiNode()) {
+    block_cache_allocator = NumaArenaAllocator::create(NumaTopology::get());
+  }
+  rocksdb_config_ = RocksDBLogStoreConfig(db_settings_,
+                                          rebuilding_settings,
+                                          env_.get(),
+                                          updateable_config,
+                                          stats_,
+                                          std::move(block_cache_allocator));
 
   // save the rocksdb cache information to be used by the SIGSEGV handler
   if (caches) {
@@ -256,7 +266,7 @@ void ShardedRocksDBLocalLogStore::init(
   }
 
   // Check that we can map shards to devices
-  if (createDiskShardMapping() != nshards_) {
+  if (createDiskShardMapping(settings.numa_aware_placement) != nshards_) {
     throw ConstructorFailed();
   }
   if (is_db_local_) {
@@ -640,7 +650,14 @@ ShardedRocksDBLocalLogStore::getShardToDiskMapping() {
   return fspath_to_dsme_;
 }
 
-size_t ShardedRocksDBLocalLogStore::createDiskShardMapping() {
+int ShardedRocksDBLocalLogStore::getNumaNode(int shard_idx) const {
+  ld_check(shard_idx >= 0 && shard_idx < nshards_);
+  return shard_idx < shard_to_numa_node_.size()
+      ? shard_to_numa_node_[shard_idx]
+      : -1;
+}
+
+size_t ShardedRocksDBLocalLogStore::createDiskShardMapping(bool numa_aware) {
   ld_check(!shard_paths_.empty());
 
   if (!is_db_local_) {
@@ -653,6 +670,7 @@ size_t ShardedRocksDBLocalLogStore::createDiskShardMapping() {
   std::unordered_map<dev_t, size_t> dev_to_out_index;
   size_t success = 0, added_to_map = 0;
   shard_to_devt_.resize(shard_paths_.size());
+  shard_to_numa_node_.assign(shard_paths_.size(), -1);
 
   for (int shard_idx = 0; shard_idx < shard_paths_.size(); ++shard_idx) {
     const fs::path& path = shard_paths_[shard_idx];
@@ -683,6 +701,10 @@ size_t ShardedRocksDBLocalLogStore::createDiskShardMapping() {
     }
 
     shard_to_devt_[shard_idx] = st.st_dev;
+    if (numa_aware) {
+      shard_to_numa_node_[shard_idx] =
+          NumaTopology::get().nodeOfDevice(st.st_dev);
+    }
     auto insert_result = dev_to_out_index.emplace(st.st_dev, added_to_map);
     if (!insert_result.second) {
       // A previous shard had the same dev_t so they are on the same disk.
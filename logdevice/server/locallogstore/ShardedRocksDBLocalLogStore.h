@@ -144,8 +144,11 @@ class ShardedRocksDBLocalLogStore : public ShardedLocalLogStore {
    * Returns the number of shards for which the disk was successfully
    * determined.  Full success is indicated by rv == numShards(), anything
    * less means there were issues.
+   *
+   * @param numa_aware  also find the NUMA node of each disk, for
+   *                    --numa-aware-placement
    */
-  size_t createDiskShardMapping();
+  size_t createDiskShardMapping(bool numa_aware);
 
   /**
    * Shards grouped by local storage device (disk). Empty if data is not stored
@@ -176,6 +179,8 @@ class ShardedRocksDBLocalLogStore : public ShardedLocalLogStore {
    */
   void setSequencerInitiatedSpaceBasedRetention(int shard_idx) override;
 
+  int getNumaNode(int shard_idx) const override;
+
   // Parses path to a file in a shard. Expected format:
   // "<path>/shard<idx>/<filename>
   // If the given path is of that form, assigns <idx> and <filename> to
@@ -250,6 +255,9 @@ class ShardedRocksDBLocalLogStore : public ShardedLocalLogStore {
   // Mapping between shard idx, and the disk on which it resides.
   // Empty if is_db_local_ is false.
   std::vector<dev_t> shard_to_devt_;
+  // NUMA node of each shard's disk, -1 if unknown or if NUMA-aware placement
+  // is disabled. Empty if is_db_local_ is false.
+  std::vector<int> shard_to_numa_node_;
   std::unordered_map<dev_t, DiskShardMappingEntry> fspath_to_dsme_;
 
   // Base path of where the actual RocksDB folders (shards) are located.
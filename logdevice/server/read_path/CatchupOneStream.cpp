@@ -22,6 +22,7 @@
 #include "logdevice/common/Metadata.h"
 #include "logdevice/common/Sender.h"
 #include "logdevice/common/ServerRecordFilter.h"
+#include "logdevice/common/Tracepoints.h"
 #include "logdevice/common/configuration/InternalLogs.h"
 #include "logdevice/common/protocol/GAP_Message.h"
 #include "logdevice/common/protocol/RECORD_Message.h"
@@ -1386,6 +1387,10 @@ void CatchupOneStream::readOnStorageThread(
                                                      std::get<2>(prio),
                                                      std::get<3>(prio),
                                                      client_address);
+  tracepoints::readStorageTaskEnqueue(read_ctx.logid_,
+                                      read_ctx.read_ptr_.lsn,
+                                      read_ctx.until_lsn_,
+                                      read_ctx.max_bytes_to_deliver_);
   deps_.putStorageTask(std::move(task_uniq), stream_->shard_);
   STAT_INCR(deps_.getStatsHolder(), read_requests_to_storage);
 
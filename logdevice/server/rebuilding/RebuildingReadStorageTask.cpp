@@ -457,7 +457,13 @@ void RebuildingReadStorageTask::onDone() {
     // The ShardRebuilding was aborted. Nothing to do.
     return;
   }
-  context->onDone(std::move(result_));
+  std::vector<std::unique_ptr<ChunkData>> result = std::move(result_);
+  result_.clear();
+  context->doneTask = this;
+  SCOPE_EXIT {
+    context->doneTask = nullptr;
+  };
+  context->onDone(std::move(result));
 }
 void RebuildingReadStorageTask::onDropped() {
   ld_check(false);
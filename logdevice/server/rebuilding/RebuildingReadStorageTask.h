@@ -76,6 +76,10 @@ class RebuildingReadStorageTask : public StorageTask {
     // Immutable parameters.
     // The onDone callback is called from worker thread.
     std::function<void(std::vector<std::unique_ptr<ChunkData>>)> onDone;
+    // Set while the task calls onDone(). If the callback wants to read more
+    // right away, it can have this task run again by calling
+    // continueOnStorageThread() on it rather than creating a new task.
+    RebuildingReadStorageTask* doneTask = nullptr;
     std::shared_ptr<const RebuildingSet> rebuildingSet;
     UpdateableSettings<RebuildingSettings> rebuildingSettings;
     ShardID myShardID;
@@ -49,15 +49,23 @@ ShardRebuilding::~ShardRebuilding() {
 }
 
 void ShardRebuilding::abortChunkRebuildings() {
+  if (chunkRebuildings_.empty()) {
+    return;
+  }
+  // Many chunk rebuildings may be running on each worker, post all aborts
+  // for a worker as one batch.
+  std::vector<std::unique_ptr<Request>> rqs;
+  rqs.reserve(chunkRebuildings_.size());
   for (const auto& p : chunkRebuildings_) {
-    std::unique_ptr<Request> rq = std::make_unique<AbortChunkRebuildingRequest>(
-        p.second.workerID, p.first.chunkID);
-    int rv = Worker::onThisThread()->processor_->postImportant(rq);
-    if (rv != 0) {
-      // If we're shutting down, ServerWorker itself will clean up all chunk
-      // rebuildings.
-      ld_check(err == E::SHUTDOWN);
-    }
+    rqs.push_back(std::make_unique<AbortChunkRebuildingRequest>(
+        p.second.workerID, p.first.chunkID));
+  }
+  int rv = Worker::onThisThread()->processor_->postImportantRequests(
+      folly::range(rqs));
+  if (rv != 0) {
+    // If we're shutting down, ServerWorker itself will clean up all chunk
+    // rebuildings.
+    ld_check(err == E::SHUTDOWN);
   }
 }
 
@@ -145,6 +153,12 @@ void ShardRebuilding::sendStorageTaskIfNeeded() {
 }
 
 void ShardRebuilding::putStorageTask() {
+  if (readContext_->doneTask != nullptr) {
+    // We're in onReadTaskDone(). Send the task that just completed back to
+    // the storage thread, keeping its place in the storage task queue.
+    readContext_->doneTask->continueOnStorageThread();
+    return;
+  }
   auto task = std::make_unique<RebuildingReadStorageTask>(readContext_);
   auto task_queue =
       ServerWorker::onThisThread()->getStorageTaskQueueForShard(shard_);
@@ -34,6 +34,38 @@ namespace {
 esn_t nextEsn(esn_t esn) {
   return esn == ESN_MAX ? ESN_MAX : esn_t(esn.val_ + 1);
 }
+
+Status writeRecoveryMetadata(LocalLogStore& store,
+                             logid_t log_id,
+                             epoch_t epoch,
+                             const EpochRecoveryMetadata& metadata) {
+  ld_check(metadata.valid());
+
+  // disable seal preemption checks since we are purging an epoch that is
+  // already recovered. Otherwise, we are guaranteed to be preempted by the
+  // Seal as purging populates seal metadata on CLEAN and RELEASE messages.
+  int rv = store.updatePerEpochLogMetadata(
+      log_id, epoch, metadata, LocalLogStore::SealPreemption::DISABLE);
+
+  if (rv != 0) {
+    if (err == E::UPTODATE) {
+      RATELIMIT_WARNING(std::chrono::seconds(10),
+                        10,
+                        "Write EpochRecoveryMetadata for log %lu shard %u epoch"
+                        " %u failed as there is already a more up-to-date "
+                        "metadata stored. Metadata that prevents the update: "
+                        "%s. This should be rare.",
+                        log_id.val_,
+                        store.getShardIdx(),
+                        epoch.val_,
+                        metadata.toString().c_str());
+      return E::OK;
+    }
+    return E::FAILED;
+  }
+  // write success
+  return E::OK;
+}
 } // namespace
 
 PurgeSingleEpoch::PurgeSingleEpoch(
@@ -154,12 +186,20 @@ void PurgeSingleEpoch::purgeRecords() {
           recovery_metadata_.valid() ? recovery_metadata_.toString().c_str()
                                      : "n/a");
 
-  // delete every record in [start, end] in this epoch
+  // delete every record in [start, end] in this epoch, then write
+  // EpochRecoveryMetadata in the same storage task if there is one to write
   startStorageTask(std::make_unique<PurgeDeleteRecordsStorageTask>(
-      log_id_, epoch_, start_esn, end_esn, ref_holder_.ref()));
+      log_id_,
+      epoch_,
+      start_esn,
+      end_esn,
+      ref_holder_.ref(),
+      get_epoch_recovery_metadata_status_ == E::OK ? copyRecoveryMetadata()
+                                                   : nullptr));
 }
 
-void PurgeSingleEpoch::onPurgeRecordsTaskDone(Status status) {
+void PurgeSingleEpoch::onPurgeRecordsTaskDone(Status status,
+                                              Status metadata_status) {
   ld_check(state_ == State::PURGE_RECORDS);
   ld_check(retry_timer_ != nullptr);
 
@@ -187,6 +227,11 @@ void PurgeSingleEpoch::onPurgeRecordsTaskDone(Status status) {
   // reset the delay
   retry_timer_->reset();
   state_ = State::WRITE_RECOVERY_METADATA;
+  if (metadata_status != E::UNKNOWN) {
+    // the delete task already wrote EpochRecoveryMetadata
+    onEpochRecoveryMetadataWritten(metadata_status);
+    return;
+  }
   writeEpochRecoveryMetadata();
 }
 
@@ -206,25 +251,31 @@ void PurgeSingleEpoch::writeEpochRecoveryMetadata() {
   // locally. This is needed for correctness.
   ld_check(recovery_metadata_.valid());
 
-  // a copy of metadata is needed since we might need retries
+  startStorageTask(std::make_unique<PurgeWriteEpochRecoveryMetadataStorageTask>(
+      log_id_, epoch_, copyRecoveryMetadata(), ref_holder_.ref()));
+}
+
+std::unique_ptr<EpochRecoveryMetadata>
+PurgeSingleEpoch::copyRecoveryMetadata() const {
   auto metadata = std::make_unique<EpochRecoveryMetadata>();
   int rv = metadata->deserialize(recovery_metadata_.serialize());
 
   // must be able to deserialze a valid metadata
   ld_check(rv == 0);
   ld_check(metadata->valid());
-
-  startStorageTask(std::make_unique<PurgeWriteEpochRecoveryMetadataStorageTask>(
-      log_id_, epoch_, std::move(metadata), ref_holder_.ref()));
+  return metadata;
 }
 
 void PurgeSingleEpoch::onWriteEpochRecoveryMetadataDone(Status status) {
-  ld_check(state_ == State::WRITE_RECOVERY_METADATA);
-  ld_check(retry_timer_ != nullptr);
-
   SCOPE_EXIT {
     finalizeIfDone();
   };
+  onEpochRecoveryMetadataWritten(status);
+}
+
+void PurgeSingleEpoch::onEpochRecoveryMetadataWritten(Status status) {
+  ld_check(state_ == State::WRITE_RECOVERY_METADATA);
+  ld_check(retry_timer_ != nullptr);
 
   if (status != E::OK) {
     if (status == E::FAILED) {
@@ -319,13 +370,15 @@ PurgeDeleteRecordsStorageTask::PurgeDeleteRecordsStorageTask(
     epoch_t epoch,
     esn_t start_esn,
     esn_t end_esn,
-    WeakRef<PurgeSingleEpoch> driver)
+    WeakRef<PurgeSingleEpoch> driver,
+    std::unique_ptr<EpochRecoveryMetadata> metadata)
     : StorageTask(StorageTask::Type::PURGE_DELETE_RECORDS),
       log_id_(log_id),
       epoch_(epoch),
       start_esn_(start_esn),
       end_esn_(end_esn),
-      driver_(std::move(driver)) {
+      driver_(std::move(driver)),
+      metadata_(std::move(metadata)) {
   ld_check(start_esn_ <= end_esn_);
 }
 
@@ -440,12 +493,17 @@ void PurgeDeleteRecordsStorageTask::executeImpl(LocalLogStore& store,
   int rv = store.writeMulti(ops);
   status_ = (rv == 0 ? E::OK : E::FAILED);
   STAT_INCR(stats, purging_delete_done);
+
+  if (status_ == E::OK && metadata_ != nullptr) {
+    metadata_status_ =
+        writeRecoveryMetadata(store, log_id_, epoch_, *metadata_);
+  }
 }
 
 void PurgeDeleteRecordsStorageTask::onDone() {
   PurgeSingleEpoch* driver = driver_.get();
   if (driver != nullptr) {
-    driver->onPurgeRecordsTaskDone(status_);
+    driver->onPurgeRecordsTaskDone(status_, metadata_status_);
   }
 }
 
@@ -467,34 +525,7 @@ void PurgeWriteEpochRecoveryMetadataStorageTask::execute() {
 void PurgeWriteEpochRecoveryMetadataStorageTask::executeImpl(
     LocalLogStore& store) {
   ld_check(metadata_ != nullptr);
-  ld_check(metadata_->valid());
-
-  // disable seal preemption checks since we are purging an epoch that is
-  // already recovered. Otherwise, we are guaranteed to be preempted by the
-  // Seal as purging populates seal metadata on CLEAN and RELEASE messages.
-  int rv = store.updatePerEpochLogMetadata(
-      log_id_, epoch_, *metadata_, LocalLogStore::SealPreemption::DISABLE);
-
-  if (rv != 0) {
-    if (err == E::UPTODATE) {
-      RATELIMIT_WARNING(std::chrono::seconds(10),
-                        10,
-                        "Write EpochRecoveryMetadata for log %lu shard %u epoch"
-                        " %u failed as there is already a more up-to-date "
-                        "metadata stored. Metadata that prevents the update: "
-                        "%s. This should be rare.",
-                        log_id_.val_,
-                        storageThreadPool_->getShardIdx(),
-                        epoch_.val_,
-                        metadata_->toString().c_str());
-      status_ = E::OK;
-    } else {
-      status_ = E::FAILED;
-    }
-  } else {
-    // write success
-    status_ = E::OK;
-  }
+  status_ = writeRecoveryMetadata(store, log_id_, epoch_, *metadata_);
 }
 
 void PurgeWriteEpochRecoveryMetadataStorageTask::onDone() {
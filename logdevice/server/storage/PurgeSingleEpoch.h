@@ -53,7 +53,14 @@ class PurgeSingleEpoch {
 
   void start();
 
-  void onPurgeRecordsTaskDone(Status status);
+  /**
+   * @param metadata_status  if the PurgeDeleteRecordsStorageTask also wrote
+   *                         EpochRecoveryMetadata after deleting the
+   *                         records, the result of that write; E::UNKNOWN
+   *                         otherwise
+   */
+  void onPurgeRecordsTaskDone(Status status,
+                              Status metadata_status = E::UNKNOWN);
 
   void onWriteEpochRecoveryMetadataDone(Status status);
 
@@ -112,6 +119,12 @@ class PurgeSingleEpoch {
 
   void writeEpochRecoveryMetadata();
 
+  void onEpochRecoveryMetadataWritten(Status status);
+
+  // A copy of recovery_metadata_ for a storage task to write, since we
+  // might need to retry.
+  std::unique_ptr<EpochRecoveryMetadata> copyRecoveryMetadata() const;
+
   // complete the state machine by transistion it to State::FINISHED. The state
   // machine is not immediately finalized in this call
   void complete(Status status);
@@ -123,13 +136,20 @@ class PurgeSingleEpoch {
   static const char* getStateString(State state, bool shorter);
 };
 
+/**
+ * Deletes records of the epoch being purged. If given EpochRecoveryMetadata,
+ * also writes it once the records are deleted, saving a round trip through
+ * the worker and the storage task queue.
+ */
 class PurgeDeleteRecordsStorageTask : public StorageTask {
  public:
-  PurgeDeleteRecordsStorageTask(logid_t log_id,
-                                epoch_t epoch,
-                                esn_t start_esn,
-                                esn_t end_esn,
-                                WeakRef<PurgeSingleEpoch> driver);
+  PurgeDeleteRecordsStorageTask(
+      logid_t log_id,
+      epoch_t epoch,
+      esn_t start_esn,
+      esn_t end_esn,
+      WeakRef<PurgeSingleEpoch> driver,
+      std::unique_ptr<EpochRecoveryMetadata> metadata = nullptr);
 
   void execute() override;
   void executeImpl(LocalLogStore& store,
@@ -155,7 +175,10 @@ class PurgeDeleteRecordsStorageTask : public StorageTask {
   const esn_t start_esn_;
   const esn_t end_esn_;
   WeakRef<PurgeSingleEpoch> driver_;
+  std::unique_ptr<EpochRecoveryMetadata> metadata_;
   Status status_;
+  // Result of writing metadata_, E::UNKNOWN if not attempted.
+  Status metadata_status_{E::UNKNOWN};
 
   // if the ESN range contains less or equal number of records than this
   // threshold, delete key by key directly. Otherwise, create an iterator
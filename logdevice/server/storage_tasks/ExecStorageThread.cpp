@@ -9,6 +9,7 @@
 
 #include <chrono>
 
+#include "logdevice/common/NumaTopology.h"
 #include "logdevice/common/SlowStorageTasksTracer.h"
 #include "logdevice/common/StorageTask-enums.h"
 #include "logdevice/common/Timestamp.h"
@@ -23,6 +24,9 @@
 namespace facebook { namespace logdevice {
 
 void ExecStorageThread::run() {
+  // Keep the thread, and the memory it first touches, close to the shard's
+  // disk.
+  NumaTopology::get().bindThisThread(pool_->getNumaNode());
   pool_->getLocalLogStore().onStorageThreadStarted();
 
   auto settings = pool_->getSettings().get();
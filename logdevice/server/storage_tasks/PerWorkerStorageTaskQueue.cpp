@@ -14,6 +14,7 @@
 #include <folly/small_vector.h>
 
 #include "logdevice/common/MetaDataLog.h"
+#include "logdevice/common/Tracepoints.h"
 #include "logdevice/common/debug.h"
 #include "logdevice/common/stats/Stats.h"
 #include "logdevice/server/ServerProcessor.h"
@@ -186,6 +187,25 @@ void PerWorkerStorageTaskQueue::onReply(const StorageTask& task) {
   check_queue(taskBuffer_[(int)type].normal);
 }
 
+void PerWorkerStorageTaskQueue::continueTask(
+    std::unique_ptr<StorageTask>&& task) {
+  ld_check(task->continue_on_storage_thread_);
+  ld_check(!task->isWriteTask());
+  ld_check(task->reply_shard_idx_ == shard_idx_);
+  task->continue_on_storage_thread_ = false;
+  task->enqueue_time_ = std::chrono::steady_clock::now();
+
+  // The task still holds its in-flight slot, see StorageTaskResponse.
+  ld_check(taskBuffer_[(int)task->getThreadType()].tasks_in_flight > 0);
+  WORKER_STAT_INCR(storage_tasks_continued);
+
+  StorageThreadPool& pool =
+      ServerWorker::onThisThread()
+          ->processor_->sharded_storage_thread_pool_->getByIndex(shard_idx_);
+  int rv = pool.tryPutTask(std::move(task));
+  ld_check(rv == 0 || err == E::SHUTDOWN);
+}
+
 bool PerWorkerStorageTaskQueue::isOverloaded() const {
   int64_t p = Worker::settings().queue_size_overload_percentage;
   // Since the overloaded status is only used on the append path to determine
@@ -229,6 +249,14 @@ void PerWorkerStorageTaskQueue::sendTaskToStorageThread(
   ld_check(pool);
   int rv;
 
+  if (worker->getNumaNode() >= 0 && pool->getNumaNode() >= 0) {
+    if (worker->getNumaNode() == pool->getNumaNode()) {
+      WORKER_STAT_INCR(storage_tasks_same_numa_node);
+    } else {
+      WORKER_STAT_INCR(storage_tasks_cross_numa_node);
+    }
+  }
+
   if (!task->isWriteTask()) {
     rv = pool->tryPutTask(std::move(task));
     // Transferring the task to the storage pool queue must always succeed.  We
@@ -245,6 +273,11 @@ void PerWorkerStorageTaskQueue::sendTaskToStorageThread(
     // First put the individual write onto the write queue
     WriteStorageTask* raw = static_cast<WriteStorageTask*>(task.release());
     auto thread_type = raw->getThreadType();
+    if (tracepoints::writeStorageTaskEnqueueEnabled()) {
+      RecordID rid = raw->getRecordID();
+      tracepoints::writeStorageTaskEnqueue(
+          rid.logid, rid.lsn(), raw->getPayloadSize());
+    }
     rv = pool->tryPutWrite(std::unique_ptr<WriteStorageTask>(raw));
     ld_check(rv == 0 || err == E::SHUTDOWN);
 
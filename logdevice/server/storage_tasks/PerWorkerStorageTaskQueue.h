@@ -66,10 +66,19 @@ class PerWorkerStorageTaskQueue {
    * thread.
    *
    * This updates the tasks-in-flight counter and possibly sends out a new
-   * task if any were buffered.
+   * task if any were buffered. Called after the task's onDone() or
+   * onDropped(), unless the task continues on the storage thread.
    */
   void onReply(const StorageTask& task);
 
+  /**
+   * Hands back to the storage thread pool a task that called
+   * StorageTask::continueOnStorageThread() from onDone(). Called instead of
+   * onReply(): the task keeps its in-flight slot, so it doesn't wait for the
+   * buffered tasks and the queue stays within max_tasks_in_flight.
+   */
+  void continueTask(std::unique_ptr<StorageTask>&& task);
+
   /**
    * Drop tasks queued in this PerWorkerStorageTaskQueue for a specified
    * thread pool to pick up.  Normally (if the worker is not shutting down),
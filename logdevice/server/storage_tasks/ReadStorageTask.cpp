@@ -17,6 +17,7 @@
 #include "logdevice/common/AdminCommandTable.h"
 #include "logdevice/common/Processor.h"
 #include "logdevice/common/Sender.h"
+#include "logdevice/common/Tracepoints.h"
 #include "logdevice/common/debug.h"
 #include "logdevice/common/protocol/RECORD_Message.h"
 #include "logdevice/include/Err.h"
@@ -122,6 +123,7 @@ void ReadStorageTask::execute() {
   // Only read if the ServerReadStream still exists.
   // We're not on a worker thread, but WeakRef's operator bool() is thread safe.
   if (stream_.getFromAnyThread()) {
+    const lsn_t from_lsn = read_ctx_.read_ptr_.lsn;
     if (options_.inject_latency) {
       folly::Baton<> baton;
       auto& io_fault_injection = IOFaultInjection::instance();
@@ -155,6 +157,8 @@ void ReadStorageTask::execute() {
     records_ = std::move(callback.releaseRecords());
 
     total_bytes_ = callback.totalBytes();
+    tracepoints::readStorageTaskExecute(
+        read_ctx_.logid_, from_lsn, records_.size(), total_bytes_);
 
     /*
      * TODO (T37204962).
@@ -9,6 +9,9 @@
 
 #include <folly/Memory.h>
 
+#include "logdevice/common/NumaTopology.h"
+#include "logdevice/common/settings/Settings.h"
+
 namespace facebook { namespace logdevice {
 
 ShardedStorageThreadPool::ShardedStorageThreadPool(
@@ -21,8 +24,17 @@ ShardedStorageThreadPool::ShardedStorageThreadPool(
     const std::shared_ptr<TraceLogger> trace_logger)
     : sharded_log_store_(store) {
   shard_size_t nshards = store->numShards();
+  const bool numa_aware =
+      settings->numa_aware_placement && NumaTopology::get().isMultiNode();
   pools_.reserve(nshards);
   for (shard_index_t shard_idx = 0; shard_idx < nshards; ++shard_idx) {
+    int numa_node = -1;
+    if (numa_aware) {
+      numa_node = store->getNumaNode(shard_idx);
+      ld_info("Storage threads of shard %d will run on NUMA node %d",
+              shard_idx,
+              numa_node);
+    }
     pools_.push_back(
         // may throw
         std::make_unique<StorageThreadPool>(shard_idx,
@@ -33,7 +45,8 @@ ShardedStorageThreadPool::ShardedStorageThreadPool(
                                             store->getByIndex(shard_idx),
                                             task_queue_size,
                                             stats,
-                                            trace_logger));
+                                            trace_logger,
+                                            numa_node));
   }
 }
 }} // namespace facebook::logdevice
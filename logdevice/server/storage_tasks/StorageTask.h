@@ -114,6 +114,20 @@ class StorageTask {
    */
   virtual void onDone() = 0;
 
+  /**
+   * May be called from onDone() when the operation this task is part of
+   * needs another round of storage work right away. Once onDone() returns,
+   * the task goes back to a storage thread instead of being destroyed, and
+   * execute() and onDone() get called again as for a new task. The task
+   * keeps its in-flight slot in PerWorkerStorageTaskQueue, so it isn't
+   * buffered or dropped behind tasks put after it. Not supported for write
+   * tasks.
+   */
+  void continueOnStorageThread() {
+    ld_check(!isWriteTask());
+    continue_on_storage_thread_ = true;
+  }
+
   /**
    * Called on a worker thread when the storage task is dropped under load.
    * Don't post more storage tasks from inside this callback.
@@ -244,6 +258,12 @@ class StorageTask {
    */
   bool dropped_from_storage_thread_queue_ = false;
 
+  /**
+   * Set by continueOnStorageThread(), cleared by
+   * PerWorkerStorageTaskQueue::continueTask().
+   */
+  bool continue_on_storage_thread_ = false;
+
   // Time this task was queued for execution.
   // Used to maintain histograms of queueing time of storage tasks.
   std::chrono::steady_clock::time_point enqueue_time_;
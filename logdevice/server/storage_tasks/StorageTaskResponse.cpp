@@ -28,6 +28,7 @@ void StorageTaskResponse::sendBackToWorker(std::unique_ptr<StorageTask> task) {
   // Tasks not associated with any worker are completed directly.
   if (worker_idx == WORKER_ID_INVALID) {
     task->onDone();
+    ld_check(!task->continue_on_storage_thread_);
     return;
   }
 
@@ -59,14 +60,25 @@ void StorageTaskResponse::sendDroppedToWorker(
 
 Request::Execution StorageTaskResponse::execute() {
   ServerWorker* worker = ServerWorker::onThisThread();
-  worker->getStorageTaskQueueForShard(task_->reply_shard_idx_)->onReply(*task_);
+  PerWorkerStorageTaskQueue* queue =
+      worker->getStorageTaskQueueForShard(task_->reply_shard_idx_);
 
   if (task_->dropped_from_storage_thread_queue_) {
+    queue->onReply(*task_);
     WORKER_STORAGE_TASK_STAT_INCR(
         task_->getThreadType(), storage_tasks_dropped);
     task_->onDropped();
+    ld_check(!task_->continue_on_storage_thread_);
   } else {
+    // onDone() decides whether the task continues on the storage thread, in
+    // which case it keeps its in-flight slot. Only release the slot, and let
+    // buffered tasks take it, once we know.
     task_->onDone();
+    if (task_->continue_on_storage_thread_) {
+      queue->continueTask(std::move(task_));
+    } else {
+      queue->onReply(*task_);
+    }
   }
 
   return Execution::COMPLETE;
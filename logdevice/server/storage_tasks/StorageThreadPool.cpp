@@ -72,7 +72,8 @@ StorageThreadPool::StorageThreadPool(
     LocalLogStore* local_log_store,
     size_t task_queue_size,
     StatsHolder* stats,
-    const std::shared_ptr<TraceLogger> trace_logger)
+    const std::shared_ptr<TraceLogger> trace_logger,
+    int numa_node)
     : server_settings_(server_settings),
       settings_(settings),
       nthreads_slow_(params[(size_t)ThreadType::SLOW].nthreads),
@@ -88,6 +89,7 @@ StorageThreadPool::StorageThreadPool(
       stats_(stats),
       shard_idx_(shard_idx),
       num_shards_(num_shards),
+      numa_node_(numa_node),
       taskQueues_([&, task_queue_size]() {
         const auto actual_queue_sizes =
             computeActualQueueSizes(task_queue_size);
@@ -52,6 +52,9 @@ class StorageThreadPool {
    * Creates the pool and starts all threads.  Does not claim ownership of the
    * local log store.
    *
+   * @param numa_node  index in NumaTopology of the node the threads bind to,
+   *                   -1 to let them run anywhere
+   *
    * @throws ConstructorFailed on failure
    */
   StorageThreadPool(shard_index_t shard_idx,
@@ -62,7 +65,8 @@ class StorageThreadPool {
                     LocalLogStore* local_log_store,
                     size_t task_queue_size,
                     StatsHolder* stats = nullptr,
-                    const std::shared_ptr<TraceLogger> trace_logger = nullptr);
+                    const std::shared_ptr<TraceLogger> trace_logger = nullptr,
+                    int numa_node = -1);
 
   ~StorageThreadPool();
 
@@ -107,6 +111,11 @@ class StorageThreadPool {
     return shard_idx_;
   }
 
+  // NUMA node the threads of this pool are bound to, -1 if none.
+  int getNumaNode() const {
+    return numa_node_;
+  }
+
   // If true, storage tasks of type FAST_STALLABLE should stall writes
   bool writeStallingEnabled() const {
     return nthreads_fast_stallable_ > 0;
@@ -271,6 +280,7 @@ class StorageThreadPool {
 
   shard_index_t shard_idx_;
   size_t num_shards_;
+  const int numa_node_;
 
   // Separate queue for each type of storage thread.
   SimpleEnumMap<StorageTask::ThreadType, PerTypeTaskQueue> taskQueues_;
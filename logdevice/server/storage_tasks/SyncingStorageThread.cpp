@@ -7,16 +7,20 @@
  */
 #include "logdevice/server/storage_tasks/SyncingStorageThread.h"
 
+#include <algorithm>
 #include <chrono>
 #include <deque>
 
+#include "logdevice/common/NumaTopology.h"
 #include "logdevice/common/SlowStorageTasksTracer.h"
+#include "logdevice/common/Tracepoints.h"
 #include "logdevice/common/debug.h"
 #include "logdevice/common/stats/Stats.h"
 #include "logdevice/server/locallogstore/LocalLogStore.h"
 #include "logdevice/server/storage_tasks/StorageTask.h"
 #include "logdevice/server/storage_tasks/StorageTaskResponse.h"
 #include "logdevice/server/storage_tasks/StorageThreadPool.h"
+#include "logdevice/server/storage_tasks/WriteStorageTask.h"
 
 namespace facebook { namespace logdevice {
 
@@ -53,6 +57,7 @@ void SyncingStorageThread::stopProcessingTasks() {
 }
 
 void SyncingStorageThread::run() {
+  NumaTopology::get().bindThisThread(pool_->getNumaNode());
   pool_->getLocalLogStore().onStorageThreadStarted();
   SlowStorageTasksTracer slow_task_tracer{pool_->getTraceLogger()};
 
@@ -76,6 +81,12 @@ void SyncingStorageThread::run() {
     }
   };
 
+  // Exponentially weighted moving average of sync() duration.
+  std::chrono::microseconds avg_sync_latency{0};
+  // True if we haven't had to block on an empty queue since the last sync,
+  // i.e. the tasks in `batch' arrived while that sync was in progress.
+  bool arrived_during_sync = false;
+
   while (!stop) {
     std::unique_ptr<StorageTask> task;
 
@@ -83,14 +94,30 @@ void SyncingStorageThread::run() {
     // Loop until got_task() finds a task that still needs a sync to
     // be issued.
     while (!stop && batch.empty()) {
-      queue_.blockingRead(task);
+      if (!queue_.read(task)) {
+        arrived_during_sync = false;
+        queue_.blockingRead(task);
+      }
       got_task(std::move(task));
     }
 
     // Delay some tasks until timeout occurs or undelayable task arrives.
     if (!stop) {
-      const std::chrono::milliseconds interval =
+      std::chrono::microseconds interval =
           pool_->getServerSettings()->storage_thread_delaying_sync_interval;
+      if (pool_->getServerSettings()->storage_thread_sync_pipelining) {
+        if (arrived_during_sync) {
+          // Group commit: the sync we just completed served as the batching
+          // window for these tasks, and their WAL writes were done by other
+          // storage threads while it was running. Sync them right away.
+          interval = std::chrono::microseconds::zero();
+        } else if (avg_sync_latency.count() > 0) {
+          // Starting from idle. Waiting much longer than a sync takes would
+          // only add latency: tasks arriving later get picked up by the
+          // next, pipelined, sync anyway.
+          interval = std::min(interval, avg_sync_latency);
+        }
+      }
       std::unique_lock<std::mutex> lock(delay_cv_mutex_);
       delay_cv_.wait_for(lock, interval, [&]() { return sync_immediately_; });
       // Usage of sync_immediately_ introduces race condition
@@ -129,8 +156,20 @@ void SyncingStorageThread::run() {
         RATELIMIT_ERROR(std::chrono::seconds(60), 1, "Sync failed!?");
       }
 
-      uint64_t duration_ms =
-          duration_cast<milliseconds>(end_time - start_time).count();
+      auto duration_us = duration_cast<microseconds>(end_time - start_time);
+      avg_sync_latency = avg_sync_latency.count() == 0
+          ? duration_us
+          : (avg_sync_latency * 7 + duration_us) / 8;
+      PER_SHARD_HISTOGRAM_ADD(pool_->stats(),
+                              sync_latency,
+                              pool_->getShardIdx(),
+                              duration_us.count());
+      PER_SHARD_HISTOGRAM_ADD(pool_->stats(),
+                              sync_batch_size,
+                              pool_->getShardIdx(),
+                              batch.size());
+
+      uint64_t duration_ms = duration_cast<milliseconds>(duration_us).count();
       ld_debug("Shard %d: Synced %zu tasks in %ld ms",
                pool_->getLocalLogStore().getShardIdx(),
                batch.size(),
@@ -158,12 +197,22 @@ void SyncingStorageThread::run() {
 
       for (auto& ptr : batch) {
         if (ptr) {
+          if (tracepoints::writeStorageTaskSyncEnabled() &&
+              ptr->isWriteTask()) {
+            auto* write = static_cast<WriteStorageTask*>(ptr.get());
+            RecordID rid = write->getRecordID();
+            tracepoints::writeStorageTaskSync(rid.logid,
+                                              rid.lsn(),
+                                              write->getPayloadSize(),
+                                              duration_us.count());
+          }
           ptr->onSynced();
           StorageTaskResponse::sendBackToWorker(std::move(ptr));
         } else {
         }
       }
       batch.clear();
+      arrived_during_sync = true;
     }
   }
 }
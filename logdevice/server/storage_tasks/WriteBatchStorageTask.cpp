@@ -16,6 +16,7 @@
 #include <folly/small_vector.h>
 #include <folly/synchronization/Baton.h>
 
+#include "logdevice/common/Tracepoints.h"
 #include "logdevice/common/debug.h"
 #include "logdevice/common/stats/PerShardHistograms.h"
 #include "logdevice/common/stats/Stats.h"
@@ -112,6 +113,12 @@ void WriteBatchStorageTask::execute() {
               task_write_ops.end(),
               std::back_inserter(write_ops));
 
+    if (tracepoints::writeStorageTaskExecuteEnabled()) {
+      RecordID rid = write->getRecordID();
+      tracepoints::writeStorageTaskExecute(
+          rid.logid, rid.lsn(), write->getPayloadSize(), ntasks);
+    }
+
     if (reply_shard_idx_ >= 0) {
       // Update the histogram of queueing latency for that individual
       // WriteStorageTask.
@@ -131,8 +138,10 @@ void WriteBatchStorageTask::execute() {
     STAT_INCR(stats(), write_batches);
   }
 
+  auto write_start_time = std::chrono::steady_clock::now();
   int rv = writeMulti(write_ops);
   Status status = rv == 0 ? E::OK : err;
+  auto write_end_time = std::chrono::steady_clock::now();
 
   auto write_ops_iter = write_ops.begin();
   for (auto& write : writes) {
@@ -140,6 +149,8 @@ void WriteBatchStorageTask::execute() {
       continue;
     }
     write->status_ = status;
+    write->execution_start_time_ = write_start_time;
+    write->execution_end_time_ = write_end_time;
     if (status == E::OK) {
       // store success, try to insert the stored record into the record
       // cache. Perform insertion on the storage thread rather than the
@@ -7,6 +7,7 @@
  */
 #pragma once
 
+#include "logdevice/common/RecordID.h"
 #include "logdevice/common/ResourceBudget.h"
 #include "logdevice/include/Err.h"
 #include "logdevice/server/locallogstore/WriteOps.h"
@@ -99,6 +100,14 @@ class WriteStorageTask : public StorageTask {
     return 0;
   }
 
+  /**
+   * Returns the record this task writes, if it's a single record. Only used
+   * for tracepoints.
+   */
+  virtual RecordID getRecordID() const {
+    return RecordID(LSN_INVALID, LOGID_INVALID);
+  }
+
   /**
    * Returns an array of write ops to be passed to LocalLogStore::writeMulti().
    * WriteStorageTask retains ownership of all WriteOps.
@@ -69,6 +69,7 @@ class PurgeSingleEpochTest : public ::testing::Test {
   std::vector<std::unique_ptr<StorageTask>> tasks_;
   std::shared_ptr<Configuration> config_;
   std::unique_ptr<MockPurgeSingleEpoch> purge_;
+  MockBackoffTimer* retry_timer_{nullptr};
   logid_t log_id_{1234};
   shard_index_t shard_{0};
   epoch_t purge_to_{10};
@@ -106,7 +107,9 @@ class MockPurgeSingleEpoch : public PurgeSingleEpoch {
   }
 
   std::unique_ptr<BackoffTimer> createRetryTimer() override {
-    return std::make_unique<MockBackoffTimer>();
+    auto timer = std::make_unique<MockBackoffTimer>();
+    test_->retry_timer_ = timer.get();
+    return std::move(timer);
   }
 
   void startStorageTask(std::unique_ptr<StorageTask>&& task) override {
@@ -230,6 +233,59 @@ TEST_F(PurgeSingleEpochTest, EpochEmptyGlobally) {
   ASSERT_TRUE(complete_);
 }
 
+TEST_F(PurgeSingleEpochTest, MetadataWrittenByDeleteTask) {
+  epoch_ = epoch_t(8);
+  local_lng_ = esn_t(10);
+  local_last_record_ = esn_t(20);
+  epoch_size_map.setCounter(BYTE_OFFSET, 0);
+  epoch_end_offsets.setCounter(BYTE_OFFSET, 0);
+  tail_record.offsets_map_.setCounter(BYTE_OFFSET, 0);
+  erm_ = EpochRecoveryMetadata(epoch_t(9),
+                               esn_t(10),
+                               esn_t(11),
+                               0,
+                               tail_record,
+                               epoch_size_map,
+                               epoch_end_offsets);
+  status_ = E::OK;
+  setUp();
+  purge_->start();
+  CHECK_STORAGE_TASK(PurgeDeleteRecordsStorageTask);
+  // the delete task wrote the metadata too, no more storage tasks needed
+  purge_->onPurgeRecordsTaskDone(E::OK, E::OK);
+  ASSERT_TRUE(tasks_.empty());
+  ASSERT_TRUE(complete_);
+}
+
+TEST_F(PurgeSingleEpochTest, MetadataWriteByDeleteTaskFailed) {
+  epoch_ = epoch_t(8);
+  local_lng_ = esn_t(10);
+  local_last_record_ = esn_t(20);
+  epoch_size_map.setCounter(BYTE_OFFSET, 0);
+  epoch_end_offsets.setCounter(BYTE_OFFSET, 0);
+  tail_record.offsets_map_.setCounter(BYTE_OFFSET, 0);
+  erm_ = EpochRecoveryMetadata(epoch_t(9),
+                               esn_t(10),
+                               esn_t(11),
+                               0,
+                               tail_record,
+                               epoch_size_map,
+                               epoch_end_offsets);
+  status_ = E::OK;
+  setUp();
+  purge_->start();
+  CHECK_STORAGE_TASK(PurgeDeleteRecordsStorageTask);
+  purge_->onPurgeRecordsTaskDone(E::OK, E::DROPPED);
+  ASSERT_TRUE(tasks_.empty());
+  ASSERT_FALSE(complete_);
+  // only the metadata write is retried
+  ASSERT_TRUE(retry_timer_->isActive());
+  retry_timer_->getCallback()();
+  CHECK_STORAGE_TASK(PurgeWriteEpochRecoveryMetadataStorageTask);
+  purge_->onWriteEpochRecoveryMetadataDone(E::OK);
+  ASSERT_TRUE(complete_);
+}
+
 /// Test the delete storage task used by PurgeSingleEpoch
 TEST_F(PurgeSingleEpochTest, DeleteRecordsByKey) {
   TemporaryRocksDBStore store;
@@ -309,3 +365,40 @@ TEST_F(PurgeSingleEpochTest, DeleteRecordsByReadingData) {
   ASSERT_EQ(0, stats.get().purging_v2_delete_by_keys);
   ASSERT_EQ(1, stats.get().purging_v2_delete_by_reading_data);
 }
+
+TEST_F(PurgeSingleEpochTest, DeleteRecordsThenWriteMetadata) {
+  TemporaryRocksDBStore store;
+  StatsHolder stats(StatsParams().setIsServer(true));
+
+  std::vector<TestRecord> test_data = {
+      TestRecord(LOG_ID, lsn(2, 1), esn_t(0)),
+      TestRecord(LOG_ID, lsn(2, 2), esn_t(1)),
+      TestRecord(LOG_ID, lsn(2, 10), esn_t(1)),
+  };
+  store_fill(store, test_data);
+
+  epoch_size_map.setCounter(BYTE_OFFSET, 0);
+  epoch_end_offsets.setCounter(BYTE_OFFSET, 0);
+  tail_record.offsets_map_.setCounter(BYTE_OFFSET, 0);
+  auto erm = std::make_unique<EpochRecoveryMetadata>(epoch_t(9),
+                                                     esn_t(1),
+                                                     esn_t(1),
+                                                     0,
+                                                     tail_record,
+                                                     epoch_size_map,
+                                                     epoch_end_offsets);
+  const std::string expected_erm = erm->toString();
+  PurgeDeleteRecordsStorageTask task(LOG_ID,
+                                     epoch_t(2),
+                                     esn_t(2),
+                                     esn_t(10),
+                                     WeakRef<PurgeSingleEpoch>(),
+                                     std::move(erm));
+  task.executeImpl(store, &stats, nullptr);
+
+  const std::vector<lsn_t> expected_lsns = {lsn(2, 1)};
+  ASSERT_EQ(expected_lsns, getLsnsForLog(LOG_ID, store));
+  EpochRecoveryMetadata written;
+  ASSERT_EQ(0, store.readPerEpochLogMetadata(LOG_ID, epoch_t(2), &written));
+  EXPECT_EQ(expected_erm, written.toString());
+}
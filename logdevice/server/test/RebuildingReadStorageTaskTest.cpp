@@ -7,6 +7,8 @@
  */
 #include "logdevice/server/rebuilding/RebuildingReadStorageTask.h"
 
+#include <algorithm>
+
 #include <gtest/gtest.h>
 
 #include "logdevice/common/settings/SettingsUpdater.h"
@@ -611,6 +613,69 @@ TEST_P(RebuildingReadStorageTaskTest, TimeRanges) {
   }
 }
 
+// A task that calls continueOnStorageThread() from onDone() reads the next
+// batch when it runs again, the same way a new task for its Context would.
+TEST_P(RebuildingReadStorageTaskTest, ContinueOnStorageThread) {
+  logid_t L1(1);
+  auto& P = partition_start;
+  ReplicationProperty R({{NodeLocationScope::NODE, 3}});
+  Slice big_payload = Slice::fromString(BIG_PAYLOAD);
+
+  // Read 10 KB per storage task, so that each batch has one big record.
+  setRebuildingSettings({{"rebuilding-max-batch-bytes", "10000"}});
+
+  auto rebuilding_set = std::make_shared<RebuildingSet>();
+  rebuilding_set->shards.emplace(
+      N2, RebuildingNodeInfo(RebuildingMode::RESTORE));
+  auto c = createContext(rebuilding_set);
+  c->logs[L1].plan.untilLSN = LSN_MAX;
+  c->logs[L1].plan.addEpochRange(
+      epoch_t(1),
+      epoch_t(1),
+      std::make_shared<EpochMetaData>(StorageSet{N1, N2, N3}, R));
+
+  std::vector<ChunkDescription> expected;
+  for (size_t p = 0; p < 3; ++p) {
+    store->putRecord(
+        L1, mklsn(1, p + 1), P[p] + MINUTE, {N1, N2, N3}, 0, big_payload);
+    expected.push_back({L1, mklsn(1, p + 1), 1, true});
+  }
+  if (GetParam()) { // new-to-old
+    std::reverse(expected.begin(), expected.end());
+  }
+
+  // Like ShardRebuilding, have the task that just completed read the next
+  // batch until there's nothing left to read.
+  std::vector<ChunkDescription> read;
+  int batches = 0;
+  c->onDone = [&](std::vector<std::unique_ptr<ChunkData>> batch) {
+    ++batches;
+    auto descs = convertChunks(batch);
+    read.insert(read.end(), descs.begin(), descs.end());
+    ASSERT_NE(nullptr, c->doneTask);
+    if (!c->reachedEnd) {
+      c->doneTask->continueOnStorageThread();
+    }
+  };
+
+  MockRebuildingReadStorageTask task(this, c);
+  int runs = 0;
+  do {
+    ASSERT_LT(runs++, 10);
+    // PerWorkerStorageTaskQueue::continueTask() clears the flag before
+    // handing the task back to the storage thread.
+    task.continue_on_storage_thread_ = false;
+    task.execute();
+    task.onDone();
+  } while (task.continue_on_storage_thread_);
+
+  EXPECT_TRUE(c->reachedEnd);
+  EXPECT_FALSE(c->persistentError);
+  EXPECT_EQ(nullptr, c->doneTask);
+  EXPECT_GE(batches, 3);
+  EXPECT_EQ(expected, read);
+}
+
 INSTANTIATE_TEST_CASE_P(P,
                         RebuildingReadStorageTaskTest,
                         ::testing::Values(false, true));
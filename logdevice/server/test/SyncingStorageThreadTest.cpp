@@ -78,6 +78,64 @@ struct UndelayableStorageTask : public TestStorageTaskBase {
     return false;
   }
 };
+/**
+ * Storage task for pipelining tests: counts execute() and onSynced() calls
+ * without any time expectations.
+ */
+struct PipelinedStorageTask : public StorageTask {
+  PipelinedStorageTask(Semaphore* executed,
+                       Semaphore* synced,
+                       std::atomic<int>* nsynced,
+                       bool delayable)
+      : StorageTask(StorageTask::Type::UNKNOWN),
+        executed_(executed),
+        synced_(synced),
+        nsynced_(nsynced),
+        delayable_(delayable) {}
+  void execute() override {
+    if (executed_) {
+      executed_->post();
+    }
+  }
+  void onDone() override {}
+  void onDropped() override {
+    ld_check(false);
+  }
+  Durability durability() const override {
+    return Durability::SYNC_WRITE;
+  }
+  bool allowDelayingSync() const override {
+    return delayable_;
+  }
+  void onSynced() override {
+    ++*nsynced_;
+    synced_->post();
+  }
+
+  Semaphore* executed_;
+  Semaphore* synced_;
+  std::atomic<int>* nsynced_;
+  bool delayable_;
+};
+
+/**
+ * Store whose first sync() of the syncing thread blocks until `unblock` is
+ * posted.
+ */
+class BlockingSyncStore final : public TemporaryRocksDBStore {
+ public:
+  int sync(Durability durability) override {
+    if (durability == Durability::ASYNC_WRITE && nsyncs.fetch_add(1) == 0) {
+      sync_started.post();
+      unblock.wait();
+    }
+    return TemporaryRocksDBStore::sync(durability);
+  }
+
+  folly::Baton<> sync_started;
+  folly::Baton<> unblock;
+  std::atomic<int> nsyncs{0};
+};
 } // namespace
 
 /**
@@ -189,3 +247,59 @@ TEST(SyncingStorageThreadTest, DelayableAndLaterUndelayableTasks) {
 
   pool.reset();
 }
+
+/**
+ * With storage-thread-sync-pipelining, storage threads keep executing the
+ * writes of the next batch while a sync is in progress, and that batch is
+ * synced as soon as the sync completes, without waiting for the delaying
+ * interval.
+ */
+TEST(SyncingStorageThreadTest, PipelinedDelayableTasks) {
+  UpdateableSettings<Settings> settings;
+  ServerSettings init_server_settings =
+      create_default_settings<ServerSettings>();
+  // Long enough that the test would time out if the second batch waited
+  // for it.
+  init_server_settings.storage_thread_delaying_sync_interval =
+      std::chrono::hours(1);
+  init_server_settings.storage_thread_sync_pipelining = true;
+  UpdateableSettings<ServerSettings> server_settings(init_server_settings);
+
+  Params params;
+  params[(size_t)StorageTaskThreadType::SLOW].nthreads = 4;
+  const int task_queue_slots = 4;
+  const int ntasks = 4;
+
+  BlockingSyncStore store;
+  auto pool = std::make_unique<StorageThreadPool>(
+      0, 1, params, server_settings, settings, &store, task_queue_slots);
+
+  Semaphore executed;
+  Semaphore synced;
+  std::atomic<int> nsynced{0};
+  // The first batch is synced right away, and the sync blocks.
+  pool->enqueueForSync(std::make_unique<PipelinedStorageTask>(
+      nullptr, &synced, &nsynced, /* delayable */ false));
+  store.sync_started.wait();
+
+  // The writes of the next batch are dequeued and executed while the sync
+  // is in progress.
+  for (int i = 0; i < ntasks; ++i) {
+    ASSERT_TRUE(pool->blockingPutTask(std::make_unique<PipelinedStorageTask>(
+        &executed, &synced, &nsynced, /* delayable */ true)));
+  }
+  for (int i = 0; i < ntasks; ++i) {
+    executed.wait();
+  }
+  EXPECT_EQ(0, nsynced.load());
+  EXPECT_EQ(1, store.nsyncs.load());
+
+  store.unblock.post();
+  for (int i = 0; i < ntasks + 1; ++i) {
+    synced.wait();
+  }
+  EXPECT_EQ(ntasks + 1, nsynced.load());
+  EXPECT_GE(store.nsyncs.load(), 2);
+
+  pool.reset();
+}
@@ -27,6 +27,14 @@ DEFINE_string(num_server_workers,
 DEFINE_string(num_client_workers,
               "ncores",
               "number of worker threads for the client");
+DEFINE_bool(io_uring,
+            false,
+            "use io_uring sockets (--io-uring-sockets) on both the node and "
+            "the client");
+DEFINE_bool(shm,
+            false,
+            "use shared memory connections (--shm-local-connections) on both "
+            "the node and the client");
 DEFINE_int32(
     max_sends_per_iteration,
     1000,
@@ -41,6 +49,8 @@ BENCHMARK(SocketBenchmark, n) {
   auto cluster =
       IntegrationTestUtils::ClusterFactory()
           .setParam("--num-workers", FLAGS_num_server_workers.c_str())
+          .setParam("--io-uring-sockets", FLAGS_io_uring ? "true" : "false")
+          .setParam("--shm-local-connections", FLAGS_shm ? "true" : "false")
           .create(1);
   std::unique_ptr<ClientSettings> client_settings{ClientSettings::create()};
   if (client_settings->set("num-workers", FLAGS_num_client_workers.c_str()) !=
@@ -53,6 +63,16 @@ BENCHMARK(SocketBenchmark, n) {
     ld_info("Unable to set execute-requests");
     exit(1);
   }
+  if (client_settings->set(
+          "io-uring-sockets", FLAGS_io_uring ? "true" : "false") != 0) {
+    ld_info("Unable to set io-uring-sockets");
+    exit(1);
+  }
+  if (client_settings->set(
+          "shm-local-connections", FLAGS_shm ? "true" : "false") != 0) {
+    ld_info("Unable to set shm-local-connections");
+    exit(1);
+  }
   auto client = cluster->createClient(
       getDefaultTestTimeout(), std::move(client_settings));
   Processor* processor =
@@ -7,6 +7,7 @@
  */
 #include <algorithm>
 #include <chrono>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <pthread.h>
@@ -1033,6 +1034,52 @@ TEST_F(AppendIntegrationTest, WriteLsnAfterTrimPoint) {
   ASSERT_EQ(-1, nread);
 }
 
+// Stores are spread over several connections between each pair of nodes.
+// Records of each log must still all be stored and read back in order.
+TEST_F(AppendIntegrationTest, ConnectionsPerNode) {
+  const int NLOGS = 4;
+  const int NRECORDS = 50;
+  auto cluster = IntegrationTestUtils::ClusterFactory()
+                     .setNumLogs(NLOGS)
+                     .setParam("--connections-per-node", "3")
+                     .create(4);
+  auto client = cluster->createClient();
+
+  std::map<logid_t, lsn_t> first_lsn;
+  for (int i = 0; i < NRECORDS; ++i) {
+    for (logid_t::raw_type log = 1; log <= NLOGS; ++log) {
+      lsn_t lsn = client->appendSync(
+          logid_t(log), folly::sformat("log {} record {}", log, i));
+      ASSERT_NE(LSN_INVALID, lsn);
+      first_lsn.emplace(logid_t(log), lsn);
+    }
+  }
+
+  int64_t stripes_created = 0;
+  for (const auto& it : cluster->getNodes()) {
+    stripes_created += it.second->stats()["connection_stripes_created"];
+  }
+  EXPECT_GT(stripes_created, 0);
+
+  for (const auto& it : first_lsn) {
+    auto reader = client->createReader(1);
+    reader->setTimeout(this->testTimeout());
+    ASSERT_EQ(0, reader->startReading(it.first, it.second));
+    std::vector<std::unique_ptr<DataRecord>> records;
+    GapRecord gap;
+    while (records.size() < NRECORDS) {
+      ssize_t nread = reader->read(NRECORDS - records.size(), &records, &gap);
+      // Returning nothing means the read timed out.
+      ASSERT_NE(0, nread);
+      ASSERT_TRUE(nread > 0 || err == E::GAP);
+    }
+    for (int i = 0; i < NRECORDS; ++i) {
+      EXPECT_EQ(folly::sformat("log {} record {}", it.first.val_, i),
+                records[i]->payload.toString());
+    }
+  }
+}
+
 // Returns the number of successful writes
 static int hammer_client_with_writes(Client& client,
                                      const int NAPPENDS,
@@ -411,6 +411,43 @@ TEST_P(ReadingIntegrationTest, ReaderSSLTest) {
             s.ssl_context_created);
 }
 
+// Same as ReaderSSLTest, with encryption offloaded to kernel TLS where the
+// kernel supports it. Connections fall back to userspace encryption otherwise,
+// so the test passes either way; it checks that every handshake went one way
+// or the other.
+TEST_P(ReadingIntegrationTest, ReaderSSLKernelTLSTest) {
+  auto cluster =
+      clusterFactory()
+          .setParam(
+              "--ssl-cert-path", TEST_SSL_FILE("logdevice_test_valid.cert"))
+          .setParam("--ssl-key-path", TEST_SSL_FILE("logdevice_test.key"))
+          .setParam(
+              "--ssl-ca-path", TEST_SSL_FILE("logdevice_test_valid_ca.cert"))
+          .setParam("--ssl-ktls", "true")
+          .create(2);
+
+  std::unique_ptr<ClientSettings> client_settings(ClientSettings::create());
+  ASSERT_EQ(0,
+            client_settings->set(
+                "ssl-cert-path", TEST_SSL_FILE("logdevice_test_valid.cert")));
+  ASSERT_EQ(0,
+            client_settings->set(
+                "ssl-key-path", TEST_SSL_FILE("logdevice_test.key")));
+  ASSERT_EQ(0,
+            client_settings->set(
+                "ssl-ca-path", TEST_SSL_FILE("logdevice_test_valid_ca.cert")));
+  ASSERT_EQ(0, client_settings->set("ssl-load-client-cert", 1));
+  ASSERT_EQ(0, client_settings->set("ssl-boundary", "node"));
+  ASSERT_EQ(0, client_settings->set("ssl-ktls", "true"));
+  auto client =
+      cluster->createClient(testTimeout(), std::move(client_settings));
+
+  IntegrationTest_RunReaderTest(cluster.get(), client);
+
+  Stats s = dynamic_cast<ClientImpl*>(client.get())->stats()->aggregate();
+  ASSERT_LE(1, s.ssl_ktls_connections + s.ssl_ktls_fallbacks);
+}
+
 TEST_P(ReadingIntegrationTest, ReaderSSLNoClientCertTest) {
   auto cluster =
       clusterFactory()
@@ -0,0 +1,280 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <folly/Random.h>
+
+#include "logdevice/common/debug.h"
+#include "logdevice/include/BufferedWriter.h"
+#include "logdevice/include/Err.h"
+#include "logdevice/include/Record.h"
+#include "logdevice/include/types.h"
+#include "logdevice/test/ldbench/worker/Options.h"
+#include "logdevice/test/ldbench/worker/Reservoir.h"
+#include "logdevice/test/ldbench/worker/Worker.h"
+#include "logdevice/test/ldbench/worker/WorkerRegistry.h"
+
+namespace facebook { namespace logdevice { namespace ldbench {
+namespace {
+
+static constexpr const char* BENCH_NAME = "stream_write";
+// Number of latency samples kept for computing percentiles.
+static constexpr size_t LATENCY_RESERVOIR_SIZE = 1000000;
+
+/**
+ * Stream write benchmark worker.
+ *
+ * Keeps a fixed number (--max-window) of appends in flight, spread uniformly
+ * across the set of logs, and measures throughput and end-to-end append
+ * latency. With --use-buffered-writer, appends go through a BufferedWriter in
+ * STREAM mode (--buffered-writer-stream-inflight-window controls the window of
+ * the underlying write streams); otherwise they go through plain
+ * Client::append(), which makes it easy to compare the two.
+ *
+ * Prints one line: duration in ms, number of successful appends, number of
+ * failed appends, and p50, p99 and p99.9 append latency in microseconds.
+ * Latency percentiles are computed from a uniform sample of at most
+ * LATENCY_RESERVOIR_SIZE appends, so memory use doesn't grow with --duration.
+ */
+class StreamWriteWorker final : public Worker,
+                                public BufferedWriter::AppendCallback {
+ public:
+  using Worker::Worker;
+  ~StreamWriteWorker() override;
+  int run() override;
+
+  // BufferedWriter::AppendCallback
+  void onSuccess(logid_t log_id,
+                 ContextSet contexts,
+                 const DataRecordAttributes& attrs) override;
+  void onFailure(logid_t log_id, ContextSet contexts, Status status) override;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  // Waits for the window to open and issues one append. Returns true when the
+  // current phase is over (deadline reached, stop requested or fatal error).
+  bool appendOne(std::unique_lock<std::mutex>& lock,
+                 const std::vector<logid_t>& logs,
+                 Clock::time_point deadline);
+  void recordAppendResult(Status status, Clock::time_point sent_time);
+
+  // The send time travels as the BufferedWriter context, to avoid per-append
+  // allocations.
+  static Context encodeTime(Clock::time_point t) {
+    return reinterpret_cast<Context>(
+        static_cast<uintptr_t>(t.time_since_epoch().count()));
+  }
+  static Clock::time_point decodeTime(Context ctx) {
+    return Clock::time_point(
+        Clock::duration(reinterpret_cast<uintptr_t>(ctx)));
+  }
+
+  std::unique_ptr<BufferedWriter> writer_;
+  std::mutex mutex_;
+  std::condition_variable cond_var_;
+  uint64_t npending_ = 0;
+  uint64_t nsuccess_ = 0;
+  uint64_t nerrors_ = 0;
+  bool measuring_ = false;
+  Reservoir<uint64_t> latencies_us_{LATENCY_RESERVOIR_SIZE};
+};
+
+StreamWriteWorker::~StreamWriteWorker() {
+  // BufferedWriter calls back into this object, destroy it first. Then make
+  // sure no Client callbacks are called after this subclass is destroyed.
+  writer_.reset();
+  destroyClient();
+}
+
+bool StreamWriteWorker::appendOne(std::unique_lock<std::mutex>& lock,
+                                  const std::vector<logid_t>& logs,
+                                  Clock::time_point deadline) {
+  // Wake up at least every second to poll isStopped(), which cannot signal
+  // the condition variable.
+  const uint64_t window = std::max<uint64_t>(options.max_window, 1);
+  for (;;) {
+    auto wakeup_time = std::min(Clock::now() + std::chrono::seconds(1),
+                                deadline);
+    cond_var_.wait_until(
+        lock, wakeup_time, [&] { return isStopped() || npending_ < window; });
+    if (isStopped() || (!options.ignore_errors && nerrors_ > 0) ||
+        Clock::now() >= deadline) {
+      return true;
+    }
+    if (npending_ < window) {
+      break;
+    }
+  }
+
+  ld_check(!logs.empty());
+  logid_t log_id = logs[folly::Random::rand32() % logs.size()];
+  const auto now = Clock::now();
+  ++npending_;
+
+  int rv;
+  if (writer_) {
+    rv = writer_->append(log_id, generatePayload(), encodeTime(now));
+  } else {
+    rv = tryAppend(log_id,
+                   generatePayload(),
+                   [this, now](Status st, const DataRecord&) {
+                     recordAppendResult(st, now);
+                   })
+        ? -1
+        : 0;
+  }
+  if (rv != 0) {
+    --npending_;
+    ++nerrors_;
+    RATELIMIT_ERROR(std::chrono::seconds(10),
+                    1,
+                    "Append failed: %s (%s)",
+                    error_name(err),
+                    error_description(err));
+  }
+  return false;
+}
+
+int StreamWriteWorker::run() {
+  std::vector<logid_t> logs;
+  if (getLogs(logs)) {
+    return 1;
+  }
+  if (logs.empty()) {
+    ld_error("No logs.");
+    return 1;
+  }
+
+  if (options.use_buffered_writer && !options.pretend) {
+    BufferedWriter::Options bw_options = options.buffered_writer_options;
+    bw_options.mode = BufferedWriter::Options::Mode::STREAM;
+    writer_ = BufferedWriter::create(client_, this, bw_options);
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  ld_info("Performing warm-up for %" PRIu64 " seconds",
+          options.warmup_duration);
+  auto deadline = Clock::now() + std::chrono::seconds(options.warmup_duration);
+  while (!appendOne(lock, logs, deadline)) {
+    /* keep going */
+  }
+
+  ld_info("Performing stream write benchmark for %" PRIi64 " seconds",
+          options.duration);
+  nsuccess_ = 0;
+  nerrors_ = 0;
+  measuring_ = true;
+  const auto start_time = Clock::now();
+  deadline = options.duration >= 0
+      ? start_time + std::chrono::seconds(options.duration)
+      : Clock::time_point::max();
+  while (!appendOne(lock, logs, deadline)) {
+    /* keep going */
+  }
+  measuring_ = false;
+  const auto end_time = Clock::now();
+
+  // Wait for pending appends (otherwise the callbacks may crash).
+  ld_info("Waiting for pending appends: npending=%" PRIu64, npending_);
+  if (writer_) {
+    lock.unlock();
+    writer_->flushAll();
+    lock.lock();
+  }
+  cond_var_.wait(lock, [this] { return npending_ == 0; });
+
+  // Percentiles of the sampled latencies.
+  std::sort(latencies_us_.begin(), latencies_us_.end());
+  auto percentile = [this](double p) -> uint64_t {
+    const size_t n = latencies_us_.getNumberOfSamples();
+    if (n == 0) {
+      return 0;
+    }
+    size_t idx = std::min(n - 1, static_cast<size_t>(p * n));
+    return *(latencies_us_.begin() + idx);
+  };
+  std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(
+                   end_time - start_time)
+                   .count()
+            << ' ' << nsuccess_ << ' ' << nerrors_ << ' ' << percentile(0.5)
+            << ' ' << percentile(0.99) << ' ' << percentile(0.999) << '\n';
+
+  return !options.ignore_errors && nerrors_ > 0;
+}
+
+void StreamWriteWorker::recordAppendResult(Status status,
+                                           Clock::time_point sent_time) {
+  const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+      Clock::now() - sent_time);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ld_check(npending_ > 0);
+    --npending_;
+    if (status == E::OK) {
+      if (measuring_) {
+        ++nsuccess_;
+        latencies_us_.put(latency.count());
+      }
+    } else {
+      ++nerrors_;
+      RATELIMIT_ERROR(std::chrono::seconds(10),
+                      1,
+                      "Append failed: %s (%s)",
+                      error_name(status),
+                      error_description(status));
+    }
+  }
+  cond_var_.notify_one();
+}
+
+void StreamWriteWorker::onSuccess(logid_t,
+                                  ContextSet contexts,
+                                  const DataRecordAttributes&) {
+  for (auto& ctx : contexts) {
+    recordAppendResult(E::OK, decodeTime(ctx.first));
+  }
+}
+
+void StreamWriteWorker::onFailure(logid_t,
+                                  ContextSet contexts,
+                                  Status status) {
+  for (auto& ctx : contexts) {
+    recordAppendResult(status, decodeTime(ctx.first));
+  }
+}
+
+} // namespace
+
+void registerStreamWriteWorker() {
+  registerWorkerImpl(BENCH_NAME,
+                     []() -> std::unique_ptr<Worker> {
+                       return std::make_unique<StreamWriteWorker>();
+                     },
+                     OptionsRestrictions(
+                         {"pretend",
+                          "max-window",
+                          "warmup-duration",
+                          "duration",
+                          "payload-size",
+                          "use-buffered-writer"},
+                         {PartitioningMode::DEFAULT},
+                         OptionsRestrictions::AllowBufferedWriterOptions::YES));
+}
+
+}}} // namespace facebook::logdevice::ldbench
@@ -26,6 +26,7 @@ const WorkerFactoryMap& getWorkerFactoryMap() {
   registerWriteSaturationWorker();
   registerIsLogEmptyWorker();
   registerFindTimeWorker();
+  registerStreamWriteWorker();
 
   return getWorkerFactoryMapImpl();
 }
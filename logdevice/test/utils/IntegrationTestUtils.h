@@ -75,6 +75,14 @@ namespace facebook { namespace logdevice {
  *
  * LOGDEVICE_TEST_FORCE_SSL      forces all sockets to be SSL-enabled
  *
+ * LOGDEVICE_TEST_FORCE_IO_URING forces all plaintext sockets on folly event
+ *                               bases to do I/O through io_uring, as if
+ *                               --io-uring-sockets was set
+ *
+ * LOGDEVICE_TEST_FORCE_SHM      makes plaintext connections over unix sockets
+ *                               on folly event bases go through shared
+ *                               memory, as if --shm-local-connections was set
+ *
  * LOGDEVICE_TEST_NO_TIMEOUT     do not enforce timeout in tests
  *
  * LOGDEVICE_TEST_MESSAGE_ERROR_CHANCE   together defines chance and status